@@ -0,0 +1,80 @@
+#include "console.hpp"
+
+// $4000-$40FF: the APU, OAM DMA and the controller ports.
+class Console::Io : public fce::Memory
+{
+public:
+    explicit Io(Console& console) noexcept
+        : console_{console}
+    {
+    }
+
+    auto get(fce::u16 addr) const noexcept -> fce::u8 override
+    {
+        if (addr == 0x4015) {
+            return console_.apu_->get(addr);
+        }
+        // no buttons pressed, over the open bus
+        return addr == 0x4016 || addr == 0x4017 ? 0x40 : 0x00;
+    }
+
+    auto set(fce::u16 addr, fce::u8 v) noexcept -> void override
+    {
+        if (addr == 0x4014) {
+            fce::u8 page[0x100];
+            for (unsigned i = 0; i < 0x100; i++) {
+                page[i] = console_.cpu_.bus().get(fce::u16(v << 8 | i));
+            }
+            console_.ppu_->oam_dma(page);
+        } else if (addr <= 0x4017 && addr != 0x4016) {
+            console_.apu_->set(addr, v);
+        }
+    }
+
+private:
+    Console& console_;
+};
+
+Console::Console(std::string const& path, fce::u32 sample_rate)
+    : rom_{path},
+      mapper_{fce::make_mapper(rom_)},
+      ppu_{std::make_shared<fce::Ppu>(mapper_)},
+      apu_{std::make_shared<fce::Apu>(sample_rate)},
+      io_{std::make_shared<Io>(*this)},
+      cpu_{this->bus()}
+{
+    // polling PPUSTATUS for the vertical blank runs to it at once
+    cpu_.skip_idle(true);
+    auto const clock = [this] { return cpu_.cycles(); };
+    mapper_->on_remap([this](fce::u8 first, fce::u8 last) { cpu_.invalidate_code(first, last); });
+    ppu_->attach(scheduler_, clock, [this] { cpu_.nmi(); });
+    mapper_->attach(scheduler_, clock, [this](bool line) {
+        mapper_irq_ = line;
+        cpu_.irq(mapper_irq_ || apu_irq_);
+    });
+    apu_->attach(
+        scheduler_, clock,
+        [this](bool line) {
+            apu_irq_ = line;
+            cpu_.irq(mapper_irq_ || apu_irq_);
+        },
+        [this](fce::u16 addr) { return cpu_.bus().get(addr); });
+}
+
+auto Console::run_frame() -> void
+{
+    auto const frames = ppu_->frames();
+    while (ppu_->frames() == frames) {
+        scheduler_.run(cpu_, cpu_.cycles() + 1000);
+    }
+}
+
+auto Console::bus() -> fce::Bus
+{
+    fce::Bus bus;
+    bus.map_ram(0x00, 0x1F, ram_.data(), ram_.size());
+    bus.map_io(0x20, 0x3F, ppu_);
+    bus.map_io(0x40, 0x40, io_);
+    bus.map_io(0x41, 0xFF, mapper_);
+    return bus;
+}
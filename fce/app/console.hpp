@@ -0,0 +1,46 @@
+#ifndef FCE_APP_CONSOLE_HPP_
+#define FCE_APP_CONSOLE_HPP_
+
+#include <array>
+#include <memory>
+#include <string>
+#include <fce/fce.hpp>
+
+// An NES running a cartridge: 2 KiB of RAM, the PPU, the APU and the mapper on
+// a Bus, and a CPU<Bus> run between the events of a Scheduler, skipping idle
+// loops, see CPU::skip_idle() and Ppu::stable(). No controllers are
+// connected, and OAM DMA doesn't stall the CPU.
+class Console
+{
+public:
+    Console(std::string const& path, fce::u32 sample_rate);
+
+    Console(Console const&) = delete;
+    auto operator=(Console const&) -> Console& = delete;
+
+    // Runs until the PPU completes a frame.
+    auto run_frame() -> void;
+
+    auto ppu() noexcept -> fce::Ppu& { return *ppu_; }
+    auto apu() noexcept -> fce::Apu& { return *apu_; }
+    auto cpu() noexcept -> fce::CPU<fce::Bus>& { return cpu_; }
+
+private:
+    class Io;
+
+    fce::Rom rom_;
+    std::shared_ptr<fce::Mapper> mapper_;
+    std::shared_ptr<fce::Ppu> ppu_;
+    std::shared_ptr<fce::Apu> apu_;
+    std::shared_ptr<Io> io_;
+    std::array<fce::u8, 0x800> ram_{};
+
+    fce::Scheduler scheduler_;
+    fce::CPU<fce::Bus> cpu_;
+    bool mapper_irq_ = false;
+    bool apu_irq_ = false;
+
+    auto bus() -> fce::Bus;
+};
+
+#endif  // FCE_APP_CONSOLE_HPP_
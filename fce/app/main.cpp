@@ -1,7 +1,16 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <iostream>
+#include <thread>
 #include <spdlog/spdlog.h>
 #include <fce/fce.hpp>
+#include "console.hpp"
 
 class Memory : public fce::Memory
 {
@@ -31,14 +40,173 @@ public:
     }
 };
 
-int main()
+constexpr fce::u32 sample_rate = 48000;
+
+// The sound of a run, written to `path` through the same ring and audio
+// thread a sound device would be fed by.
+class WavDump
 {
+public:
+    WavDump(std::string const& path, fce::Apu& apu)
+        : file_{path, std::ios::binary}, wav_{file_, apu.sample_rate()},
+          thread_{ring_, [this](fce::s16 const *samples, std::size_t count) { wav_.write(samples, count); }}
+    {
+        if (!file_) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        apu.output(&ring_);
+    }
+
+    // A dump has no deadline, so it waits for the writer rather than drop.
+    auto wait() -> void
+    {
+        while (ring_.size() > ring_.capacity() / 2) {
+            std::this_thread::yield();
+        }
+    }
+
+    auto finish() -> void
+    {
+        thread_.stop();
+        wav_.finish();
+    }
+
+private:
+    fce::AudioRing ring_{1 << 16};
+    std::ofstream file_;
+    fce::WavWriter wav_;
+    fce::AudioThread thread_;
+};
+
+// Runs `rom` headless for `seconds` and dumps its sound to `path`.
+auto dump_wav(char const *path, char const *rom, double seconds) -> int
+{
+    Console console{rom, sample_rate};
+    WavDump audio{path, console.apu()};
+
+    auto const frames = long(seconds * 60);
+    for (long i = 0; i < frames; i++) {
+        console.run_frame();
+        audio.wait();
+    }
+    audio.finish();
+    spdlog::info("{} samples, {} dropped", console.apu().samples(), console.apu().dropped());
+    return 0;
+}
+
+// Runs `rom` headless for `seconds`, as fast as the capture is written, and
+// records every frame to `path`, as raw RGB if it ends in .rgb and Y4M
+// otherwise, and the sound next to it as WAV.
+auto capture(std::string const& path, char const *rom, double seconds) -> int
+{
+    Console console{rom, sample_rate};
+    auto const dot = path.rfind('.');
+    auto const stem = path.substr(0, dot);
+    auto const format = dot != std::string::npos && path.substr(dot) == ".rgb" ? fce::VideoFormat::rgb
+                                                                               : fce::VideoFormat::y4m;
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    fce::VideoCapture video{file, format, fce::Ppu::width, fce::Ppu::height};
+    auto& ppu = console.ppu();
+    ppu.output(video.frame(), fce::Ppu::width);
+    ppu.on_frame([&](fce::u8 const *) {
+        video.submit();
+        ppu.output(video.frame(), fce::Ppu::width);
+    });
+    WavDump audio{stem + ".wav", console.apu()};
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const frames = long(seconds * 60);
+    for (long i = 0; i < frames; i++) {
+        console.run_frame();
+        audio.wait();
+    }
+    video.finish();
+    audio.finish();
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    spdlog::info("{} frames in {:.2f} s, {} stalls on the writer", video.frames(), elapsed.count(), video.stalls());
+    return 0;
+}
+
+// Runs `rom` for `seconds` of frames as fast as it goes, while a headless
+// presenter refreshing at 60 Hz takes the newest frame from a TripleBuffer.
+auto present(char const *rom, double seconds) -> int
+{
+    Console console{rom, sample_rate};
+    fce::TripleBuffer frames{std::size_t{fce::Ppu::width} * fce::Ppu::height};
+    auto& ppu = console.ppu();
+    ppu.output(frames.back(), fce::Ppu::width);
+    ppu.on_frame([&](fce::u8 const *) {
+        frames.publish();
+        ppu.output(frames.back(), fce::Ppu::width);
+    });
+
+    std::atomic<bool> done{false};
+    fce::u64 presented = 0;
+    std::thread presenter{[&] {
+        auto refresh = std::chrono::steady_clock::now();
+        while (!done.load(std::memory_order_relaxed)) {
+            refresh += std::chrono::microseconds{16639};
+            std::this_thread::sleep_until(refresh);
+            presented += frames.present();
+        }
+    }};
+
+    auto const count = long(seconds * 60);
+    for (long i = 0; i < count; i++) {
+        console.run_frame();
+    }
+    done.store(true, std::memory_order_relaxed);
+    presenter.join();
+    spdlog::info("{} frames, {} presented, {} dropped, {} duplicated", frames.published(), presented,
+                 frames.dropped(), frames.duplicated());
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    try {
+        // fce-app --wav out.wav rom.nes [seconds]: headless, sound to a file
+        if (argc > 3 && std::strcmp(argv[1], "--wav") == 0) {
+            return dump_wav(argv[2], argv[3], argc > 4 ? std::atof(argv[4]) : 10.0);
+        }
+        // fce-app --capture out.y4m|out.rgb rom.nes [seconds]: every frame,
+        // and the sound to out.wav
+        if (argc > 3 && std::strcmp(argv[1], "--capture") == 0) {
+            return capture(argv[2], argv[3], argc > 4 ? std::atof(argv[4]) : 10.0);
+        }
+        // fce-app --present rom.nes [seconds]: frames to a headless display
+        if (argc > 2 && std::strcmp(argv[1], "--present") == 0) {
+            return present(argv[2], argc > 3 ? std::atof(argv[3]) : 10.0);
+        }
+    } catch (std::exception const& e) {
+        spdlog::error("{}", e.what());
+        return 1;
+    }
+
     // spdlog::set_level(spdlog::level::trace);
 
     auto memory = std::make_shared<Memory>();
-    fce::CPU cpu{memory};
 
-    for (int i = 0; i < 800; i++) {
-        cpu.step();
+    // Only the page holding the output hook goes through Memory::set().
+    fce::Bus bus;
+    bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+    bus.map_io(0x00, 0x00, memory);
+
+    // fce-app [trace]: also saves a trace of the run for fce-trace
+    if (argc > 1) {
+        fce::CPU<fce::Bus, fce::TraceBuffer> cpu{bus};
+        cpu.run(2800);
+
+        std::ofstream file{argv[1], std::ios::binary};
+        cpu.tracer().save(file);
+        return 0;
     }
+
+    fce::CPU cpu{bus};
+
+    cpu.run(2800);
 }
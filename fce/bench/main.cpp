@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <fce/fce.hpp>
+
+namespace {
+
+// A small loop touching most addressing modes: indexed loads and stores,
+// zero page indirection, immediate arithmetic, stack operations and
+// JSR/RTS. Relative branches only jump forward, so the loop closes with JMP.
+template <typename Memory>
+auto load_program(Memory& memory) -> void
+{
+    fce::u16 addr = 0x8000;
+    for (auto e : {
+        0xA2, 0x00,         // 8000  LDX #$00
+        0xBD, 0x00, 0x02,   // 8002  LDA $0200,X
+        0x69, 0x01,         // 8005  ADC #$01
+        0x9D, 0x00, 0x02,   // 8007  STA $0200,X
+        0x51, 0x10,         // 800A  EOR ($10),Y
+        0x85, 0x20,         // 800C  STA $20
+        0xE6, 0x21,         // 800E  INC $21
+        0xE8,               // 8010  INX
+        0xD0, 0x03,         // 8011  BNE $8016
+        0x4C, 0x00, 0x80,   // 8013  JMP $8000
+        0x20, 0x20, 0x80,   // 8016  JSR $8020
+        0x4C, 0x02, 0x80,   // 8019  JMP $8002
+    })
+    {
+        memory.set(addr++, fce::u8(e));
+    }
+
+    addr = 0x8020;
+    for (auto e : {
+        0x48,               // 8020  PHA
+        0x0A,               // 8021  ASL A
+        0x68,               // 8022  PLA
+        0x18,               // 8023  CLC
+        0x60,               // 8024  RTS
+    })
+    {
+        memory.set(addr++, fce::u8(e));
+    }
+
+    memory.set(0x0010, 0x00);
+    memory.set(0x0011, 0x03);
+    memory.set(0xFFFC, 0x00);
+    memory.set(0xFFFD, 0x80);
+}
+
+// Runs in batches of one NTSC frame until `n` instructions are executed.
+template <typename CPU>
+auto run_instructions(CPU& cpu, long n) -> void
+{
+    long executed = 0;
+    while (executed < n) {
+        cpu.run_until(29781, [&](fce::Registers const&) { return ++executed >= n; });
+    }
+}
+
+// Runs in batches of one NTSC frame until `cycles` cycles have elapsed, for
+// engines that only run to a cycle budget.
+template <typename CPU>
+auto run_cycles(CPU& cpu, fce::u64 cycles) -> void
+{
+    auto const end = cpu.cycles() + cycles;
+    while (cpu.cycles() < end) {
+        cpu.run(std::min<fce::u64>(29781, end - cpu.cycles()));
+    }
+}
+
+// The cycles the benchmark program takes for `n` instructions.
+auto cycles_of(long n) -> fce::u64
+{
+    fce::FlatRamBus bus;
+    load_program(bus);
+    fce::CPU<fce::FlatRamBus> cpu{bus};
+    auto const start = cpu.cycles();
+    run_instructions(cpu, n);
+    return cpu.cycles() - start;
+}
+
+// `count` things done by `run(count)` per second, the best of three runs to
+// dampen noise from the rest of the machine.
+template <typename F>
+auto best_rate(long count, F&& run) -> double
+{
+    using Clock = std::chrono::steady_clock;
+
+    double best = 0.0;
+    for (int i = 0; i < 3; i++) {
+        auto const start = Clock::now();
+        run(count);
+        std::chrono::duration<double> const elapsed = Clock::now() - start;
+        auto const rate = double(count) / elapsed.count();
+        if (rate > best) {
+            best = rate;
+        }
+    }
+    return best;
+}
+
+template <typename F>
+auto measure(char const *name, long instructions, F&& run) -> void
+{
+    std::printf("%-32s %10.2f M instructions/s\n", name, best_rate(instructions, run) / 1e6);
+}
+
+// A cartridge for PPU benchmarks: NROM with 8 KiB of CHR ROM holding
+// arbitrary patterns.
+auto open_rom() -> fce::Rom
+{
+    constexpr char const *path = "fce-bench.nes";
+    {
+        std::ofstream file{path, std::ios::binary};
+        char const header[16] = {'N', 'E', 'S', 0x1A, 1, 1};
+        file.write(header, sizeof header);
+        for (unsigned i = 0; i < 0x4000 + 0x2000; i++) {
+            file.put(char(i * 167 >> 3));
+        }
+    }
+    fce::Rom rom{path};
+    std::remove(path);
+    return rom;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    long instructions = 50'000'000;
+    if (argc > 1) {
+        instructions = std::atol(argv[1]);
+    }
+
+    measure("CPU<Bus> (Memory)", instructions, [](long n) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::CPU cpu{memory};
+        for (long i = 0; i < n; i++) {
+            cpu.step();
+        }
+    });
+
+    measure("CPU<Bus> (RAM pages)", instructions, [](long n) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::Bus bus;
+        bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+        fce::CPU cpu{bus};
+        for (long i = 0; i < n; i++) {
+            cpu.step();
+        }
+    });
+
+    measure("CPU<FlatRamBus>", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus> cpu{bus};
+        for (long i = 0; i < n; i++) {
+            cpu.step();
+        }
+    });
+
+    measure("CPU<Bus>::run", instructions, [](long n) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::Bus bus;
+        bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+        fce::CPU cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    measure("CPU<FlatRamBus>::run", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus> cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    // as above, at Accuracy::fast
+    measure("CPU<Bus>::run fast", instructions, [](long n) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::Bus bus;
+        bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+        fce::CPU<fce::Bus, fce::NoTrace, fce::Ricoh2A03, fce::Accuracy::fast> cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    measure("CPU<FlatRamBus>::run fast", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus, fce::NoTrace, fce::Ricoh2A03, fce::Accuracy::fast> cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    measure("CPU<Bus>::run cached", instructions, [](long n) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::Bus bus;
+        bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+        fce::CPU cpu{bus};
+        cpu.engine(fce::Engine::block_cache);
+        run_instructions(cpu, n);
+    });
+
+    measure("CPU<FlatRamBus>::run cached", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus> cpu{bus};
+        cpu.engine(fce::Engine::block_cache);
+        run_instructions(cpu, n);
+    });
+
+    auto const cycles = cycles_of(instructions);
+
+    measure("CPU<Bus>::run recompiled", instructions, [cycles](long) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::Bus bus;
+        bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+        fce::CPU cpu{bus};
+        cpu.engine(fce::Engine::recompiler);
+        run_cycles(cpu, cycles);
+    });
+
+    measure("CPU<FlatRamBus>::run recompiled", instructions, [cycles](long) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus> cpu{bus};
+        cpu.engine(fce::Engine::recompiler);
+        run_cycles(cpu, cycles);
+    });
+
+    measure("CPU<FlatRamBus>::run traced", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus, fce::TraceBuffer> cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    measure("CPU<FlatRamBus>::run profiled", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus, fce::Profiler> cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    measure("CPU<FlatRamBus>::run covered", instructions, [](long n) {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus, fce::Coverage> cpu{bus};
+        run_instructions(cpu, n);
+    });
+
+    // as CPU<Bus>::run, but stopping for an event every scanline
+    measure("CPU<Bus>::run + events", instructions, [](long n) {
+        auto memory = std::make_shared<fce::Memory>();
+        load_program(*memory);
+        fce::Bus bus;
+        bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+        fce::CPU cpu{bus};
+
+        fce::Scheduler scheduler;
+        scheduler.on(fce::Event::ppu_scanline, [&](fce::u64 timestamp) {
+            scheduler.schedule(fce::Event::ppu_scanline, timestamp + 114);
+        });
+        scheduler.schedule(fce::Event::ppu_scanline, cpu.cycles() + 114);
+
+        long executed = 0;
+        while (executed < n) {
+            cpu.run_until(scheduler.next() - cpu.cycles(), [&](fce::Registers const&) { return ++executed >= n; });
+            scheduler.dispatch(cpu.cycles());
+        }
+    });
+    // frames of a full nametable with 64 sprites on screen, by the clock, in
+    // RGBA
+    {
+        auto const rom = open_rom();
+        fce::Ppu ppu{fce::make_mapper(rom)};
+        fce::u64 now = 0;
+        fce::Scheduler scheduler;
+        ppu.attach(scheduler, [&] { return now; }, [] {});
+        ppu.set(0x2006, 0x20);
+        ppu.set(0x2006, 0x00);
+        for (unsigned i = 0; i < 0x400; i++) {
+            ppu.set(0x2007, fce::u8(i * 7));
+        }
+        fce::u8 oam[256];
+        for (unsigned i = 0; i < 256; i++) {
+            oam[i] = fce::u8(i * 13);
+        }
+        ppu.oam_dma(oam);
+        ppu.set(0x2001, 0x1E);
+        std::vector<fce::u32> framebuffer(std::size_t{fce::Ppu::width} * fce::Ppu::height);
+        ppu.output(framebuffer.data(), fce::Ppu::width);
+
+        auto const frames = long(instructions / 50'000);
+        auto const rate = best_rate(frames, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                now += 29781;
+                scheduler.dispatch(now);
+            }
+        });
+        std::printf("%-32s %10.2f frames/s\n", "Ppu", rate);
+    }
+    // the FlatRamBus program on 64 machines, one NTSC frame per step_all()
+    auto const initial = std::make_unique<fce::Savestate>();
+    {
+        fce::FlatRamBus bus;
+        load_program(bus);
+        fce::CPU<fce::FlatRamBus> cpu{bus};
+        initial->cpu = cpu.state();
+        std::copy(cpu.bus().data(), cpu.bus().data() + 0x10000, initial->memory.begin());
+    }
+    for (auto threads : {std::size_t{1}, std::size_t{0}}) {
+        fce::BatchRunner batch{64, *initial, threads};
+        char name[64];
+        std::snprintf(name, sizeof name, "BatchRunner (%zu threads)", batch.threads());
+        measure(name, instructions, [&](long) {
+            for (fce::u64 elapsed = 0; elapsed < cycles / batch.size(); elapsed += 29781) {
+                batch.step_all(29781);
+            }
+        });
+    }
+    // the same, as 16 lanes running in lockstep, by the scalar handlers and
+    // by the kernels of the CPU
+    for (auto simd : {fce::Simd::none, fce::detect_simd()}) {
+        fce::Lockstep<16> lockstep{simd};
+        char name[64];
+        std::snprintf(name, sizeof name, "Lockstep<16> (%s)", lockstep.simd() == fce::Simd::avx2 ? "avx2" : "scalar");
+        measure(name, instructions, [&](long) {
+            for (std::size_t lane = 0; lane < lockstep.lanes(); lane++) {
+                lockstep.state(lane, initial->cpu);
+                lockstep.load(lane, initial->memory.data());
+            }
+            for (fce::u64 elapsed = 0; elapsed < cycles / lockstep.lanes(); elapsed += 29781) {
+                lockstep.run(29781);
+            }
+        });
+    }
+}
@@ -0,0 +1,213 @@
+#ifndef FCE_APU_HPP_
+#define FCE_APU_HPP_
+
+#include <array>
+#include <functional>
+
+#include <fce/types.hpp>
+#include <fce/audio.hpp>
+#include <fce/blip_buffer.hpp>
+#include <fce/memory.hpp>
+#include <fce/scheduler.hpp>
+
+namespace fce {
+
+// The NTSC 2A03 sound: two pulse channels, triangle, noise, DMC and the
+// frame counter, at $4000-$4013, $4015 and $4017.
+//
+// Channels are run from one change of their output to the next, not a cycle
+// at a time: every change goes into a BlipBuffer as a band-limited step at
+// the CPU cycle it happens. The frame counter ends a block of the buffer at
+// each of its steps, about every 4 ms, and the block's samples go to the
+// AudioRing given to output(), if any. The emulation thread never waits for
+// the ring; samples that don't fit are dropped and counted.
+//
+// Channels are mixed by the usual linear approximation of the non-linear
+// mixer. The DMC's reads don't stall the CPU.
+//
+// Like the PPU, the APU is a Component: register accesses bring it up to the
+// clock, and so does Event::apu_frame_counter, scheduled for the frame
+// counter's steps and for the end of a DMC sample that raises an IRQ.
+class Apu : public Memory, public Component
+{
+public:
+    // The master clock, in CPU cycles, the IRQ line of the CPU, and reads of
+    // the CPU bus for DMC samples.
+    using Clock = std::function<u64()>;
+    using IrqLine = std::function<void(bool)>;
+    using Reader = std::function<u8(u16 addr)>;
+
+    static constexpr double cpu_rate = 1789773.0;
+
+    explicit Apu(u32 sample_rate = 48000);
+
+    auto get(u16 addr) const noexcept -> u8 override;
+    auto set(u16 addr, u8 v) noexcept -> void override;
+
+    // Connects the APU to the machine. It keeps time by `clock`, in CPU
+    // cycles, clocks the frame counter through `scheduler`, raises frame and
+    // DMC IRQs through `irq` and fetches DMC samples through `read`.
+    auto attach(Scheduler& scheduler, Clock clock, IrqLine irq, Reader read) -> void;
+
+    // Pushes samples to `ring`, or drops them if it is null.
+    auto output(AudioRing *ring) noexcept -> void { ring_ = ring; }
+
+    auto sample_rate() const noexcept -> u32 { return sample_rate_; }
+    // Samples made, and those of them the ring had no room for.
+    auto samples() const noexcept -> u64 { return samples_; }
+    auto dropped() const noexcept -> u64 { return dropped_; }
+
+protected:
+    // Runs the channels, and the frame counter steps, before `to`.
+    auto advance(u64 from, u64 to) -> void override;
+
+private:
+    struct Envelope
+    {
+        bool start = false;
+        bool loop = false;  // also halts the length counter
+        bool constant = false;
+        u8 period = 0;      // or the constant volume
+        u8 divider = 0;
+        u8 decay = 0;
+
+        auto clock() noexcept -> void;
+        auto volume() const noexcept -> u8 { return constant ? period : decay; }
+    };
+
+    struct Pulse
+    {
+        Envelope envelope;
+        u8 duty = 0;
+        u8 step = 0;
+        u16 timer = 0;
+        u8 length = 0;
+        bool sweep_enabled = false;
+        bool sweep_negate = false;
+        bool sweep_reload = false;
+        u8 sweep_period = 0;
+        u8 sweep_shift = 0;
+        u8 sweep_divider = 0;
+        bool ones_complement = false;  // how pulse 1 negates
+        u64 next = 0;  // the next clock of the timer
+
+        auto target() const noexcept -> int;
+        auto muted() const noexcept -> bool;
+        auto sweep() noexcept -> void;
+        auto output() const noexcept -> int;
+    };
+
+    struct Triangle
+    {
+        bool control = false;  // also halts the length counter
+        bool reload = false;
+        u8 linear_period = 0;
+        u8 linear = 0;
+        u8 step = 0;
+        u16 timer = 0;
+        u8 length = 0;
+        u64 next = 0;
+
+        auto running() const noexcept -> bool { return length && linear && timer >= 2; }
+        auto output() const noexcept -> int;
+    };
+
+    struct Noise
+    {
+        Envelope envelope;
+        bool mode = false;
+        u8 period = 0;
+        u16 shift = 1;
+        u8 length = 0;
+        u64 next = 0;
+
+        auto output() const noexcept -> int;
+    };
+
+    struct Dmc
+    {
+        bool irq_enabled = false;
+        bool loop = false;
+        u8 rate = 0;
+        u8 level = 0;
+        u16 start = 0xC000;
+        u16 size = 1;
+        u16 address = 0xC000;
+        u16 remaining = 0;  // bytes left to fetch
+        u8 buffer = 0;
+        bool buffered = false;
+        u8 shift = 0;
+        u8 bits = 8;
+        bool silent = true;
+        u64 next = 0;
+    };
+
+    enum Channel : unsigned
+    {
+        pulse1,
+        pulse2,
+        triangle,
+        noise,
+        dmc,
+    };
+
+    u32 sample_rate_;
+    BlipBuffer blip_;
+    u64 block_start_ = 0;
+
+    std::array<Pulse, 2> pulses_;
+    Triangle triangle_;
+    Noise noise_;
+    Dmc dmc_;
+    std::array<int, 5> outputs_{};  // of every channel, as last added
+    u8 enabled_ = 0;
+
+    // the frame counter: the step to take next in the sequence started at
+    // frame_start_
+    bool five_step_ = false;
+    bool irq_inhibit_ = false;
+    bool frame_irq_ = false;
+    bool dmc_irq_ = false;
+    unsigned step_ = 0;
+    u64 frame_start_ = 0;
+
+    AudioRing *ring_ = nullptr;
+    u64 samples_ = 0;
+    u64 dropped_ = 0;
+
+    Scheduler *scheduler_ = nullptr;
+    Clock clock_;
+    IrqLine irq_;
+    Reader read_;
+
+    auto read(u16 addr) noexcept -> u8;
+    auto write(u16 addr, u8 v) noexcept -> void;
+    auto sync() noexcept -> void;
+
+    auto next_step() const noexcept -> u64;
+    auto step_frame(u64 now) noexcept -> void;
+    auto quarter_frame() noexcept -> void;
+    auto half_frame() noexcept -> void;
+    // Schedules the next frame counter step or DMC IRQ.
+    auto schedule() -> void;
+    auto update_irq() noexcept -> void;
+
+    // Runs each channel's timer before `to`.
+    auto run(u64 to) noexcept -> void;
+    auto run_pulse(Channel channel, u64 to) noexcept -> void;
+    auto run_triangle(u64 to) noexcept -> void;
+    auto run_noise(u64 to) noexcept -> void;
+    auto run_dmc(u64 to) noexcept -> void;
+    auto fetch_sample() noexcept -> void;
+
+    // Adds the change of `channel`'s output to `output`, if any, at `time`.
+    auto update(Channel channel, int output, u64 time) noexcept -> void;
+    // ...for every channel, after a register write or a frame counter step.
+    auto update_all(u64 time) noexcept -> void;
+    // Ends the block at `time` and hands its samples on.
+    auto flush(u64 time) noexcept -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_APU_HPP_
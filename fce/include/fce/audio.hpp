@@ -0,0 +1,71 @@
+#ifndef FCE_AUDIO_HPP_
+#define FCE_AUDIO_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <thread>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/spsc_ring.hpp>
+
+namespace fce {
+
+// Samples from the emulation thread, the producer, to the audio thread.
+using AudioRing = SpscRing<s16>;
+
+// Writes 16-bit mono PCM as a WAV file. The sizes in the header are filled
+// in by finish(), which needs `out` to be seekable.
+class WavWriter
+{
+public:
+    WavWriter(std::ostream& out, u32 sample_rate);
+
+    auto write(s16 const *samples, std::size_t count) -> void;
+    auto finish() -> void;
+
+    auto samples() const noexcept -> u64 { return samples_; }
+
+private:
+    std::ostream& out_;
+    u32 sample_rate_;
+    u64 samples_ = 0;
+
+    auto header() -> void;
+};
+
+// A thread that drains an AudioRing into `sink`, e.g. a sound device or a
+// WavWriter, in blocks of up to `block` samples. The emulation thread only
+// ever pushes to the ring; when the ring runs dry the audio thread sleeps
+// for a millisecond rather than wait on anything the producer must signal.
+// `sink` must not throw.
+class AudioThread
+{
+public:
+    using Sink = std::function<void(s16 const *samples, std::size_t count)>;
+
+    AudioThread(AudioRing& ring, Sink sink, std::size_t block = 1024);
+    ~AudioThread();
+
+    AudioThread(AudioThread const&) = delete;
+    auto operator=(AudioThread const&) -> AudioThread& = delete;
+
+    // Drains what is left in the ring and joins the thread.
+    auto stop() -> void;
+
+private:
+    AudioRing& ring_;
+    Sink sink_;
+    std::vector<s16> block_;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+
+    auto run() noexcept -> void;
+    auto drain() -> std::size_t;
+};
+
+}  // namespace fce
+
+#endif  // FCE_AUDIO_HPP_
@@ -0,0 +1,65 @@
+#ifndef FCE_BATCH_RUNNER_HPP_
+#define FCE_BATCH_RUNNER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/savestate.hpp>
+#include <fce/thread_pool.hpp>
+
+namespace fce {
+
+// Many independent machines started from the same Savestate and stepped
+// together, e.g. to search or to train against thousands of runs of a
+// program.
+//
+// A machine is a CPU<FlatRamBus>, which holds its 64 KiB of RAM inline, and
+// the machines sit side by side in one allocation. The views returned by
+// cpu() and ram() point straight into it. Resetting and seeding a machine
+// copies bytes without allocating, and resetting copies only the pages the
+// machine wrote since, as its bus tracks them. Writes through ram() are not
+// tracked, and must be undone by the caller before a reset.
+class BatchRunner
+{
+public:
+    using Machine = CPU<FlatRamBus>;
+
+    // `count` machines in the state of `initial`, interpreting; see
+    // ThreadPool for `threads`.
+    BatchRunner(std::size_t count, Savestate const& initial, std::size_t threads = 0);
+
+    auto size() const noexcept -> std::size_t { return machines_.size(); }
+    auto threads() const noexcept -> std::size_t { return pool_.size(); }
+
+    // Runs every machine for at least `cycles` cycles, see CPU::run().
+    auto step_all(u64 cycles) -> void;
+
+    // Returns machine `i` to the initial state.
+    auto reset(std::size_t i) noexcept -> void;
+    // Like reset(), and then stores `seed` little endian in the 8 bytes from
+    // seed_address(), for the program to pick up, e.g. to seed a PRNG.
+    auto reset(std::size_t i, u64 seed) noexcept -> void;
+
+    // $00F8 unless changed.
+    auto seed_address() const noexcept -> u16 { return seed_address_; }
+    auto seed_address(u16 addr) noexcept -> void { seed_address_ = addr; }
+
+    auto cpu(std::size_t i) noexcept -> Machine& { return machines_[i]; }
+    auto cpu(std::size_t i) const noexcept -> Machine const& { return machines_[i]; }
+    auto ram(std::size_t i) noexcept -> u8 * { return machines_[i].bus().data(); }
+    auto ram(std::size_t i) const noexcept -> u8 const * { return machines_[i].bus().data(); }
+
+private:
+    std::unique_ptr<Savestate> initial_;
+    std::vector<Machine> machines_;
+    u16 seed_address_ = 0x00F8;
+    ThreadPool pool_;
+};
+
+}  // namespace fce
+
+#endif  // FCE_BATCH_RUNNER_HPP_
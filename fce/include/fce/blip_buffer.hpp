@@ -0,0 +1,66 @@
+#ifndef FCE_BLIP_BUFFER_HPP_
+#define FCE_BLIP_BUFFER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// Band-limited step synthesis: a waveform is described by the changes of its
+// amplitude, at the clock rate of whatever produces it, and each change is
+// added to the output as a band-limited step rather than a sharp one, so
+// that a square wave at the CPU clock comes out at the sample rate without
+// aliasing. Nothing is computed for the clocks in between.
+//
+// Changes are added for a block of clocks, then end_block() resamples the
+// block, and read() hands out the samples, with DC removed.
+class BlipBuffer
+{
+public:
+    // Steps start at one of `phases` fractions of a sample, and spread over
+    // `taps` samples.
+    static constexpr std::size_t phases = 32;
+    static constexpr std::size_t taps = 16;
+
+    // Room for the samples of blocks up to `max_clocks` long.
+    BlipBuffer(double clock_rate, double sample_rate, u64 max_clocks);
+
+    auto sample_rate() const noexcept -> double { return sample_rate_; }
+
+    // Adds a change of the amplitude by `delta`, in 16-bit sample units, at
+    // `time` clocks from the start of the block.
+    auto add_delta(u64 time, int delta) noexcept -> void;
+
+    // Ends the block at `time` clocks from its start; the next one starts
+    // there. The samples before it become available.
+    auto end_block(u64 time) noexcept -> void;
+
+    auto available() const noexcept -> std::size_t { return available_; }
+
+    // Takes up to `count` samples into `out`, and returns how many.
+    auto read(s16 *out, std::size_t count) noexcept -> std::size_t;
+
+    auto clear() noexcept -> void;
+
+private:
+    // Steps for every phase, each summing to 1 << 15.
+    using Kernels = std::array<std::array<s32, taps>, phases>;
+
+    static Kernels const kernels_;
+
+    double sample_rate_;
+    u64 factor_;  // samples per clock, as 32.32 fixed point
+    u64 offset_;  // of the start of the block, in samples, 32.32 fixed point
+    std::size_t available_;
+    s64 sum_;     // the running integral of the deltas read
+    std::vector<s32> deltas_;
+
+    static auto make_kernels() -> Kernels;
+};
+
+}  // namespace fce
+
+#endif  // FCE_BLIP_BUFFER_HPP_
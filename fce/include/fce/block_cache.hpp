@@ -0,0 +1,109 @@
+#ifndef FCE_BLOCK_CACHE_HPP_
+#define FCE_BLOCK_CACHE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/code_cache.hpp>
+#include <fce/instructions.hpp>
+
+namespace fce {
+
+// Instructions decoded ahead of execution, in basic blocks keyed by the PC
+// of their first instruction. A block is a straight run of instructions up
+// to and including the next branch, jump, call, return or BRK.
+//
+// A decoded instruction is its opcode and operand bytes, so executing it
+// needs nothing from the bus. Its cycle cost is still counted by the
+// instruction itself, since it depends on page crossings and on branches
+// being taken.
+//
+// Blocks stay valid until a page they were decoded from is written through
+// the CPU or invalidated explicitly.
+class BlockCache : public CodeCache
+{
+public:
+    struct Op
+    {
+        u8 opcode;
+        std::array<u8, 2> operand;
+    };
+
+    // Ops [first, first + size) of op().
+    struct Block
+    {
+        u32 first;
+        u32 size;
+    };
+
+    // The cache is flushed as a whole once it holds this many ops.
+    static constexpr std::size_t capacity = std::size_t{1} << 16;
+    static constexpr std::size_t max_block_size = 32;
+
+    BlockCache();
+
+    // The block starting at `pc`, decoded first with `read(addr) -> u8` if it
+    // is not cached. `read` must not have side effects.
+    template <typename Read>
+    auto find(u16 pc, Read&& read) -> Block
+    {
+        if (auto const entry = entries_[pc]) {
+            return blocks_[entry - 1];
+        }
+        return this->decode(pc, read);
+    }
+
+    auto op(u32 i) const noexcept -> Op const& { return ops_[i]; }
+
+    auto invalidate(u8 page) noexcept -> void override;
+    auto flush() noexcept -> void;
+
+private:
+    std::vector<Op> ops_;
+    std::vector<Block> blocks_;
+    std::vector<u32> entries_;  // index into blocks_ + 1 for each PC, or 0
+    std::array<std::vector<u16>, 0x100> pages_;  // start of the blocks on each page
+
+    static auto ends_block(u8 opcode) noexcept -> bool;
+
+    // Registers the block just decoded into ops_, spanning [pc, last].
+    auto insert(u16 pc, u16 last, Block block) -> Block;
+
+    template <typename Read>
+    auto decode(u16 pc, Read& read) -> Block
+    {
+        if (ops_.size() + max_block_size > capacity) {
+            this->flush();
+        }
+
+        Block block{u32(ops_.size()), 0};
+        u16 addr = pc;
+        u16 last = pc;
+        for (std::size_t i = 0; i < max_block_size; i++) {
+            auto const opcode = read(addr);
+            auto const size = operand_size(addressing_modes[opcode]);
+
+            Op op{opcode, {}};
+            for (unsigned j = 0; j < size; j++) {
+                op.operand[j] = read(u16(addr + 1 + j));
+            }
+            ops_.push_back(op);
+            ++block.size;
+
+            last = u16(addr + size);
+            auto const next = u16(last + 1);
+            if (ends_block(opcode) || next < addr) {
+                break;
+            }
+            addr = next;
+        }
+
+        return this->insert(pc, last, block);
+    }
+};
+
+}  // namespace fce
+
+#endif  // FCE_BLOCK_CACHE_HPP_
@@ -0,0 +1,101 @@
+#ifndef FCE_BUS_HPP_
+#define FCE_BUS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/memory.hpp>
+
+namespace fce {
+
+// The CPU address space as 256 pages of 256 bytes. A page either points
+// straight at backing bytes (RAM, mirrored RAM, ROM banks), so an access is a
+// single load or store, or routes to an I/O handler. Unmapped pages read as
+// 0x00 and ignore writes.
+//
+// Backing bytes are not owned by the bus and must outlive it. Handlers are
+// shared with the bus.
+//
+// Pages written through RAM mapped directly are marked dirty, so that what a
+// run wrote can be told without handlers in the way, see reset_to().
+class Bus
+{
+public:
+    Bus() noexcept;
+
+    // Routes every page to `memory`.
+    explicit Bus(std::shared_ptr<Memory> memory) noexcept;
+
+    // Maps pages [first, last] onto `data`, repeating every `size` bytes.
+    // `size` must be a multiple of the page size.
+    auto map_ram(u8 first, u8 last, u8 *data, std::size_t size) noexcept -> void;
+    // Same as map_ram(), but writes are ignored.
+    auto map_rom(u8 first, u8 last, u8 const *data, std::size_t size) noexcept -> void;
+    auto map_io(u8 first, u8 last, std::shared_ptr<Memory> handler) -> void;
+    auto unmap(u8 first, u8 last) noexcept -> void;
+
+    // The backing bytes of every page, or null for pages that are not
+    // mapped directly, for code that resolves accesses itself.
+    auto read_pages() const noexcept -> u8 const *const * { return read_.data(); }
+    auto write_pages() const noexcept -> u8 *const * { return write_.data(); }
+
+    // Pages written through map_ram() mappings since the last clean(). Every
+    // page starts dirty. Code that writes through write_pages() itself marks
+    // the page in dirty_pages().
+    auto dirty(u8 page) const noexcept -> bool { return dirty_[page]; }
+    auto dirty_pages() noexcept -> bool * { return dirty_.data(); }
+    auto clean() noexcept -> void { dirty_.fill(false); }
+
+    auto get(u16 addr) const noexcept -> u8
+    {
+        auto const page = std::size_t{addr} >> 8;
+        if (auto const data = read_[page]) {
+            return data[addr & 0xFF];
+        }
+        if (auto const handler = io_[page]) {
+            return handler->get(addr);
+        }
+        return 0x00;
+    }
+
+    auto set(u16 addr, u8 v) noexcept -> void
+    {
+        auto const page = std::size_t{addr} >> 8;
+        if (auto const data = write_[page]) {
+            data[addr & 0xFF] = v;
+            dirty_[page] = true;
+        } else if (auto const handler = io_[page]) {
+            handler->set(addr, v);
+        }
+    }
+
+    // Whether reads of `addr` are free of side effects and stable, see
+    // Memory::stable(). Directly mapped and unmapped pages are, handlers are
+    // asked.
+    auto stable(u16 addr) const noexcept -> bool
+    {
+        auto const page = std::size_t{addr} >> 8;
+        if (read_[page]) {
+            return true;
+        }
+        if (auto const handler = io_[page]) {
+            return handler->stable(addr);
+        }
+        return true;
+    }
+
+private:
+    std::array<u8 const *, 0x100> read_;
+    std::array<u8 *, 0x100> write_;
+    std::array<Memory *, 0x100> io_;
+    std::array<bool, 0x100> dirty_;
+
+    std::vector<std::shared_ptr<Memory>> handlers_;
+};
+
+}  // namespace fce
+
+#endif  // FCE_BUS_HPP_
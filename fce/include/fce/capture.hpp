@@ -0,0 +1,82 @@
+#ifndef FCE_CAPTURE_HPP_
+#define FCE_CAPTURE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <thread>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/spsc_ring.hpp>
+
+namespace fce {
+
+enum class VideoFormat : u8
+{
+    y4m,  // YUV4MPEG2, 4:2:0 full range, at the NTSC frame rate
+    rgb,  // bare 24-bit RGB frames
+};
+
+// Records every frame, unlike a TripleBuffer, without the emulation thread
+// writing anything: frames are drawn into one of `depth` buffers, queued,
+// and converted and written by a thread of the capture's own, which
+// gathers them into writes of at least `batch` bytes.
+//
+// The queue is a pair of SpscRings of buffer indices, one of free buffers and
+// one of full ones. Only when every buffer is queued does frame() wait for
+// the writer, which is how a capture running faster than the disk is held
+// back; stalls() counts those waits.
+class VideoCapture
+{
+public:
+    // Frames of `width` x `height` RGBA pixels, as Ppu::output() writes them,
+    // to `out`. `width` and `height` must be even.
+    VideoCapture(std::ostream& out, VideoFormat format, unsigned width, unsigned height, std::size_t depth = 32,
+                 std::size_t batch = std::size_t{4} << 20);
+    ~VideoCapture();
+
+    VideoCapture(VideoCapture const&) = delete;
+    auto operator=(VideoCapture const&) -> VideoCapture& = delete;
+
+    // The buffer to draw the next frame into, the same until it is submitted.
+    auto frame() -> u32 *;
+    // Queues the frame drawn.
+    auto submit() -> void;
+
+    // Writes everything queued and stops the writer.
+    auto finish() -> void;
+
+    auto frames() const noexcept -> u64 { return frames_; }
+    auto stalls() const noexcept -> u64 { return stalls_; }
+
+private:
+    static constexpr std::size_t none = ~std::size_t{0};
+
+    std::ostream& out_;
+    VideoFormat format_;
+    unsigned width_;
+    unsigned height_;
+    std::size_t batch_;
+    std::vector<u32> buffers_;
+    SpscRing<std::size_t> free_;
+    SpscRing<std::size_t> full_;
+    std::size_t current_ = none;
+    u64 frames_ = 0;
+    u64 stalls_ = 0;
+
+    std::vector<char> pending_;  // converted frames not yet written
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+
+    auto size() const noexcept -> std::size_t { return std::size_t{width_} * height_; }
+
+    auto run() noexcept -> void;
+    auto drain() -> std::size_t;
+    auto convert(u32 const *pixels) -> void;
+    auto write() -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_CAPTURE_HPP_
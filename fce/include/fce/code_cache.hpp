@@ -0,0 +1,43 @@
+#ifndef FCE_CODE_CACHE_HPP_
+#define FCE_CODE_CACHE_HPP_
+
+#include <array>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// Execution engines of CPU.
+enum class Engine
+{
+    interpreter,  // decodes every instruction from the bus
+    block_cache,  // executes pre-decoded basic blocks, see BlockCache
+    recompiler,   // executes basic blocks translated to host code, see Recompiler
+};
+
+// Code derived from the instructions in memory, which goes stale when that
+// memory is written. The CPU checks code_page() on every store and drops
+// the page.
+class CodeCache
+{
+public:
+    virtual ~CodeCache() = default;
+
+    auto code_page(u16 addr) const noexcept -> bool { return code_pages_[addr >> 8]; }
+    auto code_pages() const noexcept -> bool const * { return code_pages_.data(); }
+
+    // Drops the code decoded from `page`.
+    virtual auto invalidate(u8 page) noexcept -> void = 0;
+
+protected:
+    CodeCache() noexcept
+        : code_pages_{}
+    {
+    }
+
+    std::array<bool, 0x100> code_pages_;
+};
+
+}  // namespace fce
+
+#endif  // FCE_CODE_CACHE_HPP_
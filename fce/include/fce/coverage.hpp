@@ -0,0 +1,75 @@
+#ifndef FCE_COVERAGE_HPP_
+#define FCE_COVERAGE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+
+#include <fce/types.hpp>
+#include <fce/trace.hpp>
+
+namespace fce {
+
+// A tracer for CPU<BusType, Coverage> that marks which addresses were
+// executed as instructions and which were read as data, one bit per address
+// each. An instruction costs an OR, and so does a data read; instruction
+// bytes after the opcode and writes are not marked.
+//
+// Coverage of separate runs, of one program or several, can be saved,
+// merged and rendered over the ROM image they ran, see report().
+class Coverage
+{
+public:
+    static constexpr bool enabled = false;
+    static constexpr bool accesses = true;
+
+    auto record(TraceRecord const&) noexcept -> void {}
+    auto execute(u16 pc) noexcept -> void { code_[pc >> 6] |= u64{1} << (pc & 63); }
+    auto fetch(u16) noexcept -> void {}
+    auto read(u16 addr) noexcept -> void { data_[addr >> 6] |= u64{1} << (addr & 63); }
+    auto write(u16) noexcept -> void {}
+
+    // Whether an instruction started at `addr`.
+    auto executed(u16 addr) const noexcept -> bool { return code_[addr >> 6] >> (addr & 63) & 1; }
+    // Whether `addr` was read other than as an instruction byte.
+    auto data(u16 addr) const noexcept -> bool { return data_[addr >> 6] >> (addr & 63) & 1; }
+
+    // Addresses marked so, over the whole address space.
+    auto executed_count() const noexcept -> std::size_t;
+    auto data_count() const noexcept -> std::size_t;
+
+    auto clear() noexcept -> void;
+
+    // Marks everything `other` marked, e.g. to combine test runs.
+    auto merge(Coverage const& other) noexcept -> void;
+
+    // Writes the bitmaps in the format read by load_coverage().
+    auto save(std::ostream& os) const -> void;
+
+    // Renders the coverage of `size` bytes of `image` mapped at `base`: a
+    // summary, then a row per 64 bytes with a character per byte.
+    //
+    //     #  an instruction started here
+    //     +  an operand byte of an instruction that started
+    //     d  read as data only
+    //     .  untouched
+    //
+    // Runs of untouched rows are collapsed to a `*` like hexdump does.
+    // Operand sizes are looked up in the 65C02's opcode matrix if `cmos`, as
+    // Variant::cmos of the CPU that ran, and in the NMOS one otherwise.
+    auto report(std::ostream& os, u8 const *image, std::size_t size, u16 base, bool cmos = false) const -> void;
+
+private:
+    std::array<u64, 0x10000 / 64> code_{};
+    std::array<u64, 0x10000 / 64> data_{};
+
+    friend auto load_coverage(std::istream& is) -> Coverage;
+};
+
+// Reads bitmaps written by Coverage::save(). Throws std::runtime_error if the
+// stream does not hold coverage.
+auto load_coverage(std::istream& is) -> Coverage;
+
+}  // namespace fce
+
+#endif  // FCE_COVERAGE_HPP_
@@ -1,25 +1,298 @@
 #ifndef FCE_CPU_HPP_
 #define FCE_CPU_HPP_
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 #include <fce/types.hpp>
+#include <fce/block_cache.hpp>
+#include <fce/bus.hpp>
+#include <fce/code_cache.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/instructions.hpp>
 #include <fce/memory.hpp>
+#include <fce/recompiler.hpp>
+#include <fce/trace.hpp>
+#include <fce/variant.hpp>
 
 namespace fce {
 
+// A snapshot of the programmer visible registers.
+struct Registers
+{
+    u8 a;
+    u8 x;
+    u8 y;
+    u8 s;
+    u8 p;
+    u16 pc;
+};
+
+// Everything a CPU needs to resume where it left off, as plain bytes, see
+// Savestate.
+struct CpuState
+{
+    u64 cycles;
+    u16 pc;
+    u8 a;
+    u8 x;
+    u8 y;
+    u8 s;
+    u8 p;
+    u8 nmi;  // an NMI is waiting to be serviced
+    u8 irq;  // the IRQ line
+    std::array<u8, 7> reserved;
+};
+
+enum class StopReason
+{
+    budget,      // the cycle budget ran out
+    interrupt,   // an interrupt is waiting to be serviced
+    breakpoint,  // the predicate of run_until() returned true
+    sync,        // sync() was called
+};
+
+struct RunResult
+{
+    u64 cycles;
+    StopReason reason;
+};
+
+// The engine CPUs are constructed with, Engine::interpreter unless changed.
+auto default_engine() noexcept -> Engine;
+auto default_engine(Engine engine) noexcept -> void;
+
+// A 6502 over a statically known bus. Any type with
+//
+//     auto get(u16 addr) -> u8;
+//     auto set(u16 addr, u8 v) -> void;
+//
+// will do, e.g. FlatRamBus. Memory accesses are resolved at compile time and
+// inline into the instruction handlers.
+//
+// CPU<Bus> is the general purpose instantiation: pages of the address space
+// may route to Memory handlers, and CPU{std::shared_ptr<Memory>} routes all of
+// them.
+//
+// `Tracer` is handed a TraceRecord before every instruction when its
+// `enabled` is true, see TraceBuffer. When its `accesses` is true it is
+// handed addresses: the PC before every instruction through execute(), and
+// every bus access through fetch() for instruction bytes, read() for other
+// reads and write(), see Profiler and Coverage. With the default NoTrace no
+// tracing code is generated. Operand bytes are read with BusType::get()
+// outside the cycle count.
+//
+// How instructions are executed is up to the Engine, see engine(). All of
+// them produce the same bus accesses at the same cycles.
+//
+// `VariantType` is the member of the 6502 family emulated and `Level` how
+// closely it follows the bus, see variant.hpp.
+template <typename BusType = Bus, typename Tracer = NoTrace, typename VariantType = Ricoh2A03,
+          Accuracy Level = Accuracy::exact>
 class CPU
 {
 public:
-    CPU() noexcept;
-    explicit CPU(std::shared_ptr<Memory> memory) noexcept;
+    using Variant = VariantType;
+    static constexpr Accuracy accuracy = Level;
+
+    CPU() noexcept
+        : CPU{BusType{}}
+    {
+    }
+
+    explicit CPU(BusType bus) noexcept
+        : s_{0xFD}, bus_{std::move(bus)}, cycles_{0}
+    {
+        this->engine(default_engine());
+        this->reset();
+    }
+
+    template <typename M, typename B = BusType,
+              typename = std::enable_if_t<std::is_constructible<B, std::shared_ptr<M>>::value>>
+    explicit CPU(std::shared_ptr<M> memory) noexcept
+        : CPU{BusType{std::move(memory)}}
+    {
+    }
+
+    auto bus() noexcept -> BusType& { return bus_; }
+    auto bus() const noexcept -> BusType const& { return bus_; }
+    auto tracer() noexcept -> Tracer& { return tracer_; }
+
+    auto reset() noexcept -> void
+    {
+        waiting_ = false;
+        halted_ = false;
+        s_ -= 3;
+        pc_ = this->get_u16(0xFFFC);
+    }
+
+    // Executes one instruction, or services a pending interrupt.
+    auto step() noexcept -> void
+    {
+        if (this->asleep(*this, cycles_ + 1)) {
+            return;
+        }
+        if (this->interrupt_pending(p_)) {
+            this->service_interrupt(*this);
+            return;
+        }
+        if (this->recompiled<Never>()) {
+            this->run_recompiled(cycles_ + 1);
+            return;
+        }
+
+        this->trace(*this);
+        auto const instruction = this->fetch_next();
+        Instructions<CPU>::table[instruction](*this);
+    }
+
+    // Executes instructions until at least `cycles` cycles have elapsed. The
+    // run ends early, at an instruction boundary, when an interrupt becomes
+    // pending, when sync() is called, or when `stop` returns true for the
+    // registers after an instruction. An interrupt pending on entry is
+    // serviced first.
+    //
+    // Registers are kept in locals for the whole run and only written back
+    // when it ends.
+    template <typename Predicate>
+    auto run_until(u64 cycles, Predicate stop) noexcept -> RunResult
+    {
+        auto const start = cycles_;
+        sync_ = false;
+
+        StopReason reason;
+        if (this->recompiled<Predicate>()) {
+            reason = this->run_recompiled(start + cycles);
+        } else if (engine_ == Engine::block_cache) {
+            reason = this->run_blocks(start + cycles, stop);
+        } else {
+            reason = this->interpret(start + cycles, stop);
+        }
+        return {cycles_ - start, reason};
+    }
+
+    auto run(u64 cycles) noexcept -> RunResult
+    {
+        return this->run_until(cycles, Never{});
+    }
+
+    // Interrupt lines: NMI is edge triggered, IRQ is level triggered and
+    // masked by the I flag.
+    auto nmi() noexcept -> void { nmi_ = true; }
+    auto irq(bool line) noexcept -> void { irq_ = line; }
+
+    // Whether the 65C02 executed WAI and waits for an interrupt line to be
+    // asserted, or executed STP and is halted until reset(). The clock runs
+    // on meanwhile. An IRQ masked by the I flag ends the wait without being
+    // serviced.
+    auto waiting() const noexcept -> bool { return waiting_; }
+    auto halted() const noexcept -> bool { return halted_; }
+
+    // Ends the current run() after this instruction, e.g. so that a device
+    // touched by it can be brought up to date.
+    auto sync() noexcept -> void { sync_ = true; }
 
-    auto reset() noexcept -> void;
+    // Selects how instructions are executed:
+    //
+    // - Engine::interpreter decodes every instruction from the bus.
+    // - Engine::block_cache makes run() and run_until() execute from a
+    //   BlockCache. step() always decodes.
+    // - Engine::recompiler makes step() and run() execute code translated by
+    //   a Recompiler. run_until() with a predicate and traced CPUs interpret,
+    //   as translated code doesn't stop between instructions. Hosts without
+    //   the recompiler get the block cache instead.
+    //
+    // The recompiler translates the 2A03 only; other variants get the block
+    // cache instead. The code caches don't decode 65C02 code, which is always
+    // interpreted.
+    auto engine(Engine engine) -> void
+    {
+        if (engine == Engine::recompiler && (!Recompiler::available() || !std::is_same<Variant, Ricoh2A03>::value)) {
+            engine = Engine::block_cache;
+        }
+        if (Variant::cmos) {
+            engine = Engine::interpreter;
+        }
+        if (engine == engine_ && (code_ || engine == Engine::interpreter)) {
+            return;
+        }
 
-    auto step() noexcept -> void;
+        engine_ = engine;
+        switch (engine) {
+        case Engine::interpreter:
+            code_.reset();
+            break;
+        case Engine::block_cache:
+            code_ = std::make_unique<BlockCache>();
+            break;
+        case Engine::recompiler:
+            code_ = std::make_unique<Recompiler>();
+            break;
+        }
+    }
 
-    // for debug
-    auto cycles() const noexcept { return cycles_; }
+    auto engine() const noexcept -> Engine { return engine_; }
+
+    // Idle loop skipping, off by default. When on, run() checks the code
+    // after every jump or branch backwards: if one iteration from there
+    // comes back with the same registers, writing nothing and reading only
+    // stable addresses (see Memory::stable()), every later one would too,
+    // so the clock moves ahead over the iterations that fit in the run
+    // instead of executing them. Runs scheduled by a Scheduler end at the
+    // next event, which is what a spinning program waits for.
+    //
+    // Results are those of executing the loop. run_until() with a predicate
+    // and traced CPUs never skip, nor do buses without stable().
+    auto skip_idle(bool enabled) noexcept -> void { skip_idle_ = enabled; }
+    auto skip_idle() const noexcept -> bool { return skip_idle_; }
+
+    // Cycles moved ahead over by idle loop skipping so far.
+    auto skipped_cycles() const noexcept -> u64 { return skipped_cycles_; }
+
+    // Drops cached code decoded from pages [first, last]. Needed when the
+    // bus is remapped, or written other than through this CPU.
+    auto invalidate_code(u8 first, u8 last) noexcept -> void
+    {
+        if (code_) {
+            for (unsigned page = first; page <= last; page++) {
+                if (code_->code_page(u16(page << 8))) {
+                    code_->invalidate(u8(page));
+                }
+            }
+        }
+    }
+
+    auto registers() const noexcept -> Registers { return {a_, x_, y_, s_, p_, pc_}; }
+
+    auto state() const noexcept -> CpuState
+    {
+        return {cycles_, pc_, a_, x_, y_, s_, p_, nmi_, irq_, {}};
+    }
+
+    // Resumes from `state`, awake. Cached code is kept, as the memory it
+    // was decoded from is not part of CpuState.
+    auto state(CpuState const& state) noexcept -> void
+    {
+        waiting_ = false;
+        halted_ = false;
+        cycles_ = state.cycles;
+        pc_ = state.pc;
+        a_ = state.a;
+        x_ = state.x;
+        y_ = state.y;
+        s_ = state.s;
+        p_ = state.p;
+        nmi_ = state.nmi != 0;
+        irq_ = state.irq != 0;
+    }
+
+    // The master clock, in CPU cycles since construction. It is kept up to
+    // date during run(), so devices can read it to catch up when the CPU
+    // accesses them.
+    auto cycles() const noexcept -> u64 { return cycles_; }
 
     auto stack_peek() const noexcept -> u8 { return this->get_memory(0x0100 | u8(s_ + 1)); }
     auto stack_push(u8 v) noexcept -> void { this->set_memory(0x0100 | s_--, v); }
@@ -57,20 +330,633 @@ public:                                                                       \
 #undef MAKE_FLAG
 
 private:
-    std::weak_ptr<Memory> memory_;
+    friend struct Instructions<CPU>;
+
+    // The core run_until() works on: a copy of the registers that the
+    // compiler can keep in host registers instead of reloading them from
+    // *this around every bus access. The clock is shared with the CPU,
+    // except at Accuracy::fast, where it is a copy too.
+    //
+    // A Decoded batch executes BlockCache ops: instruction bytes come from
+    // `operand_` rather than from the bus.
+    template <bool Decoded>
+    class Batch
+    {
+    public:
+        using Variant = VariantType;
+        static constexpr Accuracy accuracy = Level;
+
+        explicit Batch(CPU& cpu) noexcept
+            : a_{cpu.a_}, x_{cpu.x_}, y_{cpu.y_}, s_{cpu.s_}, p_{cpu.p_}, pc_{cpu.pc_},
+              cycles_{cpu.cycles_}, bus_{cpu.bus_}, tracer_{cpu.tracer_}, code_{cpu.code_.get()}, cpu_{cpu}
+        {
+        }
+
+        auto commit(CPU& cpu) const noexcept -> void
+        {
+            cpu.a_ = a_;
+            cpu.x_ = x_;
+            cpu.y_ = y_;
+            cpu.s_ = s_;
+            cpu.p_ = p_;
+            cpu.pc_ = pc_;
+            cpu.cycles_ = cycles_;
+        }
+
+        auto registers() const noexcept -> Registers { return {a_, x_, y_, s_, p_, pc_}; }
+
+    private:
+        friend class CPU;
+        friend struct Instructions<Batch>;
+
+        u8 a_;
+        u8 x_;
+        u8 y_;
+        u8 s_;
+        u8 p_;
+        u16 pc_;
+        std::conditional_t<Level == Accuracy::exact, u64&, u64> cycles_;
+        BusType& bus_;
+        Tracer& tracer_;
+        CodeCache* code_;
+        CPU& cpu_;
+        u8 const *operand_ = nullptr;
+        bool dropped_ = false;  // cached code was invalidated
+
+        FCE_ALWAYS_INLINE auto wait() noexcept -> void { cpu_.wait(); }
+        FCE_ALWAYS_INLINE auto halt() noexcept -> void { cpu_.halt(); }
+
+        FCE_ALWAYS_INLINE auto get_memory(u16 addr) noexcept -> u8
+        {
+            this->cycle();
+            if constexpr (Tracer::accesses) {
+                tracer_.read(addr);
+            }
+            return bus_.get(addr);
+        }
+
+        FCE_ALWAYS_INLINE auto set_memory(u16 addr, u8 v) noexcept -> void
+        {
+            this->cycle();
+            if constexpr (Tracer::accesses) {
+                tracer_.write(addr);
+            }
+            bus_.set(addr, v);
+            if (code_ && code_->code_page(addr)) {
+                code_->invalidate(u8(addr >> 8));
+                dropped_ = true;
+            }
+        }
+
+        // A read of an instruction byte served from decoded code instead
+        FCE_ALWAYS_INLINE auto decoded_read(u16 addr) noexcept -> void
+        {
+            this->cycle();
+            if constexpr (Tracer::accesses) {
+                tracer_.fetch(addr);
+            }
+        }
+
+        FCE_ALWAYS_INLINE auto stable(u16 addr) const noexcept -> bool
+        {
+            return CPU::stable(bus_, addr);
+        }
+
+        FCE_ALWAYS_INLINE auto fetch_next() noexcept -> u8
+        {
+            if constexpr (Decoded) {
+                this->decoded_read(pc_++);
+                return *operand_++;
+            } else {
+                this->cycle();
+                if constexpr (Tracer::accesses) {
+                    tracer_.fetch(pc_);
+                }
+                return bus_.get(pc_++);
+            }
+        }
+
+        FCE_ALWAYS_INLINE auto cycle() noexcept -> void
+        {
+            ++cycles_;
+        }
+    };
+
+    // The predicate of run()
+    struct Never
+    {
+        auto operator()(Registers const&) const noexcept -> bool { return false; }
+    };
+
+    // An iteration of a loop that may be idle, executed on a copy of the
+    // registers. Writes, and reads of addresses that are not stable, spoil
+    // it without reaching the bus.
+    struct Probe
+    {
+        using Variant = VariantType;
+
+        u8 a_;
+        u8 x_;
+        u8 y_;
+        u8 s_;
+        u8 p_;
+        u16 pc_;
+        u64 cycles_;
+        BusType const& bus_;
+        bool spoiled_;
+
+        FCE_ALWAYS_INLINE auto get_memory(u16 addr) noexcept -> u8
+        {
+            this->cycle();
+            if (!bus_.stable(addr)) {
+                spoiled_ = true;
+                return 0x00;
+            }
+            return bus_.get(addr);
+        }
+
+        FCE_ALWAYS_INLINE auto set_memory(u16, u8) noexcept -> void
+        {
+            this->cycle();
+            spoiled_ = true;
+        }
+
+        FCE_ALWAYS_INLINE auto wait() noexcept -> void { spoiled_ = true; }
+        FCE_ALWAYS_INLINE auto halt() noexcept -> void { spoiled_ = true; }
 
-    mutable u16 cycles_;  // for debug
+        FCE_ALWAYS_INLINE auto fetch_next() noexcept -> u8
+        {
+            return this->get_memory(pc_++);
+        }
 
-    auto get_memory(u16 addr) const noexcept -> u8;
-    auto set_memory(u16 addr, u8 v) noexcept -> void;
+        FCE_ALWAYS_INLINE auto cycle() noexcept -> void
+        {
+            ++cycles_;
+        }
+    };
 
-    auto get_u16(u16 addr) const noexcept -> u16;
+    template <typename B, typename = void>
+    struct HasStable : std::false_type
+    {
+    };
 
-    auto fetch_next() noexcept -> u8;
+    template <typename B>
+    struct HasStable<B, std::void_t<decltype(std::declval<B const&>().stable(u16{}))>> : std::true_type
+    {
+    };
 
-    auto cycle() const noexcept -> void;
+    BusType bus_;
+    mutable Tracer tracer_;
+    Engine engine_ = Engine::interpreter;
+    std::unique_ptr<CodeCache> code_;
+
+    mutable u64 cycles_;
+
+    bool nmi_ = false;
+    bool irq_ = false;
+    bool sync_ = false;
+    bool waiting_ = false;  // WAI
+    bool halted_ = false;   // STP
+
+    bool skip_idle_ = false;
+    u64 skipped_cycles_ = 0;
+    u32 busy_head_ = 0x10000;  // the last loop found not to be idle
+
+    auto interrupt_pending(u8 p) const noexcept -> bool
+    {
+        if constexpr (Variant::cmos) {
+            if (halted_) {
+                return false;
+            }
+        }
+        return nmi_ || (irq_ && !(p & 0x04));
+    }
+
+    // While the CPU waits or is halted, the clock of `core` runs on to
+    // `end`. Returns whether it does.
+    template <typename Core>
+    FCE_ALWAYS_INLINE auto asleep(Core& core, u64 end) noexcept -> bool
+    {
+        if constexpr (Variant::cmos) {
+            if (waiting_ && (nmi_ || irq_)) {
+                waiting_ = false;
+            }
+            if (waiting_ || halted_) {
+                core.cycles_ = std::max<u64>(core.cycles_, end);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto wait() noexcept -> void { waiting_ = true; }
+    auto halt() noexcept -> void { halted_ = true; }
+
+    template <typename Predicate>
+    auto interpret(u64 end, Predicate& stop) noexcept -> StopReason
+    {
+        using I = Instructions<Batch<false>>;
+
+        Batch<false> batch{*this};
+        auto reason = StopReason::budget;
+
+        if (batch.cycles_ < end && this->interrupt_pending(batch.p_)) {
+            this->service_interrupt(batch);
+        }
+
+        while (batch.cycles_ < end) {
+            if (this->asleep(batch, end)) {
+                break;
+            }
+            this->trace(batch);
+            auto const pc = batch.pc_;
+            this->execute(batch, I::fetch(batch));
+
+            if (this->stopped(batch, stop, reason)) {
+                break;
+            }
+            if constexpr (skips<Predicate>()) {
+                if (batch.pc_ <= pc && skip_idle_) {
+                    this->fast_forward(batch, end);
+                }
+            }
+        }
+
+        batch.commit(*this);
+        return reason;
+    }
+
+    // interpret(), walking cached blocks. A block is left early when a store
+    // drops cached code, since it may have overwritten the rest of it. Code
+    // dropped by a Memory handler calling invalidate_code() is only noticed
+    // at the end of the block.
+    template <typename Predicate>
+    auto run_blocks(u64 end, Predicate& stop) noexcept -> StopReason
+    {
+        Batch<true> batch{*this};
+        auto reason = StopReason::budget;
+        auto& blocks = static_cast<BlockCache&>(*code_);
+        auto const read = [this](u16 addr) { return bus_.get(addr); };
+
+        if (batch.cycles_ < end && this->interrupt_pending(batch.p_)) {
+            this->service_interrupt(batch);
+        }
+
+        auto done = false;
+        while (!done && batch.cycles_ < end) {
+            if (this->asleep(batch, end)) {
+                break;
+            }
+            auto const start = batch.pc_;
+            auto const block = blocks.find(batch.pc_, read);
+            auto op = &blocks.op(block.first);
+            auto const last = op + block.size;
+
+            batch.dropped_ = false;
+            for (; op != last; ++op) {
+                this->trace(batch);
+                batch.decoded_read(batch.pc_++);  // the opcode fetch
+                batch.operand_ = op->operand.data();
+                this->execute(batch, op->opcode);
+
+                if (this->stopped(batch, stop, reason)) {
+                    done = true;
+                    break;
+                }
+                if (batch.cycles_ >= end || batch.dropped_) {
+                    break;
+                }
+            }
+
+            if constexpr (skips<Predicate>()) {
+                if (!done && batch.pc_ <= start && skip_idle_) {
+                    this->fast_forward(batch, end);
+                }
+            }
+        }
+
+        batch.commit(*this);
+        return reason;
+    }
+
+    template <typename Predicate>
+    auto recompiled() const noexcept -> bool
+    {
+        return engine_ == Engine::recompiler && std::is_same<Predicate, Never>::value && !Tracer::enabled &&
+               !Tracer::accesses;
+    }
+
+    // interpret(), one translated block at a time. Blocks return after any
+    // instruction that called out to the bus, so interrupts raised by devices
+    // are noticed at the same instruction boundary.
+    auto run_recompiled(u64 end) noexcept -> StopReason
+    {
+        auto& recompiler = static_cast<Recompiler&>(*code_);
+        auto const read = [this](u16 addr) { return bus_.get(addr); };
+        auto reason = StopReason::budget;
+
+        if (cycles_ < end && this->interrupt_pending(p_)) {
+            this->service_interrupt(*this);
+        }
+
+        RecompilerContext context{};
+        context.cycles = cycles_;
+        context.end = end;
+        if constexpr (std::is_same<BusType, Bus>::value) {
+            context.read_pages = bus_.read_pages();
+            context.write_pages = bus_.write_pages();
+            context.dirty_pages = bus_.dirty_pages();
+        } else {
+            if constexpr (std::is_same<BusType, FlatRamBus>::value) {
+                recompiler.flat_pages(bus_.data());
+                context.dirty_pages = bus_.dirty_pages();
+            }
+            // otherwise no page is written directly
+            context.read_pages = recompiler.flat_read_pages();
+            context.write_pages = recompiler.flat_write_pages();
+        }
+        context.code_pages = recompiler.code_pages();
+        context.cpu = this;
+        context.read = &CPU::recompiled_read;
+        context.write = &CPU::recompiled_write;
+        context.interpret = &CPU::recompiled_interpret;
+        this->save(context);
+
+        while (context.cycles < end) {
+            auto const start = context.pc;
+            context.callout = 0;
+            if (auto const block = recompiler.find(context.pc, read)) {
+                block(context);
+            } else {
+                recompiled_interpret(context);
+            }
+
+            if (sync_) {
+                reason = StopReason::sync;
+                break;
+            }
+            if (this->interrupt_pending(context.p)) {
+                reason = StopReason::interrupt;
+                break;
+            }
+            if constexpr (skips<Never>()) {
+                if (context.pc <= start && skip_idle_) {
+                    this->load(context);
+                    this->fast_forward(*this, end);
+                    context.cycles = cycles_;
+                }
+            }
+        }
+
+        this->load(context);
+        return reason;
+    }
+
+    template <typename Predicate>
+    static constexpr auto skips() noexcept -> bool
+    {
+        return std::is_same<Predicate, Never>::value && !Tracer::enabled && HasStable<BusType>::value;
+    }
+
+    // Called with `core` just moved backwards to the head of what may be an
+    // idle loop, see skip_idle(). A loop found not to be idle isn't probed
+    // again until another one is.
+    template <typename Core>
+    auto fast_forward(Core& core, u64 end) noexcept -> void
+    {
+        if (core.pc_ == busy_head_ || core.cycles_ >= end) {
+            return;
+        }
+
+        auto const period = this->idle_period(core.registers());
+        if (period == 0) {
+            busy_head_ = core.pc_;
+            return;
+        }
+        auto const skipped = (end - core.cycles_) / period * period;
+        core.cycles_ += skipped;
+        skipped_cycles_ += skipped;
+    }
+
+    // Cycles an iteration of the loop at `registers.pc` takes, or 0 unless
+    // it ends where it began, touching nothing. Loops of more than a few
+    // instructions aren't considered.
+    auto idle_period(Registers const& registers) const noexcept -> u64
+    {
+        using I = Instructions<Probe>;
+
+        Probe probe{registers.a, registers.x, registers.y, registers.s, registers.p, registers.pc, 0, bus_, false};
+        for (int n = 0; n < 16 && !probe.spoiled_; n++) {
+            execute(probe, I::fetch(probe));
+            if (probe.pc_ == registers.pc) {
+                auto const same = !probe.spoiled_ && probe.a_ == registers.a && probe.x_ == registers.x &&
+                                  probe.y_ == registers.y && probe.s_ == registers.s && probe.p_ == registers.p;
+                return same ? probe.cycles_ : 0;
+            }
+        }
+        return 0;
+    }
+
+    auto save(RecompilerContext& context) const noexcept -> void
+    {
+        context.cycles = cycles_;
+        context.pc = pc_;
+        context.a = a_;
+        context.x = x_;
+        context.y = y_;
+        context.s = s_;
+        context.p = p_;
+    }
+
+    auto load(RecompilerContext const& context) noexcept -> void
+    {
+        cycles_ = context.cycles;
+        pc_ = context.pc;
+        a_ = context.a;
+        x_ = context.x;
+        y_ = context.y;
+        s_ = context.s;
+        p_ = context.p;
+    }
+
+    // Callouts of translated code. The clock is brought up to date for the
+    // device accessed.
+    static auto recompiled_read(RecompilerContext& context, u16 addr) -> u8
+    {
+        auto& cpu = *static_cast<CPU *>(context.cpu);
+        cpu.cycles_ = context.cycles;
+        context.callout = 1;
+        return cpu.bus_.get(addr);
+    }
+
+    static auto recompiled_write(RecompilerContext& context, u16 addr, u8 v) -> void
+    {
+        auto& cpu = *static_cast<CPU *>(context.cpu);
+        cpu.cycles_ = context.cycles;
+        context.callout = 1;
+        cpu.bus_.set(addr, v);
+        if (cpu.code_->code_page(addr)) {
+            cpu.code_->invalidate(u8(addr >> 8));
+        }
+    }
+
+    static auto recompiled_interpret(RecompilerContext& context) -> void
+    {
+        auto& cpu = *static_cast<CPU *>(context.cpu);
+        cpu.load(context);
+
+        Batch<false> batch{cpu};
+        cpu.execute(batch, Instructions<Batch<false>>::fetch(batch));
+        batch.commit(cpu);
+
+        cpu.save(context);
+        context.callout = 1;
+    }
+
+    // A switch rather than Instructions::table, so that the handlers inline
+    // and the registers of `core` stay in host registers.
+    template <typename Core>
+    FCE_ALWAYS_INLINE static auto execute(Core& core, u8 instruction) noexcept -> void
+    {
+        using I = Instructions<Core>;
+
+#define FCE_CASE(opcode, mode, operation)                                               \
+        case opcode:                                                                    \
+            I::template execute<typename I::mode, typename I::operation>(core);         \
+            break;
+        if constexpr (Variant::cmos) {
+            switch (instruction) {
+                FCE_OPCODES_65C02(FCE_CASE)
+            }
+        } else {
+            switch (instruction) {
+                FCE_OPCODES(FCE_CASE)
+            }
+        }
+#undef FCE_CASE
+    }
+
+    // Whether a run should end after the instruction just executed.
+    template <typename Core, typename Predicate>
+    FCE_ALWAYS_INLINE auto stopped(Core const& core, Predicate& stop, StopReason& reason) noexcept -> bool
+    {
+        if (sync_) {
+            reason = StopReason::sync;
+            return true;
+        }
+        if (this->interrupt_pending(core.p_)) {
+            reason = StopReason::interrupt;
+            return true;
+        }
+        if (stop(core.registers())) {
+            reason = StopReason::breakpoint;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Core>
+    auto service_interrupt(Core& core) noexcept -> void
+    {
+        waiting_ = false;
+        if (nmi_) {
+            nmi_ = false;
+            Instructions<Core>::interrupt(core, 0xFFFA);
+        } else {
+            Instructions<Core>::interrupt(core, 0xFFFE);
+        }
+    }
+
+    template <typename Core>
+    FCE_ALWAYS_INLINE auto trace(Core const& core) noexcept -> void
+    {
+        if constexpr (Tracer::enabled) {
+            TraceRecord record{};
+            record.cycles = core.cycles_;
+            record.pc = core.pc_;
+            record.opcode = bus_.get(core.pc_);
+            auto const& modes = Variant::cmos ? addressing_modes_65c02 : addressing_modes;
+            auto const size = operand_size(modes[record.opcode]);
+            for (unsigned i = 0; i < size; i++) {
+                record.operand[i] = bus_.get(u16(core.pc_ + 1 + i));
+            }
+            record.a = core.a_;
+            record.x = core.x_;
+            record.y = core.y_;
+            record.s = core.s_;
+            record.p = core.p_;
+            record.cmos = Variant::cmos;
+            tracer_.record(record);
+        }
+        if constexpr (Tracer::accesses) {
+            tracer_.execute(core.pc_);
+        }
+    }
+
+    FCE_ALWAYS_INLINE auto get_memory(u16 addr) const noexcept -> u8
+    {
+        this->cycle();
+        if constexpr (Tracer::accesses) {
+            tracer_.read(addr);
+        }
+        return bus_.get(addr);
+    }
+
+    FCE_ALWAYS_INLINE auto set_memory(u16 addr, u8 v) noexcept -> void
+    {
+        this->cycle();
+        if constexpr (Tracer::accesses) {
+            tracer_.write(addr);
+        }
+        bus_.set(addr, v);
+        if (code_ && code_->code_page(addr)) {
+            code_->invalidate(u8(addr >> 8));
+        }
+    }
+
+    auto get_u16(u16 addr) const noexcept -> u16
+    {
+        auto const lo = this->get_memory(addr);
+        auto const hi = this->get_memory(u16(addr + 1));
+        return u16(hi << 8 | lo);
+    }
+
+    // Whether reading `addr` has no side effects, for dummy reads at
+    // Accuracy::fast. Buses that can't tell are read.
+    FCE_ALWAYS_INLINE static auto stable(BusType const& bus, u16 addr) noexcept -> bool
+    {
+        if constexpr (HasStable<BusType>::value) {
+            return bus.stable(addr);
+        } else {
+            return false;
+        }
+    }
+
+    FCE_ALWAYS_INLINE auto stable(u16 addr) const noexcept -> bool
+    {
+        return CPU::stable(bus_, addr);
+    }
+
+    FCE_ALWAYS_INLINE auto fetch_next() noexcept -> u8
+    {
+        this->cycle();
+        if constexpr (Tracer::accesses) {
+            tracer_.fetch(pc_);
+        }
+        return bus_.get(pc_++);
+    }
+
+    FCE_ALWAYS_INLINE auto cycle() const noexcept -> void
+    {
+        ++cycles_;
+    }
 };
 
+template <typename M>
+CPU(std::shared_ptr<M>) -> CPU<Bus>;
+
+extern template class CPU<Bus>;
+
 }  // namespace fce
 
 #endif  // FCE_CPU_HPP_
@@ -1,7 +1,33 @@
 #ifndef FCE_FCE_HPP_
 #define FCE_FCE_HPP_
 
+#include <fce/apu.hpp>
+#include <fce/audio.hpp>
+#include <fce/batch_runner.hpp>
+#include <fce/blip_buffer.hpp>
+#include <fce/block_cache.hpp>
+#include <fce/bus.hpp>
+#include <fce/capture.hpp>
+#include <fce/code_cache.hpp>
+#include <fce/coverage.hpp>
 #include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/lockstep.hpp>
+#include <fce/mapper.hpp>
 #include <fce/memory.hpp>
+#include <fce/pixel_pipeline.hpp>
+#include <fce/ppu.hpp>
+#include <fce/profiler.hpp>
+#include <fce/recompiler.hpp>
+#include <fce/rewind.hpp>
+#include <fce/rom.hpp>
+#include <fce/savestate.hpp>
+#include <fce/scheduler.hpp>
+#include <fce/spsc_ring.hpp>
+#include <fce/thread_pool.hpp>
+#include <fce/tile_cache.hpp>
+#include <fce/trace.hpp>
+#include <fce/triple_buffer.hpp>
+#include <fce/variant.hpp>
 
 #endif  // FCE_FCE_HPP_
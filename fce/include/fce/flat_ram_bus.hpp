@@ -0,0 +1,47 @@
+#ifndef FCE_FLAT_RAM_BUS_HPP_
+#define FCE_FLAT_RAM_BUS_HPP_
+
+#include <array>
+#include <fce/types.hpp>
+
+namespace fce {
+
+// 64 KiB of plain RAM without any mapping or I/O, for running bare 6502
+// code. An access is a single load or store.
+class FlatRamBus
+{
+public:
+    auto get(u16 addr) const noexcept -> u8 { return cells_[addr]; }
+    auto set(u16 addr, u8 v) noexcept -> void
+    {
+        cells_[addr] = v;
+        dirty_[addr >> 8] = true;
+    }
+    auto stable(u16) const noexcept -> bool { return true; }
+
+    auto data() noexcept -> u8 * { return cells_.data(); }
+    auto data() const noexcept -> u8 const * { return cells_.data(); }
+
+    // Pages written through set() since the last clean(), as on a Bus.
+    // Writes through data() are not tracked.
+    auto dirty(u8 page) const noexcept -> bool { return dirty_[page]; }
+    auto dirty_pages() noexcept -> bool * { return dirty_.data(); }
+    auto clean() noexcept -> void { dirty_.fill(false); }
+
+private:
+    std::array<u8, 0x10000> cells_{};
+    std::array<bool, 0x100> dirty_ = all_dirty();
+
+    static constexpr auto all_dirty() noexcept -> std::array<bool, 0x100>
+    {
+        std::array<bool, 0x100> pages{};
+        for (auto& page : pages) {
+            page = true;
+        }
+        return pages;
+    }
+};
+
+}  // namespace fce
+
+#endif  // FCE_FLAT_RAM_BUS_HPP_
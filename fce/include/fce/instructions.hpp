@@ -0,0 +1,1213 @@
+#ifndef FCE_INSTRUCTIONS_HPP_
+#define FCE_INSTRUCTIONS_HPP_
+
+#include <array>
+#include <type_traits>
+
+#include <fce/types.hpp>
+#include <fce/variant.hpp>
+
+// Handlers are built from small helpers that must inline into them; the
+// switch in CPU::run_until() is too large for compilers to do so on their own.
+#if defined(_MSC_VER)
+#define FCE_ALWAYS_INLINE __forceinline
+#else
+#define FCE_ALWAYS_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace fce {
+
+// The variant of a core, its `Variant` member type if it has one, otherwise
+// the 2A03.
+template <typename Core, typename = void>
+struct VariantOf
+{
+    using type = Ricoh2A03;
+};
+
+template <typename Core>
+struct VariantOf<Core, std::void_t<typename Core::Variant>>
+{
+    using type = typename Core::Variant;
+};
+
+// The accuracy of a core, its `accuracy` member if it has one, otherwise
+// Accuracy::exact. Fast cores provide `stable(addr)` too, see dummy_read().
+template <typename Core, typename = void>
+struct AccuracyOf : std::integral_constant<Accuracy, Accuracy::exact>
+{
+};
+
+template <typename Core>
+struct AccuracyOf<Core, std::void_t<decltype(Core::accuracy)>> : std::integral_constant<Accuracy, Core::accuracy>
+{
+};
+
+// The 6502 instruction set, over any core that befriends it and provides the
+// registers and bus helpers of CPU. What the instructions do depends on the
+// variant of the core, see VariantOf, and their bus accesses on its accuracy,
+// see AccuracyOf.
+//
+// Every opcode is served by `execute<Mode, Operation>`: the addressing mode
+// resolves the effective address (performing the bus accesses it costs) and
+// the operation does the rest. `table` maps opcodes to these specializations,
+// so decoding an instruction is a single indirect call.
+template <typename Core>
+struct Instructions
+{
+    using Handler = auto (*)(Core&) noexcept -> void;
+    using Variant = typename VariantOf<Core>::type;
+    static constexpr Accuracy accuracy = AccuracyOf<Core>::value;
+
+    static const std::array<Handler, 0x100> table;
+
+    // The handlers of the variant's opcode matrix
+    static constexpr auto make_table() noexcept -> std::array<Handler, 0x100>;
+
+    template <typename Mode, typename Operation>
+    static auto execute(Core& cpu) noexcept -> void
+    {
+        Operation::template run<Mode>(cpu);
+    }
+
+    // status flag bits
+    enum : unsigned { C = 0, Z = 1, I = 2, D = 3, B = 4, V = 6, N = 7 };
+
+    // ADDRESSING
+    //
+    // `addr` is the effective address. Indexed modes that may cross a page
+    // also report `oops`, the address the 6502 reads before fixing up the
+    // high byte.
+
+    struct Address
+    {
+        u16 addr;
+        u16 oops;
+    };
+
+    // IMP / ACC
+    struct IMP
+    {
+        static constexpr bool indexed = false;
+    };
+    struct ACC
+    {
+        static constexpr bool indexed = false;
+    };
+
+    // IMM #i: load() fetches the operand like any other operand byte
+    struct IMM
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            u16 const addr = cpu.pc_++;
+            return {addr, addr};
+        }
+    };
+
+    // ZPG d
+    struct ZPG
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            u16 const addr = fetch(cpu);
+            return {addr, addr};
+        }
+    };
+
+    // ZPX/ZPY d,x
+    template <u8 Core::*Index>
+    struct ZeroPageIndexed
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            cpu.cycle();
+            u16 const addr = u8(fetch(cpu) + cpu.*Index);
+            return {addr, addr};
+        }
+    };
+    using ZPX = ZeroPageIndexed<&Core::x_>;
+    using ZPY = ZeroPageIndexed<&Core::y_>;
+
+    // ABS a
+    struct ABS
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            auto const lo = fetch(cpu);
+            auto const hi = fetch(cpu);
+            u16 const addr = u16(hi << 8 | lo);
+            return {addr, addr};
+        }
+    };
+
+    // ABX/ABY a,x
+    template <u8 Core::*Index>
+    struct AbsoluteIndexed
+    {
+        static constexpr bool indexed = true;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            auto const index = cpu.*Index;
+            auto const lo = fetch(cpu);
+            auto const hi = fetch(cpu);
+            return {u16((hi << 8 | lo) + index), u16(hi << 8 | u8(lo + index))};
+        }
+    };
+    using ABX = AbsoluteIndexed<&Core::x_>;
+    using ABY = AbsoluteIndexed<&Core::y_>;
+
+    // IND (a): NMOS parts fetch the high byte from the start of the page
+    // when the pointer is at its end
+    struct IND
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            auto const lo_addr = fetch(cpu);
+            auto const hi_addr = fetch(cpu);
+            u16 const ind_addr = u16(hi_addr << 8 | lo_addr);
+            u8 const lo = cpu.get_memory(ind_addr + 0);
+            u8 hi;
+            if constexpr (Variant::cmos) {
+                cpu.cycle();
+                hi = cpu.get_memory(u16(ind_addr + 1));
+            } else {
+                hi = cpu.get_memory(u16(hi_addr << 8 | u8(lo_addr + 1)));
+            }
+            u16 const addr = u16(hi << 8 | lo);
+            return {addr, addr};
+        }
+    };
+
+    // IAX (a,x), 65C02 only
+    struct IAX
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            auto const lo_addr = fetch(cpu);
+            auto const hi_addr = fetch(cpu);
+            cpu.cycle();
+            u16 const ind_addr = u16((hi_addr << 8 | lo_addr) + cpu.x_);
+            u8 const lo = cpu.get_memory(ind_addr);
+            u8 const hi = cpu.get_memory(u16(ind_addr + 1));
+            u16 const addr = u16(hi << 8 | lo);
+            return {addr, addr};
+        }
+    };
+
+    // IDX (d,x)
+    struct IDX
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            u8 const base = fetch(cpu);
+            cpu.cycle();
+            u8 const lo_addr = u8(base + cpu.x_);
+            u8 const hi_addr = u8(lo_addr + 1);
+            u8 const lo = cpu.get_memory(lo_addr);
+            u8 const hi = cpu.get_memory(hi_addr);
+            u16 const addr = u16(hi << 8 | lo);
+            return {addr, addr};
+        }
+    };
+
+    // IDY (d),y
+    struct IDY
+    {
+        static constexpr bool indexed = true;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            u8 const lo_addr = fetch(cpu);
+            u8 const hi_addr = u8(lo_addr + 1);
+            u8 const lo = cpu.get_memory(lo_addr);
+            u8 const hi = cpu.get_memory(hi_addr);
+            u8 const index = cpu.y_;
+            return {u16((hi << 8 | lo) + index), u16(hi << 8 | u8(lo + index))};
+        }
+    };
+
+    // ZPI (d), 65C02 only
+    struct ZPI
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            u8 const lo_addr = fetch(cpu);
+            u8 const lo = cpu.get_memory(lo_addr);
+            u8 const hi = cpu.get_memory(u8(lo_addr + 1));
+            u16 const addr = u16(hi << 8 | lo);
+            return {addr, addr};
+        }
+    };
+
+    // REL *+d
+    struct REL
+    {
+        static constexpr bool indexed = false;
+
+        FCE_ALWAYS_INLINE static auto address(Core& cpu) noexcept -> Address
+        {
+            auto const offset = s8(fetch(cpu));
+            u16 const addr = u16(cpu.pc_ + offset);
+            return {addr, addr};
+        }
+    };
+
+    // ZPR d,*+d, 65C02 only: a zero page address and a branch offset, which
+    // BBR and BBS fetch themselves
+    struct ZPR
+    {
+        static constexpr bool indexed = false;
+    };
+
+    // ACCESS PATTERNS
+
+    // The next byte of the instruction stream. Cores may serve it from
+    // already decoded instructions, see BlockCache.
+    FCE_ALWAYS_INLINE static auto fetch(Core& cpu) noexcept -> u8
+    {
+        return cpu.fetch_next();
+    }
+
+    FCE_ALWAYS_INLINE static auto push(Core& cpu, u8 v) noexcept -> void
+    {
+        cpu.set_memory(u16(0x0100 | cpu.s_--), v);
+    }
+
+    FCE_ALWAYS_INLINE static auto pull(Core& cpu) noexcept -> u8
+    {
+        return cpu.get_memory(u16(0x0100 | ++cpu.s_));
+    }
+
+    template <unsigned Bit>
+    FCE_ALWAYS_INLINE static auto flag(Core const& cpu) noexcept -> bool
+    {
+        return cpu.p_ & (1u << Bit);
+    }
+
+    template <unsigned Bit>
+    FCE_ALWAYS_INLINE static auto flag(Core& cpu, bool v) noexcept -> void
+    {
+        cpu.p_ = u8((cpu.p_ & ~(1u << Bit)) | (unsigned(v) << Bit));
+    }
+
+    // IRQ and NMI: BRK without the B flag, through the given vector
+    FCE_ALWAYS_INLINE static auto interrupt(Core& cpu, u16 vector) noexcept -> void
+    {
+        cpu.cycle();
+        cpu.cycle();
+        push(cpu, u8(cpu.pc_ >> 8));
+        push(cpu, u8(cpu.pc_));
+        push(cpu, u8(cpu.p_ & ~(1u << B)));
+        flag<I>(cpu, true);
+        if constexpr (Variant::cmos) {
+            flag<D>(cpu, false);
+        }
+        auto const lo = cpu.get_memory(vector);
+        auto const hi = cpu.get_memory(u16(vector + 1));
+        cpu.pc_ = u16(hi << 8 | lo);
+    }
+
+    FCE_ALWAYS_INLINE static auto set_nz(Core& cpu, u8 m) noexcept -> void
+    {
+        flag<N>(cpu, m & 0x80);
+        flag<Z>(cpu, m == 0x00);
+    }
+
+    // The dummy read while an indexed address is fixed up. Fast cores only
+    // spend the cycle if the read has no side effects.
+    FCE_ALWAYS_INLINE static auto dummy_read(Core& cpu, Address const& a) noexcept -> void
+    {
+        u16 addr;
+        if constexpr (Variant::cmos) {
+            addr = u16(cpu.pc_ - 1);
+        } else {
+            addr = a.oops;
+        }
+
+        if constexpr (accuracy == Accuracy::fast) {
+            if (cpu.stable(addr)) {
+                cpu.cycle();
+                return;
+            }
+        }
+        cpu.get_memory(addr);
+    }
+
+    // Reads pay for the dummy read only when the page is actually crossed.
+    template <typename Mode>
+    FCE_ALWAYS_INLINE static auto load(Core& cpu) noexcept -> u8
+    {
+        if constexpr (std::is_same<Mode, IMM>::value) {
+            return fetch(cpu);
+        }
+        auto const a = Mode::address(cpu);
+        if constexpr (Mode::indexed) {
+            if (a.addr != a.oops) {
+                dummy_read(cpu, a);
+            }
+        }
+        return cpu.get_memory(a.addr);
+    }
+
+    // Writes always do the dummy read, since the write can't be undone.
+    template <typename Mode>
+    FCE_ALWAYS_INLINE static auto store(Core& cpu, u8 v) noexcept -> void
+    {
+        auto const a = Mode::address(cpu);
+        if constexpr (Mode::indexed) {
+            dummy_read(cpu, a);
+        }
+        cpu.set_memory(a.addr, v);
+    }
+
+    // The 65C02 spends the fix-up cycle of a shift or rotate by X only when
+    // the index crosses a page; INC and DEC always spend it.
+    template <typename Mode, bool Shift = false, typename F>
+    FCE_ALWAYS_INLINE static auto modify(Core& cpu, F f) noexcept -> void
+    {
+        if constexpr (std::is_same<Mode, ACC>::value) {
+            cpu.cycle();
+            u8 const result = f(cpu, cpu.a_);
+            cpu.a_ = result;
+            set_nz(cpu, result);
+        } else {
+            auto const a = Mode::address(cpu);
+            auto const m = cpu.get_memory(a.addr);
+            cpu.cycle();
+            u8 const result = f(cpu, m);
+            if constexpr (Mode::indexed) {
+                if (!(Variant::cmos && Shift) || a.addr != a.oops) {
+                    dummy_read(cpu, a);
+                }
+            }
+            cpu.set_memory(a.addr, result);
+            set_nz(cpu, result);
+        }
+    }
+
+    // OPERATIONS
+
+    // NOPs with an operand read it as their mode does, see FCE_OPCODES_65C02
+    struct NOP
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            if constexpr (std::is_same<Mode, IMP>::value) {
+                cpu.cycle();
+            } else {
+                load<Mode>(cpu);
+            }
+        }
+    };
+
+    // The 65C02's one cycle NOPs, the opcode fetch alone
+    struct NOP1
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core&) noexcept -> void
+        {
+        }
+    };
+
+    // $5C on the 65C02: an absolute address, and five more cycles
+    struct NOP8
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            Mode::address(cpu);
+            for (int i = 0; i < 5; i++) {
+                cpu.cycle();
+            }
+        }
+    };
+
+    // WAI and STP, 65C02 only: the core sleeps until an interrupt line is
+    // asserted, or until reset
+    struct WAI
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            cpu.cycle();
+            cpu.wait();
+        }
+    };
+
+    struct STP
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            cpu.cycle();
+            cpu.halt();
+        }
+    };
+
+    struct BRK
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            ++cpu.pc_;
+            push(cpu, u8(cpu.pc_ >> 8));
+            push(cpu, u8(cpu.pc_));
+            push(cpu, cpu.p_);
+            auto const lo = cpu.get_memory(0xFFFE);
+            auto const hi = cpu.get_memory(0xFFFF);
+            cpu.pc_ = u16(hi << 8 | lo);
+            flag<B>(cpu, true);
+            if constexpr (Variant::cmos) {
+                flag<D>(cpu, false);
+            }
+        }
+    };
+
+    struct RTI
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            cpu.p_ = pull(cpu);
+            cpu.cycle();
+            auto const lo = pull(cpu);
+            auto const hi = pull(cpu);
+            cpu.pc_ = u16(hi << 8 | lo);
+        }
+    };
+
+    struct JMP
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.pc_ = Mode::address(cpu).addr;
+        }
+    };
+
+    struct JSR
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const addr = Mode::address(cpu).addr;
+            cpu.cycle();
+            push(cpu, u8(cpu.pc_ >> 8));
+            push(cpu, u8(cpu.pc_));
+            cpu.pc_ = addr;
+        }
+    };
+
+    struct RTS
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            cpu.cycle();
+            cpu.cycle();
+            auto const lo = pull(cpu);
+            auto const hi = pull(cpu);
+            cpu.pc_ = u16(hi << 8 | lo);
+        }
+    };
+
+    template <u8 Core::*Register>
+    struct Push
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            push(cpu, cpu.*Register);
+        }
+    };
+    using PHA = Push<&Core::a_>;
+    using PHP = Push<&Core::p_>;
+    using PHX = Push<&Core::x_>;
+    using PHY = Push<&Core::y_>;
+
+    template <u8 Core::*Register, bool Flags>
+    struct Pull
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            auto const m = pull(cpu);
+            cpu.cycle();
+            cpu.*Register = m;
+            if (Flags) {
+                set_nz(cpu, m);
+            }
+        }
+    };
+    using PLA = Pull<&Core::a_, true>;
+    using PLP = Pull<&Core::p_, false>;
+    using PLX = Pull<&Core::x_, true>;
+    using PLY = Pull<&Core::y_, true>;
+
+    // A branch taken to `addr`, a cycle more when it crosses a page
+    FCE_ALWAYS_INLINE static auto branch(Core& cpu, u16 addr) noexcept -> void
+    {
+        cpu.cycle();
+        if ((cpu.pc_ ^ addr) & 0xFF00) {
+            cpu.cycle();
+        }
+        cpu.pc_ = addr;
+    }
+
+    // Bxx: branch if flag `Bit` equals `Expect`
+    template <unsigned Bit, bool Expect>
+    struct Branch
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const addr = Mode::address(cpu).addr;
+            bool const actual = flag<Bit>(cpu);
+            if (actual == Expect) {
+                branch(cpu, addr);
+            }
+        }
+    };
+    using BPL = Branch<N, false>;
+    using BMI = Branch<N, true>;
+    using BVC = Branch<V, false>;
+    using BVS = Branch<V, true>;
+    using BCC = Branch<C, false>;
+    using BCS = Branch<C, true>;
+    using BNE = Branch<Z, false>;
+    using BEQ = Branch<Z, true>;
+
+    struct BRA
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            branch(cpu, Mode::address(cpu).addr);
+        }
+    };
+
+    template <unsigned Bit, bool Value>
+    struct Flag
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            flag<Bit>(cpu, Value);
+        }
+    };
+    using CLC = Flag<C, false>;
+    using SEC = Flag<C, true>;
+    using CLI = Flag<I, false>;
+    using SEI = Flag<I, true>;
+    using CLV = Flag<V, false>;
+    using CLD = Flag<D, false>;
+    using SED = Flag<D, true>;
+
+    template <u8 Core::*From, u8 Core::*To, bool Flags>
+    struct Transfer
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            auto const m = cpu.*From;
+            cpu.*To = m;
+            if (Flags) {
+                set_nz(cpu, m);
+            }
+        }
+    };
+    using TAX = Transfer<&Core::a_, &Core::x_, true>;
+    using TAY = Transfer<&Core::a_, &Core::y_, true>;
+    using TSX = Transfer<&Core::s_, &Core::x_, true>;
+    using TXA = Transfer<&Core::x_, &Core::a_, true>;
+    using TXS = Transfer<&Core::x_, &Core::s_, false>;
+    using TYA = Transfer<&Core::y_, &Core::a_, true>;
+
+    template <u8 Core::*Register>
+    struct Load
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const m = load<Mode>(cpu);
+            cpu.*Register = m;
+            set_nz(cpu, m);
+        }
+    };
+    using LDA = Load<&Core::a_>;
+    using LDX = Load<&Core::x_>;
+    using LDY = Load<&Core::y_>;
+
+    template <u8 Core::*Register>
+    struct Store
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            store<Mode>(cpu, cpu.*Register);
+        }
+    };
+    using STA = Store<&Core::a_>;
+    using STX = Store<&Core::x_>;
+    using STY = Store<&Core::y_>;
+
+    struct STZ
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            store<Mode>(cpu, 0x00);
+        }
+    };
+
+    template <u8 Core::*Register>
+    struct Compare
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const m = load<Mode>(cpu);
+            auto const src = cpu.*Register;
+            u8 const result = u8(src - m);
+            flag<C>(cpu, s8(src) >= s8(m));
+            set_nz(cpu, result);
+        }
+    };
+    using CMP = Compare<&Core::a_>;
+    using CPX = Compare<&Core::x_>;
+    using CPY = Compare<&Core::y_>;
+
+    template <u8 Core::*Register, int Delta>
+    struct Increment
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.cycle();
+            u8 const m = u8(cpu.*Register + Delta);
+            cpu.*Register = m;
+            set_nz(cpu, m);
+        }
+    };
+    using INX = Increment<&Core::x_, +1>;
+    using INY = Increment<&Core::y_, +1>;
+    using DEX = Increment<&Core::x_, -1>;
+    using DEY = Increment<&Core::y_, -1>;
+
+    struct ORA
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.a_ = cpu.a_ | load<Mode>(cpu);
+            set_nz(cpu, cpu.a_);
+        }
+    };
+
+    struct AND
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.a_ = cpu.a_ & load<Mode>(cpu);
+            set_nz(cpu, cpu.a_);
+        }
+    };
+
+    struct EOR
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            cpu.a_ = cpu.a_ ^ load<Mode>(cpu);
+            set_nz(cpu, cpu.a_);
+        }
+    };
+
+    // Decimal ADC and SBC: NMOS parts leave N, V and Z as the binary
+    // operation sets them, the 65C02 sets N and Z from the BCD result and
+    // takes a cycle more.
+    FCE_ALWAYS_INLINE static auto adc_decimal(Core& cpu, u8 a, u8 m) noexcept -> void
+    {
+        unsigned const c = flag<C>(cpu);
+        unsigned lo = (a & 0x0Fu) + (m & 0x0Fu) + c;
+        if (lo > 0x09) {
+            lo += 0x06;
+        }
+        unsigned hi = (a >> 4) + (m >> 4) + (lo > 0x0F);
+        if constexpr (!Variant::cmos) {
+            flag<Z>(cpu, u8(a + m + c) == 0x00);
+            flag<N>(cpu, hi & 0x08);
+        }
+        flag<V>(cpu, ((hi << 4) ^ a) & ~(a ^ m) & 0x80);
+        if (hi > 0x09) {
+            hi += 0x06;
+        }
+        flag<C>(cpu, hi > 0x0F);
+        cpu.a_ = u8(hi << 4 | (lo & 0x0F));
+        if constexpr (Variant::cmos) {
+            cpu.cycle();
+            set_nz(cpu, cpu.a_);
+        }
+    }
+
+    FCE_ALWAYS_INLINE static auto sbc_decimal(Core& cpu, u8 a, u8 m, bool borrow) noexcept -> void
+    {
+        int lo = (a & 0x0F) - (m & 0x0F) - int(borrow);
+        int hi = (a >> 4) - (m >> 4);
+        if (lo < 0) {
+            lo -= 0x06;
+            --hi;
+        }
+        if (hi < 0) {
+            hi -= 0x06;
+        }
+        cpu.a_ = u8(hi << 4 | (lo & 0x0F));
+        if constexpr (Variant::cmos) {
+            cpu.cycle();
+            set_nz(cpu, cpu.a_);
+        }
+    }
+
+    struct ADC
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const m = load<Mode>(cpu);
+            auto const a = cpu.a_;
+            if constexpr (Variant::decimal) {
+                if (flag<D>(cpu)) {
+                    adc_decimal(cpu, a, m);
+                    return;
+                }
+            }
+            u16 const sum = u16(a + m + flag<C>(cpu));
+            u8 const result = u8(sum);
+            flag<C>(cpu, result != sum);
+            flag<V>(cpu, (a ^ result) & (m ^ result) & 0x80);
+            cpu.a_ = result;
+            set_nz(cpu, result);
+        }
+    };
+
+    struct SBC
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const m = load<Mode>(cpu);
+            auto const a = cpu.a_;
+            bool const borrow = !flag<C>(cpu);
+            u16 const diff = u16(a - m - borrow);
+            u8 const result = u8(diff);
+            flag<C>(cpu, result == diff);
+            flag<V>(cpu, ((a ^ result) ^ (m ^ result)) & 0x80);
+            cpu.a_ = result;
+            set_nz(cpu, result);
+            if constexpr (Variant::decimal) {
+                if (flag<D>(cpu)) {
+                    sbc_decimal(cpu, a, m, borrow);
+                }
+            }
+        }
+    };
+
+    struct BIT
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const result = cpu.a_ & load<Mode>(cpu);
+            if constexpr (!std::is_same<Mode, IMM>::value) {
+                flag<N>(cpu, result & 0x80);
+                flag<V>(cpu, result & 0x40);
+            }
+            flag<Z>(cpu, result == 0x00);
+        }
+    };
+
+    // TSB/TRB: test and set/reset bits of memory with A, 65C02 only
+    template <bool Set>
+    struct TestBits
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const addr = Mode::address(cpu).addr;
+            auto const m = cpu.get_memory(addr);
+            cpu.cycle();
+            flag<Z>(cpu, (cpu.a_ & m) == 0x00);
+            cpu.set_memory(addr, Set ? u8(m | cpu.a_) : u8(m & ~cpu.a_));
+        }
+    };
+    using TSB = TestBits<true>;
+    using TRB = TestBits<false>;
+
+    // RMB/SMB: reset/set bit `Bit` of memory, 65C02 only
+    template <unsigned Bit, bool Set>
+    struct MemoryBit
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const addr = Mode::address(cpu).addr;
+            auto const m = cpu.get_memory(addr);
+            cpu.cycle();
+            cpu.set_memory(addr, Set ? u8(m | 1u << Bit) : u8(m & ~(1u << Bit)));
+        }
+    };
+    using RMB0 = MemoryBit<0, false>;
+    using RMB1 = MemoryBit<1, false>;
+    using RMB2 = MemoryBit<2, false>;
+    using RMB3 = MemoryBit<3, false>;
+    using RMB4 = MemoryBit<4, false>;
+    using RMB5 = MemoryBit<5, false>;
+    using RMB6 = MemoryBit<6, false>;
+    using RMB7 = MemoryBit<7, false>;
+    using SMB0 = MemoryBit<0, true>;
+    using SMB1 = MemoryBit<1, true>;
+    using SMB2 = MemoryBit<2, true>;
+    using SMB3 = MemoryBit<3, true>;
+    using SMB4 = MemoryBit<4, true>;
+    using SMB5 = MemoryBit<5, true>;
+    using SMB6 = MemoryBit<6, true>;
+    using SMB7 = MemoryBit<7, true>;
+
+    // BBR/BBS: branch if bit `Bit` of memory equals `Expect`, 65C02 only
+    template <unsigned Bit, bool Expect>
+    struct BranchOnBit
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            auto const m = cpu.get_memory(fetch(cpu));
+            cpu.cycle();
+            auto const addr = REL::address(cpu).addr;
+            if (bool(m >> Bit & 1) == Expect) {
+                branch(cpu, addr);
+            }
+        }
+    };
+    using BBR0 = BranchOnBit<0, false>;
+    using BBR1 = BranchOnBit<1, false>;
+    using BBR2 = BranchOnBit<2, false>;
+    using BBR3 = BranchOnBit<3, false>;
+    using BBR4 = BranchOnBit<4, false>;
+    using BBR5 = BranchOnBit<5, false>;
+    using BBR6 = BranchOnBit<6, false>;
+    using BBR7 = BranchOnBit<7, false>;
+    using BBS0 = BranchOnBit<0, true>;
+    using BBS1 = BranchOnBit<1, true>;
+    using BBS2 = BranchOnBit<2, true>;
+    using BBS3 = BranchOnBit<3, true>;
+    using BBS4 = BranchOnBit<4, true>;
+    using BBS5 = BranchOnBit<5, true>;
+    using BBS6 = BranchOnBit<6, true>;
+    using BBS7 = BranchOnBit<7, true>;
+
+    struct ASL
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            modify<Mode, true>(cpu, [](Core& c, u8 m) {
+                flag<C>(c, m & 0x80);
+                return u8(m << 1);
+            });
+        }
+    };
+
+    struct ROL
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            modify<Mode, true>(cpu, [](Core& c, u8 m) {
+                flag<C>(c, m & 0x80);
+                return u8(m << 1 | (m & 0x80) >> 7);
+            });
+        }
+    };
+
+    struct LSR
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            modify<Mode, true>(cpu, [](Core& c, u8 m) {
+                flag<C>(c, m & 0x01);
+                return u8(m >> 1);
+            });
+        }
+    };
+
+    struct ROR
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            modify<Mode, true>(cpu, [](Core& c, u8 m) {
+                flag<C>(c, m & 0x01);
+                return u8(m >> 1 | (m & 0x01) << 7);
+            });
+        }
+    };
+
+    struct INC
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            modify<Mode>(cpu, [](Core&, u8 m) { return u8(m + 1); });
+        }
+    };
+
+    struct DEC
+    {
+        template <typename Mode>
+        FCE_ALWAYS_INLINE static auto run(Core& cpu) noexcept -> void
+        {
+            modify<Mode>(cpu, [](Core&, u8 m) { return u8(m - 1); });
+        }
+    };
+};
+
+// The opcode matrix as X(opcode, mode, operation), for generating dispatch
+// tables and switch statements. Unofficial opcodes are not emulated and behave
+// as a one byte NOP.
+#define FCE_OPCODES(X) \
+    X(0x00, IMP, BRK) X(0x01, IDX, ORA) X(0x02, IMP, NOP) X(0x03, IMP, NOP) \
+    X(0x04, IMP, NOP) X(0x05, ZPG, ORA) X(0x06, ZPG, ASL) X(0x07, IMP, NOP) \
+    X(0x08, IMP, PHP) X(0x09, IMM, ORA) X(0x0A, ACC, ASL) X(0x0B, IMP, NOP) \
+    X(0x0C, IMP, NOP) X(0x0D, ABS, ORA) X(0x0E, ABS, ASL) X(0x0F, IMP, NOP) \
+    X(0x10, REL, BPL) X(0x11, IDY, ORA) X(0x12, IMP, NOP) X(0x13, IMP, NOP) \
+    X(0x14, IMP, NOP) X(0x15, ZPX, ORA) X(0x16, ZPX, ASL) X(0x17, IMP, NOP) \
+    X(0x18, IMP, CLC) X(0x19, ABY, ORA) X(0x1A, IMP, NOP) X(0x1B, IMP, NOP) \
+    X(0x1C, IMP, NOP) X(0x1D, ABX, ORA) X(0x1E, ABX, ASL) X(0x1F, IMP, NOP) \
+    X(0x20, ABS, JSR) X(0x21, IDX, AND) X(0x22, IMP, NOP) X(0x23, IMP, NOP) \
+    X(0x24, ZPG, BIT) X(0x25, ZPG, AND) X(0x26, ZPG, ROL) X(0x27, IMP, NOP) \
+    X(0x28, IMP, PLP) X(0x29, IMM, AND) X(0x2A, ACC, ROL) X(0x2B, IMP, NOP) \
+    X(0x2C, ABS, BIT) X(0x2D, ABS, AND) X(0x2E, ABS, ROL) X(0x2F, IMP, NOP) \
+    X(0x30, REL, BMI) X(0x31, IDY, AND) X(0x32, IMP, NOP) X(0x33, IMP, NOP) \
+    X(0x34, IMP, NOP) X(0x35, ZPX, AND) X(0x36, ZPX, ROL) X(0x37, IMP, NOP) \
+    X(0x38, IMP, SEC) X(0x39, ABY, AND) X(0x3A, IMP, NOP) X(0x3B, IMP, NOP) \
+    X(0x3C, IMP, NOP) X(0x3D, ABX, AND) X(0x3E, ABX, ROL) X(0x3F, IMP, NOP) \
+    X(0x40, IMP, RTI) X(0x41, IDX, EOR) X(0x42, IMP, NOP) X(0x43, IMP, NOP) \
+    X(0x44, IMP, NOP) X(0x45, ZPG, EOR) X(0x46, ZPG, LSR) X(0x47, IMP, NOP) \
+    X(0x48, IMP, PHA) X(0x49, IMM, EOR) X(0x4A, ACC, LSR) X(0x4B, IMP, NOP) \
+    X(0x4C, ABS, JMP) X(0x4D, ABS, EOR) X(0x4E, ABS, LSR) X(0x4F, IMP, NOP) \
+    X(0x50, REL, BVC) X(0x51, IDY, EOR) X(0x52, IMP, NOP) X(0x53, IMP, NOP) \
+    X(0x54, IMP, NOP) X(0x55, ZPX, EOR) X(0x56, ZPX, LSR) X(0x57, IMP, NOP) \
+    X(0x58, IMP, CLI) X(0x59, ABY, EOR) X(0x5A, IMP, NOP) X(0x5B, IMP, NOP) \
+    X(0x5C, IMP, NOP) X(0x5D, ABX, EOR) X(0x5E, ABX, LSR) X(0x5F, IMP, NOP) \
+    X(0x60, IMP, RTS) X(0x61, IDX, ADC) X(0x62, IMP, NOP) X(0x63, IMP, NOP) \
+    X(0x64, IMP, NOP) X(0x65, ZPG, ADC) X(0x66, ZPG, ROR) X(0x67, IMP, NOP) \
+    X(0x68, IMP, PLA) X(0x69, IMM, ADC) X(0x6A, ACC, ROR) X(0x6B, IMP, NOP) \
+    X(0x6C, IND, JMP) X(0x6D, ABS, ADC) X(0x6E, ABS, ROR) X(0x6F, IMP, NOP) \
+    X(0x70, REL, BVS) X(0x71, IDY, ADC) X(0x72, IMP, NOP) X(0x73, IMP, NOP) \
+    X(0x74, IMP, NOP) X(0x75, ZPX, ADC) X(0x76, ZPX, ROR) X(0x77, IMP, NOP) \
+    X(0x78, IMP, SEI) X(0x79, ABY, ADC) X(0x7A, IMP, NOP) X(0x7B, IMP, NOP) \
+    X(0x7C, IMP, NOP) X(0x7D, ABX, ADC) X(0x7E, ABX, ROR) X(0x7F, IMP, NOP) \
+    X(0x80, IMP, NOP) X(0x81, IDX, STA) X(0x82, IMP, NOP) X(0x83, IMP, NOP) \
+    X(0x84, ZPG, STY) X(0x85, ZPG, STA) X(0x86, ZPG, STX) X(0x87, IMP, NOP) \
+    X(0x88, IMP, DEY) X(0x89, IMP, NOP) X(0x8A, IMP, TXA) X(0x8B, IMP, NOP) \
+    X(0x8C, ABS, STY) X(0x8D, ABS, STA) X(0x8E, ABS, STX) X(0x8F, IMP, NOP) \
+    X(0x90, REL, BCC) X(0x91, IDY, STA) X(0x92, IMP, NOP) X(0x93, IMP, NOP) \
+    X(0x94, ZPX, STY) X(0x95, ZPX, STA) X(0x96, ZPY, STX) X(0x97, IMP, NOP) \
+    X(0x98, IMP, TYA) X(0x99, ABY, STA) X(0x9A, IMP, TXS) X(0x9B, IMP, NOP) \
+    X(0x9C, IMP, NOP) X(0x9D, ABX, STA) X(0x9E, IMP, NOP) X(0x9F, IMP, NOP) \
+    X(0xA0, IMM, LDY) X(0xA1, IDX, LDA) X(0xA2, IMM, LDX) X(0xA3, IMP, NOP) \
+    X(0xA4, ZPG, LDY) X(0xA5, ZPG, LDA) X(0xA6, ZPG, LDX) X(0xA7, IMP, NOP) \
+    X(0xA8, IMP, TAY) X(0xA9, IMM, LDA) X(0xAA, IMP, TAX) X(0xAB, IMP, NOP) \
+    X(0xAC, ABS, LDY) X(0xAD, ABS, LDA) X(0xAE, ABS, LDX) X(0xAF, IMP, NOP) \
+    X(0xB0, REL, BCS) X(0xB1, IDY, LDA) X(0xB2, IMP, NOP) X(0xB3, IMP, NOP) \
+    X(0xB4, ZPX, LDY) X(0xB5, ZPX, LDA) X(0xB6, ZPY, LDX) X(0xB7, IMP, NOP) \
+    X(0xB8, IMP, CLV) X(0xB9, ABY, LDA) X(0xBA, IMP, TSX) X(0xBB, IMP, NOP) \
+    X(0xBC, ABX, LDY) X(0xBD, ABX, LDA) X(0xBE, ABY, LDX) X(0xBF, IMP, NOP) \
+    X(0xC0, IMM, CPY) X(0xC1, IDX, CMP) X(0xC2, IMP, NOP) X(0xC3, IMP, NOP) \
+    X(0xC4, ZPG, CPY) X(0xC5, ZPG, CMP) X(0xC6, ZPG, DEC) X(0xC7, IMP, NOP) \
+    X(0xC8, IMP, INY) X(0xC9, IMM, CMP) X(0xCA, IMP, DEX) X(0xCB, IMP, NOP) \
+    X(0xCC, ABS, CPY) X(0xCD, ABS, CMP) X(0xCE, ABS, DEC) X(0xCF, IMP, NOP) \
+    X(0xD0, REL, BNE) X(0xD1, IDY, CMP) X(0xD2, IMP, NOP) X(0xD3, IMP, NOP) \
+    X(0xD4, IMP, NOP) X(0xD5, ZPX, CMP) X(0xD6, ZPX, DEC) X(0xD7, IMP, NOP) \
+    X(0xD8, IMP, CLD) X(0xD9, ABY, CMP) X(0xDA, IMP, NOP) X(0xDB, IMP, NOP) \
+    X(0xDC, IMP, NOP) X(0xDD, ABX, CMP) X(0xDE, ABX, DEC) X(0xDF, IMP, NOP) \
+    X(0xE0, IMM, CPX) X(0xE1, IDX, SBC) X(0xE2, IMP, NOP) X(0xE3, IMP, NOP) \
+    X(0xE4, ZPG, CPX) X(0xE5, ZPG, SBC) X(0xE6, ZPG, INC) X(0xE7, IMP, NOP) \
+    X(0xE8, IMP, INX) X(0xE9, IMM, SBC) X(0xEA, IMP, NOP) X(0xEB, IMP, NOP) \
+    X(0xEC, ABS, CPX) X(0xED, ABS, SBC) X(0xEE, ABS, INC) X(0xEF, IMP, NOP) \
+    X(0xF0, REL, BEQ) X(0xF1, IDY, SBC) X(0xF2, IMP, NOP) X(0xF3, IMP, NOP) \
+    X(0xF4, IMP, NOP) X(0xF5, ZPX, SBC) X(0xF6, ZPX, INC) X(0xF7, IMP, NOP) \
+    X(0xF8, IMP, SED) X(0xF9, ABY, SBC) X(0xFA, IMP, NOP) X(0xFB, IMP, NOP) \
+    X(0xFC, IMP, NOP) X(0xFD, ABX, SBC) X(0xFE, ABX, INC) X(0xFF, IMP, NOP)
+
+// The same for the 65C02, with its new instructions and addressing modes,
+// the Rockwell and WDC bit instructions among them. Opcodes it leaves
+// unassigned are NOPs of the length and timing of the 65C02's: columns 3
+// and B take a byte and a cycle, the others read operands as their modes
+// do.
+#define FCE_OPCODES_65C02(X) \
+    X(0x00, IMP, BRK) X(0x01, IDX, ORA) X(0x02, IMM, NOP) X(0x03, IMP, NOP1) \
+    X(0x04, ZPG, TSB) X(0x05, ZPG, ORA) X(0x06, ZPG, ASL) X(0x07, ZPG, RMB0) \
+    X(0x08, IMP, PHP) X(0x09, IMM, ORA) X(0x0A, ACC, ASL) X(0x0B, IMP, NOP1) \
+    X(0x0C, ABS, TSB) X(0x0D, ABS, ORA) X(0x0E, ABS, ASL) X(0x0F, ZPR, BBR0) \
+    X(0x10, REL, BPL) X(0x11, IDY, ORA) X(0x12, ZPI, ORA) X(0x13, IMP, NOP1) \
+    X(0x14, ZPG, TRB) X(0x15, ZPX, ORA) X(0x16, ZPX, ASL) X(0x17, ZPG, RMB1) \
+    X(0x18, IMP, CLC) X(0x19, ABY, ORA) X(0x1A, ACC, INC) X(0x1B, IMP, NOP1) \
+    X(0x1C, ABS, TRB) X(0x1D, ABX, ORA) X(0x1E, ABX, ASL) X(0x1F, ZPR, BBR1) \
+    X(0x20, ABS, JSR) X(0x21, IDX, AND) X(0x22, IMM, NOP) X(0x23, IMP, NOP1) \
+    X(0x24, ZPG, BIT) X(0x25, ZPG, AND) X(0x26, ZPG, ROL) X(0x27, ZPG, RMB2) \
+    X(0x28, IMP, PLP) X(0x29, IMM, AND) X(0x2A, ACC, ROL) X(0x2B, IMP, NOP1) \
+    X(0x2C, ABS, BIT) X(0x2D, ABS, AND) X(0x2E, ABS, ROL) X(0x2F, ZPR, BBR2) \
+    X(0x30, REL, BMI) X(0x31, IDY, AND) X(0x32, ZPI, AND) X(0x33, IMP, NOP1) \
+    X(0x34, ZPX, BIT) X(0x35, ZPX, AND) X(0x36, ZPX, ROL) X(0x37, ZPG, RMB3) \
+    X(0x38, IMP, SEC) X(0x39, ABY, AND) X(0x3A, ACC, DEC) X(0x3B, IMP, NOP1) \
+    X(0x3C, ABX, BIT) X(0x3D, ABX, AND) X(0x3E, ABX, ROL) X(0x3F, ZPR, BBR3) \
+    X(0x40, IMP, RTI) X(0x41, IDX, EOR) X(0x42, IMM, NOP) X(0x43, IMP, NOP1) \
+    X(0x44, ZPG, NOP) X(0x45, ZPG, EOR) X(0x46, ZPG, LSR) X(0x47, ZPG, RMB4) \
+    X(0x48, IMP, PHA) X(0x49, IMM, EOR) X(0x4A, ACC, LSR) X(0x4B, IMP, NOP1) \
+    X(0x4C, ABS, JMP) X(0x4D, ABS, EOR) X(0x4E, ABS, LSR) X(0x4F, ZPR, BBR4) \
+    X(0x50, REL, BVC) X(0x51, IDY, EOR) X(0x52, ZPI, EOR) X(0x53, IMP, NOP1) \
+    X(0x54, ZPX, NOP) X(0x55, ZPX, EOR) X(0x56, ZPX, LSR) X(0x57, ZPG, RMB5) \
+    X(0x58, IMP, CLI) X(0x59, ABY, EOR) X(0x5A, IMP, PHY) X(0x5B, IMP, NOP1) \
+    X(0x5C, ABS, NOP8) X(0x5D, ABX, EOR) X(0x5E, ABX, LSR) X(0x5F, ZPR, BBR5) \
+    X(0x60, IMP, RTS) X(0x61, IDX, ADC) X(0x62, IMM, NOP) X(0x63, IMP, NOP1) \
+    X(0x64, ZPG, STZ) X(0x65, ZPG, ADC) X(0x66, ZPG, ROR) X(0x67, ZPG, RMB6) \
+    X(0x68, IMP, PLA) X(0x69, IMM, ADC) X(0x6A, ACC, ROR) X(0x6B, IMP, NOP1) \
+    X(0x6C, IND, JMP) X(0x6D, ABS, ADC) X(0x6E, ABS, ROR) X(0x6F, ZPR, BBR6) \
+    X(0x70, REL, BVS) X(0x71, IDY, ADC) X(0x72, ZPI, ADC) X(0x73, IMP, NOP1) \
+    X(0x74, ZPX, STZ) X(0x75, ZPX, ADC) X(0x76, ZPX, ROR) X(0x77, ZPG, RMB7) \
+    X(0x78, IMP, SEI) X(0x79, ABY, ADC) X(0x7A, IMP, PLY) X(0x7B, IMP, NOP1) \
+    X(0x7C, IAX, JMP) X(0x7D, ABX, ADC) X(0x7E, ABX, ROR) X(0x7F, ZPR, BBR7) \
+    X(0x80, REL, BRA) X(0x81, IDX, STA) X(0x82, IMM, NOP) X(0x83, IMP, NOP1) \
+    X(0x84, ZPG, STY) X(0x85, ZPG, STA) X(0x86, ZPG, STX) X(0x87, ZPG, SMB0) \
+    X(0x88, IMP, DEY) X(0x89, IMM, BIT) X(0x8A, IMP, TXA) X(0x8B, IMP, NOP1) \
+    X(0x8C, ABS, STY) X(0x8D, ABS, STA) X(0x8E, ABS, STX) X(0x8F, ZPR, BBS0) \
+    X(0x90, REL, BCC) X(0x91, IDY, STA) X(0x92, ZPI, STA) X(0x93, IMP, NOP1) \
+    X(0x94, ZPX, STY) X(0x95, ZPX, STA) X(0x96, ZPY, STX) X(0x97, ZPG, SMB1) \
+    X(0x98, IMP, TYA) X(0x99, ABY, STA) X(0x9A, IMP, TXS) X(0x9B, IMP, NOP1) \
+    X(0x9C, ABS, STZ) X(0x9D, ABX, STA) X(0x9E, ABX, STZ) X(0x9F, ZPR, BBS1) \
+    X(0xA0, IMM, LDY) X(0xA1, IDX, LDA) X(0xA2, IMM, LDX) X(0xA3, IMP, NOP1) \
+    X(0xA4, ZPG, LDY) X(0xA5, ZPG, LDA) X(0xA6, ZPG, LDX) X(0xA7, ZPG, SMB2) \
+    X(0xA8, IMP, TAY) X(0xA9, IMM, LDA) X(0xAA, IMP, TAX) X(0xAB, IMP, NOP1) \
+    X(0xAC, ABS, LDY) X(0xAD, ABS, LDA) X(0xAE, ABS, LDX) X(0xAF, ZPR, BBS2) \
+    X(0xB0, REL, BCS) X(0xB1, IDY, LDA) X(0xB2, ZPI, LDA) X(0xB3, IMP, NOP1) \
+    X(0xB4, ZPX, LDY) X(0xB5, ZPX, LDA) X(0xB6, ZPY, LDX) X(0xB7, ZPG, SMB3) \
+    X(0xB8, IMP, CLV) X(0xB9, ABY, LDA) X(0xBA, IMP, TSX) X(0xBB, IMP, NOP1) \
+    X(0xBC, ABX, LDY) X(0xBD, ABX, LDA) X(0xBE, ABY, LDX) X(0xBF, ZPR, BBS3) \
+    X(0xC0, IMM, CPY) X(0xC1, IDX, CMP) X(0xC2, IMM, NOP) X(0xC3, IMP, NOP1) \
+    X(0xC4, ZPG, CPY) X(0xC5, ZPG, CMP) X(0xC6, ZPG, DEC) X(0xC7, ZPG, SMB4) \
+    X(0xC8, IMP, INY) X(0xC9, IMM, CMP) X(0xCA, IMP, DEX) X(0xCB, IMP, WAI) \
+    X(0xCC, ABS, CPY) X(0xCD, ABS, CMP) X(0xCE, ABS, DEC) X(0xCF, ZPR, BBS4) \
+    X(0xD0, REL, BNE) X(0xD1, IDY, CMP) X(0xD2, ZPI, CMP) X(0xD3, IMP, NOP1) \
+    X(0xD4, ZPX, NOP) X(0xD5, ZPX, CMP) X(0xD6, ZPX, DEC) X(0xD7, ZPG, SMB5) \
+    X(0xD8, IMP, CLD) X(0xD9, ABY, CMP) X(0xDA, IMP, PHX) X(0xDB, IMP, STP) \
+    X(0xDC, ABS, NOP) X(0xDD, ABX, CMP) X(0xDE, ABX, DEC) X(0xDF, ZPR, BBS5) \
+    X(0xE0, IMM, CPX) X(0xE1, IDX, SBC) X(0xE2, IMM, NOP) X(0xE3, IMP, NOP1) \
+    X(0xE4, ZPG, CPX) X(0xE5, ZPG, SBC) X(0xE6, ZPG, INC) X(0xE7, ZPG, SMB6) \
+    X(0xE8, IMP, INX) X(0xE9, IMM, SBC) X(0xEA, IMP, NOP) X(0xEB, IMP, NOP1) \
+    X(0xEC, ABS, CPX) X(0xED, ABS, SBC) X(0xEE, ABS, INC) X(0xEF, ZPR, BBS6) \
+    X(0xF0, REL, BEQ) X(0xF1, IDY, SBC) X(0xF2, ZPI, SBC) X(0xF3, IMP, NOP1) \
+    X(0xF4, ZPX, NOP) X(0xF5, ZPX, SBC) X(0xF6, ZPX, INC) X(0xF7, ZPG, SMB7) \
+    X(0xF8, IMP, SED) X(0xF9, ABY, SBC) X(0xFA, IMP, PLX) X(0xFB, IMP, NOP1) \
+    X(0xFC, ABS, NOP) X(0xFD, ABX, SBC) X(0xFE, ABX, INC) X(0xFF, ZPR, BBS7)
+
+template <typename Core>
+constexpr auto Instructions<Core>::make_table() noexcept -> std::array<Handler, 0x100>
+{
+#define FCE_HANDLER(opcode, mode, operation) &execute<mode, operation>,
+    if constexpr (Variant::cmos) {
+        return {{FCE_OPCODES_65C02(FCE_HANDLER)}};
+    } else {
+        return {{FCE_OPCODES(FCE_HANDLER)}};
+    }
+#undef FCE_HANDLER
+}
+
+template <typename Core>
+constexpr std::array<typename Instructions<Core>::Handler, 0x100> Instructions<Core>::table = make_table();
+
+// The addressing mode of every opcode, for code that looks at instructions
+// without executing them.
+enum class AddressingMode : u8
+{
+    IMP, ACC, IMM, ZPG, ZPX, ZPY, ABS, ABX, ABY, IND, IDX, IDY, REL,
+    ZPI, IAX, ZPR,  // 65C02 only
+};
+
+#define FCE_MODE(opcode, mode, operation) AddressingMode::mode,
+constexpr std::array<AddressingMode, 0x100> addressing_modes = {{FCE_OPCODES(FCE_MODE)}};
+constexpr std::array<AddressingMode, 0x100> addressing_modes_65c02 = {{FCE_OPCODES_65C02(FCE_MODE)}};
+#undef FCE_MODE
+
+// The mnemonic of an operation; the 65C02's one and eight cycle NOPs are
+// NOPs to assemblers.
+constexpr auto mnemonic_of(char const *operation) noexcept -> char const *
+{
+    return operation[0] == 'N' && operation[1] == 'O' && operation[2] == 'P' ? "NOP" : operation;
+}
+
+#define FCE_MNEMONIC(opcode, mode, operation) mnemonic_of(#operation),
+constexpr std::array<char const *, 0x100> mnemonics = {{FCE_OPCODES(FCE_MNEMONIC)}};
+constexpr std::array<char const *, 0x100> mnemonics_65c02 = {{FCE_OPCODES_65C02(FCE_MNEMONIC)}};
+#undef FCE_MNEMONIC
+
+// Number of operand bytes following the opcode.
+constexpr auto operand_size(AddressingMode mode) noexcept -> unsigned
+{
+    switch (mode) {
+    case AddressingMode::IMP:
+    case AddressingMode::ACC:
+        return 0;
+    case AddressingMode::ABS:
+    case AddressingMode::ABX:
+    case AddressingMode::ABY:
+    case AddressingMode::IND:
+    case AddressingMode::IAX:
+    case AddressingMode::ZPR:
+        return 2;
+    case AddressingMode::IMM:
+    case AddressingMode::ZPG:
+    case AddressingMode::ZPX:
+    case AddressingMode::ZPY:
+    case AddressingMode::IDX:
+    case AddressingMode::IDY:
+    case AddressingMode::REL:
+    case AddressingMode::ZPI:
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace fce
+
+#endif  // FCE_INSTRUCTIONS_HPP_
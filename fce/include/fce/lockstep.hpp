@@ -0,0 +1,408 @@
+#ifndef FCE_LOCKSTEP_HPP_
+#define FCE_LOCKSTEP_HPP_
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include <fce/types.hpp>
+#include <fce/cpu.hpp>
+#include <fce/instructions.hpp>
+#include <fce/pixel_pipeline.hpp>
+
+namespace fce {
+
+// The registers and RAM of a Lockstep, for its kernels: an element per lane
+// of each array, and `lanes` bytes per address of RAM.
+struct LockstepLanes
+{
+    u8 *a;
+    u8 *x;
+    u8 *y;
+    u8 *s;
+    u8 *p;
+    u16 *pc;
+    u64 *cycles;
+    u8 *ram;
+    std::size_t lanes;
+};
+
+// Executes the instruction at `pc` on the lanes whose byte of `on` is 0xFF.
+using LockstepKernel = auto (*)(LockstepLanes const& lanes, u8 const *on, u16 pc) noexcept -> void;
+
+// The kernels of a Simd for Lockstep, for lanes in multiples of 8. Those
+// missing are null, and all of them without SIMD.
+struct LockstepKernels
+{
+    // By opcode, but for those left to the scalar handlers.
+    std::array<LockstepKernel, 0x100> execute;
+    // Lockstep::group(): the lanes of `active` at `pc` with `opcode` there,
+    // as a mask and as bytes of `on`.
+    auto (*group)(LockstepLanes const& lanes, u64 active, u16 pc, u8 opcode, u8 *on) noexcept -> u64;
+    // The lanes whose clock is short of `end`.
+    auto (*running)(LockstepLanes const& lanes, u64 const *end) noexcept -> u64;
+};
+
+auto lockstep_kernels(Simd simd) noexcept -> LockstepKernels const&;
+
+// `Lanes` 6502s over 64 KiB of RAM each, executed in lockstep, for running
+// one program on many inputs, e.g. a brute-force search.
+//
+// The registers are kept as a structure of arrays, one element per lane,
+// and RAM interleaved, the lanes' bytes of an address side by side. Every
+// step() picks the lane furthest behind on its clock and executes the
+// instruction at its PC on every lane at the same PC with the same opcode;
+// the other lanes are masked out until the lanes reconverge.
+//
+// Instructions are executed by the same Instructions as CPU's, so lanes
+// produce the cycles and results a CPU<FlatRamBus> does. Those that touch
+// no memory but their operand bytes, e.g. register transfers, immediate
+// arithmetic and branches, run as one pass over all lanes without
+// branches, dropping the results of the masked lanes, which compilers
+// vectorize for the target. The others run lane by lane.
+//
+// Where the CPU has AVX2 and the lanes come in multiples of 8, all but
+// BRK, RTI and JMP (a) run as LockstepKernels instead, 8 lanes to a vector,
+// reading memory by gathers, and so do the grouping of lanes and the
+// checks of their clocks. The op tests hold them to the same results.
+//
+// There are no interrupt lines.
+template <std::size_t Lanes>
+class Lockstep
+{
+public:
+    static_assert(Lanes > 0 && Lanes <= 64, "lanes must fit a Mask");
+
+    // One bit per lane.
+    using Mask = u64;
+
+    static constexpr Mask all = Lanes == 64 ? ~Mask{0} : (Mask{1} << Lanes) - 1;
+
+    // Every lane with zeroed RAM and registers, at cycle 0, running the
+    // kernels of `simd`, if it has any for them.
+    explicit Lockstep(Simd simd = detect_simd())
+        : ram_{std::make_unique<u8[]>(Lanes * 0x10000 + padding)},
+          simd_{Lanes % 8 == 0 && simd == Simd::avx2 ? simd : Simd::none},
+          kernels_{&lockstep_kernels(simd_)}
+    {
+    }
+
+    static constexpr auto lanes() noexcept -> std::size_t { return Lanes; }
+
+    auto simd() const noexcept -> Simd { return simd_; }
+
+    // Copies the 64 KiB of `image` to the RAM of `lane`, and back.
+    auto load(std::size_t lane, u8 const *image) noexcept -> void
+    {
+        for (std::size_t addr = 0; addr < 0x10000; addr++) {
+            ram_[addr * Lanes + lane] = image[addr];
+        }
+    }
+
+    auto save(std::size_t lane, u8 *image) const noexcept -> void
+    {
+        for (std::size_t addr = 0; addr < 0x10000; addr++) {
+            image[addr] = ram_[addr * Lanes + lane];
+        }
+    }
+
+    auto get(std::size_t lane, u16 addr) const noexcept -> u8 { return ram_[addr * Lanes + lane]; }
+    auto set(std::size_t lane, u16 addr, u8 v) noexcept -> void { ram_[addr * Lanes + lane] = v; }
+
+    auto state(std::size_t lane) const noexcept -> CpuState
+    {
+        return {cycles_[lane], pc_[lane], a_[lane], x_[lane], y_[lane], s_[lane], p_[lane], 0, 0, {}};
+    }
+
+    auto state(std::size_t lane, CpuState const& state) noexcept -> void
+    {
+        cycles_[lane] = state.cycles;
+        pc_[lane] = state.pc;
+        a_[lane] = state.a;
+        x_[lane] = state.x;
+        y_[lane] = state.y;
+        s_[lane] = state.s;
+        p_[lane] = state.p;
+    }
+
+    // Executes one instruction on the lanes of `active` that run together
+    // with the one furthest behind, and returns those lanes.
+    auto step(Mask active = all) noexcept -> Mask
+    {
+        active &= all;
+        if (active == 0) {
+            return 0;
+        }
+
+        // while the lanes agree any of them leads, otherwise the lane furthest
+        // behind, so that the others can catch up with it
+        auto leader = std::size_t{countr_zero(active)};
+        Bytes on;
+        auto group = this->group(active, leader, on);
+        if (group != active) {
+            u64 earliest = ~u64{0};
+            for (std::size_t lane = 0; lane < Lanes; lane++) {
+                auto const cycles = active >> lane & 1 ? cycles_[lane] : ~u64{0};
+                if (cycles < earliest) {
+                    earliest = cycles;
+                    leader = lane;
+                }
+            }
+            group = this->group(active, leader, on);
+        }
+
+        auto const pc = pc_[leader];
+        auto const opcode = this->get(leader, pc);
+        if (auto const kernel = kernels_->execute[opcode]) {
+            kernel(this->view(), on.data(), pc);
+        } else {
+            table[opcode](*this, group, on, pc);
+        }
+        dispatches_++;
+        executed_ += popcount(group);
+        return group;
+    }
+
+    // Runs every lane of `active` for at least `cycles` cycles of its own
+    // clock.
+    auto run(u64 cycles, Mask active = all) noexcept -> void
+    {
+        std::array<u64, Lanes> end;
+        for (std::size_t lane = 0; lane < Lanes; lane++) {
+            end[lane] = cycles_[lane] + cycles;
+        }
+
+        for (;;) {
+            Mask running = 0;
+            if (kernels_->running) {
+                running = kernels_->running(this->view(), end.data());
+            } else {
+                for (std::size_t lane = 0; lane < Lanes; lane++) {
+                    running |= Mask(cycles_[lane] < end[lane]) << lane;
+                }
+            }
+            running &= active;
+            if (running == 0) {
+                return;
+            }
+            this->step(running);
+        }
+    }
+
+    // Instructions dispatched, and executed summed over the lanes. Their
+    // ratio is the average number of lanes running together.
+    auto dispatches() const noexcept -> u64 { return dispatches_; }
+    auto executed() const noexcept -> u64 { return executed_; }
+
+private:
+    // A byte per lane: registers, and masks of 0x00 or 0xFF.
+    using Bytes = std::array<u8, Lanes>;
+
+    // Kernels read RAM by 32-bit gathers, up to 3 bytes past the last.
+    static constexpr std::size_t padding = 3;
+
+    // One lane, as the core Instructions runs on: its registers are copied
+    // out of the lane arrays and back.
+    struct Lane
+    {
+        u8 a_;
+        u8 x_;
+        u8 y_;
+        u8 s_;
+        u8 p_;
+        u16 pc_;
+        u64 cycles_;
+        u8 *ram_;  // the lane's byte of address 0
+
+        Lane(Lockstep& lockstep, std::size_t lane) noexcept
+            : a_{lockstep.a_[lane]}, x_{lockstep.x_[lane]}, y_{lockstep.y_[lane]}, s_{lockstep.s_[lane]},
+              p_{lockstep.p_[lane]}, pc_{lockstep.pc_[lane]}, cycles_{lockstep.cycles_[lane]},
+              ram_{lockstep.ram_.get() + lane}
+        {
+        }
+
+        auto commit(Lockstep& lockstep, std::size_t lane) const noexcept -> void
+        {
+            lockstep.a_[lane] = a_;
+            lockstep.x_[lane] = x_;
+            lockstep.y_[lane] = y_;
+            lockstep.s_[lane] = s_;
+            lockstep.p_[lane] = p_;
+            lockstep.pc_[lane] = pc_;
+            lockstep.cycles_[lane] = cycles_;
+        }
+
+        FCE_ALWAYS_INLINE auto get_memory(u16 addr) noexcept -> u8
+        {
+            this->cycle();
+            return ram_[addr * Lanes];
+        }
+
+        FCE_ALWAYS_INLINE auto set_memory(u16 addr, u8 v) noexcept -> void
+        {
+            this->cycle();
+            ram_[addr * Lanes] = v;
+        }
+
+        FCE_ALWAYS_INLINE auto fetch_next() noexcept -> u8
+        {
+            return this->get_memory(pc_++);
+        }
+
+        FCE_ALWAYS_INLINE auto cycle() noexcept -> void
+        {
+            ++cycles_;
+        }
+    };
+
+    // A lane of an instruction run over all lanes at once: the PC is the one
+    // the lanes share, and only the instruction's own cycles are counted.
+    // Instructions that write memory don't compile against it.
+    struct Row
+    {
+        u8 a_;
+        u8 x_;
+        u8 y_;
+        u8 s_;
+        u8 p_;
+        u16 pc_;
+        u8 cycles_;
+        u8 const *ram_;  // the lane's byte of address 0
+
+        FCE_ALWAYS_INLINE auto get_memory(u16 addr) noexcept -> u8
+        {
+            this->cycle();
+            return ram_[addr * Lanes];
+        }
+
+        FCE_ALWAYS_INLINE auto fetch_next() noexcept -> u8
+        {
+            return this->get_memory(pc_++);
+        }
+
+        FCE_ALWAYS_INLINE auto cycle() noexcept -> void
+        {
+            ++cycles_;
+        }
+    };
+
+    using I = Instructions<Lane>;
+    using R = Instructions<Row>;
+    using Handler = auto (*)(Lockstep&, Mask group, Bytes const& on, u16 pc) noexcept -> void;
+
+    // Executes an instruction on every lane of `group`, one after the other.
+    template <typename Mode, typename Operation>
+    static auto execute(Lockstep& lockstep, Mask group, Bytes const&, u16) noexcept -> void
+    {
+        for (; group != 0; group &= group - 1) {
+            auto const lane = std::size_t{countr_zero(group)};
+            Lane core{lockstep, lane};
+            I::fetch(core);
+            I::template execute<Mode, Operation>(core);
+            core.commit(lockstep, lane);
+        }
+    }
+
+    // Executes an instruction on every lane as if it were at `pc`, keeping
+    // the results of the lanes `on`.
+    template <typename Mode, typename Operation>
+    static auto execute_rows(Lockstep& lockstep, Mask, Bytes const& on, u16 pc) noexcept -> void
+    {
+        auto const ram = lockstep.ram_.get();
+        for (std::size_t lane = 0; lane < Lanes; lane++) {
+            Row core{lockstep.a_[lane], lockstep.x_[lane], lockstep.y_[lane], lockstep.s_[lane],
+                     lockstep.p_[lane], pc, 0, ram + lane};
+            R::fetch(core);
+            R::template execute<Mode, Operation>(core);
+
+            auto const keep = on[lane];
+            lockstep.a_[lane] = u8((core.a_ & keep) | (lockstep.a_[lane] & ~keep));
+            lockstep.x_[lane] = u8((core.x_ & keep) | (lockstep.x_[lane] & ~keep));
+            lockstep.y_[lane] = u8((core.y_ & keep) | (lockstep.y_[lane] & ~keep));
+            lockstep.s_[lane] = u8((core.s_ & keep) | (lockstep.s_[lane] & ~keep));
+            lockstep.p_[lane] = u8((core.p_ & keep) | (lockstep.p_[lane] & ~keep));
+            lockstep.pc_[lane] = keep ? core.pc_ : lockstep.pc_[lane];
+            lockstep.cycles_[lane] += keep ? core.cycles_ : 0;
+        }
+    }
+
+    // Instructions touching no memory but their operand bytes run by rows.
+    // Modes and operations are given as both cores name them.
+    template <typename Mode, typename Operation, typename RowMode, typename RowOperation>
+    static constexpr auto handler() noexcept -> Handler
+    {
+        constexpr bool operand_only = std::is_same<Mode, typename I::IMP>::value ||
+                                      std::is_same<Mode, typename I::ACC>::value ||
+                                      std::is_same<Mode, typename I::IMM>::value ||
+                                      std::is_same<Mode, typename I::REL>::value ||
+                                      (std::is_same<Mode, typename I::ABS>::value &&
+                                       std::is_same<Operation, typename I::JMP>::value);
+        constexpr bool stack = std::is_same<Operation, typename I::BRK>::value ||
+                               std::is_same<Operation, typename I::RTI>::value ||
+                               std::is_same<Operation, typename I::RTS>::value ||
+                               std::is_same<Operation, typename I::PHA>::value ||
+                               std::is_same<Operation, typename I::PHP>::value ||
+                               std::is_same<Operation, typename I::PLA>::value ||
+                               std::is_same<Operation, typename I::PLP>::value;
+
+        if constexpr (operand_only && !stack) {
+            return &execute_rows<RowMode, RowOperation>;
+        } else {
+            return &execute<Mode, Operation>;
+        }
+    }
+
+    static const std::array<Handler, 0x100> table;
+
+    // The lanes of `active` at the PC of `leader` with the same opcode, as a
+    // Mask and as bytes.
+    auto group(Mask active, std::size_t leader, Bytes& on) noexcept -> Mask
+    {
+        auto const pc = pc_[leader];
+        auto const row = ram_.get() + pc * Lanes;
+        auto const opcode = row[leader];
+        if (kernels_->group) {
+            return kernels_->group(this->view(), active, pc, opcode, on.data());
+        }
+
+        Mask group = 0;
+        for (std::size_t lane = 0; lane < Lanes; lane++) {
+            auto const same = (active >> lane & 1) && pc_[lane] == pc && row[lane] == opcode;
+            on[lane] = u8(-int(same));
+            group |= Mask(same) << lane;
+        }
+        return group;
+    }
+
+    auto view() noexcept -> LockstepLanes
+    {
+        return {a_.data(), x_.data(), y_.data(), s_.data(), p_.data(), pc_.data(), cycles_.data(), ram_.get(), Lanes};
+    }
+
+    alignas(64) Bytes a_{};
+    alignas(64) Bytes x_{};
+    alignas(64) Bytes y_{};
+    alignas(64) Bytes s_{};
+    alignas(64) Bytes p_{};
+    alignas(64) std::array<u16, Lanes> pc_{};
+    alignas(64) std::array<u64, Lanes> cycles_{};
+    std::unique_ptr<u8[]> ram_;
+    Simd simd_;
+    LockstepKernels const *kernels_;
+
+    u64 dispatches_ = 0;
+    u64 executed_ = 0;
+};
+
+template <std::size_t Lanes>
+const std::array<typename Lockstep<Lanes>::Handler, 0x100> Lockstep<Lanes>::table = {{
+#define FCE_HANDLER(opcode, mode, operation) \
+    Lockstep<Lanes>::template handler<typename I::mode, typename I::operation, typename R::mode, typename R::operation>(),
+    FCE_OPCODES(FCE_HANDLER)
+#undef FCE_HANDLER
+}};
+
+}  // namespace fce
+
+#endif  // FCE_LOCKSTEP_HPP_
@@ -0,0 +1,103 @@
+#ifndef FCE_MAPPER_HPP_
+#define FCE_MAPPER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/memory.hpp>
+#include <fce/rom.hpp>
+#include <fce/scheduler.hpp>
+
+namespace fce {
+
+// The cartridge side of the CPU and PPU buses: PRG ROM at $8000-$FFFF and
+// PRG RAM at $6000-$7FFF, in the cells, on the CPU side, and 8 KiB of CHR
+// on the PPU side, along with how the nametables are mirrored.
+//
+// Banks are never copied. A bank switch repoints the pages Memory::get()
+// reads from, or the 1 KiB CHR windows chr_get() reads from, so it costs a
+// few stores whatever the size of the ROM. Writes to $8000-$FFFF go to the
+// mapper's registers instead of the cells.
+//
+// A mapper reads from its Rom, which must outlive it.
+class Mapper : public Memory
+{
+public:
+    // The master clock, in CPU cycles, and the IRQ line of the CPU.
+    using Clock = std::function<u64()>;
+    using IrqLine = std::function<void(bool)>;
+    // Called with the pages [first, last] of the CPU bus a bank switch
+    // repointed.
+    using Remap = std::function<void(u8 first, u8 last)>;
+
+    static constexpr u64 dots_per_line = 341;
+
+    explicit Mapper(Rom const& rom);
+
+    auto set(u16 addr, u8 v) noexcept -> void override;
+
+    auto chr_get(u16 addr) const noexcept -> u8 { return chr_read_[addr >> 10 & 7][addr & 0x3FF]; }
+    // Writes are ignored where CHR is ROM.
+    auto chr_set(u16 addr, u8 v) noexcept -> void
+    {
+        if (auto const data = chr_write_[addr >> 10 & 7]) {
+            data[addr & 0x3FF] = v;
+        }
+    }
+
+    // The 1 KiB of CHR at `window` * 0x400, see TileCache.
+    auto chr_window(unsigned window) const noexcept -> u8 const * { return chr_read_[window]; }
+
+    auto mirroring() const noexcept -> Mirroring { return mirroring_; }
+
+    // Connects a mapper that raises IRQs to the machine. Its IRQs are
+    // scheduled as Event::irq on `scheduler`, and reach the CPU through
+    // `irq`.
+    virtual auto attach(Scheduler& scheduler, Clock clock, IrqLine irq) -> void;
+
+    // Tells scanline counters when the PPU clocks them in the frame ahead:
+    // `lines` times, once per scanline, the first at PPU dot `first` on the
+    // master clock (3 dots per CPU cycle). Called with no lines while
+    // rendering is off.
+    virtual auto frame(u64 first, unsigned lines) -> void;
+
+    // Tells `remap` of every PRG bank switch from now on, for a CPU to drop
+    // the code it decoded from the pages, see CPU::invalidate_code().
+    auto on_remap(Remap remap) -> void { remap_ = std::move(remap); }
+
+protected:
+    Rom const& rom_;
+    Mirroring mirroring_;
+
+    // Called for writes to $8000-$FFFF.
+    virtual auto write_register(u16 addr, u8 v) noexcept -> void;
+
+    // Points the `size` bytes of the CPU or PPU bus at `addr` at bank `bank`
+    // of that size. Banks are counted modulo the number of them, and a ROM
+    // smaller than `size` is repeated.
+    auto map_prg(u16 addr, std::size_t size, std::size_t bank) noexcept -> void;
+    auto map_chr(u16 addr, std::size_t size, std::size_t bank) noexcept -> void;
+
+    // How many banks of `size` bytes the PRG ROM has, at least 1.
+    auto prg_banks(std::size_t size) const noexcept -> std::size_t;
+
+private:
+    Remap remap_;
+    std::vector<u8> chr_ram_;
+    std::array<u8 const *, 8> chr_read_{};
+    std::array<u8 *, 8> chr_write_{};
+};
+
+// The mapper `rom` asks for: NROM (0), MMC1 (1), UxROM (2), CNROM (3) or
+// MMC3 (4), with its power-on banks. Throws std::runtime_error for other
+// mappers.
+auto make_mapper(Rom const& rom) -> std::shared_ptr<Mapper>;
+
+}  // namespace fce
+
+#endif  // FCE_MAPPER_HPP_
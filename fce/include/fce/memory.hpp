@@ -2,6 +2,7 @@
 #define FCE_MEMORY_HPP_
 
 #include <array>
+#include <cstddef>
 #include <fce/types.hpp>
 
 namespace fce {
@@ -14,8 +15,37 @@ public:
     virtual auto get(u16 addr) const noexcept -> u8;
     virtual auto set(u16 addr, u8 v) noexcept -> void;
 
+    // Whether get(addr) has no side effects and keeps returning the same
+    // value until the next scheduled event or write, so that a CPU polling
+    // it may skip ahead, see CPU::skip_idle(). Devices opt in per register;
+    // mapped pages are.
+    virtual auto stable(u16 addr) const noexcept -> bool;
+
+    // Serves reads of pages [first, last] from `data`, repeating every
+    // `size` bytes, instead of from the cells: ROM banks are read where they
+    // are, e.g. in a Rom, rather than copied in. Writes still reach the
+    // cells. `size` must be a multiple of the page size, and `data` outlive
+    // the mapping. Returns whether any of the pages was read from elsewhere
+    // before.
+    auto map(u8 first, u8 last, u8 const *data, std::size_t size) noexcept -> bool;
+    // Reads of pages [first, last] come from the cells again.
+    auto unmap(u8 first, u8 last) noexcept -> void;
+
+    // Raw cells, for mapping straight onto a Bus. Accesses through this
+    // pointer bypass get() and set(), and mapped pages.
+    auto data() noexcept -> u8 * { return cells_.data(); }
+    auto data() const noexcept -> u8 const * { return cells_.data(); }
+
+    // Pages written through set() since the last clean(), one bit per page.
+    // Every page starts dirty, as the cells start unspecified.
+    auto dirty(u8 page) const noexcept -> bool { return dirty_[page >> 6] >> (page & 63) & 1; }
+    auto dirty_pages() const noexcept -> std::array<u64, 4> const& { return dirty_; }
+    auto clean() noexcept -> void { dirty_ = {}; }
+
 private:
     std::array<u8, 0x10000> cells_;
+    std::array<u8 const *, 0x100> pages_{};  // null for pages read from the cells
+    std::array<u64, 4> dirty_ = {~u64{0}, ~u64{0}, ~u64{0}, ~u64{0}};
 };
 
 }  // namespace fce
@@ -0,0 +1,76 @@
+#ifndef FCE_PIXEL_PIPELINE_HPP_
+#define FCE_PIXEL_PIPELINE_HPP_
+
+#include <array>
+#include <cstddef>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// Vector instruction sets the pixel pipeline has kernels for.
+enum class Simd : u8
+{
+    none,
+    sse41,
+    avx2,
+};
+
+// The best of them the host CPU supports.
+auto detect_simd() noexcept -> Simd;
+
+// The 2C02 colours as RGBA8888: red in the lowest byte, alpha opaque.
+extern std::array<u32, 64> const nes_colours;
+
+// A line as the PPU fetched it, a byte per pixel, 0 where transparent:
+// background and sprite palette indices, whether the sprite is behind the
+// background, and whether it is sprite 0.
+struct PixelLine
+{
+    u8 const *background;
+    u8 const *sprite;
+    u8 const *behind;
+    u8 const *zero;
+};
+
+// The last stage of drawing a line, with kernels for each Simd, picked once
+// at construction. Lines are `width` pixels; nothing is allocated.
+class PixelPipeline
+{
+public:
+    static constexpr std::size_t width = 256;
+
+    // `simd` must be supported by the host.
+    explicit PixelPipeline(Simd simd = detect_simd()) noexcept;
+
+    auto simd() const noexcept -> Simd { return simd_; }
+
+    // Writes to `out` the colour of every pixel: the sprite's where it is
+    // opaque and in front or over a transparent background, the
+    // background's otherwise, from the 32 entries of `palette` and masked by
+    // `grey`. Returns whether an opaque pixel of sprite 0 met an opaque
+    // background pixel, short of the last column.
+    auto compose(PixelLine const& line, u8 const *palette, u8 grey, u8 *out) const noexcept -> bool
+    {
+        return compose_(line, palette, grey, out);
+    }
+
+    // Writes the RGBA value of each colour in `indices` from `colours`, 64
+    // of them, to `out`.
+    auto lookup(u8 const *indices, u32 const *colours, u32 *out) const noexcept -> void
+    {
+        lookup_(indices, colours, out);
+    }
+
+private:
+    using Compose = bool (*)(PixelLine const&, u8 const *, u8, u8 *) noexcept;
+    using Lookup = void (*)(u8 const *, u32 const *, u32 *) noexcept;
+
+    Simd simd_;
+    Compose compose_;
+    Lookup lookup_;
+};
+
+}  // namespace fce
+
+#endif  // FCE_PIXEL_PIPELINE_HPP_
@@ -0,0 +1,147 @@
+#ifndef FCE_PPU_HPP_
+#define FCE_PPU_HPP_
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/mapper.hpp>
+#include <fce/memory.hpp>
+#include <fce/pixel_pipeline.hpp>
+#include <fce/scheduler.hpp>
+#include <fce/tile_cache.hpp>
+
+namespace fce {
+
+// The NTSC 2C02, rendering a scanline at a time: a line is drawn whole when
+// the clock reaches its first dot, from the registers as they are then.
+// Raster effects that change scroll or banks between lines work; changes in
+// the middle of a line take effect from the next one.
+//
+// Pattern tables are read through a TileCache, so fetching a row of a tile
+// is a copy. Frames are 256x240 colour indices, 0 to 63, into the NES
+// palette; colour emphasis is not emulated. The last stage of each line,
+// priorities, sprite 0 hits and the optional RGBA output, is a PixelPipeline.
+//
+// The CPU reaches the registers by mapping the PPU at $2000-$3FFF, which it
+// mirrors every 8 bytes. The PPU is a Component: reads and writes bring it up
+// to the clock before taking effect.
+class Ppu : public Memory, public Component
+{
+public:
+    using Clock = Mapper::Clock;
+    using Nmi = std::function<void()>;
+    using FrameHandler = std::function<void(u8 const *pixels)>;
+
+    static constexpr unsigned width = 256;
+    static constexpr unsigned height = 240;
+    static constexpr unsigned lines = 262;
+    static constexpr u64 dots_per_frame = lines * Mapper::dots_per_line;
+
+    explicit Ppu(std::shared_ptr<Mapper> mapper);
+
+    auto get(u16 addr) const noexcept -> u8 override;
+    auto set(u16 addr, u8 v) noexcept -> void override;
+    // PPUSTATUS, while reading it changes nothing and only the vertical
+    // blank, a scheduled event, can change what it reads: the flags and the
+    // second write toggle are clear, and rendering is off. That is a boot
+    // time wait for the vertical blank; polling with rendering on isn't
+    // skipped, as sprite 0 hits are not events.
+    auto stable(u16 addr) const noexcept -> bool override;
+
+    // Copies `page` to OAM from OAMADDR on, as a write to $4014 does. Stalling
+    // the CPU is up to the caller.
+    auto oam_dma(u8 const *page) noexcept -> void;
+
+    // Connects the PPU to the machine. It keeps time by `clock`, in CPU
+    // cycles, draws each frame by its vertical blank through
+    // Event::ppu_scanline on `scheduler`, and signals NMIs through `nmi`.
+    auto attach(Scheduler& scheduler, Clock clock, Nmi nmi) -> void;
+
+    // Called with the frame whenever one is complete, at the vertical blank.
+    auto on_frame(FrameHandler handler) -> void { on_frame_ = std::move(handler); }
+
+    // The frame being drawn, width * height colour indices, complete between
+    // the vertical blank and the next frame.
+    auto pixels() const noexcept -> u8 const * { return pixels_.data(); }
+    // Also writes every line as RGBA from `colours` straight to `rgba`, a
+    // framebuffer of height rows `pitch` pixels apart, or stops if it is null.
+    auto output(u32 *rgba, std::size_t pitch, u32 const *colours = nes_colours.data()) noexcept -> void;
+    // Frames completed.
+    auto frames() const noexcept -> u64 { return frames_; }
+
+    auto tiles() const noexcept -> TileCache const& { return tiles_; }
+
+protected:
+    // Enters the lines starting before `to`.
+    auto advance(u64 from, u64 to) -> void override;
+
+private:
+    std::shared_ptr<Mapper> mapper_;
+    TileCache tiles_;
+    PixelPipeline pipeline_;
+
+    u8 ctrl_ = 0;
+    u8 mask_ = 0;
+    u8 status_ = 0;
+    u8 oam_addr_ = 0;
+    u8 latch_ = 0;   // the last value on the register bus
+    u8 buffer_ = 0;  // of PPUDATA reads
+    u16 v_ = 0;      // the VRAM address
+    u16 t_ = 0;      // the VRAM address to be
+    u8 x_ = 0;       // fine X scroll
+    bool w_ = false; // second write to PPUSCROLL or PPUADDR
+
+    std::array<u8, 0x1000> vram_{};  // four nametables, for four-screen carts
+    std::array<u8, 0x20> palette_{};
+    std::array<u8, 0x100> oam_{};
+
+    // the next line to enter and its first dot on the master clock
+    unsigned line_ = 0;
+    u64 line_dot_ = 0;
+    u64 frames_ = 0;
+
+    // a line being drawn: background colours from the left edge of the
+    // first tile fetched, and sprite colours, priorities and sprite 0
+    std::array<u8, width + 16> background_{};
+    std::array<u8, width> sprite_{};
+    std::array<u8, width> behind_{};
+    std::array<u8, width> zero_{};
+    std::vector<u8> pixels_;
+    u32 *rgba_ = nullptr;
+    std::size_t pitch_ = 0;
+    u32 const *colours_ = nullptr;
+
+    Scheduler *scheduler_ = nullptr;
+    Clock clock_;
+    Nmi nmi_;
+    FrameHandler on_frame_;
+
+    auto rendering() const noexcept -> bool { return mask_ & 0x18; }
+
+    auto read(u16 addr) noexcept -> u8;
+    auto write(u16 addr, u8 v) noexcept -> void;
+    auto sync() noexcept -> void;
+
+    // the PPU bus, $0000-$3FFF
+    auto vram_get(u16 addr) const noexcept -> u8;
+    auto vram_set(u16 addr, u8 v) noexcept -> void;
+    auto nametable(u16 addr) const noexcept -> std::size_t;
+    static auto palette_index(u16 addr) noexcept -> std::size_t;
+
+    auto enter(unsigned line) -> void;
+    auto draw(unsigned line) noexcept -> void;
+    auto compose(unsigned line, u8 *out) noexcept -> void;
+    auto fetch_background() noexcept -> void;
+    auto fetch_sprites(unsigned line) noexcept -> void;
+    auto increment_y() noexcept -> void;
+    auto schedule_vblank() -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_PPU_HPP_
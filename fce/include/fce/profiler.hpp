@@ -0,0 +1,128 @@
+#ifndef FCE_PROFILER_HPP_
+#define FCE_PROFILER_HPP_
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/trace.hpp>
+
+namespace fce {
+
+// A tracer for CPU<BusType, Profiler> that counts where the guest spends its
+// time: instructions and cycles per PC and per opcode, bus reads and writes
+// per page, and cycles per call stack.
+//
+// The histograms are flat arrays allocated up front, so an instruction costs
+// a few increments, and a bus access one. An instruction is charged the
+// cycles up to the next one, which includes any interrupt serviced in
+// between; the last instruction of a run is charged when the next run
+// starts.
+//
+// Call stacks are followed through JSR and RTS only: code that returns with
+// RTI, or calls by pushing an address and returning to it, unbalances them.
+// Their frames are allocated up front too, max_frames of them.
+class Profiler
+{
+public:
+    static constexpr bool enabled = true;
+    static constexpr bool accesses = true;
+
+    // Call stacks deeper than this count as their ancestor at this depth.
+    static constexpr std::size_t max_depth = 64;
+    // Calls that would make more distinct stacks than this count as their
+    // caller.
+    static constexpr std::size_t max_frames = std::size_t{1} << 16;
+
+    Profiler();
+
+    auto record(TraceRecord const& record) noexcept -> void
+    {
+        if (started_) {
+            auto const elapsed = record.cycles - cycles_;
+            pc_cycles_[pc_] += elapsed;
+            opcode_cycles_[opcode_] += elapsed;
+            frames_[frame_].cycles += elapsed;
+
+            // the instruction after a JSR is the first one of its callee
+            if (opcode_ == 0x20) {
+                frame_ = this->call(record.pc);
+            } else if (opcode_ == 0x60) {
+                frame_ = frames_[frame_].parent;
+            }
+        }
+        started_ = true;
+        cmos_ = record.cmos;
+        cycles_ = record.cycles;
+        pc_ = record.pc;
+        opcode_ = record.opcode;
+
+        pc_instructions_[record.pc]++;
+        pc_opcodes_[record.pc] = record.opcode;
+        opcode_instructions_[record.opcode]++;
+    }
+
+    auto execute(u16) noexcept -> void {}
+    auto fetch(u16 addr) noexcept -> void { page_reads_[addr >> 8]++; }
+    auto read(u16 addr) noexcept -> void { page_reads_[addr >> 8]++; }
+    auto write(u16 addr) noexcept -> void { page_writes_[addr >> 8]++; }
+
+    auto instructions(u16 pc) const noexcept -> u64 { return pc_instructions_[pc]; }
+    auto cycles(u16 pc) const noexcept -> u64 { return pc_cycles_[pc]; }
+    auto opcode_instructions(u8 opcode) const noexcept -> u64 { return opcode_instructions_[opcode]; }
+    auto opcode_cycles(u8 opcode) const noexcept -> u64 { return opcode_cycles_[opcode]; }
+    auto reads(u8 page) const noexcept -> u64 { return page_reads_[page]; }
+    auto writes(u8 page) const noexcept -> u64 { return page_writes_[page]; }
+
+    // Zeroes every count and forgets the call stack.
+    auto clear() -> void;
+
+    // Writes the `top` hottest PCs and opcodes by cycles, and the busiest
+    // pages, as a table for humans. Opcodes are named as the profiled CPU
+    // decodes them.
+    auto report(std::ostream& os, std::size_t top = 20) const -> void;
+
+    // Writes cycles per call stack in the collapsed format of flame graph
+    // tools, one stack per line, e.g. `root;8020;80A6 1234`. Frames are
+    // named after the address their JSR called.
+    auto collapsed(std::ostream& os) const -> void;
+
+private:
+    struct Frame
+    {
+        u32 parent;
+        u16 entry;
+        u16 depth;
+        u64 cycles;
+    };
+
+    std::vector<u64> pc_instructions_;
+    std::vector<u64> pc_cycles_;
+    std::vector<u8> pc_opcodes_;  // the opcode last executed at each PC
+    std::vector<u64> opcode_instructions_;
+    std::vector<u64> opcode_cycles_;
+    std::vector<u64> page_reads_;
+    std::vector<u64> page_writes_;
+
+    // Frame 0 is the bottom of every stack. Children are found by parent and
+    // entry in an open addressing table of their indices, 0 for none, twice
+    // as large as frames_ grows.
+    std::vector<Frame> frames_;
+    std::vector<u32> children_;
+    u32 frame_ = 0;
+
+    // the instruction being executed, and the opcode matrix it is from
+    bool started_ = false;
+    bool cmos_ = false;
+    u64 cycles_ = 0;
+    u16 pc_ = 0;
+    u8 opcode_ = 0;
+
+    // The frame of a call from the current one to `entry`.
+    auto call(u16 entry) noexcept -> u32;
+};
+
+}  // namespace fce
+
+#endif  // FCE_PROFILER_HPP_
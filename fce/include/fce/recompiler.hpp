@@ -0,0 +1,134 @@
+#ifndef FCE_RECOMPILER_HPP_
+#define FCE_RECOMPILER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/code_cache.hpp>
+#include <fce/instructions.hpp>
+
+namespace fce {
+
+// The state shared between the CPU and translated code. Translated code
+// keeps the registers in host registers and writes them back on exit.
+struct RecompilerContext
+{
+    u64 cycles;
+    u64 end;  // translated code returns at the first instruction boundary past it
+
+    // Pages accessed directly; null pages go through read() and write().
+    // Direct writes mark their page in dirty_pages.
+    u8 const *const *read_pages;
+    u8 *const *write_pages;
+    bool *dirty_pages;
+    bool const *code_pages;
+
+    void *cpu;
+    auto (*read)(RecompilerContext& context, u16 addr) -> u8;
+    auto (*write)(RecompilerContext& context, u16 addr, u8 v) -> void;
+    // Executes the instruction at `pc` with the interpreter.
+    auto (*interpret)(RecompilerContext& context) -> void;
+
+    u16 pc;
+    u8 a;
+    u8 x;
+    u8 y;
+    u8 s;
+    u8 p;
+    u8 callout;  // set by read(), write() and interpret()
+
+    std::array<u32, 4> scratch;  // spill slots for translated code
+};
+
+// Translates basic blocks to x86-64 code, keyed by the PC of their first
+// instruction. A block ends at the next branch, jump, call, return, BRK,
+// CLI, SEI or PLP, and translated code returns to the CPU at its end.
+//
+// The 6502 registers live in host registers within a block. Memory accesses
+// to directly mapped pages are single loads and stores; other pages call
+// out to read() and write(), and JMP (a), RTI and BRK call out to
+// interpret(). Cycles are counted per access as the interpreter does, so
+// callouts see the same clock, and a block returns as soon as it has run
+// past `end`, or after an instruction that called out, so that the CPU can
+// check for interrupts.
+//
+// The code buffer is writable or executable, never both.
+//
+// Only available on x86-64 hosts with mmap(); elsewhere find() returns
+// null and the CPU interprets.
+class Recompiler : public CodeCache
+{
+public:
+    using Block = auto (*)(RecompilerContext& context) -> void;
+
+    static constexpr std::size_t max_block_size = 32;
+
+    static auto available() noexcept -> bool;
+
+    Recompiler() noexcept;
+    ~Recompiler() override;
+
+    Recompiler(Recompiler const&) = delete;
+    auto operator=(Recompiler const&) -> Recompiler& = delete;
+
+    // The translated block starting at `pc`, translated first from
+    // `read(addr) -> u8` if needed, or null if the instruction there can't
+    // be translated. `read` must not have side effects.
+    template <typename Read>
+    auto find(u16 pc, Read&& read) -> Block
+    {
+        if (auto const entry = entries_[pc]) {
+            return reinterpret_cast<Block>(code_ + entry - 1);
+        }
+
+        std::array<u8, max_block_size * 3> bytes;
+        std::size_t size = 0;
+        u16 addr = pc;
+        for (std::size_t i = 0; i < max_block_size; i++) {
+            auto const opcode = read(addr);
+            auto const length = 1 + operand_size(addressing_modes[opcode]);
+            if (u16(addr + length - 1) < addr) {
+                break;
+            }
+            for (unsigned j = 0; j < length; j++) {
+                bytes[size++] = read(u16(addr + j));
+            }
+            addr = u16(addr + length);
+            if (ends_block(opcode) || addr < pc) {
+                break;
+            }
+        }
+        if (size == 0) {
+            return nullptr;  // an instruction wrapping around the address space
+        }
+        return this->translate(pc, bytes.data(), size);
+    }
+
+    auto invalidate(u8 page) noexcept -> void override;
+    auto flush() noexcept -> void;
+
+    // Page tables for buses that are a single flat array.
+    auto flat_pages(u8 *data) noexcept -> void;
+    auto flat_read_pages() const noexcept -> u8 const *const * { return flat_read_.data(); }
+    auto flat_write_pages() const noexcept -> u8 *const * { return flat_write_.data(); }
+
+private:
+    u8 *code_ = nullptr;
+    std::size_t used_ = 0;
+    std::vector<u32> entries_;  // offset into code_ + 1 for each PC, or 0
+    std::array<std::vector<u16>, 0x100> pages_;  // start of the blocks on each page
+    std::array<u8 const *, 0x100> flat_read_;
+    std::array<u8 *, 0x100> flat_write_;
+    u8 *flat_ = nullptr;
+
+    static auto ends_block(u8 opcode) noexcept -> bool;
+
+    // Translates the `size` bytes of instructions at `pc`.
+    auto translate(u16 pc, u8 const *bytes, std::size_t size) -> Block;
+};
+
+}  // namespace fce
+
+#endif  // FCE_RECOMPILER_HPP_
@@ -0,0 +1,90 @@
+#ifndef FCE_REWIND_HPP_
+#define FCE_REWIND_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <fce/types.hpp>
+#include <fce/memory.hpp>
+#include <fce/savestate.hpp>
+
+namespace fce {
+
+// Keeps the most recent frames of a machine within a fixed budget of bytes,
+// for stepping back in time. Push a frame every video frame; the oldest
+// frames are dropped to make room for new ones.
+//
+// Every `keyframe_interval`th frame is a keyframe, stored whole. The others
+// are stored as the XOR against the keyframe before them, which is zero
+// wherever the frames agree. Both are run-length encoded, so a frame costs
+// about the bytes that changed since its keyframe, and decoding any frame
+// takes at most two passes over a Savestate.
+class Rewind
+{
+public:
+    explicit Rewind(std::size_t capacity = std::size_t{32} << 20, std::size_t keyframe_interval = 60);
+
+    template <typename CPU>
+    auto push(CPU const& cpu, Memory const& memory) -> void
+    {
+        capture(cpu, memory, *scratch_);
+        this->push(*scratch_);
+    }
+
+    auto push(Savestate const& state) -> void;
+
+    // Frames available.
+    auto size() const noexcept -> std::size_t { return frames_.size(); }
+
+    // Decodes the frame `back` frames before the newest one to `state`, and
+    // drops the frames after it, so that pushing continues from there.
+    // Returns false, leaving everything as is, if there are not that many
+    // frames.
+    auto rewind(std::size_t back, Savestate& state) -> bool;
+
+    // Decodes the frame `back` frames before the newest one without dropping
+    // anything.
+    auto peek(std::size_t back, Savestate& state) const -> bool;
+
+    auto clear() noexcept -> void;
+
+    // Bytes reserved for frames.
+    auto capacity() const noexcept -> std::size_t { return ring_.size(); }
+    // Bytes used by the encoded frames.
+    auto memory_usage() const noexcept -> std::size_t { return used_; }
+
+private:
+    struct Frame
+    {
+        std::size_t offset;  // into ring_
+        std::size_t size;
+        bool keyframe;
+    };
+
+    std::vector<u8> ring_;
+    std::size_t keyframe_interval_;
+    std::deque<Frame> frames_;  // oldest first
+    std::size_t used_ = 0;
+
+    // The newest keyframe, decoded, if frames_ holds it.
+    std::unique_ptr<Savestate> keyframe_;
+    bool keyframe_valid_ = false;
+    std::size_t since_keyframe_ = 0;
+
+    std::unique_ptr<Savestate> scratch_;
+    std::vector<u8> encoded_;
+
+    auto encode(Savestate const& state, bool keyframe) -> void;
+    auto decode(Frame const& frame, Savestate& state) const noexcept -> void;
+    // Makes room for `size` contiguous bytes after the newest frame,
+    // returning their offset.
+    auto allocate(std::size_t size) -> std::size_t;
+    auto drop_oldest() noexcept -> void;
+    auto drop_newest() noexcept -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_REWIND_HPP_
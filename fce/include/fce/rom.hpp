@@ -0,0 +1,108 @@
+#ifndef FCE_ROM_HPP_
+#define FCE_ROM_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// A view of bytes owned elsewhere.
+struct ByteSpan
+{
+    u8 const *data = nullptr;
+    std::size_t size = 0;
+
+    auto operator[](std::size_t i) const noexcept -> u8 { return data[i]; }
+    auto begin() const noexcept -> u8 const * { return data; }
+    auto end() const noexcept -> u8 const * { return data + size; }
+    auto empty() const noexcept -> bool { return size == 0; }
+};
+
+enum class RomFormat : u8
+{
+    ines,
+    nes2,
+};
+
+// How the cartridge wires the PPU nametables. Mappers may switch between
+// them, and to either nametable alone.
+enum class Mirroring : u8
+{
+    horizontal,
+    vertical,
+    four_screen,
+    single_lower,
+    single_upper,
+};
+
+// An iNES or NES 2.0 ROM file, mapped read-only into memory. PRG and CHR
+// banks are views straight into the mapping: opening a ROM reads its header
+// and nothing else, the rest is paged in as it is accessed.
+//
+// The banks stay valid as long as the Rom, and moving it.
+class Rom
+{
+public:
+    static constexpr std::size_t header_size = 16;
+    static constexpr std::size_t trainer_size = 512;
+
+    // Throws std::runtime_error if the file can't be mapped, doesn't start
+    // with an iNES header, or is shorter than its header says.
+    explicit Rom(std::string const& path);
+    ~Rom();
+
+    Rom(Rom&& other) noexcept;
+    auto operator=(Rom&& other) noexcept -> Rom&;
+    Rom(Rom const&) = delete;
+    auto operator=(Rom const&) -> Rom& = delete;
+
+    auto format() const noexcept -> RomFormat { return format_; }
+    auto mapper() const noexcept -> u16 { return mapper_; }
+    auto submapper() const noexcept -> u8 { return submapper_; }
+    auto mirroring() const noexcept -> Mirroring { return mirroring_; }
+    // Whether the PRG RAM is battery backed.
+    auto battery() const noexcept -> bool { return battery_; }
+
+    // Empty if the file has no trainer.
+    auto trainer() const noexcept -> ByteSpan { return trainer_; }
+    auto prg() const noexcept -> ByteSpan { return prg_; }
+    // Empty for cartridges with CHR RAM.
+    auto chr() const noexcept -> ByteSpan { return chr_; }
+
+    // Bank `index` of the PRG or CHR ROM cut into banks of `size` bytes,
+    // counted modulo the number of banks like the address lines of a mapper
+    // that has more than the ROM. Empty if the ROM is.
+    auto prg_bank(std::size_t index, std::size_t size) const noexcept -> ByteSpan;
+    auto chr_bank(std::size_t index, std::size_t size) const noexcept -> ByteSpan;
+
+    // RAM the cartridge has, in bytes. iNES headers don't say, so they get
+    // 8 KiB of PRG RAM, and 8 KiB of CHR RAM without CHR ROM.
+    auto prg_ram_size() const noexcept -> std::size_t { return prg_ram_size_; }
+    auto chr_ram_size() const noexcept -> std::size_t { return chr_ram_size_; }
+
+private:
+    u8 const *image_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<u8> copy_;  // the file, where it can't be mapped
+
+    RomFormat format_ = RomFormat::ines;
+    u16 mapper_ = 0;
+    u8 submapper_ = 0;
+    Mirroring mirroring_ = Mirroring::horizontal;
+    bool battery_ = false;
+    ByteSpan trainer_;
+    ByteSpan prg_;
+    ByteSpan chr_;
+    std::size_t prg_ram_size_ = 0;
+    std::size_t chr_ram_size_ = 0;
+
+    auto parse() -> void;
+    auto release() noexcept -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_ROM_HPP_
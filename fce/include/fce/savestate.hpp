@@ -0,0 +1,113 @@
+#ifndef FCE_SAVESTATE_HPP_
+#define FCE_SAVESTATE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <type_traits>
+
+#include <fce/types.hpp>
+#include <fce/bus.hpp>
+#include <fce/cpu.hpp>
+#include <fce/memory.hpp>
+
+namespace fce {
+
+// A CPU and the Memory behind it. Taking and restoring one is a copy of
+// plain bytes, cheap enough to do thousands of times per second, e.g. to
+// search from a position.
+//
+// The layout doubles as the payload of the file format, which is little
+// endian. Fields are only ever appended, each time with a new version, and
+// files of older versions load with the fields they lack zeroed.
+struct Savestate
+{
+    static constexpr u32 version = 1;
+
+    CpuState cpu;
+    std::array<u8, 0x10000> memory;
+};
+
+static_assert(std::is_trivially_copyable<Savestate>::value, "Savestate must be plain bytes");
+static_assert(sizeof(CpuState) == 24 && sizeof(Savestate) == 24 + 0x10000, "Savestate must not have padding");
+
+template <typename CPU>
+auto capture(CPU const& cpu, Memory const& memory, Savestate& state) noexcept -> void
+{
+    state.cpu = cpu.state();
+    std::memcpy(state.memory.data(), memory.data(), state.memory.size());
+}
+
+// Restores `cpu` and `memory` from `state`, dropping code cached by `cpu`.
+// Memory handlers are bypassed, and `memory` and the bus of `cpu` are left
+// clean.
+template <typename CPU>
+auto restore(CPU& cpu, Memory& memory, Savestate const& state) noexcept -> void
+{
+    cpu.state(state.cpu);
+    std::memcpy(memory.data(), state.memory.data(), state.memory.size());
+    memory.clean();
+    cpu.bus().clean();
+    cpu.invalidate_code(0x00, 0xFF);
+}
+
+// Like restore(), but copies only the pages of `memory` that are dirty, so
+// resetting after a short run costs about the pages it wrote. A page is
+// dirty if it was written through Memory::set(), or, when `cpu` runs on a
+// Bus, through a page the bus maps onto the cells of `memory` with
+// map_ram(). `memory` must have held `state` when they were last clean,
+// e.g. after restore().
+template <typename CPU>
+auto reset_to(CPU& cpu, Memory& memory, Savestate const& state) noexcept -> void
+{
+    cpu.state(state.cpu);
+    auto dirty = memory.dirty_pages();
+
+    auto& bus = cpu.bus();
+    if constexpr (std::is_same<std::decay_t<decltype(bus)>, Bus>::value) {
+        auto const cells = reinterpret_cast<std::uintptr_t>(memory.data());
+        for (unsigned page = 0; page < 0x100; page++) {
+            if (!bus.dirty(u8(page))) {
+                continue;
+            }
+            // mapped pages are whole pages of the cells, or of other RAM
+            auto const offset = reinterpret_cast<std::uintptr_t>(bus.write_pages()[page]) - cells;
+            if (offset < 0x10000) {
+                dirty[offset >> 14] |= u64{1} << (offset >> 8 & 63);
+            }
+        }
+    }
+    bus.clean();
+
+    for (unsigned word = 0; word < dirty.size(); word++) {
+        for (auto bits = dirty[word]; bits != 0; bits &= bits - 1) {
+            auto const page = u8(word * 64 + countr_zero(bits));
+            std::memcpy(memory.data() + page * 0x100, state.memory.data() + page * 0x100, 0x100);
+            cpu.invalidate_code(page, page);
+        }
+    }
+    memory.clean();
+}
+
+enum class Compression
+{
+    none,
+    zstd,  // only if built with zstd, see compression_available()
+};
+
+auto compression_available(Compression compression) noexcept -> bool;
+
+// Writes `state` in the format read by load_state(). Throws
+// std::runtime_error if `compression` is not available.
+auto save_state(std::ostream& os, Savestate const& state, Compression compression = Compression::none) -> void;
+
+// Reads a state written by save_state() of this or an older version. Throws
+// std::runtime_error if the stream does not hold such a savestate, or if it is
+// compressed and compression is not available; `state` is left unspecified
+// then.
+auto load_state(std::istream& is, Savestate& state) -> void;
+
+}  // namespace fce
+
+#endif  // FCE_SAVESTATE_HPP_
@@ -0,0 +1,124 @@
+#ifndef FCE_SCHEDULER_HPP_
+#define FCE_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// Things that happen at a known time on the master clock. Each kind has at
+// most one pending occurrence.
+enum class Event : u8
+{
+    ppu_scanline,
+    apu_frame_counter,
+    irq,
+    nmi,
+};
+
+constexpr std::size_t event_count = 4;
+
+// A min-heap of pending events keyed by a 64-bit timestamp on the master
+// clock, which counts CPU cycles (CPU::cycles()).
+//
+// The CPU runs freely until the next event is due; devices that are not
+// driven by events are brought up to date lazily, see Component.
+class Scheduler
+{
+public:
+    using Handler = std::function<void(u64 timestamp)>;
+
+    static constexpr u64 never = ~u64{0};
+
+    Scheduler() noexcept;
+
+    // Sets the handler called when `event` fires.
+    auto on(Event event, Handler handler) -> void;
+
+    // Schedules `event` at `timestamp`, replacing any pending occurrence.
+    auto schedule(Event event, u64 timestamp) -> void;
+    auto cancel(Event event) noexcept -> void;
+    auto pending(Event event) const noexcept -> bool;
+
+    // Timestamp of the earliest pending event, or `never`.
+    auto next() const noexcept -> u64 { return heap_.empty() ? never : heap_.front().timestamp; }
+
+    // Fires, in timestamp order, every event due at or before `now`. Handlers
+    // may schedule further events, which fire too if they are due.
+    auto dispatch(u64 now) -> void;
+
+    // Runs `cpu` until `until` on the master clock, dispatching events as
+    // they fall due. The CPU stops at instruction boundaries, so an event
+    // fires up to one instruction late; its handler gets the timestamp it
+    // was scheduled for.
+    //
+    // An event scheduled earlier than next() while the CPU is running takes
+    // effect when the current run ends; call CPU::sync() to end it at once.
+    template <typename CPU>
+    auto run(CPU& cpu, u64 until) -> void
+    {
+        while (cpu.cycles() < until) {
+            auto const target = std::min(this->next(), until);
+            if (target > cpu.cycles()) {
+                cpu.run(target - cpu.cycles());
+            }
+            this->dispatch(cpu.cycles());
+        }
+    }
+
+private:
+    struct Entry
+    {
+        u64 timestamp;
+        u32 generation;
+        Event event;
+    };
+
+    // Entries are invalidated by bumping the generation of their event
+    // rather than by searching the heap; the front is always live.
+    std::vector<Entry> heap_;
+    std::array<u32, event_count> generations_;
+    std::array<bool, event_count> pending_;
+    std::array<Handler, event_count> handlers_;
+
+    static auto later(Entry const& lhs, Entry const& rhs) noexcept -> bool;
+
+    auto live(Entry const& entry) const noexcept -> bool;
+    auto pop() noexcept -> Entry;
+    auto prune() noexcept -> void;
+};
+
+// A device that is only brought up to date when something needs its state:
+// when the CPU touches its registers, or when one of its events fires.
+class Component
+{
+public:
+    virtual ~Component() = default;
+
+    // Runs the component up to `now` on the master clock.
+    auto catch_up(u64 now) -> void
+    {
+        if (now > timestamp_) {
+            this->advance(timestamp_, now);
+            timestamp_ = now;
+        }
+    }
+
+    auto timestamp() const noexcept -> u64 { return timestamp_; }
+
+protected:
+    // Emulates the component from `from` up to, but not including, `to`.
+    virtual auto advance(u64 from, u64 to) -> void = 0;
+
+private:
+    u64 timestamp_ = 0;
+};
+
+}  // namespace fce
+
+#endif  // FCE_SCHEDULER_HPP_
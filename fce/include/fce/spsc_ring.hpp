@@ -0,0 +1,112 @@
+#ifndef FCE_SPSC_RING_HPP_
+#define FCE_SPSC_RING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// A bounded queue from one producing thread to one consuming thread, without
+// locks: each side owns one index, publishes it with a release store and
+// reads the other's with an acquire load. Neither side ever waits; push()
+// takes what fits and pop() what there is.
+//
+// The indices count items ever pushed and popped, and live on cache lines of
+// their own, as do the producer's and the consumer's last view of the other
+// index, so that a side only touches the other's line when its view runs
+// out.
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "items are copied as bytes");
+
+public:
+    // Holds at least `capacity` items; the capacity is rounded up to a power
+    // of two.
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        items_ = std::make_unique<T[]>(size);
+        mask_ = size - 1;
+    }
+
+    SpscRing(SpscRing const&) = delete;
+    auto operator=(SpscRing const&) -> SpscRing& = delete;
+
+    auto capacity() const noexcept -> std::size_t { return mask_ + 1; }
+
+    // Items waiting, as seen from either side at some point of the call.
+    auto size() const noexcept -> std::size_t
+    {
+        return tail_.value.load(std::memory_order_acquire) - head_.value.load(std::memory_order_acquire);
+    }
+
+    // Producer side: appends as many of the `count` items as fit and returns
+    // how many did.
+    auto push(T const *items, std::size_t count) noexcept -> std::size_t
+    {
+        auto const tail = tail_.value.load(std::memory_order_relaxed);
+        if (this->capacity() - (tail - head_seen_.value) < count) {
+            head_seen_.value = head_.value.load(std::memory_order_acquire);
+        }
+        count = std::min(count, this->capacity() - (tail - head_seen_.value));
+        this->copy(items, count, tail);
+        tail_.value.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: takes up to `count` items into `items` and returns how
+    // many it took.
+    auto pop(T *items, std::size_t count) noexcept -> std::size_t
+    {
+        auto const head = head_.value.load(std::memory_order_relaxed);
+        if (tail_seen_.value - head < count) {
+            tail_seen_.value = tail_.value.load(std::memory_order_acquire);
+        }
+        count = std::min(count, tail_seen_.value - head);
+        auto const start = head & mask_;
+        auto const first = std::min(count, this->capacity() - start);
+        std::copy_n(&items_[start], first, items);
+        std::copy_n(&items_[0], count - first, items + first);
+        head_.value.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    struct alignas(64) Index
+    {
+        std::atomic<std::size_t> value{0};
+    };
+    struct alignas(64) Seen
+    {
+        std::size_t value = 0;
+    };
+
+    std::unique_ptr<T[]> items_;
+    std::size_t mask_;
+
+    Index head_;       // written by the consumer
+    Index tail_;       // written by the producer
+    Seen head_seen_;   // the producer's view of head_
+    Seen tail_seen_;   // the consumer's view of tail_
+
+    auto copy(T const *items, std::size_t count, std::size_t tail) noexcept -> void
+    {
+        auto const start = tail & mask_;
+        auto const first = std::min(count, this->capacity() - start);
+        std::copy_n(items, first, &items_[start]);
+        std::copy_n(items + first, count - first, &items_[0]);
+    }
+};
+
+}  // namespace fce
+
+#endif  // FCE_SPSC_RING_HPP_
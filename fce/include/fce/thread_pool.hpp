@@ -0,0 +1,77 @@
+#ifndef FCE_THREAD_POOL_HPP_
+#define FCE_THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// A fixed set of threads for running many independent tasks of about the
+// same size, e.g. stepping a batch of machines.
+//
+// for_each() splits the indices into one range per thread. A thread works
+// through its own range first and then steals from the others, so that a
+// thread that draws cheap tasks doesn't sit idle while the rest catch up.
+// Dispatching doesn't allocate.
+class ThreadPool
+{
+public:
+    // Uses `threads` threads, including the one calling for_each(); 0 means
+    // one per hardware thread.
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+
+    auto size() const noexcept -> std::size_t { return threads_.size() + 1; }
+
+    // Calls `task(i)` for every i in [0, count) and returns when all calls
+    // have. `task` must not throw, and must be safe to call concurrently for
+    // different indices.
+    template <typename F>
+    auto for_each(std::size_t count, F&& task) -> void
+    {
+        auto const call = [](void *context, std::size_t i) { (*static_cast<std::remove_reference_t<F> *>(context))(i); };
+        this->run(count, call, const_cast<void *>(static_cast<void const *>(&task)));
+    }
+
+private:
+    using Task = void (*)(void *context, std::size_t i);
+
+    // Indices not yet taken from one thread's share.
+    struct alignas(64) Range
+    {
+        std::atomic<std::size_t> next;
+        std::size_t end;
+    };
+
+    std::vector<std::thread> threads_;
+    std::unique_ptr<Range[]> ranges_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    u64 generation_ = 0;
+    std::size_t active_ = 0;  // worker threads still running tasks
+    bool stopping_ = false;
+
+    Task task_ = nullptr;
+    void *context_ = nullptr;
+
+    auto run(std::size_t count, Task task, void *context) -> void;
+    auto work(std::size_t thread) noexcept -> void;
+    auto worker(std::size_t thread) noexcept -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_THREAD_POOL_HPP_
@@ -0,0 +1,60 @@
+#ifndef FCE_TILE_CACHE_HPP_
+#define FCE_TILE_CACHE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+class Mapper;
+
+// The 512 tiles of the PPU pattern tables decoded from bit planes to a byte
+// per pixel, 0 to 3, both as stored and mirrored left to right, so that the
+// PPU fetches a row of a tile, flipped or not, with a copy.
+//
+// Tiles are decoded when first used after they went stale: after a write to
+// them, see invalidate(), or after the mapper pointed their 1 KiB CHR window
+// elsewhere, see sync().
+class TileCache
+{
+public:
+    static constexpr std::size_t tiles = 512;
+
+    TileCache();
+
+    // Follows the CHR windows of `mapper`, which must outlive the cache
+    // until the next call. Call it before row(), and whenever the mapper
+    // may have switched banks.
+    auto sync(Mapper const& mapper) noexcept -> void;
+
+    // Drops the tile holding pattern table address `addr`.
+    auto invalidate(u16 addr) noexcept -> void { valid_[addr >> 4 & (tiles - 1)] = false; }
+
+    // Row `y` of `tile` as 8 pixels, left to right, or right to left if
+    // `mirrored`.
+    auto row(u16 tile, unsigned y, bool mirrored = false) noexcept -> u8 const *
+    {
+        if (!valid_[tile]) {
+            this->decode(tile);
+        }
+        return &pixels_[(std::size_t{mirrored} * tiles + tile) * 64 + y * 8];
+    }
+
+    // Tiles decoded so far.
+    auto decoded() const noexcept -> u64 { return decoded_; }
+
+private:
+    std::array<u8 const *, 8> windows_{};
+    std::array<bool, tiles> valid_{};
+    std::vector<u8> pixels_;
+    u64 decoded_ = 0;
+
+    auto decode(u16 tile) noexcept -> void;
+};
+
+}  // namespace fce
+
+#endif  // FCE_TILE_CACHE_HPP_
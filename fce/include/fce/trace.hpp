@@ -0,0 +1,88 @@
+#ifndef FCE_TRACE_HPP_
+#define FCE_TRACE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// The state of the CPU just before it executes an instruction.
+struct TraceRecord
+{
+    u64 cycles;
+    u16 pc;
+    u8 opcode;
+    std::array<u8, 2> operand;  // only operand_size() bytes are valid
+    u8 a;
+    u8 x;
+    u8 y;
+    u8 s;
+    u8 p;
+    bool cmos;  // decoded by the 65C02's opcode matrix, see Variant
+};
+
+// The default tracer of CPU. Tracing code is discarded at compile time.
+struct NoTrace
+{
+    static constexpr bool enabled = false;
+    static constexpr bool accesses = false;
+
+    auto record(TraceRecord const&) noexcept -> void {}
+};
+
+// Keeps the last `capacity` records of a CPU<BusType, TraceBuffer>. Storage
+// is allocated up front, so recording is a copy into the ring.
+class TraceBuffer
+{
+public:
+    static constexpr bool enabled = true;
+    static constexpr bool accesses = false;
+
+    // `capacity` is rounded up to a power of two.
+    explicit TraceBuffer(std::size_t capacity = std::size_t{1} << 20);
+
+    auto record(TraceRecord const& record) noexcept -> void
+    {
+        records_[std::size_t(recorded_++) & mask_] = record;
+    }
+
+    auto capacity() const noexcept -> std::size_t { return records_.size(); }
+    // Records available, at most capacity().
+    auto size() const noexcept -> std::size_t;
+    // Records ever made, including the overwritten ones.
+    auto recorded() const noexcept -> u64 { return recorded_; }
+
+    // The `i`th oldest record still available.
+    auto operator[](std::size_t i) const noexcept -> TraceRecord const&;
+
+    auto clear() noexcept -> void { recorded_ = 0; }
+
+    // Writes the available records, oldest first, in the format read by
+    // load_trace().
+    auto save(std::ostream& os) const -> void;
+
+private:
+    std::vector<TraceRecord> records_;
+    std::size_t mask_;
+    u64 recorded_ = 0;
+};
+
+// Reads records written by TraceBuffer::save(). Throws std::runtime_error if
+// the stream does not hold a trace.
+auto load_trace(std::istream& is) -> std::vector<TraceRecord>;
+
+// Renders a record like a line of nestest.log, without the PPU position and
+// the memory contents nestest.log shows for some operands, in the syntax of
+// the opcode matrix that decoded it:
+//
+//     C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD CYC:7
+auto format_nestest(TraceRecord const& record) -> std::string;
+
+}  // namespace fce
+
+#endif  // FCE_TRACE_HPP_
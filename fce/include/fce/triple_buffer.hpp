@@ -0,0 +1,69 @@
+#ifndef FCE_TRIPLE_BUFFER_HPP_
+#define FCE_TRIPLE_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// Hands frames from the emulation thread to a presenter without either
+// waiting for the other. Of three framebuffers, the producer draws into the
+// back one and the presenter shows the front one; the third is the newest
+// complete frame. Publishing swaps it with the back buffer and presenting
+// with the front one, each with a single atomic exchange of its index, so
+// the producer runs at its own speed and the presenter always gets the
+// newest frame at its own refresh.
+//
+// A frame replaced before the presenter took it is counted as dropped, and
+// a refresh without a new frame as duplicated.
+class TripleBuffer
+{
+public:
+    // Frames of `size` pixels, RGBA as Ppu::output() writes them.
+    explicit TripleBuffer(std::size_t size);
+
+    TripleBuffer(TripleBuffer const&) = delete;
+    auto operator=(TripleBuffer const&) -> TripleBuffer& = delete;
+
+    auto size() const noexcept -> std::size_t { return size_; }
+
+    // Producer side: the frame to draw, which publish() makes the newest and
+    // replaces with another.
+    auto back() noexcept -> u32 * { return this->frame(back_); }
+    auto publish() noexcept -> void;
+
+    // Presenter side: takes the newest frame, if there is one it hasn't
+    // taken, and returns whether there was. front() is the frame taken last,
+    // blank before the first.
+    auto present() noexcept -> bool;
+    auto front() const noexcept -> u32 const * { return this->frame(front_); }
+
+    auto published() const noexcept -> u64 { return published_.load(std::memory_order_relaxed); }
+    auto dropped() const noexcept -> u64 { return dropped_.load(std::memory_order_relaxed); }
+    auto duplicated() const noexcept -> u64 { return duplicated_.load(std::memory_order_relaxed); }
+
+private:
+    // the newest frame's buffer, with `fresh` set until it is taken
+    static constexpr u8 fresh = 4;
+
+    std::size_t size_;
+    std::vector<u32> frames_;
+    u8 back_ = 0;
+    u8 front_ = 1;
+    alignas(64) std::atomic<u8> middle_{2};
+
+    // each written by one side only
+    alignas(64) std::atomic<u64> published_{0};
+    std::atomic<u64> dropped_{0};
+    alignas(64) std::atomic<u64> duplicated_{0};
+
+    auto frame(u8 index) noexcept -> u32 * { return &frames_[index * size_]; }
+    auto frame(u8 index) const noexcept -> u32 const * { return &frames_[index * size_]; }
+};
+
+}  // namespace fce
+
+#endif  // FCE_TRIPLE_BUFFER_HPP_
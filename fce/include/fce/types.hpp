@@ -3,11 +3,65 @@
 
 #include <cstdint>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <stdlib.h>
+#endif
+
 namespace fce {
 
 using s8 = std::int8_t;
+using s16 = std::int16_t;
+using s32 = std::int32_t;
+using s64 = std::int64_t;
 using u8 = std::uint8_t;
 using u16 = std::uint16_t;
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+// Bit operations of C++20's <bit>, over the compiler's builtins.
+
+// The index of the lowest set bit of `v`, which must not be 0.
+inline auto countr_zero(u64 v) noexcept -> unsigned
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctzll(v));
+#endif
+}
+
+inline auto popcount(u64 v) noexcept -> unsigned
+{
+#if defined(_MSC_VER)
+    v = v - (v >> 1 & 0x5555555555555555);
+    v = (v & 0x3333333333333333) + (v >> 2 & 0x3333333333333333);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0F;
+    return unsigned(v * 0x0101010101010101 >> 56);
+#else
+    return unsigned(__builtin_popcountll(v));
+#endif
+}
+
+inline auto byteswap(u16 v) noexcept -> u16
+{
+#if defined(_MSC_VER)
+    return _byteswap_ushort(v);
+#else
+    return __builtin_bswap16(v);
+#endif
+}
+
+inline auto byteswap(u64 v) noexcept -> u64
+{
+#if defined(_MSC_VER)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
 
 }  // namespace fce
 
@@ -0,0 +1,54 @@
+#ifndef FCE_VARIANT_HPP_
+#define FCE_VARIANT_HPP_
+
+#include <fce/types.hpp>
+
+namespace fce {
+
+// Which member of the 6502 family a CPU is, as a policy for Instructions.
+// Features a variant lacks are compiled out of its handlers rather than
+// tested for at run time.
+//
+// - `decimal`: ADC and SBC do BCD arithmetic while the D flag is set.
+// - `cmos`: the 65C02 opcode matrix and timing. Dummy reads re-read the
+//   last operand byte instead of a half-computed address, JMP (a) doesn't
+//   wrap within the page but takes a cycle more, and interrupts clear D.
+
+// The NES CPU: an NMOS 6502 with decimal mode cut out.
+struct Ricoh2A03
+{
+    static constexpr bool decimal = false;
+    static constexpr bool cmos = false;
+};
+
+struct Nmos6502
+{
+    static constexpr bool decimal = true;
+    static constexpr bool cmos = false;
+};
+
+struct Wdc65C02
+{
+    static constexpr bool decimal = true;
+    static constexpr bool cmos = true;
+};
+
+// How closely a CPU follows the bus, chosen at compile time.
+//
+// - Accuracy::exact ticks the clock on every bus access and performs every
+//   dummy read, for cycle accurate I/O and test ROMs.
+// - Accuracy::fast keeps the clock off the bus during a run, so that an
+//   instruction's cycles add up to a single addition, and skips dummy reads
+//   of addresses where reading has no side effects (see Memory::stable()).
+//   Devices reading CPU::cycles() during a run see when it started.
+//
+// Both count the same cycles and produce the same results.
+enum class Accuracy : u8
+{
+    exact,
+    fast,
+};
+
+}  // namespace fce
+
+#endif  // FCE_VARIANT_HPP_
@@ -0,0 +1,534 @@
+#include "fce/apu.hpp"
+#include <algorithm>
+#include <iterator>
+
+using Apu = fce::Apu;
+
+namespace {
+
+using fce::s16;
+using fce::u8;
+using fce::u16;
+using fce::u64;
+
+// The longest block between two flushes: a write to $4017 just before a step
+// restarts the sequence, a step and a bit away from the next.
+constexpr u64 max_block = 16384;
+
+constexpr u8 quarter = 1;
+constexpr u8 half = 2;
+constexpr u8 irq = 4;
+
+struct Step
+{
+    u16 cycle;
+    u8 actions;
+};
+
+// the four and five step sequences, their lengths and periods
+constexpr Step steps[2][5] = {
+    {{7457, quarter}, {14913, quarter | half}, {22371, quarter}, {29829, quarter | half | irq}, {}},
+    {{7457, quarter}, {14913, quarter | half}, {22371, quarter}, {29829, 0}, {37281, quarter | half}},
+};
+constexpr unsigned sequence_steps[2] = {4, 5};
+constexpr u64 sequence_periods[2] = {29830, 37282};
+
+constexpr u8 lengths[32] = {
+    10, 254, 20, 2,  40, 4,  80, 6,  160, 8,  60, 10, 14, 12, 26, 14,
+    12, 16,  24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30,
+};
+
+constexpr u8 duties[4][8] = {
+    {0, 1, 0, 0, 0, 0, 0, 0},
+    {0, 1, 1, 0, 0, 0, 0, 0},
+    {0, 1, 1, 1, 1, 0, 0, 0},
+    {1, 0, 0, 1, 1, 1, 1, 1},
+};
+
+constexpr u16 noise_periods[16] = {4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068};
+constexpr u16 dmc_periods[16] = {428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54};
+
+// sample units per step of each channel's output: 0.00752 per pulse step,
+// 0.00851 per triangle step, 0.00494 per noise step and 0.00335 per DMC step
+// of full scale
+constexpr int weights[5] = {246, 246, 279, 162, 110};
+
+// Clocks of a timer of `period`, next due at `next`, before `to`.
+auto clocks_before(u64 next, u64 period, u64 to) noexcept -> u64
+{
+    return next < to ? (to - next + period - 1) / period : 0;
+}
+
+}  // namespace
+
+Apu::Apu(u32 sample_rate)
+    : sample_rate_{sample_rate}, blip_{cpu_rate, double(sample_rate), max_block}
+{
+    pulses_[0].ones_complement = true;
+}
+
+auto Apu::get(u16 addr) const noexcept -> u8
+{
+    // reading the status acknowledges the frame IRQ
+    return const_cast<Apu&>(*this).read(addr);
+}
+
+auto Apu::set(u16 addr, u8 v) noexcept -> void
+{
+    this->write(addr, v);
+}
+
+auto Apu::attach(Scheduler& scheduler, Clock clock, IrqLine irq_line, Reader read) -> void
+{
+    scheduler_ = &scheduler;
+    clock_ = std::move(clock);
+    irq_ = std::move(irq_line);
+    read_ = std::move(read);
+    scheduler.on(Event::apu_frame_counter, [this](u64 timestamp) {
+        this->catch_up(timestamp + 1);
+        this->schedule();
+    });
+    this->schedule();
+}
+
+auto Apu::advance(u64, u64 to) -> void
+{
+    for (auto step = this->next_step(); step < to; step = this->next_step()) {
+        this->run(step);
+        this->step_frame(step);
+    }
+    this->run(to);
+}
+
+auto Apu::read(u16 addr) noexcept -> u8
+{
+    if (addr != 0x4015) {
+        return 0x00;
+    }
+    this->sync();
+    auto const status = u8((pulses_[0].length ? 0x01 : 0) | (pulses_[1].length ? 0x02 : 0) |
+                           (triangle_.length ? 0x04 : 0) | (noise_.length ? 0x08 : 0) |
+                           (dmc_.remaining ? 0x10 : 0) | (frame_irq_ ? 0x40 : 0) | (dmc_irq_ ? 0x80 : 0));
+    frame_irq_ = false;
+    this->update_irq();
+    return status;
+}
+
+auto Apu::write(u16 addr, u8 v) noexcept -> void
+{
+    this->sync();
+    switch (addr) {
+    case 0x4000:
+    case 0x4004: {
+        auto& pulse = pulses_[addr >> 2 & 1];
+        pulse.duty = v >> 6;
+        pulse.envelope.loop = v & 0x20;
+        pulse.envelope.constant = v & 0x10;
+        pulse.envelope.period = v & 0x0F;
+        break;
+    }
+    case 0x4001:
+    case 0x4005: {
+        auto& pulse = pulses_[addr >> 2 & 1];
+        pulse.sweep_enabled = v & 0x80;
+        pulse.sweep_period = v >> 4 & 7;
+        pulse.sweep_negate = v & 0x08;
+        pulse.sweep_shift = v & 7;
+        pulse.sweep_reload = true;
+        break;
+    }
+    case 0x4002:
+    case 0x4006: {
+        auto& pulse = pulses_[addr >> 2 & 1];
+        pulse.timer = u16((pulse.timer & 0x700) | v);
+        break;
+    }
+    case 0x4003:
+    case 0x4007: {
+        auto const channel = std::size_t(addr >> 2 & 1);
+        auto& pulse = pulses_[channel];
+        pulse.timer = u16((pulse.timer & 0xFF) | (v & 7) << 8);
+        if (enabled_ >> channel & 1) {
+            pulse.length = lengths[v >> 3];
+        }
+        pulse.step = 0;
+        pulse.envelope.start = true;
+        break;
+    }
+    case 0x4008:
+        triangle_.control = v & 0x80;
+        triangle_.linear_period = v & 0x7F;
+        break;
+    case 0x400A:
+        triangle_.timer = u16((triangle_.timer & 0x700) | v);
+        break;
+    case 0x400B:
+        triangle_.timer = u16((triangle_.timer & 0xFF) | (v & 7) << 8);
+        if (enabled_ & 0x04) {
+            triangle_.length = lengths[v >> 3];
+        }
+        triangle_.reload = true;
+        break;
+    case 0x400C:
+        noise_.envelope.loop = v & 0x20;
+        noise_.envelope.constant = v & 0x10;
+        noise_.envelope.period = v & 0x0F;
+        break;
+    case 0x400E:
+        noise_.mode = v & 0x80;
+        noise_.period = v & 0x0F;
+        break;
+    case 0x400F:
+        if (enabled_ & 0x08) {
+            noise_.length = lengths[v >> 3];
+        }
+        noise_.envelope.start = true;
+        break;
+    case 0x4010:
+        dmc_.irq_enabled = v & 0x80;
+        dmc_.loop = v & 0x40;
+        dmc_.rate = v & 0x0F;
+        if (!dmc_.irq_enabled) {
+            dmc_irq_ = false;
+            this->update_irq();
+        }
+        this->schedule();
+        break;
+    case 0x4011:
+        dmc_.level = v & 0x7F;
+        break;
+    case 0x4012:
+        dmc_.start = u16(0xC000 | v << 6);
+        break;
+    case 0x4013:
+        dmc_.size = u16(v << 4 | 1);
+        break;
+    case 0x4015:
+        enabled_ = v & 0x1F;
+        if (!(v & 0x01)) {
+            pulses_[0].length = 0;
+        }
+        if (!(v & 0x02)) {
+            pulses_[1].length = 0;
+        }
+        if (!(v & 0x04)) {
+            triangle_.length = 0;
+        }
+        if (!(v & 0x08)) {
+            noise_.length = 0;
+        }
+        if (!(v & 0x10)) {
+            dmc_.remaining = 0;
+        } else if (!dmc_.remaining) {
+            dmc_.address = dmc_.start;
+            dmc_.remaining = dmc_.size;
+            this->fetch_sample();
+        }
+        dmc_irq_ = false;
+        this->update_irq();
+        this->schedule();
+        break;
+    case 0x4017:
+        five_step_ = v & 0x80;
+        irq_inhibit_ = v & 0x40;
+        if (irq_inhibit_) {
+            frame_irq_ = false;
+            this->update_irq();
+        }
+        frame_start_ = this->timestamp();
+        step_ = 0;
+        if (five_step_) {
+            this->quarter_frame();
+            this->half_frame();
+        }
+        this->schedule();
+        break;
+    default:
+        return;
+    }
+    this->update_all(this->timestamp());
+}
+
+auto Apu::sync() noexcept -> void
+{
+    if (clock_) {
+        this->catch_up(clock_());
+    }
+}
+
+auto Apu::next_step() const noexcept -> u64
+{
+    return frame_start_ + steps[five_step_][step_].cycle;
+}
+
+auto Apu::step_frame(u64 now) noexcept -> void
+{
+    auto const actions = steps[five_step_][step_].actions;
+    if (actions & quarter) {
+        this->quarter_frame();
+    }
+    if (actions & half) {
+        this->half_frame();
+    }
+    if ((actions & irq) && !irq_inhibit_) {
+        frame_irq_ = true;
+        this->update_irq();
+    }
+    this->update_all(now);
+    this->flush(now);
+
+    if (++step_ == sequence_steps[five_step_]) {
+        step_ = 0;
+        frame_start_ += sequence_periods[five_step_];
+    }
+}
+
+auto Apu::quarter_frame() noexcept -> void
+{
+    pulses_[0].envelope.clock();
+    pulses_[1].envelope.clock();
+    noise_.envelope.clock();
+
+    if (triangle_.reload) {
+        triangle_.linear = triangle_.linear_period;
+    } else if (triangle_.linear) {
+        triangle_.linear--;
+    }
+    if (!triangle_.control) {
+        triangle_.reload = false;
+    }
+}
+
+auto Apu::half_frame() noexcept -> void
+{
+    for (auto& pulse : pulses_) {
+        if (pulse.length && !pulse.envelope.loop) {
+            pulse.length--;
+        }
+        pulse.sweep();
+    }
+    if (triangle_.length && !triangle_.control) {
+        triangle_.length--;
+    }
+    if (noise_.length && !noise_.envelope.loop) {
+        noise_.length--;
+    }
+}
+
+auto Apu::schedule() -> void
+{
+    if (!scheduler_) {
+        return;
+    }
+    auto at = this->next_step();
+    if (dmc_.irq_enabled && !dmc_.loop && dmc_.remaining && dmc_.buffered) {
+        // the buffer empties after the bits left of the byte playing, then
+        // every 8 bits, and the last byte is fetched on the last of those
+        u64 const period = dmc_periods[dmc_.rate];
+        at = std::min(at, dmc_.next + (dmc_.bits - 1u) * period + (dmc_.remaining - 1u) * 8 * period);
+    }
+    scheduler_->schedule(Event::apu_frame_counter, at);
+}
+
+auto Apu::update_irq() noexcept -> void
+{
+    if (irq_) {
+        irq_(frame_irq_ || dmc_irq_);
+    }
+}
+
+auto Apu::run(u64 to) noexcept -> void
+{
+    this->run_pulse(pulse1, to);
+    this->run_pulse(pulse2, to);
+    this->run_triangle(to);
+    this->run_noise(to);
+    this->run_dmc(to);
+}
+
+auto Apu::run_pulse(Channel channel, u64 to) noexcept -> void
+{
+    auto& pulse = pulses_[channel];
+    auto const period = (u64{pulse.timer} + 1) * 2;
+    if (!pulse.length || pulse.muted() || !pulse.envelope.volume()) {
+        // silent at every step
+        auto const clocks = clocks_before(pulse.next, period, to);
+        pulse.step = u8((pulse.step + clocks) & 7);
+        pulse.next += clocks * period;
+        return;
+    }
+    for (; pulse.next < to; pulse.next += period) {
+        pulse.step = (pulse.step + 1) & 7;
+        this->update(channel, pulse.output(), pulse.next);
+    }
+}
+
+auto Apu::run_triangle(u64 to) noexcept -> void
+{
+    auto const period = u64{triangle_.timer} + 1;
+    if (!triangle_.running()) {
+        // the sequencer holds, also at periods too short to be heard
+        triangle_.next += clocks_before(triangle_.next, period, to) * period;
+        return;
+    }
+    for (; triangle_.next < to; triangle_.next += period) {
+        triangle_.step = (triangle_.step + 1) & 31;
+        this->update(triangle, triangle_.output(), triangle_.next);
+    }
+}
+
+auto Apu::run_noise(u64 to) noexcept -> void
+{
+    u64 const period = noise_periods[noise_.period];
+    auto const tap = noise_.mode ? 6 : 1;
+    for (; noise_.next < to; noise_.next += period) {
+        auto const feedback = (noise_.shift ^ noise_.shift >> tap) & 1;
+        noise_.shift = u16(noise_.shift >> 1 | feedback << 14);
+        this->update(noise, noise_.output(), noise_.next);
+    }
+}
+
+auto Apu::run_dmc(u64 to) noexcept -> void
+{
+    u64 const period = dmc_periods[dmc_.rate];
+    if (dmc_.silent && !dmc_.buffered) {
+        // nothing to play until a sample starts
+        auto const clocks = clocks_before(dmc_.next, period, to);
+        dmc_.bits = u8((dmc_.bits + 7 - clocks % 8) % 8 + 1);
+        dmc_.next += clocks * period;
+        return;
+    }
+    for (; dmc_.next < to; dmc_.next += period) {
+        if (!dmc_.silent) {
+            if (dmc_.shift & 1) {
+                if (dmc_.level <= 125) {
+                    dmc_.level += 2;
+                }
+            } else if (dmc_.level >= 2) {
+                dmc_.level -= 2;
+            }
+            this->update(dmc, dmc_.level, dmc_.next);
+        }
+        dmc_.shift >>= 1;
+        if (--dmc_.bits == 0) {
+            dmc_.bits = 8;
+            dmc_.silent = !dmc_.buffered;
+            if (dmc_.buffered) {
+                dmc_.shift = dmc_.buffer;
+                dmc_.buffered = false;
+                this->fetch_sample();
+            }
+        }
+    }
+}
+
+auto Apu::fetch_sample() noexcept -> void
+{
+    if (dmc_.buffered || !dmc_.remaining) {
+        return;
+    }
+    dmc_.buffer = read_ ? read_(dmc_.address) : u8(0);
+    dmc_.buffered = true;
+    dmc_.address = dmc_.address == 0xFFFF ? u16(0x8000) : u16(dmc_.address + 1);
+    if (--dmc_.remaining == 0) {
+        if (dmc_.loop) {
+            dmc_.address = dmc_.start;
+            dmc_.remaining = dmc_.size;
+        } else if (dmc_.irq_enabled) {
+            dmc_irq_ = true;
+            this->update_irq();
+        }
+    }
+}
+
+auto Apu::update(Channel channel, int output, u64 time) noexcept -> void
+{
+    auto& last = outputs_[channel];
+    if (output != last) {
+        blip_.add_delta(time - block_start_, (output - last) * weights[channel]);
+        last = output;
+    }
+}
+
+auto Apu::update_all(u64 time) noexcept -> void
+{
+    this->update(pulse1, pulses_[0].output(), time);
+    this->update(pulse2, pulses_[1].output(), time);
+    this->update(triangle, triangle_.output(), time);
+    this->update(noise, noise_.output(), time);
+    this->update(dmc, dmc_.level, time);
+}
+
+auto Apu::flush(u64 time) noexcept -> void
+{
+    blip_.end_block(time - block_start_);
+    block_start_ = time;
+
+    s16 block[512];
+    while (auto const count = blip_.read(block, std::size(block))) {
+        samples_ += count;
+        if (ring_) {
+            dropped_ += count - ring_->push(block, count);
+        }
+    }
+}
+
+auto Apu::Envelope::clock() noexcept -> void
+{
+    if (start) {
+        start = false;
+        decay = 15;
+        divider = period;
+    } else if (divider == 0) {
+        divider = period;
+        if (decay) {
+            decay--;
+        } else if (loop) {
+            decay = 15;
+        }
+    } else {
+        divider--;
+    }
+}
+
+auto Apu::Pulse::target() const noexcept -> int
+{
+    auto const change = int(timer >> sweep_shift);
+    if (sweep_negate) {
+        return int(timer) - change - (ones_complement ? 1 : 0);
+    }
+    return int(timer) + change;
+}
+
+auto Apu::Pulse::muted() const noexcept -> bool
+{
+    return timer < 8 || this->target() > 0x7FF;
+}
+
+auto Apu::Pulse::sweep() noexcept -> void
+{
+    if (sweep_divider == 0 && sweep_enabled && sweep_shift && !this->muted()) {
+        timer = u16(std::max(this->target(), 0));
+    }
+    if (sweep_divider == 0 || sweep_reload) {
+        sweep_divider = sweep_period;
+        sweep_reload = false;
+    } else {
+        sweep_divider--;
+    }
+}
+
+auto Apu::Pulse::output() const noexcept -> int
+{
+    return length && duties[duty][step] && !this->muted() ? envelope.volume() : 0;
+}
+
+auto Apu::Triangle::output() const noexcept -> int
+{
+    return step < 16 ? 15 - step : step - 16;
+}
+
+auto Apu::Noise::output() const noexcept -> int
+{
+    return length && !(shift & 1) ? envelope.volume() : 0;
+}
@@ -0,0 +1,98 @@
+#include "fce/audio.hpp"
+#include <chrono>
+#include <ostream>
+#include <utility>
+
+using AudioThread = fce::AudioThread;
+using WavWriter = fce::WavWriter;
+
+namespace {
+
+auto put(std::ostream& out, fce::u64 v, unsigned bytes) -> void
+{
+    for (unsigned i = 0; i < bytes; i++) {
+        out.put(char(v >> (8 * i) & 0xFF));
+    }
+}
+
+}  // namespace
+
+WavWriter::WavWriter(std::ostream& out, u32 sample_rate)
+    : out_{out}, sample_rate_{sample_rate}
+{
+    this->header();
+}
+
+auto WavWriter::write(s16 const *samples, std::size_t count) -> void
+{
+    for (std::size_t i = 0; i < count; i++) {
+        put(out_, u16(samples[i]), 2);
+    }
+    samples_ += count;
+}
+
+auto WavWriter::finish() -> void
+{
+    auto const end = out_.tellp();
+    out_.seekp(0);
+    this->header();
+    out_.seekp(end);
+    out_.flush();
+}
+
+auto WavWriter::header() -> void
+{
+    auto const data = samples_ * 2;
+    out_.write("RIFF", 4);
+    put(out_, 36 + data, 4);
+    out_.write("WAVEfmt ", 8);
+    put(out_, 16, 4);  // format chunk size
+    put(out_, 1, 2);  // PCM
+    put(out_, 1, 2);  // mono
+    put(out_, sample_rate_, 4);
+    put(out_, u64{sample_rate_} * 2, 4);  // bytes per second
+    put(out_, 2, 2);  // bytes per frame
+    put(out_, 16, 2);  // bits per sample
+    out_.write("data", 4);
+    put(out_, data, 4);
+}
+
+AudioThread::AudioThread(AudioRing& ring, Sink sink, std::size_t block)
+    : ring_{ring}, sink_{std::move(sink)}, block_(block)
+{
+    thread_ = std::thread{[this] { this->run(); }};
+}
+
+AudioThread::~AudioThread()
+{
+    this->stop();
+}
+
+auto AudioThread::stop() -> void
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_relaxed);
+    thread_.join();
+    while (this->drain() != 0) {
+    }
+}
+
+auto AudioThread::run() noexcept -> void
+{
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (this->drain() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+}
+
+auto AudioThread::drain() -> std::size_t
+{
+    auto const count = ring_.pop(block_.data(), block_.size());
+    if (count != 0) {
+        sink_(block_.data(), count);
+    }
+    return count;
+}
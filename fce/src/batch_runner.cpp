@@ -0,0 +1,43 @@
+#include "fce/batch_runner.hpp"
+#include <cstring>
+
+using BatchRunner = fce::BatchRunner;
+
+BatchRunner::BatchRunner(std::size_t count, Savestate const& initial, std::size_t threads)
+    : initial_{std::make_unique<Savestate>(initial)}, pool_{threads}
+{
+    machines_.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        machines_.emplace_back();
+        machines_.back().engine(Engine::interpreter);
+        this->reset(i);
+    }
+}
+
+auto BatchRunner::step_all(u64 cycles) -> void
+{
+    pool_.for_each(machines_.size(), [this, cycles](std::size_t i) { machines_[i].run(cycles); });
+}
+
+auto BatchRunner::reset(std::size_t i) noexcept -> void
+{
+    auto& machine = machines_[i];
+    auto& bus = machine.bus();
+    machine.state(initial_->cpu);
+    for (unsigned page = 0; page < 0x100; page++) {
+        if (bus.dirty(u8(page))) {
+            std::memcpy(bus.data() + page * 0x100, initial_->memory.data() + page * 0x100, 0x100);
+            machine.invalidate_code(u8(page), u8(page));
+        }
+    }
+    bus.clean();
+}
+
+auto BatchRunner::reset(std::size_t i, u64 seed) noexcept -> void
+{
+    this->reset(i);
+    auto& bus = machines_[i].bus();
+    for (unsigned k = 0; k < 8; k++) {
+        bus.set(u16(seed_address_ + k), u8(seed >> (8 * k)));
+    }
+}
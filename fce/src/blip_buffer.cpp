@@ -0,0 +1,119 @@
+#include "fce/blip_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using BlipBuffer = fce::BlipBuffer;
+
+namespace {
+
+using fce::s16;
+using fce::s32;
+using fce::s64;
+using fce::u64;
+
+constexpr unsigned delta_bits = 15;
+constexpr unsigned phase_bits = 5;
+static_assert(BlipBuffer::phases == 1u << phase_bits);
+// DC is removed by leaking 1/512 of the integral per sample, a high-pass
+// corner of about 15 Hz at 48 kHz
+constexpr unsigned bass_shift = 9;
+
+constexpr double pi = 3.14159265358979323846;
+
+}  // namespace
+
+BlipBuffer::Kernels const BlipBuffer::kernels_ = BlipBuffer::make_kernels();
+
+BlipBuffer::BlipBuffer(double clock_rate, double sample_rate, u64 max_clocks)
+    : sample_rate_{sample_rate},
+      factor_{u64(std::llround(sample_rate / clock_rate * 4294967296.0))},
+      offset_{0},
+      available_{0},
+      sum_{0}
+{
+    auto const samples = std::size_t(max_clocks * factor_ >> 32) + 1;
+    deltas_.resize(samples + taps);
+}
+
+auto BlipBuffer::add_delta(u64 time, int delta) noexcept -> void
+{
+    auto const fixed = offset_ + time * factor_;
+    auto const index = std::size_t(fixed >> 32);
+    if (index + taps > deltas_.size()) {
+        return;  // past the longest block
+    }
+    auto const& kernel = kernels_[fixed >> (32 - phase_bits) & (phases - 1)];
+    auto const out = &deltas_[index];
+    for (std::size_t i = 0; i < taps; i++) {
+        out[i] += kernel[i] * delta;
+    }
+}
+
+auto BlipBuffer::end_block(u64 time) noexcept -> void
+{
+    offset_ += time * factor_;
+    available_ = std::min(std::size_t(offset_ >> 32), deltas_.size() - taps);
+}
+
+auto BlipBuffer::read(s16 *out, std::size_t count) noexcept -> std::size_t
+{
+    count = std::min(count, available_);
+    auto sum = sum_;
+    for (std::size_t i = 0; i < count; i++) {
+        auto const s = std::clamp<s64>(sum >> delta_bits, std::numeric_limits<s16>::min(),
+                                       std::numeric_limits<s16>::max());
+        sum += deltas_[i];
+        out[i] = s16(s);
+        sum -= s * (1 << (delta_bits - bass_shift));
+    }
+    sum_ = sum;
+
+    // the tails of the steps near the end stay for the next read
+    auto const kept = available_ - count + taps;
+    std::copy_n(&deltas_[count], kept, deltas_.begin());
+    std::fill_n(&deltas_[kept], count, 0);
+    available_ -= count;
+    offset_ -= u64{count} << 32;
+    return count;
+}
+
+auto BlipBuffer::clear() noexcept -> void
+{
+    offset_ = 0;
+    available_ = 0;
+    sum_ = 0;
+    std::fill(deltas_.begin(), deltas_.end(), 0);
+}
+
+auto BlipBuffer::make_kernels() -> Kernels
+{
+    // a windowed sinc with its cutoff a little short of the Nyquist
+    // frequency, sampled at each phase and scaled to sum to 1 << 15
+    constexpr double cutoff = 0.45;
+    Kernels kernels{};
+    for (std::size_t phase = 0; phase < phases; phase++) {
+        std::array<double, taps> h{};
+        double total = 0;
+        for (std::size_t i = 0; i < taps; i++) {
+            auto const t = double(i) - double(taps) / 2 + 0.5 - double(phase) / phases;
+            auto const x = 2 * cutoff * t;
+            auto const sinc = x == 0 ? 1.0 : std::sin(pi * x) / (pi * x);
+            auto const w = 2 * pi * t / taps;
+            auto const window = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2 * w);
+            h[i] = sinc * window;
+            total += h[i];
+        }
+
+        auto& kernel = kernels[phase];
+        s32 sum = 0;
+        for (std::size_t i = 0; i < taps; i++) {
+            kernel[i] = s32(std::lround(h[i] / total * (1 << delta_bits)));
+            sum += kernel[i];
+        }
+        // rounding errors go to the largest tap, so that steps are exact
+        auto const largest = std::max_element(kernel.begin(), kernel.end());
+        *largest += (1 << delta_bits) - sum;
+    }
+    return kernels;
+}
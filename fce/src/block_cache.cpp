@@ -0,0 +1,60 @@
+#include "fce/block_cache.hpp"
+#include <algorithm>
+
+using BlockCache = fce::BlockCache;
+
+BlockCache::BlockCache()
+    : entries_(0x10000, 0)
+{
+    ops_.reserve(capacity);
+}
+
+auto BlockCache::invalidate(u8 page) noexcept -> void
+{
+    for (auto const pc : pages_[page]) {
+        entries_[pc] = 0;
+    }
+    pages_[page].clear();
+    code_pages_[page] = false;
+}
+
+auto BlockCache::flush() noexcept -> void
+{
+    ops_.clear();
+    blocks_.clear();
+    std::fill(entries_.begin(), entries_.end(), 0);
+    for (auto& pcs : pages_) {
+        pcs.clear();
+    }
+    code_pages_.fill(false);
+}
+
+auto BlockCache::ends_block(u8 opcode) noexcept -> bool
+{
+    switch (opcode) {
+    case 0x00:  // BRK
+    case 0x20:  // JSR
+    case 0x40:  // RTI
+    case 0x4C:  // JMP a
+    case 0x60:  // RTS
+    case 0x6C:  // JMP (a)
+        return true;
+    default:
+        return addressing_modes[opcode] == AddressingMode::REL;
+    }
+}
+
+auto BlockCache::insert(u16 pc, u16 last, Block block) -> Block
+{
+    blocks_.push_back(block);
+    entries_[pc] = u32(blocks_.size());
+
+    for (auto page = unsigned(pc >> 8); ; page = (page + 1) & 0xFF) {
+        pages_[page].push_back(pc);
+        code_pages_[page] = true;
+        if (page == unsigned(last >> 8)) {
+            break;
+        }
+    }
+    return block;
+}
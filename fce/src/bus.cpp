@@ -0,0 +1,63 @@
+#include "fce/bus.hpp"
+#include <cassert>
+#include <utility>
+
+using Bus = fce::Bus;
+
+Bus::Bus() noexcept
+    : read_{}, write_{}, io_{}
+{
+    dirty_.fill(true);
+}
+
+Bus::Bus(std::shared_ptr<Memory> memory) noexcept
+    : Bus{}
+{
+    if (memory) {
+        io_.fill(memory.get());
+        handlers_.push_back(std::move(memory));
+    }
+}
+
+auto Bus::map_ram(u8 first, u8 last, u8 *data, std::size_t size) noexcept -> void
+{
+    assert(size != 0 && size % 0x100 == 0);
+
+    for (unsigned page = first; page <= last; page++) {
+        auto const offset = ((page - first) << 8) % size;
+        read_[page] = data + offset;
+        write_[page] = data + offset;
+        io_[page] = nullptr;
+    }
+}
+
+auto Bus::map_rom(u8 first, u8 last, u8 const *data, std::size_t size) noexcept -> void
+{
+    assert(size != 0 && size % 0x100 == 0);
+
+    for (unsigned page = first; page <= last; page++) {
+        auto const offset = ((page - first) << 8) % size;
+        read_[page] = data + offset;
+        write_[page] = nullptr;
+        io_[page] = nullptr;
+    }
+}
+
+auto Bus::map_io(u8 first, u8 last, std::shared_ptr<Memory> handler) -> void
+{
+    for (unsigned page = first; page <= last; page++) {
+        read_[page] = nullptr;
+        write_[page] = nullptr;
+        io_[page] = handler.get();
+    }
+    handlers_.push_back(std::move(handler));
+}
+
+auto Bus::unmap(u8 first, u8 last) noexcept -> void
+{
+    for (unsigned page = first; page <= last; page++) {
+        read_[page] = nullptr;
+        write_[page] = nullptr;
+        io_[page] = nullptr;
+    }
+}
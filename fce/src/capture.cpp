@@ -0,0 +1,163 @@
+#include "fce/capture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <ostream>
+#include <string>
+
+using VideoCapture = fce::VideoCapture;
+
+namespace {
+
+using fce::u32;
+
+constexpr std::size_t y4m_frame_header = 6;  // "FRAME\n"
+
+auto red(u32 p) noexcept -> int { return int(p & 0xFF); }
+auto green(u32 p) noexcept -> int { return int(p >> 8 & 0xFF); }
+auto blue(u32 p) noexcept -> int { return int(p >> 16 & 0xFF); }
+
+// Full range BT.601 in 16-bit fixed point. The chroma of 2x2 pixels is taken
+// from their sums, hence the two extra bits.
+auto luma(u32 p) noexcept -> char
+{
+    return char((19595 * red(p) + 38470 * green(p) + 7471 * blue(p) + 32768) >> 16);
+}
+
+auto chroma(int r, int g, int b, int kr, int kg, int kb) noexcept -> char
+{
+    return char(std::min((kr * r + kg * g + kb * b + (128 << 18) + (1 << 17)) >> 18, 255));
+}
+
+}  // namespace
+
+VideoCapture::VideoCapture(std::ostream& out, VideoFormat format, unsigned width, unsigned height,
+                           std::size_t depth, std::size_t batch)
+    : out_{out},
+      format_{format},
+      width_{width},
+      height_{height},
+      batch_{batch},
+      buffers_(depth * this->size()),
+      free_{depth},
+      full_{depth}
+{
+    for (std::size_t i = 0; i < depth; i++) {
+        free_.push(&i, 1);
+    }
+    auto const frame_bytes = format == VideoFormat::y4m ? y4m_frame_header + this->size() * 3 / 2 : this->size() * 3;
+    pending_.reserve(batch + frame_bytes);
+
+    if (format == VideoFormat::y4m) {
+        // 8:7 pixels at 39375000 / 655171 frames a second
+        auto const header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) +
+                            " F39375000:655171 Ip A8:7 C420jpeg XCOLORRANGE=FULL\n";
+        pending_.insert(pending_.end(), header.begin(), header.end());
+    }
+    thread_ = std::thread{[this] { this->run(); }};
+}
+
+VideoCapture::~VideoCapture()
+{
+    this->finish();
+}
+
+auto VideoCapture::frame() -> u32 *
+{
+    if (current_ == none && free_.pop(&current_, 1) == 0) {
+        stalls_++;
+        while (free_.pop(&current_, 1) == 0) {
+            std::this_thread::yield();
+        }
+    }
+    return &buffers_[current_ * this->size()];
+}
+
+auto VideoCapture::submit() -> void
+{
+    this->frame();
+    full_.push(&current_, 1);
+    current_ = none;
+    frames_++;
+}
+
+auto VideoCapture::finish() -> void
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_relaxed);
+    thread_.join();
+    while (this->drain() != 0) {
+    }
+    this->write();
+    out_.flush();
+}
+
+auto VideoCapture::run() noexcept -> void
+{
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (this->drain() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+}
+
+auto VideoCapture::drain() -> std::size_t
+{
+    std::size_t index;
+    if (full_.pop(&index, 1) == 0) {
+        return 0;
+    }
+    this->convert(&buffers_[index * this->size()]);
+    free_.push(&index, 1);
+    if (pending_.size() >= batch_) {
+        this->write();
+    }
+    return 1;
+}
+
+auto VideoCapture::convert(u32 const *pixels) -> void
+{
+    if (format_ == VideoFormat::rgb) {
+        for (std::size_t i = 0; i < this->size(); i++) {
+            pending_.push_back(char(red(pixels[i])));
+            pending_.push_back(char(green(pixels[i])));
+            pending_.push_back(char(blue(pixels[i])));
+        }
+        return;
+    }
+
+    static constexpr char frame_header[] = "FRAME\n";
+    pending_.insert(pending_.end(), frame_header, frame_header + y4m_frame_header);
+    std::transform(pixels, pixels + this->size(), std::back_inserter(pending_), luma);
+
+    // both chroma planes at once: U into the end, V after it
+    auto const quarter = this->size() / 4;
+    auto const u = pending_.size();
+    pending_.resize(u + 2 * quarter);
+    auto const v = u + quarter;
+    std::size_t i = 0;
+    for (std::size_t y = 0; y < height_; y += 2) {
+        auto const row = pixels + y * width_;
+        for (std::size_t x = 0; x < width_; x += 2, i++) {
+            u32 const block[] = {row[x], row[x + 1], row[x + width_], row[x + width_ + 1]};
+            int r = 0;
+            int g = 0;
+            int b = 0;
+            for (auto p : block) {
+                r += red(p);
+                g += green(p);
+                b += blue(p);
+            }
+            pending_[u + i] = chroma(r, g, b, -11059, -21709, 32768);
+            pending_[v + i] = chroma(r, g, b, 32768, -27439, -5329);
+        }
+    }
+}
+
+auto VideoCapture::write() -> void
+{
+    out_.write(pending_.data(), std::streamsize(pending_.size()));
+    pending_.clear();
+}
@@ -0,0 +1,148 @@
+#include "fce/coverage.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fce/instructions.hpp"
+
+using Coverage = fce::Coverage;
+
+namespace {
+
+// The file is the magic followed by the executed and the data bitmap, each
+// 8 KiB with address 8 * i + j at bit j of byte i.
+constexpr char magic[8] = {'F', 'C', 'E', 'C', 'O', 'V', 'R', '1'};
+constexpr std::size_t bitmap_size = 0x10000 / 8;
+
+auto count(std::array<fce::u64, 0x10000 / 64> const& bits) noexcept -> std::size_t
+{
+    std::size_t n = 0;
+    for (auto word : bits) {
+        n += fce::popcount(word);
+    }
+    return n;
+}
+
+auto put(std::array<fce::u64, 0x10000 / 64> const& bits, char *out) noexcept -> void
+{
+    for (std::size_t i = 0; i < bitmap_size; i++) {
+        out[i] = char(bits[i / 8] >> (8 * (i % 8)) & 0xFF);
+    }
+}
+
+auto take(std::array<fce::u64, 0x10000 / 64>& bits, char const *in) noexcept -> void
+{
+    for (std::size_t i = 0; i < bitmap_size; i++) {
+        bits[i / 8] |= fce::u64(fce::u8(in[i])) << (8 * (i % 8));
+    }
+}
+
+auto percent(std::size_t part, std::size_t total) noexcept -> double
+{
+    return total == 0 ? 0.0 : 100.0 * double(part) / double(total);
+}
+
+}  // namespace
+
+auto Coverage::executed_count() const noexcept -> std::size_t
+{
+    return count(code_);
+}
+
+auto Coverage::data_count() const noexcept -> std::size_t
+{
+    return count(data_);
+}
+
+auto Coverage::clear() noexcept -> void
+{
+    code_.fill(0);
+    data_.fill(0);
+}
+
+auto Coverage::merge(Coverage const& other) noexcept -> void
+{
+    for (std::size_t i = 0; i < code_.size(); i++) {
+        code_[i] |= other.code_[i];
+        data_[i] |= other.data_[i];
+    }
+}
+
+auto Coverage::save(std::ostream& os) const -> void
+{
+    std::vector<char> buffer(sizeof magic + 2 * bitmap_size);
+    std::copy(magic, magic + sizeof magic, buffer.begin());
+    put(code_, buffer.data() + sizeof magic);
+    put(data_, buffer.data() + sizeof magic + bitmap_size);
+    os.write(buffer.data(), std::streamsize(buffer.size()));
+}
+
+auto fce::load_coverage(std::istream& is) -> Coverage
+{
+    char header[sizeof magic];
+    if (!is.read(header, sizeof header) || !std::equal(magic, magic + sizeof magic, header)) {
+        throw std::runtime_error("not coverage");
+    }
+    std::vector<char> buffer(2 * bitmap_size);
+    if (!is.read(buffer.data(), std::streamsize(buffer.size()))) {
+        throw std::runtime_error("truncated coverage");
+    }
+
+    Coverage coverage;
+    take(coverage.code_, buffer.data());
+    take(coverage.data_, buffer.data() + bitmap_size);
+    return coverage;
+}
+
+auto Coverage::report(std::ostream& os, u8 const *image, std::size_t size, u16 base, bool cmos) const -> void
+{
+    size = std::min(size, std::size_t(0x10000 - base));
+    auto const& modes = cmos ? addressing_modes_65c02 : addressing_modes;
+
+    // '#', '+', 'd' or '.' for each byte of the image
+    std::string map(size, '.');
+    std::size_t instructions = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        auto const addr = u16(base + i);
+        if (this->executed(addr)) {
+            instructions++;
+            map[i] = '#';
+            auto const operands = operand_size(modes[image[i]]);
+            for (std::size_t j = i + 1; j <= i + operands && j < size; j++) {
+                if (map[j] == '.' || map[j] == 'd') {
+                    map[j] = '+';
+                }
+            }
+        } else if (this->data(addr) && map[i] == '.') {
+            map[i] = 'd';
+        }
+    }
+    auto const code = size - std::size_t(std::count(map.begin(), map.end(), '.')) -
+                      std::size_t(std::count(map.begin(), map.end(), 'd'));
+    auto const data = std::size_t(std::count(map.begin(), map.end(), 'd'));
+
+    char line[128];
+    std::snprintf(line, sizeof line, "%04X-%04X  %zu instructions, %zu bytes of code (%.1f%%), %zu of data (%.1f%%)\n",
+                  unsigned(base), unsigned(base + (size == 0 ? 0 : size - 1)), instructions, code,
+                  percent(code, size), data, percent(data, size));
+    os << line;
+
+    auto collapsed = false;
+    for (std::size_t row = 0; row < size; row += 64) {
+        auto const text = map.substr(row, 64);
+        if (text.find_first_not_of('.') == std::string::npos && row != 0 && row + 64 < size) {
+            if (!collapsed) {
+                os << "*\n";
+                collapsed = true;
+            }
+            continue;
+        }
+        collapsed = false;
+        std::snprintf(line, sizeof line, "%04X  ", unsigned(u16(base + row)));
+        os << line << text << '\n';
+    }
+}
@@ -0,0 +1,565 @@
+#include "fce/lockstep.hpp"
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FCE_LOCKSTEP_SIMD 1
+#include <immintrin.h>
+#endif
+
+using LockstepKernel = fce::LockstepKernel;
+using LockstepKernels = fce::LockstepKernels;
+using LockstepLanes = fce::LockstepLanes;
+
+namespace {
+
+using fce::u8;
+using fce::u16;
+using fce::u32;
+using fce::u64;
+
+constexpr LockstepKernels none{};
+
+#if defined(FCE_LOCKSTEP_SIMD)
+
+// Addressing modes and operations, as FCE_OPCODES names them
+namespace modes {
+struct IMP; struct ACC; struct IMM; struct ZPG; struct ZPX; struct ZPY; struct ABS;
+struct ABX; struct ABY; struct IND; struct IDX; struct IDY; struct REL;
+}  // namespace modes
+
+namespace ops {
+struct ADC; struct AND; struct ASL; struct BCC; struct BCS; struct BEQ; struct BIT; struct BMI;
+struct BNE; struct BPL; struct BRK; struct BVC; struct BVS; struct CLC; struct CLD; struct CLI;
+struct CLV; struct CMP; struct CPX; struct CPY; struct DEC; struct DEX; struct DEY; struct EOR;
+struct INC; struct INX; struct INY; struct JMP; struct JSR; struct LDA; struct LDX; struct LDY;
+struct LSR; struct NOP; struct ORA; struct PHA; struct PHP; struct PLA; struct PLP; struct ROL;
+struct ROR; struct RTI; struct RTS; struct SBC; struct SEC; struct SED; struct SEI; struct STA;
+struct STX; struct STY; struct TAX; struct TAY; struct TSX; struct TXA; struct TXS; struct TYA;
+}  // namespace ops
+
+using namespace modes;
+using namespace ops;
+
+template <typename T, typename... U>
+constexpr bool any = (std::is_same<T, U>::value || ...);
+
+template <typename Op>
+constexpr bool reads = any<Op, LDA, LDX, LDY, ORA, AND, EOR, ADC, SBC, CMP, CPX, CPY, BIT>;
+template <typename Op>
+constexpr bool stores = any<Op, STA, STX, STY>;
+template <typename Op>
+constexpr bool modifies = any<Op, ASL, LSR, ROL, ROR, INC, DEC>;
+template <typename Op>
+constexpr bool branches = any<Op, BPL, BMI, BVC, BVS, BCC, BCS, BNE, BEQ>;
+
+// Everything but BRK, RTI and JMP (a), which run lane by lane.
+template <typename Mode, typename Op>
+constexpr bool vectorized = reads<Op> || stores<Op> || modifies<Op> || branches<Op> ||
+                            (std::is_same<Mode, IMP>::value && !any<Op, BRK, RTI>) ||
+                            (std::is_same<Op, JMP>::value && std::is_same<Mode, ABS>::value);
+
+// The registers an instruction writes, besides the PC
+template <typename Mode, typename Op>
+constexpr bool writes_a = any<Op, LDA, ORA, AND, EOR, ADC, SBC, PLA, TXA, TYA> ||
+                          (std::is_same<Mode, ACC>::value && modifies<Op>);
+template <typename Op>
+constexpr bool writes_x = any<Op, LDX, INX, DEX, TAX, TSX>;
+template <typename Op>
+constexpr bool writes_y = any<Op, LDY, INY, DEY, TAY>;
+template <typename Op>
+constexpr bool writes_s = any<Op, JSR, RTS, PHA, PHP, PLA, PLP, TXS>;
+template <typename Op>
+constexpr bool writes_p = !stores<Op> && !branches<Op> && !any<Op, JMP, JSR, RTS, PHA, PHP, TXS, NOP>;
+
+template <typename Mode>
+constexpr unsigned operand_size = any<Mode, IMP, ACC> ? 0 : any<Mode, ABS, ABX, ABY, IND> ? 2 : 1;
+
+#define FCE_AVX2 __attribute__((target("avx2"), always_inline)) inline
+
+// Eight lanes, one in each 32-bit element. Registers hold bytes, addresses
+// 16 bits, and masks all ones or zeros.
+struct Chunk
+{
+    __m256i a;
+    __m256i x;
+    __m256i y;
+    __m256i s;
+    __m256i p;
+    __m256i pc;
+    __m256i cycles;  // of the instruction so far
+    __m256i on;
+    u8 *ram;  // the first lane's byte of address 0
+    std::size_t lanes;
+};
+
+FCE_AVX2 auto splat(int v) noexcept -> __m256i
+{
+    return _mm256_set1_epi32(v);
+}
+
+FCE_AVX2 auto widen(u8 const *bytes) noexcept -> __m256i
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(bytes)));
+}
+
+FCE_AVX2 auto narrow(u8 *bytes, __m256i v) noexcept -> void
+{
+    auto const low = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                      0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    auto const packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, low), _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(bytes), _mm256_castsi256_si128(packed));
+}
+
+FCE_AVX2 auto widen(u16 const *words) noexcept -> __m256i
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(words)));
+}
+
+FCE_AVX2 auto narrow(u16 *words, __m256i v) noexcept -> void
+{
+    auto const low = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                                      0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    auto const packed = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, low), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(words), _mm256_castsi256_si128(packed));
+}
+
+FCE_AVX2 auto tick(Chunk& k, int n) noexcept -> void
+{
+    k.cycles = _mm256_add_epi32(k.cycles, splat(n));
+}
+
+// A cycle more in the lanes of `mask`
+FCE_AVX2 auto tick(Chunk& k, __m256i mask) noexcept -> void
+{
+    k.cycles = _mm256_sub_epi32(k.cycles, mask);
+}
+
+FCE_AVX2 auto byte(__m256i v) noexcept -> __m256i
+{
+    return _mm256_and_si256(v, splat(0xFF));
+}
+
+// The bytes of `addr`, the same for every lane, e.g. operand bytes
+FCE_AVX2 auto row(Chunk const& k, u16 addr) noexcept -> __m256i
+{
+    return widen(k.ram + std::size_t{addr} * k.lanes);
+}
+
+// Each lane's byte of its own address. The gather reads 32 bits a byte,
+// hence Lockstep's padding.
+FCE_AVX2 auto read(Chunk const& k, __m256i addr) noexcept -> __m256i
+{
+    auto const index = _mm256_add_epi32(_mm256_mullo_epi32(addr, splat(int(k.lanes))),
+                                        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    return byte(_mm256_i32gather_epi32(reinterpret_cast<int const *>(k.ram), index, 1));
+}
+
+// There is no scatter in AVX2: the lanes on store one by one.
+FCE_AVX2 auto write(Chunk const& k, __m256i addr, __m256i v) noexcept -> void
+{
+    alignas(32) u32 at[8];
+    alignas(32) u32 value[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(at), addr);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(value), v);
+    for (auto lanes = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(k.on))); lanes != 0; lanes &= lanes - 1) {
+        auto const lane = fce::countr_zero(lanes);
+        k.ram[at[lane] * k.lanes + lane] = u8(value[lane]);
+    }
+}
+
+// Replaces the bits of `mask` in P with those of `bits`
+FCE_AVX2 auto flags(Chunk& k, int mask, __m256i bits) noexcept -> void
+{
+    k.p = _mm256_or_si256(_mm256_andnot_si256(splat(mask), k.p), bits);
+}
+
+FCE_AVX2 auto set_nz(Chunk& k, __m256i m) noexcept -> void
+{
+    auto const z = _mm256_and_si256(_mm256_cmpeq_epi32(m, _mm256_setzero_si256()), splat(0x02));
+    flags(k, 0x82, _mm256_or_si256(_mm256_and_si256(m, splat(0x80)), z));
+}
+
+FCE_AVX2 auto push(Chunk& k, __m256i v) noexcept -> void
+{
+    write(k, _mm256_or_si256(k.s, splat(0x100)), v);
+    k.s = byte(_mm256_sub_epi32(k.s, splat(1)));
+    tick(k, 1);
+}
+
+FCE_AVX2 auto pull(Chunk& k) noexcept -> __m256i
+{
+    k.s = byte(_mm256_add_epi32(k.s, splat(1)));
+    tick(k, 1);
+    return read(k, _mm256_or_si256(k.s, splat(0x100)));
+}
+
+template <typename Op>
+FCE_AVX2 auto target(Chunk& k) noexcept -> __m256i&
+{
+    if constexpr (any<Op, LDA, STA, CMP, PHA, PLA>) {
+        return k.a;
+    } else if constexpr (any<Op, LDX, STX, CPX>) {
+        return k.x;
+    } else if constexpr (any<Op, PHP, PLP>) {
+        return k.p;
+    } else {
+        return k.y;
+    }
+}
+
+// An effective address, and where indexing crossed a page
+struct Effective
+{
+    __m256i addr;
+    __m256i crossed;
+};
+
+template <typename Mode>
+FCE_AVX2 auto address(Chunk& k, u16 pc) noexcept -> Effective
+{
+    auto const zero = _mm256_setzero_si256();
+    auto const lo = row(k, u16(pc + 1));
+    if constexpr (std::is_same<Mode, ZPG>::value) {
+        tick(k, 1);
+        return {lo, zero};
+    } else if constexpr (any<Mode, ZPX, ZPY>) {
+        tick(k, 2);
+        return {byte(_mm256_add_epi32(lo, std::is_same<Mode, ZPX>::value ? k.x : k.y)), zero};
+    } else if constexpr (std::is_same<Mode, ABS>::value) {
+        tick(k, 2);
+        return {_mm256_or_si256(lo, _mm256_slli_epi32(row(k, u16(pc + 2)), 8)), zero};
+    } else if constexpr (any<Mode, ABX, ABY>) {
+        tick(k, 2);
+        auto const sum = _mm256_add_epi32(lo, std::is_same<Mode, ABX>::value ? k.x : k.y);
+        auto const addr = _mm256_add_epi32(_mm256_slli_epi32(row(k, u16(pc + 2)), 8), sum);
+        return {_mm256_and_si256(addr, splat(0xFFFF)), _mm256_cmpgt_epi32(sum, splat(0xFF))};
+    } else if constexpr (std::is_same<Mode, IDX>::value) {
+        tick(k, 4);
+        auto const pointer = byte(_mm256_add_epi32(lo, k.x));
+        auto const addr_lo = read(k, pointer);
+        auto const addr_hi = read(k, byte(_mm256_add_epi32(pointer, splat(1))));
+        return {_mm256_or_si256(addr_lo, _mm256_slli_epi32(addr_hi, 8)), zero};
+    } else {
+        static_assert(std::is_same<Mode, IDY>::value, "no memory operand");
+        tick(k, 3);
+        auto const addr_lo = read(k, lo);
+        auto const addr_hi = read(k, byte(_mm256_add_epi32(lo, splat(1))));
+        auto const sum = _mm256_add_epi32(addr_lo, k.y);
+        auto const addr = _mm256_add_epi32(_mm256_slli_epi32(addr_hi, 8), sum);
+        return {_mm256_and_si256(addr, splat(0xFFFF)), _mm256_cmpgt_epi32(sum, splat(0xFF))};
+    }
+}
+
+// Reads pay for the dummy read only where the page is crossed, writes
+// always do, as in Instructions.
+template <typename Mode>
+FCE_AVX2 auto load(Chunk& k, u16 pc) noexcept -> __m256i
+{
+    if constexpr (std::is_same<Mode, IMM>::value) {
+        tick(k, 1);
+        return row(k, u16(pc + 1));
+    } else {
+        auto const e = address<Mode>(k, pc);
+        tick(k, e.crossed);
+        tick(k, 1);
+        return read(k, e.addr);
+    }
+}
+
+template <typename Mode>
+FCE_AVX2 auto store(Chunk& k, u16 pc, __m256i v) noexcept -> void
+{
+    auto const e = address<Mode>(k, pc);
+    tick(k, any<Mode, ABX, ABY, IDY> ? 2 : 1);
+    write(k, e.addr, v);
+}
+
+template <typename Op>
+FCE_AVX2 auto shift(Chunk& k, __m256i m) noexcept -> __m256i
+{
+    if constexpr (std::is_same<Op, ASL>::value) {
+        flags(k, 0x01, _mm256_srli_epi32(m, 7));
+        return byte(_mm256_slli_epi32(m, 1));
+    } else if constexpr (std::is_same<Op, ROL>::value) {
+        flags(k, 0x01, _mm256_srli_epi32(m, 7));
+        return byte(_mm256_or_si256(_mm256_slli_epi32(m, 1), _mm256_srli_epi32(m, 7)));
+    } else if constexpr (std::is_same<Op, LSR>::value) {
+        flags(k, 0x01, _mm256_and_si256(m, splat(0x01)));
+        return _mm256_srli_epi32(m, 1);
+    } else if constexpr (std::is_same<Op, ROR>::value) {
+        flags(k, 0x01, _mm256_and_si256(m, splat(0x01)));
+        return byte(_mm256_or_si256(_mm256_srli_epi32(m, 1), _mm256_slli_epi32(m, 7)));
+    } else if constexpr (std::is_same<Op, INC>::value) {
+        return byte(_mm256_add_epi32(m, splat(1)));
+    } else {
+        return byte(_mm256_sub_epi32(m, splat(1)));
+    }
+}
+
+template <typename Mode, typename Op>
+FCE_AVX2 auto modify(Chunk& k, u16 pc) noexcept -> void
+{
+    if constexpr (std::is_same<Mode, ACC>::value) {
+        tick(k, 1);
+        k.a = shift<Op>(k, k.a);
+        set_nz(k, k.a);
+    } else {
+        auto const e = address<Mode>(k, pc);
+        auto const m = read(k, e.addr);
+        tick(k, any<Mode, ABX, ABY> ? 4 : 3);
+        auto const result = shift<Op>(k, m);
+        write(k, e.addr, result);
+        set_nz(k, result);
+    }
+}
+
+// The 2A03's ADC, SBC, compares and BIT, flag for flag as Instructions.
+template <typename Op>
+FCE_AVX2 auto alu(Chunk& k, __m256i m) noexcept -> void
+{
+    if constexpr (any<Op, LDA, LDX, LDY>) {
+        target<Op>(k) = m;
+        set_nz(k, m);
+    } else if constexpr (std::is_same<Op, ORA>::value) {
+        k.a = _mm256_or_si256(k.a, m);
+        set_nz(k, k.a);
+    } else if constexpr (std::is_same<Op, AND>::value) {
+        k.a = _mm256_and_si256(k.a, m);
+        set_nz(k, k.a);
+    } else if constexpr (std::is_same<Op, EOR>::value) {
+        k.a = _mm256_xor_si256(k.a, m);
+        set_nz(k, k.a);
+    } else if constexpr (std::is_same<Op, ADC>::value) {
+        auto const sum = _mm256_add_epi32(_mm256_add_epi32(k.a, m), _mm256_and_si256(k.p, splat(0x01)));
+        auto const result = byte(sum);
+        auto const overflow = _mm256_and_si256(_mm256_xor_si256(k.a, result), _mm256_xor_si256(m, result));
+        flags(k, 0x41, _mm256_or_si256(_mm256_srli_epi32(sum, 8),
+                                       _mm256_srli_epi32(_mm256_and_si256(overflow, splat(0x80)), 1)));
+        k.a = result;
+        set_nz(k, result);
+    } else if constexpr (std::is_same<Op, SBC>::value) {
+        auto const borrow = _mm256_andnot_si256(k.p, splat(0x01));
+        auto const diff = _mm256_sub_epi32(_mm256_sub_epi32(k.a, m), borrow);
+        auto const carry = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), diff), splat(0x01));
+        auto const overflow = _mm256_and_si256(_mm256_xor_si256(k.a, m), splat(0x80));
+        flags(k, 0x41, _mm256_or_si256(carry, _mm256_srli_epi32(overflow, 1)));
+        k.a = byte(diff);
+        set_nz(k, k.a);
+    } else if constexpr (any<Op, CMP, CPX, CPY>) {
+        // C compares as signed bytes
+        auto const src = target<Op>(k);
+        auto const sign = splat(0x80);
+        auto const less = _mm256_cmpgt_epi32(_mm256_sub_epi32(_mm256_xor_si256(m, sign), sign),
+                                             _mm256_sub_epi32(_mm256_xor_si256(src, sign), sign));
+        flags(k, 0x01, _mm256_andnot_si256(less, splat(0x01)));
+        set_nz(k, byte(_mm256_sub_epi32(src, m)));
+    } else {
+        static_assert(std::is_same<Op, BIT>::value, "not a read");
+        auto const result = _mm256_and_si256(k.a, m);
+        auto const z = _mm256_and_si256(_mm256_cmpeq_epi32(result, _mm256_setzero_si256()), splat(0x02));
+        flags(k, 0xC2, _mm256_or_si256(_mm256_and_si256(result, splat(0xC0)), z));
+    }
+}
+
+template <typename Op>
+constexpr auto branch_flag() noexcept -> int
+{
+    if constexpr (any<Op, BPL, BMI>) {
+        return 0x80;
+    } else if constexpr (any<Op, BVC, BVS>) {
+        return 0x40;
+    } else if constexpr (any<Op, BCC, BCS>) {
+        return 0x01;
+    } else {
+        return 0x02;
+    }
+}
+
+// One instruction on the lanes of `k`, after its opcode fetch.
+template <typename Mode, typename Op>
+FCE_AVX2 auto execute(Chunk& k, u16 pc) noexcept -> void
+{
+    k.pc = splat(u16(pc + 1 + operand_size<Mode>));
+
+    if constexpr (reads<Op>) {
+        alu<Op>(k, load<Mode>(k, pc));
+    } else if constexpr (stores<Op>) {
+        store<Mode>(k, pc, target<Op>(k));
+    } else if constexpr (modifies<Op>) {
+        modify<Mode, Op>(k, pc);
+    } else if constexpr (branches<Op>) {
+        // the offset is a signed byte
+        tick(k, 1);
+        auto const next = k.pc;
+        auto const offset = _mm256_sub_epi32(_mm256_xor_si256(row(k, u16(pc + 1)), splat(0x80)), splat(0x80));
+        auto const to = _mm256_and_si256(_mm256_add_epi32(next, offset), splat(0xFFFF));
+        constexpr int bit = branch_flag<Op>();
+        constexpr bool expect = any<Op, BMI, BVS, BCS, BEQ>;
+        auto const taken = _mm256_cmpeq_epi32(_mm256_and_si256(k.p, splat(bit)), splat(expect ? bit : 0));
+        auto const page = _mm256_and_si256(_mm256_xor_si256(next, to), splat(0xFF00));
+        auto const crossed = _mm256_andnot_si256(_mm256_cmpeq_epi32(page, _mm256_setzero_si256()), taken);
+        tick(k, taken);
+        tick(k, crossed);
+        k.pc = _mm256_blendv_epi8(next, to, taken);
+    } else if constexpr (std::is_same<Op, JMP>::value) {
+        tick(k, 2);
+        k.pc = _mm256_or_si256(row(k, u16(pc + 1)), _mm256_slli_epi32(row(k, u16(pc + 2)), 8));
+    } else if constexpr (std::is_same<Op, JSR>::value) {
+        tick(k, 3);
+        auto const to = _mm256_or_si256(row(k, u16(pc + 1)), _mm256_slli_epi32(row(k, u16(pc + 2)), 8));
+        push(k, _mm256_srli_epi32(k.pc, 8));
+        push(k, byte(k.pc));
+        k.pc = to;
+    } else if constexpr (std::is_same<Op, RTS>::value) {
+        tick(k, 3);
+        auto const lo = pull(k);
+        auto const hi = pull(k);
+        k.pc = _mm256_or_si256(lo, _mm256_slli_epi32(hi, 8));
+    } else if constexpr (any<Op, PHA, PHP>) {
+        tick(k, 1);
+        push(k, target<Op>(k));
+    } else if constexpr (any<Op, PLA, PLP>) {
+        tick(k, 1);
+        auto const m = pull(k);
+        tick(k, 1);
+        target<Op>(k) = m;
+        if constexpr (std::is_same<Op, PLA>::value) {
+            set_nz(k, m);
+        }
+    } else if constexpr (any<Op, INX, INY, DEX, DEY>) {
+        tick(k, 1);
+        auto& r = any<Op, INX, DEX> ? k.x : k.y;
+        r = byte(_mm256_add_epi32(r, splat(any<Op, INX, INY> ? 1 : -1)));
+        set_nz(k, r);
+    } else if constexpr (any<Op, TAX, TAY, TSX, TXA, TXS, TYA>) {
+        tick(k, 1);
+        auto const from = any<Op, TAX, TAY> ? k.a : std::is_same<Op, TSX>::value ? k.s : any<Op, TXA, TXS> ? k.x : k.y;
+        if constexpr (std::is_same<Op, TXS>::value) {
+            k.s = from;
+        } else {
+            auto& to = any<Op, TAX, TSX> ? k.x : any<Op, TAY> ? k.y : k.a;
+            to = from;
+            set_nz(k, from);
+        }
+    } else if constexpr (any<Op, CLC, SEC, CLI, SEI, CLV, CLD, SED>) {
+        tick(k, 1);
+        constexpr int bit = any<Op, CLC, SEC> ? 0x01 : any<Op, CLI, SEI> ? 0x04 : any<Op, CLV> ? 0x40 : 0x08;
+        flags(k, bit, splat(any<Op, SEC, SEI, SED> ? bit : 0));
+    } else {
+        static_assert(std::is_same<Op, NOP>::value, "not vectorized");
+        tick(k, 1);
+    }
+}
+
+// Registers are loaded for all eight lanes of a chunk, and those written
+// are stored back blended, so the lanes off keep theirs.
+template <typename Mode, typename Op>
+__attribute__((target("avx2"))) auto kernel(LockstepLanes const& lanes, u8 const *on, u16 pc) noexcept -> void
+{
+    for (std::size_t c = 0; c < lanes.lanes; c += 8) {
+        auto const mask = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(on + c)));
+        if (_mm256_testz_si256(mask, mask)) {
+            continue;
+        }
+
+        Chunk const before = {
+            widen(lanes.a + c), widen(lanes.x + c), widen(lanes.y + c), widen(lanes.s + c), widen(lanes.p + c),
+            widen(lanes.pc + c), splat(1), mask, lanes.ram + c, lanes.lanes,
+        };
+        auto k = before;
+        execute<Mode, Op>(k, pc);
+
+        if constexpr (writes_a<Mode, Op>) {
+            narrow(lanes.a + c, _mm256_blendv_epi8(before.a, k.a, mask));
+        }
+        if constexpr (writes_x<Op>) {
+            narrow(lanes.x + c, _mm256_blendv_epi8(before.x, k.x, mask));
+        }
+        if constexpr (writes_y<Op>) {
+            narrow(lanes.y + c, _mm256_blendv_epi8(before.y, k.y, mask));
+        }
+        if constexpr (writes_s<Op>) {
+            narrow(lanes.s + c, _mm256_blendv_epi8(before.s, k.s, mask));
+        }
+        if constexpr (writes_p<Op>) {
+            narrow(lanes.p + c, _mm256_blendv_epi8(before.p, k.p, mask));
+        }
+        narrow(lanes.pc + c, _mm256_blendv_epi8(before.pc, k.pc, mask));
+
+        auto const cycles = reinterpret_cast<__m256i *>(lanes.cycles + c);
+        auto const spent = _mm256_and_si256(k.cycles, mask);
+        _mm256_storeu_si256(cycles, _mm256_add_epi64(_mm256_loadu_si256(cycles),
+                                                     _mm256_cvtepu32_epi64(_mm256_castsi256_si128(spent))));
+        _mm256_storeu_si256(cycles + 1, _mm256_add_epi64(_mm256_loadu_si256(cycles + 1),
+                                                         _mm256_cvtepu32_epi64(_mm256_extracti128_si256(spent, 1))));
+    }
+}
+
+template <typename Mode, typename Op>
+constexpr auto kernel_of() noexcept -> LockstepKernel
+{
+    if constexpr (vectorized<Mode, Op>) {
+        return &kernel<Mode, Op>;
+    } else {
+        return nullptr;
+    }
+}
+
+__attribute__((target("avx2"))) auto group_lanes(LockstepLanes const& lanes, u64 active, u16 pc, u8 opcode,
+                                                  u8 *on) noexcept -> u64
+{
+    auto const row = lanes.ram + std::size_t{pc} * lanes.lanes;
+    auto const bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    u64 group = 0;
+    for (std::size_t c = 0; c < lanes.lanes; c += 8) {
+        auto const at = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(lanes.pc + c)),
+                                        _mm_set1_epi16(short(pc)));
+        auto const same = _mm_cmpeq_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(row + c)),
+                                         _mm_set1_epi8(char(opcode)));
+        auto const in = _mm_cmpeq_epi8(_mm_and_si128(_mm_set1_epi8(char(active >> c)), bits), bits);
+        auto const mask = _mm_and_si128(_mm_and_si128(_mm_packs_epi16(at, at), same), in);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(on + c), mask);
+        group |= u64(_mm_movemask_epi8(mask) & 0xFF) << c;
+    }
+    return group;
+}
+
+// Clocks stay below 2^63, so signed compares do.
+__attribute__((target("avx2"))) auto running_lanes(LockstepLanes const& lanes, u64 const *end) noexcept -> u64
+{
+    u64 running = 0;
+    for (std::size_t c = 0; c < lanes.lanes; c += 4) {
+        auto const below = _mm256_cmpgt_epi64(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(end + c)),
+                                              _mm256_loadu_si256(reinterpret_cast<__m256i const *>(lanes.cycles + c)));
+        running |= u64(_mm256_movemask_pd(_mm256_castsi256_pd(below))) << c;
+    }
+    return running;
+}
+
+constexpr LockstepKernels avx2 = {
+    {{
+#define FCE_KERNEL(opcode, mode, operation) kernel_of<modes::mode, ops::operation>(),
+        FCE_OPCODES(FCE_KERNEL)
+#undef FCE_KERNEL
+    }},
+    &group_lanes,
+    &running_lanes,
+};
+
+#undef FCE_AVX2
+
+#endif
+
+}  // namespace
+
+auto fce::lockstep_kernels(Simd simd) noexcept -> LockstepKernels const&
+{
+#if defined(FCE_LOCKSTEP_SIMD)
+    if (simd == Simd::avx2) {
+        return avx2;
+    }
+#else
+    (void)simd;
+#endif
+    return none;
+}
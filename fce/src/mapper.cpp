@@ -0,0 +1,387 @@
+#include "fce/mapper.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using Mapper = fce::Mapper;
+
+namespace {
+
+using fce::u8;
+using fce::u16;
+using fce::u64;
+using fce::Mirroring;
+using fce::Rom;
+
+class Mmc1 final : public Mapper
+{
+public:
+    explicit Mmc1(Rom const& rom)
+        : Mapper{rom}
+    {
+        this->update();
+    }
+
+protected:
+    // Registers are written a bit at a time, from bit 0 of five writes; a
+    // write with bit 7 set starts over.
+    auto write_register(u16 addr, u8 v) noexcept -> void override
+    {
+        if (v & 0x80) {
+            shift_ = 0;
+            count_ = 0;
+            control_ |= 0x0C;
+            this->update();
+            return;
+        }
+        shift_ = u8(shift_ | (v & 1) << count_);
+        if (++count_ < 5) {
+            return;
+        }
+        switch (addr >> 13 & 3) {
+        case 0: control_ = shift_; break;
+        case 1: chr0_ = shift_; break;
+        case 2: chr1_ = shift_; break;
+        default: prg_ = shift_; break;
+        }
+        shift_ = 0;
+        count_ = 0;
+        this->update();
+    }
+
+private:
+    u8 shift_ = 0;
+    u8 count_ = 0;
+    u8 control_ = 0x0C;
+    u8 chr0_ = 0;
+    u8 chr1_ = 0;
+    u8 prg_ = 0;
+
+    auto update() noexcept -> void
+    {
+        static constexpr Mirroring mirrorings[] = {
+            Mirroring::single_lower, Mirroring::single_upper, Mirroring::vertical, Mirroring::horizontal,
+        };
+        mirroring_ = mirrorings[control_ & 3];
+
+        // 512 KiB boards pick the 256 KiB half with bit 4 of the CHR bank
+        auto const large = rom_.prg().size > 0x40000;
+        auto const outer = large ? std::size_t(chr0_ & 0x10) : 0;
+        auto const bank = outer | (prg_ & 0x0F);
+        auto const last = large ? outer | 0x0F : this->prg_banks(0x4000) - 1;
+        switch (control_ >> 2 & 3) {
+        case 0:
+        case 1:
+            this->map_prg(0x8000, 0x8000, bank >> 1);
+            break;
+        case 2:
+            this->map_prg(0x8000, 0x4000, outer);
+            this->map_prg(0xC000, 0x4000, bank);
+            break;
+        default:
+            this->map_prg(0x8000, 0x4000, bank);
+            this->map_prg(0xC000, 0x4000, last);
+            break;
+        }
+
+        if (control_ & 0x10) {
+            this->map_chr(0x0000, 0x1000, chr0_);
+            this->map_chr(0x1000, 0x1000, chr1_);
+        } else {
+            this->map_chr(0x0000, 0x2000, chr0_ >> 1);
+        }
+    }
+};
+
+class Uxrom final : public Mapper
+{
+public:
+    explicit Uxrom(Rom const& rom)
+        : Mapper{rom}
+    {
+        this->map_prg(0x8000, 0x4000, 0);
+        this->map_prg(0xC000, 0x4000, this->prg_banks(0x4000) - 1);
+    }
+
+protected:
+    auto write_register(u16, u8 v) noexcept -> void override
+    {
+        this->map_prg(0x8000, 0x4000, v);
+    }
+};
+
+class Cnrom final : public Mapper
+{
+public:
+    using Mapper::Mapper;
+
+protected:
+    auto write_register(u16, u8 v) noexcept -> void override
+    {
+        this->map_chr(0x0000, 0x2000, v);
+    }
+};
+
+// The scanline counter is clocked by the PPU and only looked at when a
+// register is written or when the IRQ it predicts is due.
+class Mmc3 final : public Mapper, public fce::Component
+{
+public:
+    explicit Mmc3(Rom const& rom)
+        : Mapper{rom}
+    {
+        this->update_prg();
+        this->update_chr();
+    }
+
+    auto attach(fce::Scheduler& scheduler, Clock clock, IrqLine irq) -> void override
+    {
+        scheduler_ = &scheduler;
+        clock_ = std::move(clock);
+        irq_ = std::move(irq);
+        scheduler.on(fce::Event::irq, [this](u64 timestamp) {
+            this->catch_up(timestamp + 1);
+            this->reschedule();
+        });
+        this->reschedule();
+    }
+
+    auto frame(u64 first, unsigned lines) -> void override
+    {
+        this->sync();
+        first_ = first;
+        lines_ = lines;
+        next_ = 0;
+        this->reschedule();
+    }
+
+protected:
+    auto write_register(u16 addr, u8 v) noexcept -> void override
+    {
+        switch (addr & 0xE001) {
+        case 0x8000: {
+            auto const changed = select_ ^ v;
+            select_ = v;
+            if (changed & 0x40) {
+                this->update_prg();
+            }
+            if (changed & 0x80) {
+                this->update_chr();
+            }
+            break;
+        }
+        case 0x8001:
+            registers_[select_ & 7] = v;
+            if ((select_ & 7) < 6) {
+                this->update_chr();
+            } else {
+                this->update_prg();
+            }
+            break;
+        case 0xA000:
+            if (rom_.mirroring() != Mirroring::four_screen) {
+                mirroring_ = v & 1 ? Mirroring::horizontal : Mirroring::vertical;
+            }
+            break;
+        case 0xC000:
+            this->sync();
+            latch_ = v;
+            this->reschedule();
+            break;
+        case 0xC001:
+            this->sync();
+            counter_ = 0;
+            reload_ = true;
+            this->reschedule();
+            break;
+        case 0xE000:
+            this->sync();
+            enabled_ = false;
+            this->line(false);
+            this->reschedule();
+            break;
+        case 0xE001:
+            this->sync();
+            enabled_ = true;
+            this->reschedule();
+            break;
+        default:
+            break;  // PRG RAM protection is not emulated
+        }
+    }
+
+    // Applies the clocks due before `to`.
+    auto advance(u64, u64 to) -> void override
+    {
+        for (; next_ < lines_ && this->clock_time(next_) < to; next_++) {
+            if (counter_ == 0 || reload_) {
+                counter_ = latch_;
+                reload_ = false;
+            } else {
+                counter_--;
+            }
+            if (counter_ == 0 && enabled_) {
+                this->line(true);
+            }
+        }
+    }
+
+private:
+    u8 select_ = 0;
+    std::array<u8, 8> registers_ = {0, 2, 4, 5, 6, 7, 0, 1};
+
+    u8 latch_ = 0;
+    u8 counter_ = 0;
+    bool reload_ = false;
+    bool enabled_ = false;
+    bool asserted_ = false;
+
+    // the clocks of the current frame, see Mapper::frame()
+    u64 first_ = 0;
+    unsigned lines_ = 0;
+    unsigned next_ = 0;
+
+    fce::Scheduler *scheduler_ = nullptr;
+    Clock clock_;
+    IrqLine irq_;
+
+    // The CPU cycle clock `i` of the frame falls in.
+    auto clock_time(unsigned i) const noexcept -> u64
+    {
+        return (first_ + u64{i} * dots_per_line) / 3;
+    }
+
+    auto sync() -> void
+    {
+        if (clock_) {
+            this->catch_up(clock_());
+        }
+    }
+
+    auto line(bool asserted) -> void
+    {
+        if (asserted != asserted_) {
+            asserted_ = asserted;
+            if (irq_) {
+                irq_(asserted);
+            }
+        }
+    }
+
+    // Schedules the clock at which the counter next reaches 0, if that
+    // raises an IRQ within the frame.
+    auto reschedule() -> void
+    {
+        if (!scheduler_) {
+            return;
+        }
+        // clocks after the next one until the counter is 0
+        auto const ahead = counter_ == 0 || reload_ ? unsigned(latch_) : unsigned(counter_) - 1;
+        if (enabled_ && next_ + ahead < lines_) {
+            scheduler_->schedule(fce::Event::irq, this->clock_time(next_ + ahead));
+        } else {
+            scheduler_->cancel(fce::Event::irq);
+        }
+    }
+
+    auto update_prg() noexcept -> void
+    {
+        auto const banks = this->prg_banks(0x2000);
+        auto const second_last = banks >= 2 ? banks - 2 : 0;
+        auto const swap = (select_ & 0x40) != 0;
+        this->map_prg(0x8000, 0x2000, swap ? second_last : registers_[6]);
+        this->map_prg(0xA000, 0x2000, registers_[7]);
+        this->map_prg(0xC000, 0x2000, swap ? registers_[6] : second_last);
+        this->map_prg(0xE000, 0x2000, banks - 1);
+    }
+
+    auto update_chr() noexcept -> void
+    {
+        auto const invert = u16(select_ & 0x80 ? 0x1000 : 0x0000);
+        this->map_chr(0x0000 ^ invert, 0x800, registers_[0] >> 1);
+        this->map_chr(0x0800 ^ invert, 0x800, registers_[1] >> 1);
+        for (unsigned i = 0; i < 4; i++) {
+            this->map_chr(u16((0x1000 + 0x400 * i) ^ invert), 0x400, registers_[2 + i]);
+        }
+    }
+};
+
+}  // namespace
+
+Mapper::Mapper(Rom const& rom)
+    : rom_{rom}, mirroring_{rom.mirroring()}
+{
+    if (rom.chr().empty()) {
+        chr_ram_.resize(std::max(rom.chr_ram_size(), std::size_t{0x2000}));
+    }
+    this->map_prg(0x8000, 0x8000, 0);
+    this->map_chr(0x0000, 0x2000, 0);
+}
+
+auto Mapper::set(u16 addr, u8 v) noexcept -> void
+{
+    if (addr >= 0x8000) {
+        this->write_register(addr, v);
+    } else {
+        Memory::set(addr, v);
+    }
+}
+
+auto Mapper::attach(Scheduler&, Clock, IrqLine) -> void
+{
+}
+
+auto Mapper::frame(u64, unsigned) -> void
+{
+}
+
+auto Mapper::write_register(u16, u8) noexcept -> void
+{
+}
+
+auto Mapper::map_prg(u16 addr, std::size_t size, std::size_t bank) noexcept -> void
+{
+    auto const span = rom_.prg_bank(bank, size);
+    auto const first = u8(addr >> 8);
+    auto const last = u8((addr + size - 1) >> 8);
+    if (this->map(first, last, span.data, span.size) && remap_) {
+        remap_(first, last);
+    }
+}
+
+auto Mapper::map_chr(u16 addr, std::size_t size, std::size_t bank) noexcept -> void
+{
+    auto span = rom_.chr_bank(bank, size);
+    u8 *ram = nullptr;
+    if (!chr_ram_.empty()) {
+        auto const count = std::max(chr_ram_.size() / size, std::size_t{1});
+        ram = chr_ram_.data() + bank % count * std::min(size, chr_ram_.size());
+        span = fce::ByteSpan{ram, std::min(size, chr_ram_.size())};
+    }
+
+    auto const first = std::size_t{addr} >> 10;
+    auto const last = (addr + size - 1) >> 10;
+    for (auto window = first; window <= last; window++) {
+        auto const offset = ((window - first) << 10) % span.size;
+        chr_read_[window] = span.data + offset;
+        chr_write_[window] = ram ? ram + offset : nullptr;
+    }
+}
+
+auto Mapper::prg_banks(std::size_t size) const noexcept -> std::size_t
+{
+    return std::max(rom_.prg().size / size, std::size_t{1});
+}
+
+auto fce::make_mapper(Rom const& rom) -> std::shared_ptr<Mapper>
+{
+    switch (rom.mapper()) {
+    case 0: return std::make_shared<Mapper>(rom);
+    case 1: return std::make_shared<Mmc1>(rom);
+    case 2: return std::make_shared<Uxrom>(rom);
+    case 3: return std::make_shared<Cnrom>(rom);
+    case 4: return std::make_shared<Mmc3>(rom);
+    default: throw std::runtime_error("unsupported mapper " + std::to_string(rom.mapper()));
+    }
+}
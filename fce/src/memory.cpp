@@ -1,16 +1,45 @@
 #include "fce/memory.hpp"
+#include <cassert>
 #include <spdlog/spdlog.h>
 
 using Memory = fce::Memory;
 
 auto Memory::get(u16 addr) const noexcept -> u8
 {
-    // TODO: memory mapping
+    if (auto const data = pages_[addr >> 8]) {
+        return data[addr & 0xFF];
+    }
     return cells_[addr];
 }
 
 auto Memory::set(u16 addr, u8 v) noexcept -> void
 {
-    // TODO: memory mapping
     cells_[addr] = v;
+    dirty_[addr >> 14] |= u64{1} << (addr >> 8 & 63);
+}
+
+auto Memory::stable(u16 addr) const noexcept -> bool
+{
+    // mapped pages are ROM, the cells may be registers of a subclass
+    return pages_[addr >> 8] != nullptr;
+}
+
+auto Memory::map(u8 first, u8 last, u8 const *data, std::size_t size) noexcept -> bool
+{
+    assert(size != 0 && size % 0x100 == 0);
+
+    bool moved = false;
+    for (unsigned page = first; page <= last; page++) {
+        auto const at = data + (std::size_t(page - first) << 8) % size;
+        moved = moved || pages_[page] != at;
+        pages_[page] = at;
+    }
+    return moved;
+}
+
+auto Memory::unmap(u8 first, u8 last) noexcept -> void
+{
+    for (unsigned page = first; page <= last; page++) {
+        pages_[page] = nullptr;
+    }
 }
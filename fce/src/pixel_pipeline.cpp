@@ -0,0 +1,178 @@
+#include "fce/pixel_pipeline.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FCE_PIXEL_SIMD 1
+#include <immintrin.h>
+#endif
+
+using PixelLine = fce::PixelLine;
+using PixelPipeline = fce::PixelPipeline;
+
+namespace {
+
+using fce::u8;
+using fce::u32;
+
+constexpr auto width = PixelPipeline::width;
+
+constexpr auto rgba(u32 r, u32 g, u32 b) noexcept -> u32
+{
+    return r | g << 8 | b << 16 | u32{0xFF} << 24;
+}
+
+auto compose_scalar(PixelLine const& line, u8 const *palette, u8 grey, u8 *out) noexcept -> bool
+{
+    auto hit = false;
+    for (std::size_t x = 0; x < width; x++) {
+        auto const b = line.background[x];
+        auto const s = line.sprite[x];
+        if (s && b && line.zero[x] && x != width - 1) {
+            hit = true;
+        }
+        auto const index = s && (!b || !line.behind[x]) ? s : b;
+        out[x] = palette[index] & grey;
+    }
+    return hit;
+}
+
+auto lookup_scalar(u8 const *indices, u32 const *colours, u32 *out) noexcept -> void
+{
+    for (std::size_t x = 0; x < width; x++) {
+        out[x] = colours[indices[x]];
+    }
+}
+
+#if defined(FCE_PIXEL_SIMD)
+
+// 16 pixels at a time. Palettes are looked up with two byte shuffles, one
+// per half of the 32 entries.
+__attribute__((target("sse4.1"))) auto compose_sse41(PixelLine const& line, u8 const *palette, u8 grey,
+                                                     u8 *out) noexcept -> bool
+{
+    auto const zero = _mm_setzero_si128();
+    auto const low = _mm_loadu_si128(reinterpret_cast<__m128i const *>(palette));
+    auto const high = _mm_loadu_si128(reinterpret_cast<__m128i const *>(palette + 16));
+    auto const fifteen = _mm_set1_epi8(15);
+    auto const mask = _mm_set1_epi8(char(grey));
+
+    unsigned hits = 0;
+    for (std::size_t x = 0; x < width; x += 16) {
+        auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(line.background + x));
+        auto const s = _mm_loadu_si128(reinterpret_cast<__m128i const *>(line.sprite + x));
+        auto const front = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(line.behind + x)), zero);
+        auto const other = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(line.zero + x)), zero);
+        auto const clear_b = _mm_cmpeq_epi8(b, zero);
+        auto const clear_s = _mm_cmpeq_epi8(s, zero);
+
+        auto const hit = _mm_or_si128(_mm_or_si128(clear_b, clear_s), other);
+        hits |= ~unsigned(_mm_movemask_epi8(hit)) & (x + 16 == width ? 0x7FFF : 0xFFFF);
+
+        auto const sprite = _mm_andnot_si128(clear_s, _mm_or_si128(clear_b, front));
+        auto const index = _mm_blendv_epi8(b, s, sprite);
+        auto const colour = _mm_blendv_epi8(_mm_shuffle_epi8(low, index), _mm_shuffle_epi8(high, index),
+                                            _mm_cmpgt_epi8(index, fifteen));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_and_si128(colour, mask));
+    }
+    return hits != 0;
+}
+
+// As compose_sse41(), 32 pixels at a time. Shuffles stay within 128-bit
+// lanes, so the palette halves are repeated in both.
+__attribute__((target("avx2"))) auto compose_avx2(PixelLine const& line, u8 const *palette, u8 grey,
+                                                  u8 *out) noexcept -> bool
+{
+    auto const zero = _mm256_setzero_si256();
+    auto const low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(palette)));
+    auto const high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(palette + 16)));
+    auto const fifteen = _mm256_set1_epi8(15);
+    auto const mask = _mm256_set1_epi8(char(grey));
+
+    u32 hits = 0;
+    for (std::size_t x = 0; x < width; x += 32) {
+        auto const b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(line.background + x));
+        auto const s = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(line.sprite + x));
+        auto const front =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(line.behind + x)), zero);
+        auto const other =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(line.zero + x)), zero);
+        auto const clear_b = _mm256_cmpeq_epi8(b, zero);
+        auto const clear_s = _mm256_cmpeq_epi8(s, zero);
+
+        auto const hit = _mm256_or_si256(_mm256_or_si256(clear_b, clear_s), other);
+        hits |= ~u32(_mm256_movemask_epi8(hit)) & (x + 32 == width ? 0x7FFFFFFF : 0xFFFFFFFF);
+
+        auto const sprite = _mm256_andnot_si256(clear_s, _mm256_or_si256(clear_b, front));
+        auto const index = _mm256_blendv_epi8(b, s, sprite);
+        auto const colour = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, index), _mm256_shuffle_epi8(high, index),
+                                               _mm256_cmpgt_epi8(index, fifteen));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_and_si256(colour, mask));
+    }
+    return hits != 0;
+}
+
+// 8 pixels a gather. Without AVX2, the scalar loop is as good as shuffling
+// 64 entries of 4 bytes.
+__attribute__((target("avx2"))) auto lookup_avx2(u8 const *indices, u32 const *colours, u32 *out) noexcept -> void
+{
+    auto const table = reinterpret_cast<int const *>(colours);
+    for (std::size_t x = 0; x < width; x += 8) {
+        auto const index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(indices + x)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_i32gather_epi32(table, index, 4));
+    }
+}
+
+#endif
+
+}  // namespace
+
+std::array<fce::u32, 64> const fce::nes_colours = {
+    rgba(0x74, 0x74, 0x74), rgba(0x24, 0x18, 0x8C), rgba(0x00, 0x00, 0xA8), rgba(0x44, 0x00, 0x9C),
+    rgba(0x8C, 0x00, 0x74), rgba(0xA8, 0x00, 0x10), rgba(0xA4, 0x00, 0x00), rgba(0x7C, 0x08, 0x00),
+    rgba(0x40, 0x2C, 0x00), rgba(0x00, 0x44, 0x00), rgba(0x00, 0x50, 0x00), rgba(0x00, 0x3C, 0x14),
+    rgba(0x18, 0x3C, 0x5C), rgba(0x00, 0x00, 0x00), rgba(0x00, 0x00, 0x00), rgba(0x00, 0x00, 0x00),
+    rgba(0xBC, 0xBC, 0xBC), rgba(0x00, 0x70, 0xEC), rgba(0x20, 0x38, 0xEC), rgba(0x80, 0x00, 0xF0),
+    rgba(0xBC, 0x00, 0xBC), rgba(0xE4, 0x00, 0x58), rgba(0xD8, 0x28, 0x00), rgba(0xC8, 0x4C, 0x0C),
+    rgba(0x88, 0x70, 0x00), rgba(0x00, 0x94, 0x00), rgba(0x00, 0xA8, 0x00), rgba(0x00, 0x90, 0x38),
+    rgba(0x00, 0x80, 0x88), rgba(0x00, 0x00, 0x00), rgba(0x00, 0x00, 0x00), rgba(0x00, 0x00, 0x00),
+    rgba(0xFC, 0xFC, 0xFC), rgba(0x3C, 0xBC, 0xFC), rgba(0x5C, 0x94, 0xFC), rgba(0xCC, 0x88, 0xFC),
+    rgba(0xF4, 0x78, 0xFC), rgba(0xFC, 0x74, 0xB4), rgba(0xFC, 0x74, 0x60), rgba(0xFC, 0x98, 0x38),
+    rgba(0xF0, 0xBC, 0x3C), rgba(0x80, 0xD0, 0x10), rgba(0x4C, 0xDC, 0x48), rgba(0x58, 0xF8, 0x98),
+    rgba(0x00, 0xE8, 0xD8), rgba(0x78, 0x78, 0x78), rgba(0x00, 0x00, 0x00), rgba(0x00, 0x00, 0x00),
+    rgba(0xFC, 0xFC, 0xFC), rgba(0xA8, 0xE4, 0xFC), rgba(0xC4, 0xD4, 0xFC), rgba(0xD4, 0xC8, 0xFC),
+    rgba(0xFC, 0xC4, 0xFC), rgba(0xFC, 0xC4, 0xD8), rgba(0xFC, 0xBC, 0xB0), rgba(0xFC, 0xD8, 0xA8),
+    rgba(0xFC, 0xE4, 0xA0), rgba(0xE0, 0xFC, 0xA0), rgba(0xA8, 0xF0, 0xBC), rgba(0xB0, 0xFC, 0xCC),
+    rgba(0x9C, 0xFC, 0xF0), rgba(0xC4, 0xC4, 0xC4), rgba(0x00, 0x00, 0x00), rgba(0x00, 0x00, 0x00),
+};
+
+auto fce::detect_simd() noexcept -> Simd
+{
+#if defined(FCE_PIXEL_SIMD)
+    if (__builtin_cpu_supports("avx2")) {
+        return Simd::avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Simd::sse41;
+    }
+#endif
+    return Simd::none;
+}
+
+PixelPipeline::PixelPipeline(Simd simd) noexcept
+    : simd_{simd}, compose_{compose_scalar}, lookup_{lookup_scalar}
+{
+#if defined(FCE_PIXEL_SIMD)
+    switch (simd) {
+    case Simd::avx2:
+        compose_ = compose_avx2;
+        lookup_ = lookup_avx2;
+        break;
+    case Simd::sse41:
+        compose_ = compose_sse41;
+        break;
+    case Simd::none:
+        break;
+    }
+#else
+    simd_ = Simd::none;
+#endif
+}
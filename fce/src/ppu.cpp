@@ -0,0 +1,393 @@
+#include "fce/ppu.hpp"
+#include <algorithm>
+#include <cstring>
+
+using PixelLine = fce::PixelLine;
+using Ppu = fce::Ppu;
+
+namespace {
+
+using fce::u8;
+using fce::u16;
+using fce::u32;
+using fce::u64;
+
+constexpr unsigned vblank_line = 241;
+constexpr unsigned prerender_line = 261;
+
+// The dot of a line at which MMC3 style counters are clocked.
+constexpr u64 counter_dot = 260;
+
+// Bytes of `pixels` that aren't 0 with `bits` ORed in, for 8 at a time.
+auto colour(u64 pixels, u8 bits) noexcept -> u64
+{
+    auto const opaque = (pixels | pixels >> 1) & 0x0101010101010101;
+    return pixels | opaque * bits;
+}
+
+}  // namespace
+
+Ppu::Ppu(std::shared_ptr<Mapper> mapper)
+    : mapper_{std::move(mapper)}, pixels_(std::size_t{width} * height)
+{
+}
+
+auto Ppu::get(u16 addr) const noexcept -> u8
+{
+    // reads of most registers have side effects
+    return const_cast<Ppu&>(*this).read(addr);
+}
+
+auto Ppu::stable(u16 addr) const noexcept -> bool
+{
+    return (addr & 7) == 2 && !w_ && (status_ & 0xE0) == 0 && (latch_ & 0xE0) == 0 && !this->rendering();
+}
+
+auto Ppu::set(u16 addr, u8 v) noexcept -> void
+{
+    this->write(addr, v);
+}
+
+auto Ppu::output(u32 *rgba, std::size_t pitch, u32 const *colours) noexcept -> void
+{
+    rgba_ = rgba;
+    pitch_ = pitch;
+    colours_ = colours;
+}
+
+auto Ppu::oam_dma(u8 const *page) noexcept -> void
+{
+    for (unsigned i = 0; i < 0x100; i++) {
+        oam_[u8(oam_addr_ + i)] = page[i];
+    }
+}
+
+auto Ppu::attach(Scheduler& scheduler, Clock clock, Nmi nmi) -> void
+{
+    scheduler_ = &scheduler;
+    clock_ = std::move(clock);
+    nmi_ = std::move(nmi);
+    scheduler.on(Event::ppu_scanline, [this](u64 timestamp) {
+        this->catch_up(timestamp + 1);
+        this->schedule_vblank();
+    });
+    this->schedule_vblank();
+}
+
+auto Ppu::advance(u64, u64 to) -> void
+{
+    auto const end = to * 3;
+    while (line_dot_ < end) {
+        auto const line = line_;
+        line_ = (line_ + 1) % lines;
+        this->enter(line);
+        line_dot_ += Mapper::dots_per_line;
+    }
+}
+
+auto Ppu::read(u16 addr) noexcept -> u8
+{
+    this->sync();
+    switch (addr & 7) {
+    case 2:
+        latch_ = u8((status_ & 0xE0) | (latch_ & 0x1F));
+        status_ &= 0x7F;
+        w_ = false;
+        break;
+    case 4:
+        latch_ = oam_[oam_addr_];
+        break;
+    case 7: {
+        auto const at = u16(v_ & 0x3FFF);
+        if (at >= 0x3F00) {
+            latch_ = u8((latch_ & 0xC0) | palette_[palette_index(at)]);
+            buffer_ = this->vram_get(u16(at - 0x1000));
+        } else {
+            latch_ = buffer_;
+            buffer_ = this->vram_get(at);
+        }
+        v_ = u16(v_ + (ctrl_ & 0x04 ? 32 : 1));
+        break;
+    }
+    default:
+        break;
+    }
+    return latch_;
+}
+
+auto Ppu::write(u16 addr, u8 v) noexcept -> void
+{
+    this->sync();
+    latch_ = v;
+    switch (addr & 7) {
+    case 0: {
+        auto const enabled = ~ctrl_ & v & 0x80;
+        ctrl_ = v;
+        t_ = u16((t_ & ~0x0C00) | (v & 3) << 10);
+        if (enabled && (status_ & 0x80) && nmi_) {
+            nmi_();
+        }
+        break;
+    }
+    case 1: {
+        auto const was = this->rendering();
+        mask_ = v;
+        if (was != this->rendering() && line_ < vblank_line) {
+            // counters are clocked on the lines left, or no more
+            auto const left = this->rendering() ? height - line_ : 0;
+            mapper_->frame(line_dot_ + counter_dot, left);
+        }
+        break;
+    }
+    case 3:
+        oam_addr_ = v;
+        break;
+    case 4:
+        oam_[oam_addr_++] = v;
+        break;
+    case 5:
+        if (!w_) {
+            t_ = u16((t_ & ~0x001F) | v >> 3);
+            x_ = v & 7;
+        } else {
+            t_ = u16((t_ & ~0x73E0) | (v & 7) << 12 | (v & 0xF8) << 2);
+        }
+        w_ = !w_;
+        break;
+    case 6:
+        if (!w_) {
+            t_ = u16((t_ & 0x00FF) | (v & 0x3F) << 8);
+        } else {
+            t_ = u16((t_ & 0xFF00) | v);
+            v_ = t_;
+        }
+        w_ = !w_;
+        break;
+    case 7:
+        this->vram_set(u16(v_ & 0x3FFF), v);
+        v_ = u16(v_ + (ctrl_ & 0x04 ? 32 : 1));
+        break;
+    default:
+        break;
+    }
+}
+
+auto Ppu::sync() noexcept -> void
+{
+    if (clock_) {
+        this->catch_up(clock_());
+    }
+}
+
+auto Ppu::vram_get(u16 addr) const noexcept -> u8
+{
+    if (addr < 0x2000) {
+        return mapper_->chr_get(addr);
+    }
+    if (addr < 0x3F00) {
+        return vram_[this->nametable(addr)];
+    }
+    return palette_[palette_index(addr)];
+}
+
+auto Ppu::vram_set(u16 addr, u8 v) noexcept -> void
+{
+    if (addr < 0x2000) {
+        mapper_->chr_set(addr, v);
+        tiles_.invalidate(addr);
+    } else if (addr < 0x3F00) {
+        vram_[this->nametable(addr)] = v;
+    } else {
+        palette_[palette_index(addr)] = v & 0x3F;
+    }
+}
+
+auto Ppu::nametable(u16 addr) const noexcept -> std::size_t
+{
+    static constexpr u8 tables[][4] = {
+        {0, 0, 1, 1},  // horizontal
+        {0, 1, 0, 1},  // vertical
+        {0, 1, 2, 3},  // four screen
+        {0, 0, 0, 0},  // single lower
+        {1, 1, 1, 1},  // single upper
+    };
+    auto const table = tables[std::size_t(mapper_->mirroring())][addr >> 10 & 3];
+    return std::size_t{table} << 10 | (addr & 0x3FF);
+}
+
+auto Ppu::palette_index(u16 addr) noexcept -> std::size_t
+{
+    // the backdrop entries of the sprite palettes are those of the background
+    auto const index = std::size_t{addr} & 0x1F;
+    return (index & 0x13) == 0x10 ? index & 0x0F : index;
+}
+
+auto Ppu::enter(unsigned line) -> void
+{
+    if (line < height) {
+        this->draw(line);
+    } else if (line == vblank_line) {
+        status_ |= 0x80;
+        frames_++;
+        if (on_frame_) {
+            on_frame_(pixels_.data());
+        }
+        if ((ctrl_ & 0x80) && nmi_) {
+            nmi_();
+        }
+    } else if (line == prerender_line) {
+        status_ &= 0x1F;
+        if (this->rendering()) {
+            v_ = t_;
+            // the pre-render line and the visible ones
+            mapper_->frame(line_dot_ + counter_dot, height + 1);
+        } else {
+            mapper_->frame(0, 0);
+        }
+    }
+}
+
+auto Ppu::draw(unsigned line) noexcept -> void
+{
+    auto const out = &pixels_[std::size_t{line} * width];
+    if (!this->rendering()) {
+        std::fill_n(out, width, palette_[0]);
+    } else {
+        this->compose(line, out);
+    }
+    if (rgba_) {
+        pipeline_.lookup(out, colours_, rgba_ + line * pitch_);
+    }
+}
+
+auto Ppu::compose(unsigned line, u8 *out) noexcept -> void
+{
+    tiles_.sync(*mapper_);
+
+    auto const background = &background_[x_];
+    if (mask_ & 0x08) {
+        this->fetch_background();
+        if (!(mask_ & 0x02)) {
+            std::fill_n(background, 8, 0);
+        }
+    } else {
+        background_.fill(0);
+    }
+    sprite_.fill(0);
+    if (mask_ & 0x10) {
+        this->fetch_sprites(line);
+        if (!(mask_ & 0x04)) {
+            std::fill_n(sprite_.begin(), 8, 0);
+        }
+    }
+
+    auto const grey = u8(mask_ & 0x01 ? 0x30 : 0x3F);
+    PixelLine const pixels{background, sprite_.data(), behind_.data(), zero_.data()};
+    if (pipeline_.compose(pixels, palette_.data(), grey, out)) {
+        status_ |= 0x40;
+    }
+
+    this->increment_y();
+    v_ = u16((v_ & ~0x041F) | (t_ & 0x041F));
+}
+
+auto Ppu::fetch_background() noexcept -> void
+{
+    auto const table = u16(ctrl_ & 0x10 ? 0x100 : 0x000);
+    auto const fine_y = unsigned(v_ >> 12 & 7);
+    auto v = v_;
+    for (std::size_t i = 0; i < 33; i++) {
+        auto const tile = vram_[this->nametable(u16(0x2000 | (v & 0x0FFF)))];
+        auto const attribute = vram_[this->nametable(u16(0x23C0 | (v & 0x0C00) | (v >> 4 & 0x38) | (v >> 2 & 0x07)))];
+        auto const shift = (v >> 4 & 4) | (v & 2);
+        auto const palette = u8((attribute >> shift & 3) << 2);
+
+        u64 pixels;
+        std::memcpy(&pixels, tiles_.row(u16(table + tile), fine_y), 8);
+        pixels = colour(pixels, palette);
+        std::memcpy(&background_[i * 8], &pixels, 8);
+
+        if ((v & 0x1F) == 31) {
+            v = u16((v & ~0x001F) ^ 0x0400);
+        } else {
+            v++;
+        }
+    }
+}
+
+auto Ppu::fetch_sprites(unsigned line) noexcept -> void
+{
+    auto const tall = (ctrl_ & 0x20) != 0;
+    auto const size = tall ? 16 : 8;
+    unsigned found = 0;
+    for (unsigned i = 0; i < 64; i++) {
+        auto const sprite = &oam_[i * 4];
+        // sprites show from the line after their Y
+        auto row = int(line) - int(sprite[0]) - 1;
+        if (row < 0 || row >= size) {
+            continue;
+        }
+        if (found++ == 8) {
+            status_ |= 0x20;
+            break;
+        }
+
+        auto const attributes = sprite[2];
+        if (attributes & 0x80) {
+            row = size - 1 - row;
+        }
+        u16 tile;
+        if (tall) {
+            tile = u16((sprite[1] & 1) << 8 | (sprite[1] & 0xFE) | row >> 3);
+        } else {
+            tile = u16((ctrl_ & 0x08 ? 0x100 : 0x000) | sprite[1]);
+        }
+
+        u64 pixels;
+        std::memcpy(&pixels, tiles_.row(tile, unsigned(row & 7), attributes & 0x40), 8);
+        pixels = colour(pixels, u8(0x10 | (attributes & 3) << 2));
+
+        u8 row_pixels[8];
+        std::memcpy(row_pixels, &pixels, 8);
+        unsigned const x = sprite[3];
+        for (unsigned j = 0; j < 8 && x + j < width; j++) {
+            // earlier sprites are in front
+            if ((row_pixels[j] & 3) && !sprite_[x + j]) {
+                sprite_[x + j] = row_pixels[j];
+                behind_[x + j] = attributes & 0x20;
+                zero_[x + j] = i == 0;
+            }
+        }
+    }
+}
+
+auto Ppu::increment_y() noexcept -> void
+{
+    if ((v_ & 0x7000) != 0x7000) {
+        v_ = u16(v_ + 0x1000);
+        return;
+    }
+    v_ &= 0x0FFF;
+    auto y = unsigned(v_ >> 5 & 0x1F);
+    if (y == 29) {
+        y = 0;
+        v_ ^= 0x0800;
+    } else if (y == 31) {
+        y = 0;
+    } else {
+        y++;
+    }
+    v_ = u16((v_ & 0xFC1F) | y << 5);
+}
+
+auto Ppu::schedule_vblank() -> void
+{
+    // the first vertical blank after the lines entered so far
+    auto dot = line_dot_;
+    auto line = line_;
+    while (line != vblank_line) {
+        dot += Mapper::dots_per_line;
+        line = (line + 1) % lines;
+    }
+    scheduler_->schedule(Event::ppu_scanline, dot / 3);
+}
@@ -0,0 +1,142 @@
+#include "fce/profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <ostream>
+#include <string>
+
+#include "fce/instructions.hpp"
+
+using Profiler = fce::Profiler;
+
+namespace {
+
+// Indices of the `top` largest of `counts` that aren't 0, largest first.
+auto hottest(std::vector<fce::u64> const& counts, std::size_t top) -> std::vector<std::size_t>
+{
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        if (counts[i] != 0) {
+            indices.push_back(i);
+        }
+    }
+    auto const by_count = [&](std::size_t lhs, std::size_t rhs) {
+        return counts[lhs] != counts[rhs] ? counts[lhs] > counts[rhs] : lhs < rhs;
+    };
+    top = std::min(top, indices.size());
+    std::partial_sort(indices.begin(), indices.begin() + std::ptrdiff_t(top), indices.end(), by_count);
+    indices.resize(top);
+    return indices;
+}
+
+auto percent(fce::u64 part, fce::u64 total) noexcept -> double
+{
+    return total == 0 ? 0.0 : 100.0 * double(part) / double(total);
+}
+
+}  // namespace
+
+Profiler::Profiler()
+    : pc_instructions_(0x10000), pc_cycles_(0x10000), pc_opcodes_(0x10000),
+      opcode_instructions_(0x100), opcode_cycles_(0x100), page_reads_(0x100), page_writes_(0x100),
+      children_(2 * max_frames)
+{
+    frames_.reserve(max_frames);
+    frames_.push_back(Frame{0, 0, 0, 0});
+}
+
+auto Profiler::clear() -> void
+{
+    for (auto counts : {&pc_instructions_, &pc_cycles_, &opcode_instructions_, &opcode_cycles_,
+                        &page_reads_, &page_writes_}) {
+        std::fill(counts->begin(), counts->end(), 0);
+    }
+    std::fill(pc_opcodes_.begin(), pc_opcodes_.end(), 0);
+    frames_.assign(1, Frame{0, 0, 0, 0});
+    std::fill(children_.begin(), children_.end(), 0);
+    frame_ = 0;
+    started_ = false;
+}
+
+auto Profiler::call(u16 entry) noexcept -> u32
+{
+    auto const& frame = frames_[frame_];
+    if (frame.depth == max_depth) {
+        return frame_;
+    }
+
+    auto const mask = children_.size() - 1;
+    auto slot = std::size_t((u64(frame_) << 16 | entry) * 0x9E3779B97F4A7C15 >> 32) & mask;
+    for (; children_[slot] != 0; slot = (slot + 1) & mask) {
+        auto const& child = frames_[children_[slot]];
+        if (child.parent == frame_ && child.entry == entry) {
+            return children_[slot];
+        }
+    }
+    if (frames_.size() == max_frames) {
+        return frame_;
+    }
+    auto const child = u32(frames_.size());
+    frames_.push_back(Frame{frame_, entry, u16(frame.depth + 1), 0});
+    children_[slot] = child;
+    return child;
+}
+
+auto Profiler::report(std::ostream& os, std::size_t top) const -> void
+{
+    auto const total = std::accumulate(pc_cycles_.begin(), pc_cycles_.end(), u64{0});
+    auto const instructions = std::accumulate(pc_instructions_.begin(), pc_instructions_.end(), u64{0});
+    auto const& names = cmos_ ? mnemonics_65c02 : mnemonics;
+
+    char line[128];
+    std::snprintf(line, sizeof line, "%llu instructions, %llu cycles\n",
+                  static_cast<unsigned long long>(instructions), static_cast<unsigned long long>(total));
+    os << line;
+
+    os << "\n  PC  op               cycles       %     instructions\n";
+    for (auto const pc : hottest(pc_cycles_, top)) {
+        std::snprintf(line, sizeof line, "%04zX  %-3s  %20llu  %5.1f%%  %15llu\n", pc,
+                      names[pc_opcodes_[pc]], static_cast<unsigned long long>(pc_cycles_[pc]),
+                      percent(pc_cycles_[pc], total), static_cast<unsigned long long>(pc_instructions_[pc]));
+        os << line;
+    }
+
+    os << "\n  op               cycles       %     instructions\n";
+    for (auto const opcode : hottest(opcode_cycles_, top)) {
+        std::snprintf(line, sizeof line, "%02zX %-3s  %20llu  %5.1f%%  %15llu\n", opcode, names[opcode],
+                      static_cast<unsigned long long>(opcode_cycles_[opcode]),
+                      percent(opcode_cycles_[opcode], total),
+                      static_cast<unsigned long long>(opcode_instructions_[opcode]));
+        os << line;
+    }
+
+    std::vector<u64> busy(0x100);
+    for (std::size_t page = 0; page < busy.size(); page++) {
+        busy[page] = page_reads_[page] + page_writes_[page];
+    }
+    os << "\npage                reads               writes\n";
+    for (auto const page : hottest(busy, top)) {
+        std::snprintf(line, sizeof line, "%02zXxx  %20llu %20llu\n", page,
+                      static_cast<unsigned long long>(page_reads_[page]),
+                      static_cast<unsigned long long>(page_writes_[page]));
+        os << line;
+    }
+}
+
+auto Profiler::collapsed(std::ostream& os) const -> void
+{
+    // stacks are spelled out from their frames' parents
+    std::vector<std::string> names(frames_.size());
+    names[0] = "root";
+    for (std::size_t i = 1; i < frames_.size(); i++) {
+        char entry[8];
+        std::snprintf(entry, sizeof entry, ";%04X", unsigned(frames_[i].entry));
+        names[i] = names[frames_[i].parent] + entry;
+    }
+
+    for (std::size_t i = 0; i < frames_.size(); i++) {
+        if (frames_[i].cycles != 0) {
+            os << names[i] << ' ' << frames_[i].cycles << '\n';
+        }
+    }
+}
@@ -0,0 +1,1278 @@
+#include "fce/recompiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define FCE_RECOMPILER 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using Recompiler = fce::Recompiler;
+using RecompilerContext = fce::RecompilerContext;
+
+namespace {
+
+using fce::s8;
+using fce::u8;
+using fce::u16;
+using fce::u32;
+using fce::u64;
+
+constexpr std::size_t code_size = std::size_t{4} << 20;
+
+// Room left in the buffer below which it is flushed before translating.
+constexpr std::size_t max_translation = std::size_t{256} << 10;
+
+#if defined(FCE_RECOMPILER)
+
+// The buffer is never writable and executable at once: the pages a
+// translation is copied into are made writable for the copy only.
+auto protect(u8 *code, std::size_t from, std::size_t to, int protection) noexcept -> bool
+{
+    auto const page = std::size_t(sysconf(_SC_PAGESIZE));
+    auto const first = from & ~(page - 1);
+    auto const last = (to + page - 1) & ~(page - 1);
+    return mprotect(code + first, last - first, protection) == 0;
+}
+
+// HOST ENCODING
+//
+// Just the x86-64 instructions the translator uses.
+
+enum Reg : int
+{
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+enum Alu : int { ADD = 0, OR = 1, AND = 4, SUB = 5, XOR = 6, CMP = 7 };
+
+enum Cond : int { B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, GE = 0xD };
+
+// [base + index * scale + disp]
+struct Mem
+{
+    int base;
+    int index;
+    int scale;
+    std::int32_t disp;
+};
+
+auto at(int base, std::int32_t disp = 0) -> Mem { return {base, -1, 1, disp}; }
+auto at(int base, int index, int scale, std::int32_t disp = 0) -> Mem { return {base, index, scale, disp}; }
+
+struct Label
+{
+    int section = -1;
+    std::size_t offset = 0;
+};
+
+// Code goes to sections that are laid out one after another: section 0 is
+// the straight line path, and slow paths branch off to the next section, so
+// that slow paths within slow paths stay out of line too.
+class Assembler
+{
+public:
+    // Switches to the section after the current one, returning the current
+    // one.
+    auto cold() -> int
+    {
+        auto const previous = current_++;
+        if (std::size_t(current_) == sections_.size()) {
+            sections_.emplace_back();
+        }
+        return previous;
+    }
+
+    auto section(int section) -> void { current_ = section; }
+
+    auto label() -> int
+    {
+        labels_.emplace_back();
+        return int(labels_.size() - 1);
+    }
+
+    auto bind(int label) -> void
+    {
+        labels_[std::size_t(label)] = {current_, this->code().size()};
+    }
+
+    // All sections, with jumps resolved.
+    auto finish() -> std::vector<u8>
+    {
+        std::vector<u8> out;
+        std::vector<std::size_t> starts;
+        for (auto const& section : sections_) {
+            starts.push_back(out.size());
+            out.insert(out.end(), section.begin(), section.end());
+        }
+
+        auto const position = [&starts](int section, std::size_t offset) {
+            return starts[std::size_t(section)] + offset;
+        };
+        for (auto const& fixup : fixups_) {
+            auto const& target = labels_[std::size_t(fixup.label)];
+            auto const from = position(fixup.section, fixup.offset) + 4;
+            auto const rel = std::int32_t(std::int64_t(position(target.section, target.offset)) - std::int64_t(from));
+            std::memcpy(&out[from - 4], &rel, 4);
+        }
+        return out;
+    }
+
+    // mov r32, r32
+    auto mov(int dst, int src) -> void { this->rr({0x89}, src, dst, false, false); }
+    // mov r64, r64
+    auto mov64(int dst, int src) -> void { this->rr({0x89}, src, dst, true, false); }
+    // mov r32, imm32
+    auto mov_imm(int dst, u32 imm) -> void
+    {
+        this->rex(false, 0, 0, dst, false);
+        this->byte(u8(0xB8 + (dst & 7)));
+        this->imm32(imm);
+    }
+    // movzx r32, r8
+    auto movzx8(int dst, int src) -> void { this->rr({0x0F, 0xB6}, dst, src, false, true); }
+    // movzx r32, r16
+    auto movzx16(int dst, int src) -> void { this->rr({0x0F, 0xB7}, dst, src, false, false); }
+    // movsx r32, r8
+    auto movsx8(int dst, int src) -> void { this->rr({0x0F, 0xBE}, dst, src, false, true); }
+    // movzx r32, byte [m]
+    auto load8(int dst, Mem m) -> void { this->rm({0x0F, 0xB6}, dst, m, false, false); }
+    // mov r32, [m]
+    auto load32(int dst, Mem m) -> void { this->rm({0x8B}, dst, m, false, false); }
+    // mov r64, [m]
+    auto load64(int dst, Mem m) -> void { this->rm({0x8B}, dst, m, true, false); }
+    // mov byte [m], r8
+    auto store8(Mem m, int src) -> void { this->rm({0x88}, src, m, false, true); }
+    // mov dword [m], r32
+    auto store32(Mem m, int src) -> void { this->rm({0x89}, src, m, false, false); }
+    // mov byte [m], imm8
+    auto store8_imm(Mem m, u8 imm) -> void
+    {
+        this->rm({0xC6}, 0, m, false, false);
+        this->byte(imm);
+    }
+    // mov word [m], r16
+    auto store16(Mem m, int src) -> void
+    {
+        this->byte(0x66);
+        this->rm({0x89}, src, m, false, false);
+    }
+    // mov word [m], imm16
+    auto store16_imm(Mem m, u16 imm) -> void
+    {
+        this->byte(0x66);
+        this->rm({0xC7}, 0, m, false, false);
+        this->byte(u8(imm));
+        this->byte(u8(imm >> 8));
+    }
+    // op r32, r32
+    auto alu(Alu op, int dst, int src) -> void { this->rr({u8(op * 8 + 1)}, src, dst, false, false); }
+    // op r32, imm32
+    auto alu_imm(Alu op, int dst, u32 imm) -> void
+    {
+        this->rr({0x81}, op, dst, false, false);
+        this->imm32(imm);
+    }
+    // op r8, imm8
+    auto alu8_imm(Alu op, int dst, u8 imm) -> void
+    {
+        this->rr({0x80}, op, dst, false, true);
+        this->byte(imm);
+    }
+    // op qword [m], imm32
+    auto alu64_mem_imm(Alu op, Mem m, u32 imm) -> void
+    {
+        this->rm({0x81}, op, m, true, false);
+        this->imm32(imm);
+    }
+    // cmp byte [m], imm8
+    auto cmp8_mem_imm(Mem m, u8 imm) -> void
+    {
+        this->rm({0x80}, CMP, m, false, false);
+        this->byte(imm);
+    }
+    // cmp qword [m], r64
+    auto cmp64_mem(Mem m, int src) -> void { this->rm({0x39}, src, m, true, false); }
+    // test r32, imm32
+    auto test_imm(int dst, u32 imm) -> void
+    {
+        this->rr({0xF7}, 0, dst, false, false);
+        this->imm32(imm);
+    }
+    // test r32, r32
+    auto test(int a, int b) -> void { this->rr({0x85}, b, a, false, false); }
+    // test r64, r64
+    auto test64(int a, int b) -> void { this->rr({0x85}, b, a, true, false); }
+    // shl/shr r32, imm8
+    auto shl(int dst, u8 n) -> void { this->rr({0xC1}, 4, dst, false, false); this->byte(n); }
+    auto shr(int dst, u8 n) -> void { this->rr({0xC1}, 5, dst, false, false); this->byte(n); }
+    // rol/ror r8, 1
+    auto rol8(int dst) -> void { this->rr({0xD0}, 0, dst, false, true); }
+    auto ror8(int dst) -> void { this->rr({0xD0}, 1, dst, false, true); }
+    // setcc r8
+    auto set(Cond cond, int dst) -> void { this->rr({0x0F, u8(0x90 + cond)}, 0, dst, false, true); }
+    // lea r32, [m]
+    auto lea(int dst, Mem m) -> void { this->rm({0x8D}, dst, m, false, false); }
+
+    auto jmp(int label) -> void
+    {
+        this->byte(0xE9);
+        this->fixup(label);
+    }
+    auto jcc(Cond cond, int label) -> void
+    {
+        this->byte(0x0F);
+        this->byte(u8(0x80 + cond));
+        this->fixup(label);
+    }
+    // call qword [m]
+    auto call(Mem m) -> void { this->rm({0xFF}, 2, m, false, false); }
+
+    auto push(int r) -> void
+    {
+        this->rex(false, 0, 0, r, false);
+        this->byte(u8(0x50 + (r & 7)));
+    }
+    auto pop(int r) -> void
+    {
+        this->rex(false, 0, 0, r, false);
+        this->byte(u8(0x58 + (r & 7)));
+    }
+    auto ret() -> void { this->byte(0xC3); }
+    // add/sub rsp, imm8
+    auto adjust_stack(Alu op, u8 n) -> void
+    {
+        this->rr({0x83}, op, RSP, true, false);
+        this->byte(n);
+    }
+
+private:
+    struct Fixup
+    {
+        int section;
+        std::size_t offset;
+        int label;
+    };
+
+    std::vector<std::vector<u8>> sections_ = std::vector<std::vector<u8>>(1);
+    int current_ = 0;
+    std::vector<Label> labels_;
+    std::vector<Fixup> fixups_;
+
+    auto code() -> std::vector<u8>& { return sections_[std::size_t(current_)]; }
+    auto byte(u8 b) -> void { this->code().push_back(b); }
+
+    auto imm32(u32 v) -> void
+    {
+        for (int i = 0; i < 4; i++) {
+            this->byte(u8(v >> (8 * i)));
+        }
+    }
+
+    auto fixup(int label) -> void
+    {
+        fixups_.push_back({current_, this->code().size(), label});
+        this->imm32(0);
+    }
+
+    // Byte operands 4-7 need a REX prefix to mean SPL-DIL rather than AH-BH.
+    auto rex(bool w, int r, int x, int b, bool force) -> void
+    {
+        u8 const v = u8(0x40 | (w << 3) | ((r >> 3) << 2) | ((x >> 3) << 1) | (b >> 3));
+        if (v != 0x40 || force) {
+            this->byte(v);
+        }
+    }
+
+    auto opcode(std::initializer_list<u8> bytes) -> void
+    {
+        for (auto b : bytes) {
+            this->byte(b);
+        }
+    }
+
+    // register direct: ModRM.reg = `reg`, ModRM.rm = `rm`
+    auto rr(std::initializer_list<u8> op, int reg, int rm, bool w, bool bytes) -> void
+    {
+        this->rex(w, reg, 0, rm, bytes && ((reg >= 4 && reg < 8) || (rm >= 4 && rm < 8)));
+        this->opcode(op);
+        this->byte(u8(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+    }
+
+    auto rm(std::initializer_list<u8> op, int reg, Mem m, bool w, bool bytes) -> void
+    {
+        auto const index = m.index < 0 ? RSP : m.index;
+        this->rex(w, reg, m.index < 0 ? 0 : m.index, m.base, bytes && reg >= 4 && reg < 8);
+        this->opcode(op);
+
+        auto const disp8 = m.disp >= -128 && m.disp < 128;
+        u8 const mod = disp8 ? 0x40 : 0x80;
+        if (m.index < 0 && (m.base & 7) != RSP) {
+            this->byte(u8(mod | ((reg & 7) << 3) | (m.base & 7)));
+        } else {
+            auto const scale = m.scale == 8 ? 3 : m.scale == 4 ? 2 : m.scale == 2 ? 1 : 0;
+            this->byte(u8(mod | ((reg & 7) << 3) | RSP));
+            this->byte(u8((scale << 6) | ((index & 7) << 3) | (m.base & 7)));
+        }
+        if (disp8) {
+            this->byte(u8(m.disp));
+        } else {
+            this->imm32(u32(m.disp));
+        }
+    }
+};
+
+// TRANSLATION
+//
+// Register allocation: RBX points to the context; A, X, Y, P and S live
+// zero-extended in R12D, R13D, R14D, R15D and EBP, all preserved across
+// calls. A computed effective address lives in ESI.
+
+constexpr int CTX = RBX;
+constexpr int A = R12;
+constexpr int X = R13;
+constexpr int Y = R14;
+constexpr int P = R15;
+constexpr int S = RBP;
+
+#define FCE_FIELD(name) std::int32_t(offsetof(RecompilerContext, name))
+
+auto const CYCLES = at(CTX, FCE_FIELD(cycles));
+auto const END = at(CTX, FCE_FIELD(end));
+auto const READ_PAGES = at(CTX, FCE_FIELD(read_pages));
+auto const WRITE_PAGES = at(CTX, FCE_FIELD(write_pages));
+auto const DIRTY_PAGES = at(CTX, FCE_FIELD(dirty_pages));
+auto const CODE_PAGES = at(CTX, FCE_FIELD(code_pages));
+auto const READ = at(CTX, FCE_FIELD(read));
+auto const WRITE = at(CTX, FCE_FIELD(write));
+auto const INTERPRET = at(CTX, FCE_FIELD(interpret));
+auto const PC = at(CTX, FCE_FIELD(pc));
+auto const CALLOUT = at(CTX, FCE_FIELD(callout));
+
+auto scratch(int i) -> Mem
+{
+    return at(CTX, FCE_FIELD(scratch) + 4 * i);
+}
+
+// spill slots
+auto const ADDR = scratch(0);   // ESI across a callout
+auto const REAL = scratch(1);   // ESI across a dummy read
+auto const VALUE = scratch(2);  // a result across a dummy read
+auto const LOW = scratch(3);    // the low byte of a pointer
+
+constexpr std::pair<int, std::int32_t> registers[] = {
+    {A, FCE_FIELD(a)}, {X, FCE_FIELD(x)}, {Y, FCE_FIELD(y)}, {P, FCE_FIELD(p)}, {S, FCE_FIELD(s)},
+};
+
+#undef FCE_FIELD
+
+enum class Access { load, store, modify };
+
+// Operations, as FCE_OPCODES names them
+namespace ops {
+struct ADC; struct AND; struct ASL; struct BCC; struct BCS; struct BEQ; struct BIT; struct BMI;
+struct BNE; struct BPL; struct BRK; struct BVC; struct BVS; struct CLC; struct CLD; struct CLI;
+struct CLV; struct CMP; struct CPX; struct CPY; struct DEC; struct DEX; struct DEY; struct EOR;
+struct INC; struct INX; struct INY; struct JMP; struct JSR; struct LDA; struct LDX; struct LDY;
+struct LSR; struct NOP; struct ORA; struct PHA; struct PHP; struct PLA; struct PLP; struct ROL;
+struct ROR; struct RTI; struct RTS; struct SBC; struct SEC; struct SED; struct SEI; struct STA;
+struct STX; struct STY; struct TAX; struct TAY; struct TSX; struct TXA; struct TXS; struct TYA;
+}  // namespace ops
+
+template <typename T, typename... U>
+constexpr bool any = (std::is_same<T, U>::value || ...);
+
+class Translator
+{
+public:
+    explicit Translator(u16 pc)
+        : pc_{pc}
+    {
+        epilogue_ = as_.label();
+
+        for (auto r : {RBX, RBP, R12, R13, R14, R15}) {
+            as_.push(r);
+        }
+        as_.adjust_stack(SUB, 8);  // keeps calls 16 byte aligned
+        as_.mov64(RBX, RDI);
+        this->reload();
+    }
+
+    // Translates one instruction; returns false after the last one of a
+    // block.
+    auto instruction(u8 const *bytes) -> bool
+    {
+        auto const opcode = bytes[0];
+        lo_ = bytes[1];
+        hi_ = bytes[2];
+        mode_ = fce::addressing_modes[opcode];
+        next_ = u16(pc_ + 1 + fce::operand_size(mode_));
+        pending_ = 1;  // the opcode fetch
+        called_ = false;
+
+#define FCE_OPERATION(code, mode, op) &Translator::operation<ops::op>,
+        static constexpr std::array<Operation, 0x100> operations = {{FCE_OPCODES(FCE_OPERATION)}};
+#undef FCE_OPERATION
+        auto const more = (this->*operations[opcode])(opcode);
+        pc_ = next_;
+        return more;
+    }
+
+    // Ends a block that ran out of room after a plain instruction.
+    auto finish() -> std::vector<u8>
+    {
+        as_.store16_imm(PC, pc_);
+        as_.bind(epilogue_);
+        for (auto [r, offset] : registers) {
+            as_.store8(at(CTX, offset), r);
+        }
+        as_.adjust_stack(ADD, 8);
+        for (auto r : {R15, R14, R13, R12, RBP, RBX}) {
+            as_.pop(r);
+        }
+        as_.ret();
+        return as_.finish();
+    }
+
+private:
+    using Operation = auto (Translator::*)(u8 opcode) -> bool;
+
+    Assembler as_;
+    int epilogue_;
+    u16 pc_;
+    u16 next_ = 0;
+    u8 lo_ = 0;
+    u8 hi_ = 0;
+    fce::AddressingMode mode_ = fce::AddressingMode::IMP;
+    u32 pending_ = 0;  // cycles of this instruction not yet added to CYCLES
+    bool called_ = false;  // may have called out
+
+    auto word() const -> u16 { return u16(hi_ << 8 | lo_); }
+
+    auto reload() -> void
+    {
+        for (auto [r, offset] : registers) {
+            as_.load8(r, at(CTX, offset));
+        }
+    }
+
+    auto spill() -> void
+    {
+        for (auto [r, offset] : registers) {
+            as_.store8(at(CTX, offset), r);
+        }
+    }
+
+    auto flush_cycles() -> void
+    {
+        if (pending_ != 0) {
+            as_.alu64_mem_imm(ADD, CYCLES, pending_);
+            pending_ = 0;
+        }
+    }
+
+    // Leaves the block with the PC at `pc` if `cond` holds.
+    auto exit_if(Cond cond, u16 pc) -> void
+    {
+        auto const stub = as_.label();
+        as_.jcc(cond, stub);
+        auto const section = as_.cold();
+        as_.bind(stub);
+        as_.store16_imm(PC, pc);
+        as_.jmp(epilogue_);
+        as_.section(section);
+    }
+
+    auto exit(u16 pc) -> void
+    {
+        this->flush_cycles();
+        as_.store16_imm(PC, pc);
+        as_.jmp(epilogue_);
+    }
+
+    // Counts the instruction and leaves the block if the budget ran out or
+    // it called out.
+    auto end_instruction() -> void
+    {
+        this->flush_cycles();
+        as_.load64(RAX, END);
+        as_.cmp64_mem(CYCLES, RAX);
+        this->exit_if(AE, next_);
+        if (called_) {
+            as_.cmp8_mem_imm(CALLOUT, 0);
+            this->exit_if(NE, next_);
+        }
+    }
+
+    // MEMORY
+    //
+    // Each access counts its cycle before it happens, as the interpreter
+    // does; a callout adds the pending cycles to the clock for its duration.
+    // `counted` is false for accesses whose cycle was already added at run
+    // time.
+
+    // EAX = [addr]
+    auto read(u16 addr, bool counted = true) -> void
+    {
+        pending_ += counted;
+        called_ = true;
+        auto const slow = as_.label();
+        auto const done = as_.label();
+
+        as_.load64(RDX, READ_PAGES);
+        as_.load64(RDX, at(RDX, (addr >> 8) * 8));
+        as_.test64(RDX, RDX);
+        as_.jcc(E, slow);
+        as_.load8(RAX, at(RDX, addr & 0xFF));
+        as_.bind(done);
+
+        auto const section = as_.cold();
+        as_.bind(slow);
+        this->call_read([&] { as_.mov_imm(RSI, addr); });
+        as_.jmp(done);
+        as_.section(section);
+    }
+
+    // EAX = [ESI]
+    auto read_indirect(bool counted = true) -> void
+    {
+        pending_ += counted;
+        called_ = true;
+        auto const slow = as_.label();
+        auto const done = as_.label();
+
+        as_.mov(RAX, RSI);
+        as_.shr(RAX, 8);
+        as_.load64(RDX, READ_PAGES);
+        as_.load64(RDX, at(RDX, RAX, 8));
+        as_.test64(RDX, RDX);
+        as_.jcc(E, slow);
+        as_.movzx8(RAX, RSI);
+        as_.load8(RAX, at(RDX, RAX, 1));
+        as_.bind(done);
+
+        auto const section = as_.cold();
+        as_.bind(slow);
+        as_.store32(ADDR, RSI);
+        this->call_read([] {});
+        as_.load32(RSI, ADDR);
+        as_.jmp(done);
+        as_.section(section);
+    }
+
+    template <typename F>
+    auto call_read(F&& set_address) -> void
+    {
+        if (pending_ != 0) {
+            as_.alu64_mem_imm(ADD, CYCLES, pending_);
+        }
+        as_.mov64(RDI, RBX);
+        set_address();
+        as_.call(READ);
+        as_.movzx8(RAX, RAX);
+        if (pending_ != 0) {
+            as_.alu64_mem_imm(SUB, CYCLES, pending_);
+        }
+    }
+
+    // [addr] = `src`, one of EAX or the 6502 registers
+    auto write(u16 addr, int src) -> void
+    {
+        pending_ += 1;
+        called_ = true;
+        auto const slow = as_.label();
+        auto const done = as_.label();
+
+        as_.load64(RDX, WRITE_PAGES);
+        as_.load64(RDX, at(RDX, (addr >> 8) * 8));
+        as_.test64(RDX, RDX);
+        as_.jcc(E, slow);
+        as_.load64(R8, CODE_PAGES);
+        as_.cmp8_mem_imm(at(R8, addr >> 8), 0);
+        as_.jcc(NE, slow);
+        as_.store8(at(RDX, addr & 0xFF), src);
+        as_.load64(R8, DIRTY_PAGES);
+        as_.store8_imm(at(R8, addr >> 8), 1);
+        as_.bind(done);
+
+        auto const section = as_.cold();
+        as_.bind(slow);
+        this->call_write(src, [&] { as_.mov_imm(RSI, addr); });
+        as_.jmp(done);
+        as_.section(section);
+    }
+
+    // [ESI] = `src`
+    auto write_indirect(int src) -> void
+    {
+        pending_ += 1;
+        called_ = true;
+        auto const slow = as_.label();
+        auto const done = as_.label();
+
+        as_.mov(RCX, RSI);
+        as_.shr(RCX, 8);
+        as_.load64(RDX, WRITE_PAGES);
+        as_.load64(RDX, at(RDX, RCX, 8));
+        as_.test64(RDX, RDX);
+        as_.jcc(E, slow);
+        as_.load64(R8, CODE_PAGES);
+        as_.cmp8_mem_imm(at(R8, RCX, 1), 0);
+        as_.jcc(NE, slow);
+        as_.load64(R8, DIRTY_PAGES);
+        as_.store8_imm(at(R8, RCX, 1), 1);
+        as_.movzx8(RCX, RSI);
+        as_.store8(at(RDX, RCX, 1), src);
+        as_.bind(done);
+
+        auto const section = as_.cold();
+        as_.bind(slow);
+        this->call_write(src, [] {});
+        as_.jmp(done);
+        as_.section(section);
+    }
+
+    template <typename F>
+    auto call_write(int src, F&& set_address) -> void
+    {
+        if (pending_ != 0) {
+            as_.alu64_mem_imm(ADD, CYCLES, pending_);
+        }
+        as_.movzx8(RDX, src);
+        as_.mov64(RDI, RBX);
+        set_address();
+        as_.call(WRITE);
+        if (pending_ != 0) {
+            as_.alu64_mem_imm(SUB, CYCLES, pending_);
+        }
+    }
+
+    // The read of the address before the carry into its high byte, when
+    // ESI = base + `index` crossed a page.
+    auto dummy_read(int index, bool counted) -> void
+    {
+        auto const same = as_.label();
+        as_.store32(REAL, RSI);
+        as_.movzx8(RAX, RSI);
+        as_.alu(CMP, RAX, index);
+        as_.jcc(AE, same);
+        as_.alu_imm(SUB, RSI, 0x100);
+        as_.movzx16(RSI, RSI);
+        as_.bind(same);
+        this->read_indirect(counted);
+        as_.load32(RSI, REAL);
+    }
+
+    // ADDRESSING
+    //
+    // Resolves the effective address into ESI, or returns true if it is
+    // static (word()).
+
+    auto address(Access access) -> bool
+    {
+        using fce::AddressingMode;
+
+        switch (mode_) {
+        case AddressingMode::ZPG:
+            pending_ += 1;
+            hi_ = 0;
+            return true;
+        case AddressingMode::ABS:
+            pending_ += 2;
+            return true;
+        case AddressingMode::ZPX:
+        case AddressingMode::ZPY:
+            pending_ += 2;
+            as_.lea(RSI, at(mode_ == AddressingMode::ZPX ? X : Y, lo_));
+            as_.movzx8(RSI, RSI);
+            return false;
+        case AddressingMode::ABX:
+        case AddressingMode::ABY:
+            pending_ += 2;
+            as_.lea(RSI, at(mode_ == AddressingMode::ABX ? X : Y, this->word()));
+            this->indexed(mode_ == AddressingMode::ABX ? X : Y, access);
+            return false;
+        case AddressingMode::IDX:
+            pending_ += 2;
+            as_.lea(RSI, at(X, lo_));
+            as_.movzx8(RSI, RSI);
+            this->read_indirect();
+            as_.store32(LOW, RAX);
+            as_.alu_imm(ADD, RSI, 1);
+            as_.movzx8(RSI, RSI);
+            this->read_indirect();
+            as_.shl(RAX, 8);
+            as_.load8(RCX, LOW);
+            as_.alu(OR, RAX, RCX);
+            as_.mov(RSI, RAX);
+            return false;
+        case AddressingMode::IDY:
+            pending_ += 1;
+            this->read(lo_);
+            as_.store32(LOW, RAX);
+            this->read(u8(lo_ + 1));
+            as_.shl(RAX, 8);
+            as_.load8(RCX, LOW);
+            as_.alu(OR, RAX, RCX);
+            as_.lea(RSI, at(RAX, Y, 1));
+            this->indexed(Y, access);
+            return false;
+        case AddressingMode::IMP:
+        case AddressingMode::ACC:
+        case AddressingMode::IMM:
+        case AddressingMode::IND:
+        case AddressingMode::REL:
+        case AddressingMode::ZPI:
+        case AddressingMode::IAX:
+        case AddressingMode::ZPR:
+            break;
+        }
+        return true;
+    }
+
+    // Wraps ESI = base + `index` and does the dummy read: loads only when
+    // crossing a page, at a cycle known only at run time.
+    auto indexed(int index, Access access) -> void
+    {
+        as_.movzx16(RSI, RSI);
+        if (access != Access::load) {
+            return;
+        }
+
+        auto const crossed = as_.label();
+        auto const done = as_.label();
+        as_.movzx8(RAX, RSI);
+        as_.alu(CMP, RAX, index);
+        as_.jcc(B, crossed);
+        as_.bind(done);
+
+        auto const section = as_.cold();
+        as_.bind(crossed);
+        as_.alu64_mem_imm(ADD, CYCLES, 1);
+        this->dummy_read(index, false);
+        as_.jmp(done);
+        as_.section(section);
+    }
+
+    auto index_register() const -> int
+    {
+        return mode_ == fce::AddressingMode::ABX ? X : Y;
+    }
+
+    auto is_indexed() const -> bool
+    {
+        using fce::AddressingMode;
+        return mode_ == AddressingMode::ABX || mode_ == AddressingMode::ABY || mode_ == AddressingMode::IDY;
+    }
+
+    // EAX = the operand of a read instruction
+    auto load() -> void
+    {
+        if (mode_ == fce::AddressingMode::IMM) {
+            pending_ += 1;
+            as_.mov_imm(RAX, lo_);
+        } else if (this->address(Access::load)) {
+            this->read(this->word());
+        } else {
+            this->read_indirect();
+        }
+    }
+
+    auto store(int src) -> void
+    {
+        if (this->address(Access::store)) {
+            this->write(this->word(), src);
+            return;
+        }
+        if (this->is_indexed()) {
+            this->dummy_read(this->index_register(), true);
+        }
+        this->write_indirect(src);
+    }
+
+    // FLAGS
+
+    auto set_nz(int r) -> void
+    {
+        as_.alu_imm(AND, P, 0x7D);
+        as_.test(r, r);
+        as_.set(E, RCX);
+        as_.movzx8(RCX, RCX);
+        as_.shl(RCX, 1);
+        as_.alu(OR, P, RCX);
+        as_.mov(RCX, r);
+        as_.alu_imm(AND, RCX, 0x80);
+        as_.alu(OR, P, RCX);
+    }
+
+    // C = bit `bit` of EAX
+    auto set_c_from(int bit) -> void
+    {
+        as_.alu_imm(AND, P, 0xFE);
+        as_.mov(RCX, RAX);
+        if (bit != 0) {
+            as_.shr(RCX, u8(bit));
+        }
+        as_.alu_imm(AND, RCX, 1);
+        as_.alu(OR, P, RCX);
+    }
+
+    // OPERATIONS
+
+    template <typename Op>
+    auto operation(u8 opcode) -> bool
+    {
+        if constexpr (any<Op, ops::LDA, ops::LDX, ops::LDY>) {
+            auto const r = any<Op, ops::LDA> ? A : any<Op, ops::LDX> ? X : Y;
+            this->load();
+            as_.mov(r, RAX);
+            this->set_nz(r);
+        } else if constexpr (any<Op, ops::STA, ops::STX, ops::STY>) {
+            this->store(any<Op, ops::STA> ? A : any<Op, ops::STX> ? X : Y);
+        } else if constexpr (any<Op, ops::ORA, ops::AND, ops::EOR>) {
+            this->load();
+            as_.alu(any<Op, ops::ORA> ? OR : any<Op, ops::AND> ? AND : XOR, A, RAX);
+            this->set_nz(A);
+        } else if constexpr (any<Op, ops::ADC>) {
+            this->load();
+            this->adc();
+        } else if constexpr (any<Op, ops::SBC>) {
+            this->load();
+            this->sbc();
+        } else if constexpr (any<Op, ops::CMP, ops::CPX, ops::CPY>) {
+            this->load();
+            this->compare(any<Op, ops::CMP> ? A : any<Op, ops::CPX> ? X : Y);
+        } else if constexpr (any<Op, ops::BIT>) {
+            this->load();
+            this->bit();
+        } else if constexpr (any<Op, ops::ASL, ops::LSR, ops::ROL, ops::ROR, ops::INC, ops::DEC>) {
+            this->modify<Op>();
+        } else if constexpr (any<Op, ops::INX, ops::INY, ops::DEX, ops::DEY>) {
+            auto const r = any<Op, ops::INX, ops::DEX> ? X : Y;
+            pending_ += 1;
+            as_.alu8_imm(any<Op, ops::INX, ops::INY> ? ADD : SUB, r, 1);
+            this->set_nz(r);
+        } else if constexpr (any<Op, ops::TAX, ops::TAY, ops::TXA, ops::TYA, ops::TSX, ops::TXS>) {
+            auto const from = any<Op, ops::TAX, ops::TAY> ? A :
+                              any<Op, ops::TXA, ops::TXS> ? X :
+                              any<Op, ops::TYA> ? Y : S;
+            auto const to = any<Op, ops::TXA, ops::TYA> ? A :
+                            any<Op, ops::TAX, ops::TSX> ? X :
+                            any<Op, ops::TAY> ? Y : S;
+            pending_ += 1;
+            as_.mov(to, from);
+            if (to != S) {
+                this->set_nz(to);
+            }
+        } else if constexpr (any<Op, ops::NOP>) {
+            pending_ += 1;
+        } else if constexpr (any<Op, ops::PHA, ops::PHP>) {
+            pending_ += 1;
+            this->push(any<Op, ops::PHA> ? A : P);
+        } else if constexpr (any<Op, ops::PLA, ops::PLP>) {
+            pending_ += 1;
+            this->pull();
+            pending_ += 1;
+            if constexpr (any<Op, ops::PLA>) {
+                as_.mov(A, RAX);
+                this->set_nz(A);
+            } else {
+                as_.mov(P, RAX);
+                this->exit(next_);  // may have cleared I
+                return false;
+            }
+        } else if constexpr (any<Op, ops::BPL, ops::BMI, ops::BVC, ops::BVS, ops::BCC, ops::BCS, ops::BNE, ops::BEQ>) {
+            this->branch(opcode);
+            return false;
+        } else if constexpr (any<Op, ops::CLC, ops::CLD, ops::CLI, ops::CLV, ops::SEC, ops::SED, ops::SEI>) {
+            this->flag<Op>();
+            if constexpr (any<Op, ops::CLI, ops::SEI>) {
+                this->exit(next_);
+                return false;
+            }
+        } else if constexpr (any<Op, ops::JSR>) {
+            pending_ += 3;
+            as_.mov_imm(RAX, u8(next_ >> 8));
+            this->push(RAX);
+            as_.mov_imm(RAX, u8(next_));
+            this->push(RAX);
+            this->exit(this->word());
+            return false;
+        } else if constexpr (any<Op, ops::RTS>) {
+            pending_ += 3;
+            this->pull();
+            as_.store32(LOW, RAX);
+            this->pull();
+            as_.shl(RAX, 8);
+            as_.load8(RCX, LOW);
+            as_.alu(OR, RAX, RCX);
+            this->flush_cycles();
+            as_.store16(PC, RAX);
+            as_.jmp(epilogue_);
+            return false;
+        } else if constexpr (any<Op, ops::JMP>) {
+            if (mode_ != fce::AddressingMode::ABS) {
+                this->interpret();
+                return false;
+            }
+            pending_ += 2;
+            this->exit(this->word());
+            return false;
+        } else {
+            this->interpret();
+            return false;
+        }
+
+        this->end_instruction();
+        return true;
+    }
+
+    auto adc() -> void
+    {
+        as_.mov(RCX, P);
+        as_.alu_imm(AND, RCX, 1);
+        as_.lea(RDX, at(A, RAX, 1));
+        as_.alu(ADD, RDX, RCX);  // sum
+        as_.mov(RCX, A);
+        as_.alu(XOR, RCX, RDX);
+        as_.mov(RDI, RAX);
+        as_.alu(XOR, RDI, RDX);
+        as_.alu(AND, RCX, RDI);
+        as_.alu_imm(AND, RCX, 0x80);
+        as_.shr(RCX, 1);  // V
+        as_.alu_imm(AND, P, 0xBE);
+        as_.alu(OR, P, RCX);
+        as_.mov(RCX, RDX);
+        as_.shr(RCX, 8);  // C
+        as_.alu(OR, P, RCX);
+        as_.movzx8(A, RDX);
+        this->set_nz(A);
+    }
+
+    auto sbc() -> void
+    {
+        as_.mov(RCX, P);
+        as_.alu_imm(AND, RCX, 1);
+        as_.alu_imm(XOR, RCX, 1);  // borrow
+        as_.mov(RDX, A);
+        as_.alu(SUB, RDX, RAX);
+        as_.alu(SUB, RDX, RCX);  // difference
+        as_.mov(RDI, A);
+        as_.alu(XOR, RDI, RAX);
+        as_.alu_imm(AND, RDI, 0x80);
+        as_.shr(RDI, 1);  // V, as the interpreter computes it
+        as_.mov(RCX, RDX);
+        as_.shr(RCX, 31);
+        as_.alu_imm(XOR, RCX, 1);  // C: no borrow
+        as_.alu_imm(AND, P, 0xBE);
+        as_.alu(OR, P, RCX);
+        as_.alu(OR, P, RDI);
+        as_.movzx8(A, RDX);
+        this->set_nz(A);
+    }
+
+    auto compare(int r) -> void
+    {
+        // C = s8(r) >= s8(m)
+        as_.movsx8(RCX, r);
+        as_.movsx8(RDX, RAX);
+        as_.alu(CMP, RCX, RDX);
+        as_.set(GE, RDI);
+        as_.movzx8(RDI, RDI);
+        as_.alu_imm(AND, P, 0xFE);
+        as_.alu(OR, P, RDI);
+        as_.mov(RDX, r);
+        as_.alu(SUB, RDX, RAX);
+        as_.movzx8(RDX, RDX);
+        this->set_nz(RDX);
+    }
+
+    auto bit() -> void
+    {
+        as_.alu(AND, RAX, A);
+        as_.alu_imm(AND, P, 0x3D);
+        as_.mov(RCX, RAX);
+        as_.alu_imm(AND, RCX, 0xC0);
+        as_.alu(OR, P, RCX);
+        as_.test(RAX, RAX);
+        as_.set(E, RCX);
+        as_.movzx8(RCX, RCX);
+        as_.shl(RCX, 1);
+        as_.alu(OR, P, RCX);
+    }
+
+    // EAX = f(EAX), with C
+    template <typename Op>
+    auto shift() -> void
+    {
+        if constexpr (any<Op, ops::ASL>) {
+            this->set_c_from(7);
+            as_.shl(RAX, 1);
+            as_.movzx8(RAX, RAX);
+        } else if constexpr (any<Op, ops::ROL>) {
+            this->set_c_from(7);
+            as_.rol8(RAX);
+        } else if constexpr (any<Op, ops::LSR>) {
+            this->set_c_from(0);
+            as_.shr(RAX, 1);
+        } else if constexpr (any<Op, ops::ROR>) {
+            this->set_c_from(0);
+            as_.ror8(RAX);
+        } else if constexpr (any<Op, ops::INC>) {
+            as_.alu8_imm(ADD, RAX, 1);
+        } else {
+            as_.alu8_imm(SUB, RAX, 1);
+        }
+        as_.movzx8(RAX, RAX);
+    }
+
+    template <typename Op>
+    auto modify() -> void
+    {
+        if (mode_ == fce::AddressingMode::ACC) {
+            pending_ += 1;
+            as_.mov(RAX, A);
+            this->shift<Op>();
+            as_.mov(A, RAX);
+            this->set_nz(A);
+            return;
+        }
+
+        if (this->address(Access::modify)) {
+            auto const addr = this->word();
+            this->read(addr);
+            pending_ += 1;
+            this->shift<Op>();
+            this->set_nz(RAX);
+            this->write(addr, RAX);
+        } else {
+            this->read_indirect();
+            pending_ += 1;
+            this->shift<Op>();
+            this->set_nz(RAX);
+            if (this->is_indexed()) {
+                as_.store32(VALUE, RAX);
+                this->dummy_read(this->index_register(), true);
+                as_.load32(RAX, VALUE);
+            }
+            this->write_indirect(RAX);
+        }
+    }
+
+    auto push(int src) -> void
+    {
+        as_.mov(RSI, S);
+        as_.alu_imm(OR, RSI, 0x100);
+        this->write_indirect(src);
+        as_.alu8_imm(SUB, S, 1);
+    }
+
+    auto pull() -> void
+    {
+        as_.alu8_imm(ADD, S, 1);
+        as_.mov(RSI, S);
+        as_.alu_imm(OR, RSI, 0x100);
+        this->read_indirect();
+    }
+
+    template <typename Op>
+    auto flag() -> void
+    {
+        u32 const bit = any<Op, ops::CLC, ops::SEC> ? 0x01 :
+                        any<Op, ops::CLI, ops::SEI> ? 0x04 :
+                        any<Op, ops::CLD, ops::SED> ? 0x08 : 0x40;  // V
+
+        pending_ += 1;
+        if constexpr (any<Op, ops::SEC, ops::SEI, ops::SED>) {
+            as_.alu_imm(OR, P, bit);
+        } else {
+            as_.alu_imm(AND, P, ~bit & 0xFF);
+        }
+    }
+
+    auto branch(u8 opcode) -> void
+    {
+        // BPL BMI BVC BVS BCC BCS BNE BEQ: bits 7-6 select the flag, bit 5
+        // the value taken on
+        static constexpr u32 bits[] = {0x80, 0x40, 0x01, 0x02};
+        auto const bit = bits[opcode >> 6];
+        auto const expect = (opcode & 0x20) != 0;
+
+        pending_ += 1;
+        auto const target = u16(next_ + s8(lo_));
+        auto const taken = as_.label();
+
+        as_.test_imm(P, bit);
+        as_.jcc(expect ? NE : E, taken);
+        this->exit(next_);
+
+        auto const section = as_.cold();
+        as_.bind(taken);
+        pending_ = 3 + ((next_ ^ target) & 0xFF00 ? 1 : 0);
+        this->exit(target);
+        as_.section(section);
+    }
+
+    auto interpret() -> void
+    {
+        // the interpreter fetches the instruction and counts all its cycles
+        pending_ = 0;
+        this->spill();
+        as_.store16_imm(PC, pc_);
+        as_.mov64(RDI, RBX);
+        as_.call(INTERPRET);
+        this->reload();
+        as_.jmp(epilogue_);
+    }
+};
+
+#endif  // FCE_RECOMPILER
+
+}  // namespace
+
+auto Recompiler::available() noexcept -> bool
+{
+#if defined(FCE_RECOMPILER)
+    return true;
+#else
+    return false;
+#endif
+}
+
+Recompiler::Recompiler() noexcept
+    : entries_(0x10000, 0), flat_read_{}, flat_write_{}
+{
+}
+
+Recompiler::~Recompiler()
+{
+#if defined(FCE_RECOMPILER)
+    if (code_) {
+        munmap(code_, code_size);
+    }
+#endif
+}
+
+auto Recompiler::invalidate(u8 page) noexcept -> void
+{
+    for (auto const pc : pages_[page]) {
+        entries_[pc] = 0;
+    }
+    pages_[page].clear();
+    code_pages_[page] = false;
+}
+
+auto Recompiler::flush() noexcept -> void
+{
+#if defined(FCE_RECOMPILER)
+    if (code_) {
+        protect(code_, 0, code_size, PROT_READ | PROT_WRITE);
+    }
+#endif
+    used_ = 0;
+    std::fill(entries_.begin(), entries_.end(), 0);
+    for (auto& pcs : pages_) {
+        pcs.clear();
+    }
+    code_pages_.fill(false);
+}
+
+auto Recompiler::flat_pages(u8 *data) noexcept -> void
+{
+    if (data != flat_) {
+        for (std::size_t page = 0; page < 0x100; page++) {
+            flat_read_[page] = data + (page << 8);
+            flat_write_[page] = data + (page << 8);
+        }
+        flat_ = data;
+    }
+}
+
+auto Recompiler::ends_block(u8 opcode) noexcept -> bool
+{
+    switch (opcode) {
+    case 0x00:  // BRK
+    case 0x20:  // JSR
+    case 0x28:  // PLP
+    case 0x40:  // RTI
+    case 0x4C:  // JMP a
+    case 0x58:  // CLI
+    case 0x60:  // RTS
+    case 0x6C:  // JMP (a)
+    case 0x78:  // SEI
+        return true;
+    default:
+        return addressing_modes[opcode] == AddressingMode::REL;
+    }
+}
+
+auto Recompiler::translate(u16 pc, u8 const *bytes, std::size_t size) -> Block
+{
+#if defined(FCE_RECOMPILER)
+    if (!code_) {
+        void *const memory = mmap(nullptr, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        code_ = static_cast<u8 *>(memory);
+    }
+    if (code_size - used_ < max_translation) {
+        this->flush();
+    }
+
+    Translator translator{pc};
+    u16 last = pc;
+    std::size_t offset = 0;
+    while (offset < size) {
+        u8 instruction[3] = {bytes[offset], 0, 0};
+        auto const length = 1 + operand_size(addressing_modes[instruction[0]]);
+        for (unsigned i = 1; i < length; i++) {
+            instruction[i] = bytes[offset + i];
+        }
+        last = u16(pc + offset + length - 1);
+        offset += length;
+        if (!translator.instruction(instruction)) {
+            break;
+        }
+    }
+    auto const code = translator.finish();
+    if (code.size() > code_size - used_) {
+        return nullptr;
+    }
+
+    // the last page written may hold earlier translations, already executable
+    if (!protect(code_, used_, used_ + code.size(), PROT_READ | PROT_WRITE)) {
+        return nullptr;
+    }
+    std::memcpy(code_ + used_, code.data(), code.size());
+    if (!protect(code_, used_, used_ + code.size(), PROT_READ | PROT_EXEC)) {
+        this->flush();  // earlier translations on the page aren't executable
+        return nullptr;
+    }
+    entries_[pc] = u32(used_ + 1);
+    used_ += (code.size() + 15) & ~std::size_t{15};
+
+    for (auto page = unsigned(pc >> 8); ; page = (page + 1) & 0xFF) {
+        pages_[page].push_back(pc);
+        code_pages_[page] = true;
+        if (page == unsigned(last >> 8)) {
+            break;
+        }
+    }
+    return reinterpret_cast<Block>(code_ + entries_[pc] - 1);
+#else
+    (void)pc;
+    (void)bytes;
+    (void)size;
+    return nullptr;
+#endif
+}
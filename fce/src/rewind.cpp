@@ -0,0 +1,252 @@
+#include "fce/rewind.hpp"
+#include <algorithm>
+#include <cstring>
+
+using Rewind = fce::Rewind;
+using Savestate = fce::Savestate;
+
+namespace {
+
+using fce::u8;
+using fce::u64;
+
+// Encoded frames are runs of
+//
+//     zeros      LEB128, bytes equal to the base
+//     literals   LEB128, followed by that many XORed bytes
+//
+// Zero runs shorter than `min_zeros` are folded into the literals.
+constexpr std::size_t min_zeros = 4;
+
+auto put_varint(std::vector<u8>& out, std::size_t v) -> void
+{
+    while (v >= 0x80) {
+        out.push_back(u8(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(u8(v));
+}
+
+auto take_varint(u8 const *&in) noexcept -> std::size_t
+{
+    std::size_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        auto const b = *in++;
+        v |= std::size_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return v;
+        }
+    }
+}
+
+auto bytes(Savestate const& state) noexcept -> u8 const *
+{
+    return reinterpret_cast<u8 const *>(&state);
+}
+
+auto bytes(Savestate& state) noexcept -> u8 *
+{
+    return reinterpret_cast<u8 *>(&state);
+}
+
+// Applies an encoded frame to `out` by XOR.
+auto apply(u8 const *in, std::size_t size, u8 *out) noexcept -> void
+{
+    auto const end = in + size;
+    std::size_t i = 0;
+    while (in != end) {
+        i += take_varint(in);
+        auto const literals = take_varint(in);
+        for (std::size_t k = 0; k < literals; k++) {
+            out[i++] ^= *in++;
+        }
+    }
+}
+
+}  // namespace
+
+Rewind::Rewind(std::size_t capacity, std::size_t keyframe_interval)
+    : ring_(std::max(capacity, 4 * sizeof(Savestate))),
+      keyframe_interval_{std::max<std::size_t>(keyframe_interval, 1)},
+      keyframe_{std::make_unique<Savestate>()},
+      scratch_{std::make_unique<Savestate>()}
+{
+}
+
+auto Rewind::push(Savestate const& state) -> void
+{
+    auto keyframe = !keyframe_valid_ || since_keyframe_ >= keyframe_interval_;
+    this->encode(state, keyframe);
+    auto offset = this->allocate(encoded_.size());
+
+    // making room may have dropped the keyframe this frame is relative to
+    if (!keyframe && !keyframe_valid_) {
+        keyframe = true;
+        this->encode(state, keyframe);
+        offset = this->allocate(encoded_.size());
+    }
+
+    std::copy(encoded_.begin(), encoded_.end(), ring_.begin() + std::ptrdiff_t(offset));
+    frames_.push_back({offset, encoded_.size(), keyframe});
+    used_ += encoded_.size();
+
+    if (keyframe) {
+        *keyframe_ = state;
+        keyframe_valid_ = true;
+        since_keyframe_ = 1;
+    } else {
+        since_keyframe_++;
+    }
+}
+
+auto Rewind::rewind(std::size_t back, Savestate& state) -> bool
+{
+    if (!this->peek(back, state)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < back; i++) {
+        this->drop_newest();
+    }
+    return true;
+}
+
+auto Rewind::peek(std::size_t back, Savestate& state) const -> bool
+{
+    if (back >= frames_.size()) {
+        return false;
+    }
+    auto const index = frames_.size() - 1 - back;
+
+    auto key = index;
+    while (!frames_[key].keyframe) {
+        key--;
+    }
+
+    // the newest keyframe is kept decoded
+    if (keyframe_valid_ && key == frames_.size() - since_keyframe_) {
+        state = *keyframe_;
+    } else {
+        std::memset(bytes(state), 0, sizeof state);
+        this->decode(frames_[key], state);
+    }
+    if (key != index) {
+        this->decode(frames_[index], state);
+    }
+    return true;
+}
+
+auto Rewind::clear() noexcept -> void
+{
+    frames_.clear();
+    used_ = 0;
+    keyframe_valid_ = false;
+    since_keyframe_ = 0;
+}
+
+auto Rewind::encode(Savestate const& state, bool keyframe) -> void
+{
+    auto const current = bytes(state);
+    auto const base = keyframe ? nullptr : bytes(*keyframe_);
+    auto const n = sizeof state;
+    auto const x = [&](std::size_t i) { return u8(base ? current[i] ^ base[i] : current[i]); };
+
+    encoded_.clear();
+    std::size_t i = 0;
+    while (i < n) {
+        // zeros, a word at a time where possible
+        auto j = i;
+        while (j + 8 <= n) {
+            u64 a;
+            u64 b = 0;
+            std::memcpy(&a, current + j, 8);
+            if (base) {
+                std::memcpy(&b, base + j, 8);
+            }
+            if (a != b) {
+                break;
+            }
+            j += 8;
+        }
+        while (j < n && x(j) == 0) {
+            j++;
+        }
+
+        // literals, up to the next long enough zero run
+        auto end = j;
+        auto k = j;
+        while (k < n) {
+            if (x(k) != 0) {
+                end = ++k;
+                continue;
+            }
+            auto z = k;
+            while (z < n && x(z) == 0) {
+                z++;
+            }
+            if (z - k >= min_zeros || z == n) {
+                break;
+            }
+            k = z;
+        }
+
+        put_varint(encoded_, j - i);
+        put_varint(encoded_, end - j);
+        for (auto l = j; l < end; l++) {
+            encoded_.push_back(x(l));
+        }
+        i = end;
+    }
+}
+
+auto Rewind::decode(Frame const& frame, Savestate& state) const noexcept -> void
+{
+    apply(ring_.data() + frame.offset, frame.size, bytes(state));
+}
+
+auto Rewind::allocate(std::size_t size) -> std::size_t
+{
+    while (!frames_.empty()) {
+        auto const head = frames_.front().offset;
+        auto const end = frames_.back().offset + frames_.back().size;
+
+        if (end > head) {
+            // [head, end) in use
+            if (ring_.size() - end >= size) {
+                return end;
+            }
+            if (head >= size) {
+                return 0;
+            }
+        } else if (head - end >= size) {
+            // [head, ring end) and [0, end) in use
+            return end;
+        }
+        this->drop_oldest();
+    }
+    return 0;
+}
+
+auto Rewind::drop_oldest() noexcept -> void
+{
+    // a keyframe goes with the frames relative to it
+    do {
+        used_ -= frames_.front().size;
+        frames_.pop_front();
+    } while (!frames_.empty() && !frames_.front().keyframe);
+
+    if (frames_.empty()) {
+        keyframe_valid_ = false;
+    }
+}
+
+auto Rewind::drop_newest() noexcept -> void
+{
+    auto const& frame = frames_.back();
+    used_ -= frame.size;
+    if (frame.keyframe) {
+        keyframe_valid_ = false;
+    } else {
+        since_keyframe_--;
+    }
+    frames_.pop_back();
+}
@@ -0,0 +1,203 @@
+#include "fce/rom.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__)
+#define FCE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using ByteSpan = fce::ByteSpan;
+using Rom = fce::Rom;
+
+namespace {
+
+using fce::u8;
+
+constexpr std::size_t prg_unit = std::size_t{16} << 10;
+constexpr std::size_t chr_unit = std::size_t{8} << 10;
+
+// A NES 2.0 ROM size: a count of `unit`s, or when the high nibble is 0xF an
+// exponent and multiplier packed in the low byte, 2^E * (2M + 1) bytes.
+auto rom_size(u8 low, unsigned high, std::size_t unit) -> std::size_t
+{
+    if (high != 0xF) {
+        return (std::size_t(high) << 8 | low) * unit;
+    }
+    auto const exponent = unsigned(low >> 2);
+    if (exponent > 40) {
+        throw std::runtime_error("ROM size out of range");
+    }
+    return (std::size_t{1} << exponent) * (std::size_t(low & 3) * 2 + 1);
+}
+
+// A NES 2.0 RAM size: none, or 64 bytes shifted left by the count.
+auto ram_size(unsigned shift) noexcept -> std::size_t
+{
+    return shift == 0 ? 0 : std::size_t{64} << shift;
+}
+
+auto bank(ByteSpan rom, std::size_t index, std::size_t size) noexcept -> ByteSpan
+{
+    if (rom.size < size || size == 0) {
+        return rom;
+    }
+    auto const count = rom.size / size;
+    return ByteSpan{rom.data + index % count * size, size};
+}
+
+}  // namespace
+
+Rom::Rom(std::string const& path)
+{
+#if defined(FCE_MMAP)
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot open " + path);
+    }
+    size_ = std::size_t(st.st_size);
+    if (size_ != 0) {
+        void *const image = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (image == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("cannot map " + path);
+        }
+        image_ = static_cast<u8 const *>(image);
+    }
+    ::close(fd);
+#else
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    copy_.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    image_ = copy_.data();
+    size_ = copy_.size();
+#endif
+
+    try {
+        this->parse();
+    } catch (...) {
+        this->release();
+        throw;
+    }
+}
+
+Rom::~Rom()
+{
+    this->release();
+}
+
+Rom::Rom(Rom&& other) noexcept
+    : image_{std::exchange(other.image_, nullptr)}, size_{std::exchange(other.size_, 0)},
+      copy_{std::move(other.copy_)}, format_{other.format_}, mapper_{other.mapper_},
+      submapper_{other.submapper_}, mirroring_{other.mirroring_}, battery_{other.battery_},
+      trainer_{other.trainer_}, prg_{other.prg_}, chr_{other.chr_}, prg_ram_size_{other.prg_ram_size_},
+      chr_ram_size_{other.chr_ram_size_}
+{
+}
+
+auto Rom::operator=(Rom&& other) noexcept -> Rom&
+{
+    if (this != &other) {
+        this->release();
+        image_ = std::exchange(other.image_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        copy_ = std::move(other.copy_);
+        format_ = other.format_;
+        mapper_ = other.mapper_;
+        submapper_ = other.submapper_;
+        mirroring_ = other.mirroring_;
+        battery_ = other.battery_;
+        trainer_ = other.trainer_;
+        prg_ = other.prg_;
+        chr_ = other.chr_;
+        prg_ram_size_ = other.prg_ram_size_;
+        chr_ram_size_ = other.chr_ram_size_;
+    }
+    return *this;
+}
+
+auto Rom::prg_bank(std::size_t index, std::size_t size) const noexcept -> ByteSpan
+{
+    return bank(prg_, index, size);
+}
+
+auto Rom::chr_bank(std::size_t index, std::size_t size) const noexcept -> ByteSpan
+{
+    return bank(chr_, index, size);
+}
+
+auto Rom::parse() -> void
+{
+    auto const h = image_;
+    if (size_ < header_size || h[0] != 'N' || h[1] != 'E' || h[2] != 'S' || h[3] != 0x1A) {
+        throw std::runtime_error("not an iNES ROM");
+    }
+
+    std::size_t prg_size = 0;
+    std::size_t chr_size = 0;
+    if ((h[7] & 0x0C) == 0x08) {
+        format_ = RomFormat::nes2;
+        mapper_ = u16((h[6] >> 4) | (h[7] & 0xF0) | (h[8] & 0x0F) << 8);
+        submapper_ = u8(h[8] >> 4);
+        prg_size = rom_size(h[4], h[9] & 0x0Fu, prg_unit);
+        chr_size = rom_size(h[5], unsigned(h[9] >> 4), chr_unit);
+        prg_ram_size_ = ram_size(h[10] & 0x0Fu) + ram_size(unsigned(h[10] >> 4));
+        chr_ram_size_ = ram_size(h[11] & 0x0Fu) + ram_size(unsigned(h[11] >> 4));
+    } else {
+        // Headers written by old tools have junk from byte 7 on, in which
+        // case the upper nibble of the mapper is lost.
+        auto const junk = (h[7] & 0x0C) != 0 || h[12] != 0 || h[13] != 0 || h[14] != 0 || h[15] != 0;
+        format_ = RomFormat::ines;
+        mapper_ = u16((h[6] >> 4) | (junk ? 0 : h[7] & 0xF0));
+        prg_size = h[4] * prg_unit;
+        chr_size = h[5] * chr_unit;
+        prg_ram_size_ = (junk || h[8] == 0 ? 1 : h[8]) * chr_unit;
+        chr_ram_size_ = chr_size == 0 ? chr_unit : 0;
+    }
+    if (h[6] & 0x08) {
+        mirroring_ = Mirroring::four_screen;
+    } else {
+        mirroring_ = h[6] & 0x01 ? Mirroring::vertical : Mirroring::horizontal;
+    }
+    battery_ = h[6] & 0x02;
+
+    std::size_t offset = header_size;
+    auto const take = [&](std::size_t size) {
+        if (size_ - offset < size) {
+            throw std::runtime_error("truncated ROM");
+        }
+        ByteSpan const span{image_ + offset, size};
+        offset += size;
+        return span;
+    };
+    trainer_ = take(h[6] & 0x04 ? trainer_size : 0);
+    prg_ = take(prg_size);
+    chr_ = take(chr_size);
+    if (prg_.empty()) {
+        throw std::runtime_error("ROM without PRG");
+    }
+}
+
+auto Rom::release() noexcept -> void
+{
+#if defined(FCE_MMAP)
+    if (image_) {
+        ::munmap(const_cast<u8 *>(image_), size_);
+    }
+#endif
+    image_ = nullptr;
+    size_ = 0;
+    copy_.clear();
+}
@@ -0,0 +1,156 @@
+#include "fce/savestate.hpp"
+#include <algorithm>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(FCE_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+using Compression = fce::Compression;
+using Savestate = fce::Savestate;
+
+namespace {
+
+// The file starts with the magic, the version of Savestate, the compression
+// and the size of the payload that follows, all little endian. The payload
+// is a Savestate, compressed or not.
+constexpr char magic[8] = {'F', 'C', 'E', 'S', 'T', 'A', 'T', 'E'};
+constexpr std::size_t header_size = 24;
+
+// The size of the payload of each version, from 1 up, as Savestate was then.
+constexpr std::size_t payload_sizes[] = {
+    sizeof(fce::CpuState) + 0x10000,
+};
+static_assert(std::size(payload_sizes) == Savestate::version, "a version appends fields to Savestate");
+static_assert(payload_sizes[Savestate::version - 1] == sizeof(Savestate), "Savestate has the latest layout");
+
+auto put(char *&out, fce::u64 v, unsigned bytes) noexcept -> void
+{
+    for (unsigned i = 0; i < bytes; i++) {
+        *out++ = char(v >> (8 * i) & 0xFF);
+    }
+}
+
+auto take(char const *&in, unsigned bytes) noexcept -> fce::u64
+{
+    fce::u64 v = 0;
+    for (unsigned i = 0; i < bytes; i++) {
+        v |= fce::u64(fce::u8(*in++)) << (8 * i);
+    }
+    return v;
+}
+
+// Converts the multi-byte fields between host and file byte order; both ways
+// are the same swap.
+auto to_little_endian(Savestate& state) noexcept -> void
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    state.cpu.cycles = fce::byteswap(state.cpu.cycles);
+    state.cpu.pc = fce::byteswap(state.cpu.pc);
+#else
+    (void)state;
+#endif
+}
+
+}  // namespace
+
+auto fce::compression_available(Compression compression) noexcept -> bool
+{
+    switch (compression) {
+    case Compression::none:
+        return true;
+    case Compression::zstd:
+#if defined(FCE_HAVE_ZSTD)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+auto fce::save_state(std::ostream& os, Savestate const& state, Compression compression) -> void
+{
+    if (!compression_available(compression)) {
+        throw std::runtime_error("compression not available");
+    }
+
+    auto little = state;
+    to_little_endian(little);
+    auto const raw = reinterpret_cast<char const *>(&little);
+
+    std::vector<char> payload;
+    if (compression == Compression::zstd) {
+#if defined(FCE_HAVE_ZSTD)
+        payload.resize(ZSTD_compressBound(sizeof little));
+        auto const size = ZSTD_compress(payload.data(), payload.size(), raw, sizeof little, 3);
+        if (ZSTD_isError(size)) {
+            throw std::runtime_error(ZSTD_getErrorName(size));
+        }
+        payload.resize(size);
+#endif
+    } else {
+        payload.assign(raw, raw + sizeof little);
+    }
+
+    char header[header_size];
+    char *out = header;
+    for (auto c : magic) {
+        *out++ = c;
+    }
+    put(out, Savestate::version, 4);
+    put(out, u64(compression), 4);
+    put(out, payload.size(), 8);
+    os.write(header, sizeof header);
+    os.write(payload.data(), std::streamsize(payload.size()));
+}
+
+auto fce::load_state(std::istream& is, Savestate& state) -> void
+{
+    char header[header_size];
+    if (!is.read(header, sizeof header) || !std::equal(magic, magic + sizeof magic, header)) {
+        throw std::runtime_error("not a savestate");
+    }
+    char const *in = header + sizeof magic;
+    auto const version = take(in, 4);
+    auto const compression = take(in, 4);
+    auto const size = take(in, 8);
+
+    if (version == 0 || version > Savestate::version) {
+        throw std::runtime_error("unsupported savestate version");
+    }
+    auto const expected = payload_sizes[version - 1];
+    if (compression > u64(Compression::zstd) || !compression_available(Compression(compression))) {
+        throw std::runtime_error("compression not available");
+    }
+    if (size > 2 * sizeof(Savestate)) {
+        throw std::runtime_error("corrupt savestate");
+    }
+
+    std::vector<char> payload(size);
+    if (!is.read(payload.data(), std::streamsize(size))) {
+        throw std::runtime_error("truncated savestate");
+    }
+
+    // fields appended since the file was written stay zero
+    state = Savestate{};
+    auto const raw = reinterpret_cast<char *>(&state);
+    if (Compression(compression) == Compression::zstd) {
+#if defined(FCE_HAVE_ZSTD)
+        auto const decompressed = ZSTD_decompress(raw, sizeof state, payload.data(), payload.size());
+        if (ZSTD_isError(decompressed) || decompressed != expected) {
+            throw std::runtime_error("corrupt savestate");
+        }
+#endif
+    } else {
+        if (size != expected) {
+            throw std::runtime_error("corrupt savestate");
+        }
+        std::copy(payload.begin(), payload.end(), raw);
+    }
+    to_little_endian(state);
+}
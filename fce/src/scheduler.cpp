@@ -0,0 +1,92 @@
+#include "fce/scheduler.hpp"
+#include <utility>
+
+using Scheduler = fce::Scheduler;
+using Event = fce::Event;
+
+namespace {
+
+auto index(Event event) noexcept -> std::size_t
+{
+    return static_cast<std::size_t>(event);
+}
+
+}  // namespace
+
+Scheduler::Scheduler() noexcept
+    : generations_{}, pending_{}
+{
+}
+
+auto Scheduler::on(Event event, Handler handler) -> void
+{
+    handlers_[index(event)] = std::move(handler);
+}
+
+auto Scheduler::schedule(Event event, u64 timestamp) -> void
+{
+    auto const i = index(event);
+    generations_[i]++;
+    pending_[i] = true;
+
+    heap_.push_back({timestamp, generations_[i], event});
+    std::push_heap(heap_.begin(), heap_.end(), later);
+    this->prune();
+}
+
+auto Scheduler::cancel(Event event) noexcept -> void
+{
+    auto const i = index(event);
+    generations_[i]++;
+    pending_[i] = false;
+    this->prune();
+}
+
+auto Scheduler::pending(Event event) const noexcept -> bool
+{
+    return pending_[index(event)];
+}
+
+auto Scheduler::dispatch(u64 now) -> void
+{
+    while (!heap_.empty() && heap_.front().timestamp <= now) {
+        auto const entry = this->pop();
+        pending_[index(entry.event)] = false;
+        this->prune();
+
+        auto const& handler = handlers_[index(entry.event)];
+        if (handler) {
+            handler(entry.timestamp);
+        }
+    }
+}
+
+// Orders the heap by timestamp, earliest first. Events due at the same time
+// fire in the order of their kind, so runs are reproducible.
+auto Scheduler::later(Entry const& lhs, Entry const& rhs) noexcept -> bool
+{
+    if (lhs.timestamp != rhs.timestamp) {
+        return lhs.timestamp > rhs.timestamp;
+    }
+    return lhs.event > rhs.event;
+}
+
+auto Scheduler::live(Entry const& entry) const noexcept -> bool
+{
+    return entry.generation == generations_[index(entry.event)];
+}
+
+auto Scheduler::pop() noexcept -> Entry
+{
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    auto const entry = heap_.back();
+    heap_.pop_back();
+    return entry;
+}
+
+auto Scheduler::prune() noexcept -> void
+{
+    while (!heap_.empty() && !this->live(heap_.front())) {
+        this->pop();
+    }
+}
@@ -0,0 +1,98 @@
+#include "fce/thread_pool.hpp"
+#include <algorithm>
+
+using ThreadPool = fce::ThreadPool;
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    ranges_ = std::make_unique<Range[]>(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+        ranges_[i].next = 0;
+        ranges_[i].end = 0;
+    }
+
+    threads_.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; i++) {
+        threads_.emplace_back([this, i] { this->worker(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+auto ThreadPool::run(std::size_t count, Task task, void *context) -> void
+{
+    if (count == 0) {
+        return;
+    }
+
+    auto const n = this->size();
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        task_ = task;
+        context_ = context;
+        for (std::size_t i = 0; i < n; i++) {
+            ranges_[i].next.store(count * i / n, std::memory_order_relaxed);
+            ranges_[i].end = count * (i + 1) / n;
+        }
+        active_ = threads_.size();
+        generation_++;
+    }
+    wake_.notify_all();
+
+    this->work(0);
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_.wait(lock, [this] { return active_ == 0; });
+}
+
+auto ThreadPool::work(std::size_t thread) noexcept -> void
+{
+    auto const n = this->size();
+
+    // own range first, then the others, starting with the next thread's
+    for (std::size_t k = 0; k < n; k++) {
+        auto& range = ranges_[(thread + k) % n];
+        for (;;) {
+            auto const i = range.next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= range.end) {
+                break;
+            }
+            task_(context_, i);
+        }
+    }
+}
+
+auto ThreadPool::worker(std::size_t thread) noexcept -> void
+{
+    u64 seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        this->work(thread);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
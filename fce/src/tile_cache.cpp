@@ -0,0 +1,40 @@
+#include "fce/tile_cache.hpp"
+#include <algorithm>
+
+#include "fce/mapper.hpp"
+
+using TileCache = fce::TileCache;
+
+TileCache::TileCache()
+    : pixels_(2 * tiles * 64)
+{
+}
+
+auto TileCache::sync(Mapper const& mapper) noexcept -> void
+{
+    for (unsigned window = 0; window < windows_.size(); window++) {
+        auto const data = mapper.chr_window(window);
+        if (data != windows_[window]) {
+            windows_[window] = data;
+            std::fill_n(valid_.begin() + window * 64, 64, false);
+        }
+    }
+}
+
+auto TileCache::decode(u16 tile) noexcept -> void
+{
+    auto const planes = windows_[tile >> 6] + (tile & 63) * 16;
+    auto const plain = &pixels_[std::size_t{tile} * 64];
+    auto const mirrored = &pixels_[(tiles + tile) * 64];
+    for (unsigned y = 0; y < 8; y++) {
+        auto const lo = planes[y];
+        auto const hi = planes[y + 8];
+        for (unsigned x = 0; x < 8; x++) {
+            auto const pixel = u8((lo >> (7 - x) & 1) | (hi >> (7 - x) & 1) << 1);
+            plain[y * 8 + x] = pixel;
+            mirrored[y * 8 + 7 - x] = pixel;
+        }
+    }
+    valid_[tile] = true;
+    decoded_++;
+}
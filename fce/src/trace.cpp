@@ -0,0 +1,202 @@
+#include "fce/trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include "fce/instructions.hpp"
+
+using TraceBuffer = fce::TraceBuffer;
+using TraceRecord = fce::TraceRecord;
+
+namespace {
+
+// The file starts with the magic and a record count, followed by records of
+// `record_size` bytes. Everything is little endian.
+constexpr char magic[8] = {'F', 'C', 'E', 'T', 'R', 'A', 'C', '2'};
+constexpr std::size_t record_size = 19;
+
+auto put(char *&out, fce::u64 v, unsigned bytes) noexcept -> void
+{
+    for (unsigned i = 0; i < bytes; i++) {
+        *out++ = char(v >> (8 * i) & 0xFF);
+    }
+}
+
+auto take(char const *&in, unsigned bytes) noexcept -> fce::u64
+{
+    fce::u64 v = 0;
+    for (unsigned i = 0; i < bytes; i++) {
+        v |= fce::u64(fce::u8(*in++)) << (8 * i);
+    }
+    return v;
+}
+
+}  // namespace
+
+TraceBuffer::TraceBuffer(std::size_t capacity)
+{
+    std::size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    records_.resize(size);
+    mask_ = size - 1;
+}
+
+auto TraceBuffer::size() const noexcept -> std::size_t
+{
+    return recorded_ < records_.size() ? std::size_t(recorded_) : records_.size();
+}
+
+auto TraceBuffer::operator[](std::size_t i) const noexcept -> TraceRecord const&
+{
+    auto const first = std::size_t(recorded_) - this->size();
+    return records_[(first + i) & mask_];
+}
+
+auto TraceBuffer::save(std::ostream& os) const -> void
+{
+    char header[16];
+    char *out = header;
+    for (auto c : magic) {
+        *out++ = c;
+    }
+    put(out, this->size(), 8);
+    os.write(header, sizeof header);
+
+    for (std::size_t i = 0; i < this->size(); i++) {
+        auto const& record = (*this)[i];
+
+        char buffer[record_size];
+        out = buffer;
+        put(out, record.cycles, 8);
+        put(out, record.pc, 2);
+        put(out, record.opcode, 1);
+        put(out, record.operand[0], 1);
+        put(out, record.operand[1], 1);
+        put(out, record.a, 1);
+        put(out, record.x, 1);
+        put(out, record.y, 1);
+        put(out, record.s, 1);
+        put(out, record.p, 1);
+        put(out, record.cmos, 1);
+        os.write(buffer, sizeof buffer);
+    }
+}
+
+auto fce::load_trace(std::istream& is) -> std::vector<TraceRecord>
+{
+    char header[16];
+    if (!is.read(header, sizeof header) || !std::equal(magic, magic + sizeof magic, header)) {
+        throw std::runtime_error("not a trace");
+    }
+    char const *in = header + sizeof magic;
+    auto const count = take(in, 8);
+
+    std::vector<TraceRecord> records;
+    for (u64 i = 0; i < count; i++) {
+        char buffer[record_size];
+        if (!is.read(buffer, sizeof buffer)) {
+            throw std::runtime_error("truncated trace");
+        }
+        in = buffer;
+
+        TraceRecord record{};
+        record.cycles = take(in, 8);
+        record.pc = u16(take(in, 2));
+        record.opcode = u8(take(in, 1));
+        record.operand[0] = u8(take(in, 1));
+        record.operand[1] = u8(take(in, 1));
+        record.a = u8(take(in, 1));
+        record.x = u8(take(in, 1));
+        record.y = u8(take(in, 1));
+        record.s = u8(take(in, 1));
+        record.p = u8(take(in, 1));
+        record.cmos = take(in, 1) != 0;
+        records.push_back(record);
+    }
+    return records;
+}
+
+auto fce::format_nestest(TraceRecord const& record) -> std::string
+{
+    auto const mode = (record.cmos ? addressing_modes_65c02 : addressing_modes)[record.opcode];
+    auto const mnemonic = (record.cmos ? mnemonics_65c02 : mnemonics)[record.opcode];
+    auto const lo = record.operand[0];
+    auto const hi = record.operand[1];
+    auto const word = unsigned(hi << 8 | lo);
+
+    char bytes[16];
+    switch (operand_size(mode)) {
+    case 0:
+        std::snprintf(bytes, sizeof bytes, "%02X", record.opcode);
+        break;
+    case 1:
+        std::snprintf(bytes, sizeof bytes, "%02X %02X", record.opcode, lo);
+        break;
+    default:
+        std::snprintf(bytes, sizeof bytes, "%02X %02X %02X", record.opcode, lo, hi);
+        break;
+    }
+
+    char text[32];
+    switch (mode) {
+    case AddressingMode::IMP:
+        std::snprintf(text, sizeof text, "%s", mnemonic);
+        break;
+    case AddressingMode::ACC:
+        std::snprintf(text, sizeof text, "%s A", mnemonic);
+        break;
+    case AddressingMode::IMM:
+        std::snprintf(text, sizeof text, "%s #$%02X", mnemonic, lo);
+        break;
+    case AddressingMode::ZPG:
+        std::snprintf(text, sizeof text, "%s $%02X", mnemonic, lo);
+        break;
+    case AddressingMode::ZPX:
+        std::snprintf(text, sizeof text, "%s $%02X,X", mnemonic, lo);
+        break;
+    case AddressingMode::ZPY:
+        std::snprintf(text, sizeof text, "%s $%02X,Y", mnemonic, lo);
+        break;
+    case AddressingMode::ABS:
+        std::snprintf(text, sizeof text, "%s $%04X", mnemonic, word);
+        break;
+    case AddressingMode::ABX:
+        std::snprintf(text, sizeof text, "%s $%04X,X", mnemonic, word);
+        break;
+    case AddressingMode::ABY:
+        std::snprintf(text, sizeof text, "%s $%04X,Y", mnemonic, word);
+        break;
+    case AddressingMode::IND:
+        std::snprintf(text, sizeof text, "%s ($%04X)", mnemonic, word);
+        break;
+    case AddressingMode::IDX:
+        std::snprintf(text, sizeof text, "%s ($%02X,X)", mnemonic, lo);
+        break;
+    case AddressingMode::IDY:
+        std::snprintf(text, sizeof text, "%s ($%02X),Y", mnemonic, lo);
+        break;
+    case AddressingMode::ZPI:
+        std::snprintf(text, sizeof text, "%s ($%02X)", mnemonic, lo);
+        break;
+    case AddressingMode::IAX:
+        std::snprintf(text, sizeof text, "%s ($%04X,X)", mnemonic, word);
+        break;
+    case AddressingMode::REL:
+        // the branch target, as computed by the REL mode
+        std::snprintf(text, sizeof text, "%s $%04X", mnemonic, unsigned(u16(record.pc + 2 + s8(lo))));
+        break;
+    case AddressingMode::ZPR:
+        std::snprintf(text, sizeof text, "%s $%02X,$%04X", mnemonic, lo, unsigned(u16(record.pc + 3 + s8(hi))));
+        break;
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof line, "%04X  %-8s  %-32sA:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%llu",
+                  record.pc, bytes, text, record.a, record.x, record.y, record.p, record.s,
+                  static_cast<unsigned long long>(record.cycles));
+    return line;
+}
@@ -0,0 +1,31 @@
+#include "fce/triple_buffer.hpp"
+
+using TripleBuffer = fce::TripleBuffer;
+
+TripleBuffer::TripleBuffer(std::size_t size)
+    : size_{size}, frames_(3 * size)
+{
+}
+
+auto TripleBuffer::publish() noexcept -> void
+{
+    // releases the frame drawn, and acquires the presenter's last one
+    auto const old = middle_.exchange(u8(back_ | fresh), std::memory_order_acq_rel);
+    back_ = old & 3;
+    published_.store(published_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (old & fresh) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+auto TripleBuffer::present() noexcept -> bool
+{
+    if (!(middle_.load(std::memory_order_relaxed) & fresh)) {
+        duplicated_.store(duplicated_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    // publish() only ever puts another fresh frame in its place
+    auto const old = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = old & 3;
+    return true;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/apu.hpp>
+#include <fce/scheduler.hpp>
+
+using namespace fce;
+
+TEST_CASE("APU", "[apu]") {
+    Apu apu{48000};
+    Scheduler scheduler;
+    u64 now = 0;
+    bool irq = false;
+    std::vector<u16> reads;
+    apu.attach(scheduler, [&] { return now; }, [&](bool line) { irq = line; },
+               [&](u16 addr) {
+                   reads.push_back(addr);
+                   return u8(0xFF);
+               });
+    AudioRing ring{1 << 17};
+    apu.output(&ring);
+    auto const run_to = [&](u64 cycle) {
+        now = cycle;
+        scheduler.dispatch(now);
+        apu.catch_up(now);
+    };
+
+    SECTION("Length Counters") {
+        apu.set(0x4003, 0x08);  // ignored while disabled
+        REQUIRE((apu.get(0x4015) & 0x01) == 0);
+
+        apu.set(0x4015, 0x0F);
+        apu.set(0x4003, 0x08);  // 254
+        apu.set(0x400F, 0x18);  // 2
+        REQUIRE((apu.get(0x4015) & 0x0F) == 0x09);
+
+        // two half frames
+        run_to(29830);
+        REQUIRE((apu.get(0x4015) & 0x0F) == 0x01);
+
+        apu.set(0x4015, 0x00);
+        REQUIRE((apu.get(0x4015) & 0x0F) == 0x00);
+    }
+    SECTION("Frame IRQ") {
+        run_to(29828);
+        REQUIRE_FALSE(irq);
+        run_to(29830);
+        REQUIRE(irq);
+        REQUIRE((apu.get(0x4015) & 0x40) == 0x40);
+        REQUIRE_FALSE(irq);  // acknowledged by reading
+
+        apu.set(0x4017, 0x40);
+        run_to(29830 * 3);
+        REQUIRE_FALSE(irq);
+        REQUIRE((apu.get(0x4015) & 0x40) == 0);
+    }
+    SECTION("DMC") {
+        apu.set(0x4010, 0x8F);  // IRQ, fastest
+        apu.set(0x4012, 0x01);
+        apu.set(0x4013, 0x01);  // 17 bytes
+        apu.set(0x4015, 0x10);
+        REQUIRE(reads.size() == 1);
+        REQUIRE(reads[0] == 0xC040);
+        REQUIRE((apu.get(0x4015) & 0x10) == 0x10);
+
+        // the scheduler brings the APU to the last fetch, no later
+        now = 17 * 8 * 54;
+        scheduler.dispatch(now);
+        REQUIRE(irq);
+        REQUIRE(reads.size() == 17);
+        REQUIRE(reads.back() == 0xC050);
+        REQUIRE((apu.get(0x4015) & 0x90) == 0x80);
+    }
+    SECTION("Pulse") {
+        // 440 Hz, half duty, full volume, for a second
+        apu.set(0x4015, 0x01);
+        apu.set(0x4000, 0xBF);
+        apu.set(0x4002, 0xFD);
+        apu.set(0x4003, 0x00);
+        run_to(u64(Apu::cpu_rate));
+
+        auto const count = ring.size();
+        REQUIRE(count == apu.samples());
+        REQUIRE(count >= 47700);
+        REQUIRE(count <= 48000);
+        REQUIRE(apu.dropped() == 0);
+
+        std::vector<s16> samples(count);
+        ring.pop(samples.data(), count);
+        unsigned rising = 0;
+        for (std::size_t i = 1000; i < count; i++) {
+            rising += samples[i - 1] < 0 && samples[i] >= 0;
+        }
+        REQUIRE(rising >= 420);
+        REQUIRE(rising <= 440);
+        REQUIRE(*std::max_element(samples.begin(), samples.end()) > 1000);
+    }
+    SECTION("Dropped") {
+        AudioRing small{256};
+        apu.output(&small);
+        apu.set(0x4015, 0x01);
+        apu.set(0x4000, 0xBF);
+        apu.set(0x4002, 0xFD);
+        apu.set(0x4003, 0x00);
+        run_to(29830);
+
+        REQUIRE(small.size() == 256);
+        REQUIRE(apu.dropped() == apu.samples() - 256);
+    }
+}
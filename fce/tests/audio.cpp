@@ -0,0 +1,68 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/audio.hpp>
+
+using namespace fce;
+
+namespace {
+
+auto little(std::string const& bytes, std::size_t offset, unsigned size) -> u64
+{
+    u64 v = 0;
+    for (unsigned i = 0; i < size; i++) {
+        v |= u64(u8(bytes[offset + i])) << (8 * i);
+    }
+    return v;
+}
+
+}  // namespace
+
+TEST_CASE("WAV Writer", "[audio]") {
+    std::stringstream out;
+    WavWriter wav{out, 44100};
+    s16 const samples[] = {0, 1, -1, 32767, -32768};
+    wav.write(samples, 5);
+    wav.write(samples, 2);
+    wav.finish();
+
+    auto const bytes = out.str();
+    REQUIRE(bytes.size() == 44 + 14);
+    REQUIRE(bytes.substr(0, 4) == "RIFF");
+    REQUIRE(little(bytes, 4, 4) == 36 + 14);
+    REQUIRE(bytes.substr(8, 8) == "WAVEfmt ");
+    REQUIRE(little(bytes, 24, 4) == 44100);
+    REQUIRE(bytes.substr(36, 4) == "data");
+    REQUIRE(little(bytes, 40, 4) == 14);
+    REQUIRE(little(bytes, 44 + 4, 2) == 0xFFFF);
+    REQUIRE(little(bytes, 44 + 8, 2) == 0x8000);
+}
+
+TEST_CASE("Audio Thread", "[audio]") {
+    AudioRing ring{64};
+    std::vector<s16> drained;
+    AudioThread thread{ring, [&](s16 const *samples, std::size_t count) {
+                           drained.insert(drained.end(), samples, samples + count);
+                       }, 16};
+
+    s16 next = 0;
+    while (next < 1000) {
+        s16 block[10];
+        for (auto& s : block) {
+            s = next++;
+        }
+        std::size_t pushed = 0;
+        while (pushed < 10) {
+            pushed += ring.push(block + pushed, 10 - pushed);
+            std::this_thread::yield();
+        }
+    }
+    thread.stop();
+
+    REQUIRE(drained.size() == 1000);
+    for (std::size_t i = 0; i < drained.size(); i++) {
+        REQUIRE(drained[i] == s16(i));
+    }
+}
@@ -0,0 +1,79 @@
+#include <cstring>
+#include <memory>
+#include <catch2/catch.hpp>
+#include <fce/batch_runner.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/savestate.hpp>
+
+using namespace fce;
+
+TEST_CASE("BatchRunner", "[batch]") {
+    FlatRamBus program;
+    program.set(0xFFFC, 0x00);
+    program.set(0xFFFD, 0x02);
+    program.set(0x0200, 0xA5);  // LDA $F8
+    program.set(0x0201, 0xF8);
+    program.set(0x0202, 0x85);  // STA $11
+    program.set(0x0203, 0x11);
+    program.set(0x0204, 0xE8);  // INX
+    program.set(0x0205, 0xE6);  // INC $10
+    program.set(0x0206, 0x10);
+    program.set(0x0207, 0x4C);  // JMP $0204
+    program.set(0x0208, 0x04);
+    program.set(0x0209, 0x02);
+
+    CPU<FlatRamBus> reference{program};
+    reference.engine(Engine::interpreter);
+    reference.x(0x00);
+    reference.a(0x00);
+    reference.y(0x00);
+    reference.p(0x00);
+
+    auto const initial = std::make_unique<Savestate>();
+    initial->cpu = reference.state();
+    std::memcpy(initial->memory.data(), reference.bus().data(), initial->memory.size());
+
+    BatchRunner batch{8, *initial, GENERATE(1, 3)};
+    REQUIRE(batch.size() == 8);
+
+    SECTION("Step All") {
+        batch.step_all(1000);
+        reference.run(1000);
+
+        for (std::size_t i = 0; i < batch.size(); i++) {
+            REQUIRE(batch.cpu(i).cycles() == reference.cycles());
+            REQUIRE(batch.cpu(i).pc() == reference.pc());
+            REQUIRE(batch.cpu(i).x() == reference.x());
+            REQUIRE(batch.ram(i)[0x0010] == reference.bus().get(0x0010));
+        }
+    }
+    SECTION("Reset") {
+        batch.step_all(1000);
+        batch.reset(2);
+
+        REQUIRE(batch.cpu(2).cycles() == initial->cpu.cycles);
+        REQUIRE(batch.cpu(2).pc() == 0x0200);
+        REQUIRE(batch.ram(2)[0x0010] == 0x00);
+        REQUIRE(batch.ram(2)[0x0011] == 0x00);
+        REQUIRE_FALSE(batch.cpu(2).bus().dirty(0x00));
+        REQUIRE(batch.cpu(3).cycles() != initial->cpu.cycles);
+    }
+    SECTION("Seed") {
+        for (std::size_t i = 0; i < batch.size(); i++) {
+            batch.reset(i, 0x0123456789ABCD00 | i);
+        }
+        REQUIRE(batch.ram(5)[0x00F9] == 0xCD);
+        REQUIRE(batch.ram(5)[0x00FF] == 0x01);
+
+        batch.step_all(100);
+        for (std::size_t i = 0; i < batch.size(); i++) {
+            REQUIRE(batch.ram(i)[0x0011] == i);
+        }
+
+        // the seed is written as the program's writes are, and undone
+        batch.reset(5);
+        REQUIRE(batch.ram(5)[0x00F9] == 0x00);
+        REQUIRE(batch.ram(5)[0x0011] == 0x00);
+    }
+}
@@ -0,0 +1,61 @@
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/blip_buffer.hpp>
+
+using namespace fce;
+
+TEST_CASE("Blip Buffer", "[blip_buffer]") {
+    // 10 clocks per sample
+    BlipBuffer blip{480000.0, 48000.0, 10000};
+    std::vector<s16> samples(1000);
+
+    SECTION("Blocks") {
+        blip.end_block(1000);
+        REQUIRE(blip.available() == 100);
+        blip.end_block(5);
+        blip.end_block(5);
+        REQUIRE(blip.available() == 101);
+
+        REQUIRE(blip.read(samples.data(), 60) == 60);
+        REQUIRE(blip.available() == 41);
+        REQUIRE(blip.read(samples.data(), 1000) == 41);
+        REQUIRE(blip.available() == 0);
+    }
+    SECTION("Step") {
+        blip.add_delta(1000, 10000);
+        blip.end_block(3000);
+        REQUIRE(blip.read(samples.data(), 1000) == 300);
+
+        // silent before it, settled after it, and decaying towards DC 0
+        REQUIRE(samples[80] == 0);
+        REQUIRE(samples[120] > 9700);
+        REQUIRE(samples[120] <= 10000);
+        REQUIRE(samples[299] < samples[120]);
+        REQUIRE(samples[299] > 5000);
+        for (std::size_t i = 0; i < 100; i++) {
+            REQUIRE(samples[i] <= samples[i + 1] + 1);
+        }
+    }
+    SECTION("Across Reads") {
+        // a step whose tail is past the samples of its block
+        blip.add_delta(995, 8000);
+        blip.end_block(1000);
+        REQUIRE(blip.read(samples.data(), 1000) == 100);
+        blip.end_block(1000);
+        REQUIRE(blip.read(samples.data() + 100, 1000) == 100);
+
+        BlipBuffer whole{480000.0, 48000.0, 10000};
+        std::vector<s16> expected(200);
+        whole.add_delta(995, 8000);
+        whole.end_block(2000);
+        whole.read(expected.data(), 200);
+        REQUIRE(std::vector<s16>(samples.begin(), samples.begin() + 200) == expected);
+    }
+    SECTION("Clamped") {
+        blip.add_delta(0, 30000);
+        blip.add_delta(0, 30000);
+        blip.end_block(1000);
+        blip.read(samples.data(), 100);
+        REQUIRE(samples[50] == 32767);
+    }
+}
@@ -0,0 +1,99 @@
+#include <memory>
+#include <catch2/catch.hpp>
+#include <fce/block_cache.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/memory.hpp>
+
+using namespace fce;
+
+TEST_CASE("Block Cache", "[block_cache]") {
+    FlatRamBus bus;
+    bus.set(0x80FE, 0xA9);  // LDA #$01
+    bus.set(0x80FF, 0x01);
+    bus.set(0x8100, 0x8D);  // STA $0200
+    bus.set(0x8101, 0x00);
+    bus.set(0x8102, 0x02);
+    bus.set(0x8103, 0xD0);  // BNE $80FE
+    bus.set(0x8104, 0xF9);
+    bus.set(0x8105, 0xE8);  // INX
+
+    BlockCache cache;
+    int reads = 0;
+    auto const read = [&](u16 addr) {
+        ++reads;
+        return bus.get(addr);
+    };
+
+    auto const block = cache.find(0x80FE, read);
+    REQUIRE(block.size == 3);
+    REQUIRE(cache.op(block.first).opcode == 0xA9);
+    REQUIRE(cache.op(block.first).operand[0] == 0x01);
+    REQUIRE(cache.op(block.first + 1).operand[1] == 0x02);
+    REQUIRE(cache.op(block.first + 2).operand[0] == 0xF9);
+    REQUIRE(cache.code_page(0x80FE));
+    REQUIRE(cache.code_page(0x8104));
+    REQUIRE_FALSE(cache.code_page(0x8200));
+
+    SECTION("Cached") {
+        auto const old_reads = reads;
+        auto const again = cache.find(0x80FE, read);
+        REQUIRE(reads == old_reads);
+        REQUIRE(again.first == block.first);
+    }
+    SECTION("Invalidate") {
+        cache.invalidate(0x81);
+        REQUIRE_FALSE(cache.code_page(0x8100));
+
+        auto const old_reads = reads;
+        cache.find(0x80FE, read);
+        REQUIRE(reads > old_reads);
+    }
+}
+
+TEST_CASE("CPU Block Cache", "[block_cache][cpu]") {
+    auto memory = std::make_shared<Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x02);
+    memory->set(0x0200, 0xA9);  // LDA #$C8
+    memory->set(0x0201, 0xC8);
+    memory->set(0x0202, 0x8D);  // STA $0205
+    memory->set(0x0203, 0x05);
+    memory->set(0x0204, 0x02);
+    memory->set(0x0205, 0xE8);  // INX, overwritten with INY
+    memory->set(0x0206, 0x4C);  // JMP $0200
+    memory->set(0x0207, 0x00);
+    memory->set(0x0208, 0x02);
+
+    CPU cpu{memory};
+    cpu.engine(Engine::block_cache);
+    cpu.x(0x00);
+    cpu.y(0x00);
+    auto const old_cycles = cpu.cycles();
+
+    SECTION("Self Modifying") {
+        auto const result = cpu.run_until(1000, [](Registers const& r) { return r.pc == 0x0206; });
+
+        REQUIRE(result.reason == StopReason::breakpoint);
+        REQUIRE(result.cycles == 8);
+        REQUIRE(cpu.cycles() - old_cycles == 8);
+        REQUIRE(cpu.x() == 0x00);
+        REQUIRE(cpu.y() == 0x01);
+    }
+    SECTION("Loop") {
+        auto const result = cpu.run(110);
+
+        REQUIRE(result.cycles == 110);
+        REQUIRE(cpu.y() == 10);
+        REQUIRE(cpu.pc() == 0x0200);
+    }
+    SECTION("Invalidate Code") {
+        cpu.run(11);
+        memory->set(0x0201, 0xEA);  // LDA #$EA, behind the CPU's back
+        cpu.invalidate_code(0x02, 0x02);
+        cpu.run(11);
+
+        REQUIRE(memory->get(0x0205) == 0xEA);
+        REQUIRE(cpu.y() == 1);
+    }
+}
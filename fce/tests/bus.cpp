@@ -0,0 +1,141 @@
+#include <array>
+#include <memory>
+#include <catch2/catch.hpp>
+#include <fce/bus.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/memory.hpp>
+
+using namespace fce;
+
+namespace {
+
+class Counter : public Memory
+{
+public:
+    auto get(u16 addr) const noexcept -> u8 override {
+        ++reads;
+        return Memory::get(addr);
+    }
+
+    auto set(u16 addr, u8 v) noexcept -> void override {
+        ++writes;
+        Memory::set(addr, v);
+    }
+
+    mutable int reads = 0;
+    int writes = 0;
+};
+
+}  // namespace
+
+TEST_CASE("Unmapped", "[bus]") {
+    Bus bus;
+
+    bus.set(0x1234, 0xAB);
+    REQUIRE(bus.get(0x1234) == 0x00);
+}
+
+TEST_CASE("RAM", "[bus]") {
+    std::array<u8, 0x800> ram{};
+    Bus bus;
+    bus.map_ram(0x00, 0x1F, ram.data(), ram.size());
+
+    SECTION("Direct") {
+        bus.set(0x0123, 0xAB);
+        REQUIRE(ram[0x0123] == 0xAB);
+        REQUIRE(bus.get(0x0123) == 0xAB);
+    }
+    SECTION("Mirrored") {
+        bus.set(0x0923, 0xAB);
+        REQUIRE(ram[0x0123] == 0xAB);
+        REQUIRE(bus.get(0x0123) == 0xAB);
+        REQUIRE(bus.get(0x1123) == 0xAB);
+        REQUIRE(bus.get(0x1923) == 0xAB);
+    }
+    SECTION("Bounds") {
+        bus.set(0x2000, 0xAB);
+        REQUIRE(bus.get(0x2000) == 0x00);
+    }
+}
+
+TEST_CASE("ROM", "[bus]") {
+    std::array<u8, 0x4000> rom{};
+    rom[0x0000] = 0x12;
+    rom[0x3FFF] = 0x34;
+
+    Bus bus;
+    bus.map_rom(0x80, 0xFF, rom.data(), rom.size());
+
+    REQUIRE(bus.get(0x8000) == 0x12);
+    REQUIRE(bus.get(0xC000) == 0x12);
+    REQUIRE(bus.get(0xFFFF) == 0x34);
+
+    bus.set(0x8000, 0xAB);
+    REQUIRE(bus.get(0x8000) == 0x12);
+    REQUIRE(rom[0x0000] == 0x12);
+}
+
+TEST_CASE("I/O", "[bus]") {
+    std::array<u8, 0x800> ram{};
+    auto handler = std::make_shared<Counter>();
+
+    Bus bus;
+    bus.map_ram(0x00, 0x1F, ram.data(), ram.size());
+    bus.map_io(0x20, 0x3F, handler);
+
+    bus.set(0x2001, 0xAB);
+    REQUIRE(handler->writes == 1);
+    REQUIRE(bus.get(0x2001) == 0xAB);
+    REQUIRE(handler->reads == 1);
+
+    bus.set(0x0001, 0xCD);
+    REQUIRE(bus.get(0x0001) == 0xCD);
+    REQUIRE(handler->writes == 1);
+    REQUIRE(handler->reads == 1);
+
+    bus.unmap(0x20, 0x3F);
+    REQUIRE(bus.get(0x2001) == 0x00);
+    REQUIRE(handler->reads == 1);
+}
+
+TEST_CASE("CPU on Bus", "[bus][cpu]") {
+    std::array<u8, 0x800> ram{};
+    std::array<u8, 0x8000> rom{};
+    rom[0x0000] = 0x85;  // STA $10
+    rom[0x0001] = 0x10;
+    rom[0x7FFC] = 0x00;
+    rom[0x7FFD] = 0x80;
+
+    Bus bus;
+    bus.map_ram(0x00, 0x1F, ram.data(), ram.size());
+    bus.map_rom(0x80, 0xFF, rom.data(), rom.size());
+
+    CPU cpu{bus};
+    REQUIRE(cpu.pc() == 0x8000);
+
+    cpu.a(0xAB);
+    cpu.step();
+
+    REQUIRE(cpu.pc() == 0x8002);
+    REQUIRE(ram[0x0010] == 0xAB);
+}
+
+TEST_CASE("CPU on FlatRamBus", "[bus][cpu]") {
+    FlatRamBus bus;
+    bus.set(0x8000, 0x85);  // STA $10
+    bus.set(0x8001, 0x10);
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x80);
+
+    CPU<FlatRamBus> cpu{bus};
+    REQUIRE(cpu.pc() == 0x8000);
+
+    auto const old_cycles = cpu.cycles();
+    cpu.a(0xAB);
+    cpu.step();
+
+    REQUIRE(cpu.pc() == 0x8002);
+    REQUIRE(cpu.cycles() - old_cycles == 3);
+    REQUIRE(cpu.bus().get(0x0010) == 0xAB);
+}
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <catch2/catch.hpp>
+#include <fce/capture.hpp>
+
+using namespace fce;
+
+namespace {
+
+constexpr u32 white = 0xFFFFFFFF;
+constexpr u32 red = 0xFF0000FF;
+
+}  // namespace
+
+TEST_CASE("Video Capture", "[capture]") {
+    std::stringstream out;
+
+    SECTION("Y4M") {
+        {
+            VideoCapture capture{out, VideoFormat::y4m, 4, 2};
+            std::fill_n(capture.frame(), 8, white);
+            capture.submit();
+            auto const frame = capture.frame();
+            std::fill_n(frame, 8, red);
+            frame[0] = white;
+            frame[4] = white;
+            capture.submit();
+        }
+        auto const bytes = out.str();
+        auto const header = std::string{"YUV4MPEG2 W4 H2 F39375000:655171 Ip A8:7 C420jpeg XCOLORRANGE=FULL\n"};
+        REQUIRE(bytes.substr(0, header.size()) == header);
+        REQUIRE(bytes.size() == header.size() + 2 * (6 + 8 + 4));
+
+        auto const first = bytes.substr(header.size(), 18);
+        REQUIRE(first == "FRAME\n" + std::string(8, char(255)) + std::string(4, char(128)));
+
+        auto const second = bytes.substr(header.size() + 18);
+        REQUIRE(second.substr(0, 6) == "FRAME\n");
+        REQUIRE(u8(second[6]) == 255);
+        REQUIRE(u8(second[7]) == 76);  // red
+        REQUIRE(u8(second[14]) == 106);  // half white, half red
+        REQUIRE(u8(second[15]) == 85);
+        REQUIRE(u8(second[16]) == 192);
+        REQUIRE(u8(second[17]) == 255);
+    }
+    SECTION("RGB") {
+        VideoCapture capture{out, VideoFormat::rgb, 2, 2};
+        std::fill_n(capture.frame(), 4, red);
+        capture.submit();
+        capture.finish();
+        REQUIRE(out.str() == std::string{"\xFF\0\0\xFF\0\0\xFF\0\0\xFF\0\0", 12});
+    }
+    SECTION("Every Frame") {
+        // far more frames than buffers, in writes of a few frames
+        VideoCapture capture{out, VideoFormat::rgb, 2, 2, 4, 40};
+        for (u32 i = 0; i < 1000; i++) {
+            std::fill_n(capture.frame(), 4, i & 0xFF);
+            capture.submit();
+        }
+        capture.finish();
+
+        auto const bytes = out.str();
+        REQUIRE(capture.frames() == 1000);
+        REQUIRE(bytes.size() == 1000 * 12);
+        bool ordered = true;
+        for (std::size_t i = 0; i < 1000; i++) {
+            ordered = ordered && u8(bytes[i * 12]) == u8(i) && u8(bytes[i * 12 + 11]) == 0;
+        }
+        REQUIRE(ordered);
+    }
+}
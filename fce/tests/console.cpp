@@ -0,0 +1,68 @@
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/fce.hpp>
+#include "console.hpp"
+
+using namespace fce;
+
+namespace {
+
+constexpr char const *path = "fce-tests-console.nes";
+
+// NROM with 16 KiB of PRG at $C000 running `program`, and 8 KiB of CHR.
+auto write_rom(std::vector<u8> const& program) -> void
+{
+    std::vector<u8> prg(0x4000);
+    std::copy(program.begin(), program.end(), prg.begin());
+    prg[0x3FFC] = 0x00;  // reset vector $C000
+    prg[0x3FFD] = 0xC0;
+
+    std::vector<u8> header = {'N', 'E', 'S', 0x1A, 1, 1};
+    header.resize(Rom::header_size);
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<char const *>(header.data()), std::streamsize(header.size()));
+    file.write(reinterpret_cast<char const *>(prg.data()), std::streamsize(prg.size()));
+    file.write(std::vector<char>(0x2000).data(), 0x2000);
+}
+
+}  // namespace
+
+TEST_CASE("Console", "[console]") {
+    // waits for two vertical blanks as games do at power on, then fills a
+    // page of RAM, all in loops closed by branches backwards
+    write_rom({
+        0x78,              // C000  SEI
+        0xAD, 0x02, 0x20,  // C001  LDA $2002
+        0x10, 0xFB,        // C004  BPL $C001
+        0xAD, 0x02, 0x20,  // C006  LDA $2002
+        0x10, 0xFB,        // C009  BPL $C006
+        0xA2, 0x00,        // C00B  LDX #$00
+        0xA9, 0x2A,        // C00D  LDA #$2A
+        0x9D, 0x00, 0x02,  // C00F  STA $0200,X
+        0xE8,              // C012  INX
+        0xD0, 0xFA,        // C013  BNE $C00F
+        0xA9, 0x01,        // C015  LDA #$01
+        0x85, 0x00,        // C017  STA $00
+        0x4C, 0x19, 0xC0,  // C019  JMP $C019
+    });
+    Console console{path, 48000};
+    std::remove(path);
+    auto& cpu = console.cpu();
+
+    console.run_frame();
+    REQUIRE(cpu.bus().get(0x0000) == 0x00);  // the second wait is a frame long
+    REQUIRE(cpu.pc() <= 0xC009);
+
+    console.run_frame();
+    console.run_frame();
+    REQUIRE(cpu.pc() == 0xC019);
+    REQUIRE(cpu.bus().get(0x0000) == 0x01);
+    REQUIRE(cpu.bus().get(0x0200) == 0x2A);
+    REQUIRE(cpu.bus().get(0x02FF) == 0x2A);
+    REQUIRE(cpu.x() == 0x00);
+
+    // the waits were skipped rather than spun through
+    REQUIRE(cpu.skipped_cycles() > 40000);
+}
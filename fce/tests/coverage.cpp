@@ -0,0 +1,116 @@
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <catch2/catch.hpp>
+#include <fce/coverage.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+
+using namespace fce;
+
+namespace {
+
+auto load_program(FlatRamBus& bus) -> void
+{
+    u16 addr = 0x8000;
+    for (auto e : {
+        0xAD, 0x00, 0x90,   // 8000  LDA $9000
+        0x20, 0x10, 0x80,   // 8003  JSR $8010
+        0x4C, 0x00, 0x80,   // 8006  JMP $8000
+    })
+    {
+        bus.set(addr++, u8(e));
+    }
+    addr = 0x8010;
+    for (auto e : {
+        0x8D, 0x00, 0x03,   // 8010  STA $0300
+        0x60,               // 8013  RTS
+        0xA9, 0x00,         // 8014  LDA #$00, never reached
+    })
+    {
+        bus.set(addr++, u8(e));
+    }
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x80);
+}
+
+}  // namespace
+
+TEST_CASE("Coverage", "[coverage]") {
+    FlatRamBus bus;
+    load_program(bus);
+
+    CPU<FlatRamBus, Coverage> cpu{bus};
+    cpu.s(0xFD);
+    cpu.engine(GENERATE(Engine::interpreter, Engine::block_cache, Engine::recompiler));
+    auto& coverage = cpu.tracer();
+    coverage.clear();
+    cpu.run(1000);
+
+    SECTION("Executed") {
+        for (u16 pc : {0x8000, 0x8003, 0x8006, 0x8010, 0x8013}) {
+            REQUIRE(coverage.executed(pc));
+        }
+        REQUIRE_FALSE(coverage.executed(0x8001));
+        REQUIRE_FALSE(coverage.executed(0x8014));
+        REQUIRE(coverage.executed_count() == 5);
+    }
+    SECTION("Data") {
+        REQUIRE(coverage.data(0x9000));
+        REQUIRE_FALSE(coverage.data(0x8001));  // an operand
+        REQUIRE_FALSE(coverage.data(0x0300));  // written only
+    }
+    SECTION("Merge") {
+        Coverage other;
+        other.execute(0x8014);
+        other.read(0x9001);
+        coverage.merge(other);
+
+        REQUIRE(coverage.executed(0x8014));
+        REQUIRE(coverage.data(0x9001));
+        REQUIRE(coverage.executed_count() == 6);
+    }
+    SECTION("Save And Load") {
+        std::stringstream stream;
+        coverage.save(stream);
+        auto const loaded = load_coverage(stream);
+
+        REQUIRE(loaded.executed_count() == coverage.executed_count());
+        REQUIRE(loaded.data_count() == coverage.data_count());
+        for (unsigned addr = 0; addr < 0x10000; addr++) {
+            REQUIRE(loaded.executed(u16(addr)) == coverage.executed(u16(addr)));
+            REQUIRE(loaded.data(u16(addr)) == coverage.data(u16(addr)));
+        }
+
+        std::istringstream garbage{"not coverage at all"};
+        REQUIRE_THROWS_AS(load_coverage(garbage), std::runtime_error);
+        auto truncated = stream.str().substr(0, 100);
+        std::istringstream short_stream{truncated};
+        REQUIRE_THROWS_AS(load_coverage(short_stream), std::runtime_error);
+    }
+    SECTION("Report") {
+        std::ostringstream report;
+        coverage.report(report, cpu.bus().data() + 0x8000, 0x8000, 0x8000);
+        auto const text = report.str();
+
+        REQUIRE(text.find("8000-FFFF  5 instructions, 13 bytes of code") == 0);
+        REQUIRE(text.find("\n8000  #++#++#++.......#++#.....") != std::string::npos);
+        REQUIRE(text.find("\n9000  d...") != std::string::npos);
+        REQUIRE(text.find("\n*\n") != std::string::npos);
+    }
+}
+
+TEST_CASE("Coverage 65C02", "[coverage][variant]") {
+    u8 const image[] = {0x64, 0x10, 0xEA};  // STZ $10; NOP
+    Coverage coverage;
+    coverage.execute(0x8000);
+    coverage.execute(0x8002);
+
+    std::ostringstream nmos;
+    coverage.report(nmos, image, sizeof image, 0x8000);
+    REQUIRE(nmos.str().find("\n8000  #.#\n") != std::string::npos);
+
+    std::ostringstream cmos;
+    coverage.report(cmos, image, sizeof image, 0x8000, true);
+    REQUIRE(cmos.str().find("\n8000  #+#\n") != std::string::npos);
+}
@@ -189,3 +189,121 @@ TEST_CASE("Stack", "[cpu]") {
         REQUIRE(cpu.s() == 0x01);
     }
 }
+
+TEST_CASE("Run", "[cpu]") {
+    auto memory = std::make_shared<fce::Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x80);
+    memory->set(0x8000, 0xE8);  // INX
+    memory->set(0x8001, 0x4C);  // JMP $8000
+    memory->set(0x8002, 0x00);
+    memory->set(0x8003, 0x80);
+
+    fce::CPU cpu{memory};
+    cpu.x(0x00);
+    cpu.i(true);
+
+    auto const old_cycles = cpu.cycles();
+
+    SECTION("Budget") {
+        auto const result = cpu.run(10);
+
+        REQUIRE(result.reason == fce::StopReason::budget);
+        REQUIRE(result.cycles == 10);
+        REQUIRE(cpu.cycles() - old_cycles == 10);
+        REQUIRE(cpu.x() == 2);
+        REQUIRE(cpu.pc() == 0x8000);
+    }
+    SECTION("Overshoot") {
+        auto const result = cpu.run(3);
+
+        REQUIRE(result.reason == fce::StopReason::budget);
+        REQUIRE(result.cycles == 5);
+        REQUIRE(cpu.pc() == 0x8000);
+    }
+    SECTION("Breakpoint") {
+        auto const result = cpu.run_until(1000, [](fce::Registers const& r) {
+            return r.x == 3 && r.pc == 0x8001;
+        });
+
+        REQUIRE(result.reason == fce::StopReason::breakpoint);
+        REQUIRE(result.cycles == 12);
+        REQUIRE(cpu.x() == 3);
+        REQUIRE(cpu.pc() == 0x8001);
+    }
+    SECTION("Interrupt") {
+        memory->set(0xFFFA, 0x00);
+        memory->set(0xFFFB, 0x90);
+        cpu.s(0xFD);
+
+        cpu.nmi();
+        auto const result = cpu.run(7);
+
+        REQUIRE(result.reason == fce::StopReason::budget);
+        REQUIRE(result.cycles == 7);
+        REQUIRE(cpu.pc() == 0x9000);
+        REQUIRE(cpu.i());
+        REQUIRE(memory->get(0x01FD) == 0x80);
+        REQUIRE(memory->get(0x01FC) == 0x00);
+        REQUIRE(cpu.s() == 0xFA);
+    }
+}
+
+TEST_CASE("Interrupts", "[cpu]") {
+    auto memory = std::make_shared<fce::Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x80);
+    memory->set(0xFFFA, 0x00);  // NMI
+    memory->set(0xFFFB, 0x90);
+    memory->set(0xFFFE, 0x00);  // IRQ
+    memory->set(0xFFFF, 0xA0);
+    memory->set(0x8000, 0xEA);  // NOP
+    memory->set(0x8001, 0xEA);  // NOP
+    memory->set(0x9000, 0xEA);  // NOP
+
+    fce::CPU cpu{memory};
+    cpu.s(0xFD);
+    cpu.p(0x00);
+
+    auto const old_cycles = cpu.cycles();
+
+    SECTION("NMI") {
+        cpu.i(true);
+        cpu.nmi();
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0x9000);
+        REQUIRE(cpu.cycles() - old_cycles == 7);
+        REQUIRE(memory->get(0x01FB) == 0x04);
+
+        cpu.step();
+        REQUIRE(cpu.pc() == 0x9001);
+    }
+    SECTION("IRQ") {
+        cpu.irq(true);
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0xA000);
+        REQUIRE(cpu.cycles() - old_cycles == 7);
+        REQUIRE(memory->get(0x01FB) == 0x00);
+        REQUIRE(cpu.i());
+    }
+    SECTION("IRQ Masked") {
+        cpu.i(true);
+        cpu.irq(true);
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0x8001);
+    }
+    SECTION("Run Stops") {
+        memory->set(0x8001, 0x58);  // CLI
+        cpu.i(true);
+        cpu.irq(true);
+
+        auto const result = cpu.run(100);
+
+        REQUIRE(result.reason == fce::StopReason::interrupt);
+        REQUIRE(cpu.pc() == 0x8002);
+        REQUIRE(!cpu.i());
+    }
+}
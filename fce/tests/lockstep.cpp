@@ -0,0 +1,98 @@
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/lockstep.hpp>
+
+using namespace fce;
+
+namespace {
+
+// Sums $01 $00 times into $02, then spins: lanes with different inputs
+// branch apart and meet again at the loop and the spin.
+auto load_program(FlatRamBus& bus, u8 count, u8 addend) -> void
+{
+    u16 addr = 0x0200;
+    for (auto e : {
+        0xA6, 0x00,         // 0200  LDX $00
+        0xA9, 0x00,         // 0202  LDA #$00
+        0x18,               // 0204  CLC
+        0x65, 0x01,         // 0205  ADC $01
+        0xCA,               // 0207  DEX
+        0xF0, 0x03,         // 0208  BEQ $020D
+        0x4C, 0x04, 0x02,   // 020A  JMP $0204
+        0x85, 0x02,         // 020D  STA $02
+        0x4C, 0x0F, 0x02,   // 020F  JMP $020F
+    })
+    {
+        bus.set(addr++, u8(e));
+    }
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x02);
+    bus.set(0x0000, count);
+    bus.set(0x0001, addend);
+}
+
+}  // namespace
+
+TEST_CASE("Lockstep", "[lockstep]") {
+    // the kernels, if the CPU has them, and the scalar handlers
+    auto const simd = GENERATE(detect_simd(), Simd::none);
+    Lockstep<16> lockstep{simd};
+    std::vector<CPU<FlatRamBus>> references;
+    auto const diverge = GENERATE(false, true);
+
+    for (std::size_t lane = 0; lane < lockstep.lanes(); lane++) {
+        FlatRamBus bus;
+        load_program(bus, diverge ? u8(lane + 1) : 5, u8(lane * 3 + 1));
+        references.emplace_back(bus);
+
+        auto& cpu = references.back();
+        cpu.engine(Engine::interpreter);
+        cpu.a(0x00);
+        cpu.x(0x00);
+        cpu.y(0x00);
+        cpu.p(0x00);
+        lockstep.state(lane, cpu.state());
+        lockstep.load(lane, cpu.bus().data());
+    }
+
+    SECTION("Same Results As CPU") {
+        lockstep.run(1000);
+
+        std::vector<u8> ram(0x10000);
+        for (std::size_t lane = 0; lane < lockstep.lanes(); lane++) {
+            auto& cpu = references[lane];
+            cpu.run(1000);
+
+            auto const state = lockstep.state(lane);
+            REQUIRE(state.cycles == cpu.cycles());
+            REQUIRE(state.pc == cpu.pc());
+            REQUIRE(state.a == cpu.a());
+            REQUIRE(state.x == cpu.x());
+            REQUIRE(state.p == cpu.p());
+            lockstep.save(lane, ram.data());
+            REQUIRE(std::memcmp(ram.data(), cpu.bus().data(), 0x10000) == 0);
+        }
+        REQUIRE(lockstep.get(3, 0x0002) == u8((diverge ? 4 : 5) * 10));
+    }
+    SECTION("Lanes Run Together") {
+        lockstep.run(1000);
+
+        if (diverge) {
+            REQUIRE(lockstep.executed() < lockstep.dispatches() * lockstep.lanes());
+        } else {
+            REQUIRE(lockstep.executed() == lockstep.dispatches() * lockstep.lanes());
+        }
+    }
+    SECTION("Masked Lanes") {
+        auto const before = lockstep.state(1);
+        lockstep.run(100, 0b101);
+
+        REQUIRE(lockstep.state(0).cycles >= before.cycles + 100);
+        REQUIRE(lockstep.state(2).cycles >= before.cycles + 100);
+        REQUIRE(lockstep.state(1).cycles == before.cycles);
+        REQUIRE(lockstep.state(1).pc == before.pc);
+    }
+}
@@ -0,0 +1,9 @@
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+#include <fce/cpu.hpp>
+
+int main(int argc, char *argv[])
+{
+    fce::default_engine(fce::Engine::recompiler);
+    return Catch::Session().run(argc, argv);
+}
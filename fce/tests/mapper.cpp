@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/bus.hpp>
+#include <fce/cpu.hpp>
+#include <fce/mapper.hpp>
+#include <fce/rom.hpp>
+#include <fce/scheduler.hpp>
+
+using namespace fce;
+
+namespace {
+
+constexpr char const *path = "fce-tests-mapper.nes";
+
+// A ROM for `mapper` with the PRG ROM `prg`, a multiple of 16 KiB, and `chr`
+// 8 KiB banks, whose every byte holds the number of its 1 KiB CHR bank.
+auto open_rom(u8 mapper, std::vector<u8> const& prg, u8 chr) -> Rom
+{
+    std::ofstream file{path, std::ios::binary};
+    std::vector<u8> header = {'N', 'E', 'S', 0x1A, u8(prg.size() / 0x4000), chr, u8(mapper << 4 | 0x01), 0x00};
+    header.resize(Rom::header_size);
+    file.write(reinterpret_cast<char const *>(header.data()), std::streamsize(header.size()));
+    file.write(reinterpret_cast<char const *>(prg.data()), std::streamsize(prg.size()));
+    for (std::size_t i = 0; i < chr * std::size_t{0x2000}; i++) {
+        file.put(char(i / 0x400));
+    }
+    file.close();
+
+    Rom rom{path};
+    std::remove(path);
+    return rom;
+}
+
+// The same with `prg` 16 KiB banks, whose every byte holds the number of its
+// 8 KiB bank.
+auto open_rom(u8 mapper, u8 prg, u8 chr) -> Rom
+{
+    std::vector<u8> data(prg * std::size_t{0x4000});
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = u8(i / 0x2000);
+    }
+    return open_rom(mapper, data, chr);
+}
+
+// Writes `v` to an MMC1 register a bit at a time.
+auto mmc1_write(Mapper& mapper, u16 addr, u8 v) -> void
+{
+    for (unsigned i = 0; i < 5; i++) {
+        mapper.set(addr, u8(v >> i & 1));
+    }
+}
+
+}  // namespace
+
+TEST_CASE("NROM", "[mapper]") {
+    auto const rom = open_rom(0, 1, 1);
+    auto const mapper = make_mapper(rom);
+
+    REQUIRE(mapper->get(0x8000) == 0);
+    REQUIRE(mapper->get(0xA000) == 1);
+    REQUIRE(mapper->get(0xC000) == 0);  // 16 KiB are mirrored
+    REQUIRE(mapper->chr_get(0x1C00) == 7);
+    REQUIRE(mapper->mirroring() == Mirroring::vertical);
+
+    mapper->set(0x8000, 0x55);
+    REQUIRE(mapper->get(0x8000) == 0);
+    mapper->set(0x6000, 0x55);  // PRG RAM
+    REQUIRE(mapper->get(0x6000) == 0x55);
+    mapper->chr_set(0x0000, 0x55);
+    REQUIRE(mapper->chr_get(0x0000) == 0);
+}
+
+TEST_CASE("UxROM", "[mapper]") {
+    auto const rom = open_rom(2, 8, 0);
+    auto const mapper = make_mapper(rom);
+
+    REQUIRE(mapper->get(0x8000) == 0);
+    REQUIRE(mapper->get(0xC000) == 14);
+
+    mapper->set(0x8000, 3);
+    REQUIRE(mapper->get(0x8000) == 6);
+    REQUIRE(mapper->get(0xA000) == 7);
+    REQUIRE(mapper->get(0xFFFF) == 15);
+
+    // CHR RAM
+    mapper->chr_set(0x1234, 0x55);
+    REQUIRE(mapper->chr_get(0x1234) == 0x55);
+}
+
+TEST_CASE("UxROM Bank Switch Under Cached Code", "[mapper]") {
+    // every switchable bank has a subroutine at $8000 returning its number
+    std::vector<u8> prg(4 * 0x4000);
+    for (u8 bank = 0; bank < 3; bank++) {
+        u8 const subroutine[] = {0xA9, bank, 0x60};  // LDA #bank; RTS
+        std::copy(std::begin(subroutine), std::end(subroutine), prg.begin() + bank * 0x4000);
+    }
+    u8 const program[] = {
+        0x20, 0x00, 0x80,  // C000  JSR $8000
+        0x85, 0x00,        // C003  STA $00
+        0xA9, 0x01,        // C005  LDA #$01
+        0x8D, 0x00, 0xC1,  // C007  STA $C100, a page without code
+        0x20, 0x00, 0x80,  // C00A  JSR $8000
+        0x85, 0x01,        // C00D  STA $01
+        0x4C, 0x0F, 0xC0,  // C00F  JMP $C00F
+    };
+    std::copy(std::begin(program), std::end(program), prg.begin() + 3 * 0x4000);
+    prg[0xFFFC] = 0x00;
+    prg[0xFFFD] = 0xC0;
+
+    auto const rom = open_rom(2, prg, 0);
+    auto const mapper = make_mapper(rom);
+    std::vector<u8> ram(0x800, 0xFF);
+    Bus bus;
+    bus.map_ram(0x00, 0x07, ram.data(), ram.size());
+    bus.map_io(0x80, 0xFF, mapper);
+
+    CPU<Bus> cpu{bus};
+    cpu.engine(GENERATE(Engine::interpreter, Engine::block_cache, Engine::recompiler));
+    mapper->on_remap([&](u8 first, u8 last) { cpu.invalidate_code(first, last); });
+    cpu.run(200);
+
+    REQUIRE(cpu.pc() == 0xC00F);
+    REQUIRE(ram[0x00] == 0);
+    REQUIRE(ram[0x01] == 1);
+}
+
+TEST_CASE("CNROM", "[mapper]") {
+    auto const rom = open_rom(3, 2, 4);
+    auto const mapper = make_mapper(rom);
+
+    mapper->set(0x8000, 2);
+    REQUIRE(mapper->chr_get(0x0000) == 16);
+    REQUIRE(mapper->chr_get(0x1FFF) == 23);
+    REQUIRE(mapper->get(0xC000) == 2);
+}
+
+TEST_CASE("MMC1", "[mapper]") {
+    auto const rom = open_rom(1, 8, 4);
+    auto const mapper = make_mapper(rom);
+
+    // powers on with the last bank fixed at $C000
+    REQUIRE(mapper->get(0xC000) == 14);
+
+    SECTION("PRG Modes") {
+        mmc1_write(*mapper, 0xE000, 2);
+        REQUIRE(mapper->get(0x8000) == 4);
+        REQUIRE(mapper->get(0xC000) == 14);
+
+        mmc1_write(*mapper, 0x8000, 0x08);  // fixed first, switched $C000
+        REQUIRE(mapper->get(0x8000) == 0);
+        REQUIRE(mapper->get(0xC000) == 4);
+
+        mmc1_write(*mapper, 0x8000, 0x00);  // 32 KiB
+        REQUIRE(mapper->get(0x8000) == 4);
+        REQUIRE(mapper->get(0xE000) == 7);
+    }
+    SECTION("CHR And Mirroring") {
+        mmc1_write(*mapper, 0x8000, 0x1F);  // 4 KiB CHR, horizontal
+        mmc1_write(*mapper, 0xA000, 3);
+        mmc1_write(*mapper, 0xC000, 6);
+        REQUIRE(mapper->chr_get(0x0000) == 12);
+        REQUIRE(mapper->chr_get(0x1000) == 24);
+        REQUIRE(mapper->mirroring() == Mirroring::horizontal);
+
+        mmc1_write(*mapper, 0x8000, 0x00);
+        REQUIRE(mapper->mirroring() == Mirroring::single_lower);
+    }
+    SECTION("Reset") {
+        mapper->set(0x8000, 1);
+        mapper->set(0x8000, 1);
+        mapper->set(0x8000, 0x80);
+        mmc1_write(*mapper, 0xE000, 1);
+        REQUIRE(mapper->get(0x8000) == 2);
+    }
+}
+
+TEST_CASE("MMC1 512 KiB", "[mapper]") {
+    auto const rom = open_rom(1, 32, 1);
+    auto const mapper = make_mapper(rom);
+
+    // the last bank of the lower 256 KiB, as the outer bank is 0
+    REQUIRE(mapper->get(0xC000) == 30);
+    mmc1_write(*mapper, 0xE000, 2);
+    REQUIRE(mapper->get(0x8000) == 4);
+
+    mmc1_write(*mapper, 0xA000, 0x10);  // the upper half
+    REQUIRE(mapper->get(0x8000) == 36);
+    REQUIRE(mapper->get(0xC000) == 62);
+}
+
+TEST_CASE("MMC3", "[mapper]") {
+    auto const rom = open_rom(4, 8, 8);
+    auto const mapper = make_mapper(rom);
+
+    SECTION("PRG Banks") {
+        mapper->set(0x8000, 6);
+        mapper->set(0x8001, 3);
+        mapper->set(0x8000, 7);
+        mapper->set(0x8001, 5);
+        REQUIRE(mapper->get(0x8000) == 3);
+        REQUIRE(mapper->get(0xA000) == 5);
+        REQUIRE(mapper->get(0xC000) == 14);
+        REQUIRE(mapper->get(0xE000) == 15);
+
+        mapper->set(0x8000, 0x40);
+        REQUIRE(mapper->get(0x8000) == 14);
+        REQUIRE(mapper->get(0xC000) == 3);
+    }
+    SECTION("CHR Banks") {
+        mapper->set(0x8000, 0);
+        mapper->set(0x8001, 10);
+        mapper->set(0x8000, 2);
+        mapper->set(0x8001, 33);
+        REQUIRE(mapper->chr_get(0x0000) == 10);
+        REQUIRE(mapper->chr_get(0x0400) == 11);
+        REQUIRE(mapper->chr_get(0x1000) == 33);
+
+        mapper->set(0x8000, 0x80);
+        REQUIRE(mapper->chr_get(0x1000) == 10);
+        REQUIRE(mapper->chr_get(0x0000) == 33);
+    }
+    SECTION("Mirroring") {
+        mapper->set(0xA000, 1);
+        REQUIRE(mapper->mirroring() == Mirroring::horizontal);
+    }
+    SECTION("IRQ") {
+        Scheduler scheduler;
+        u64 now = 0;
+        std::vector<bool> lines;
+        mapper->attach(scheduler, [&] { return now; }, [&](bool line) { lines.push_back(line); });
+
+        mapper->set(0xC000, 9);
+        mapper->set(0xC001, 0);
+        mapper->set(0xE001, 0);
+        REQUIRE_FALSE(scheduler.pending(Event::irq));
+
+        // clocked at dot 100 and every line after it: the counter is
+        // reloaded at the first clock and 0 nine clocks later
+        mapper->frame(100, 240);
+        auto const due = (100 + 9 * Mapper::dots_per_line) / 3;
+        REQUIRE(scheduler.next() == due);
+
+        now = due;
+        scheduler.dispatch(now);
+        REQUIRE(lines == std::vector<bool>{true});
+        REQUIRE(scheduler.next() == (100 + 19 * Mapper::dots_per_line) / 3);
+
+        now += 10;
+        mapper->set(0xE000, 0);
+        REQUIRE(lines == std::vector<bool>{true, false});
+        REQUIRE_FALSE(scheduler.pending(Event::irq));
+
+        // no IRQ past the end of the frame
+        mapper->set(0xE001, 0);
+        mapper->frame(0, 5);
+        REQUIRE_FALSE(scheduler.pending(Event::irq));
+    }
+}
+
+TEST_CASE("Unsupported Mapper", "[mapper]") {
+    auto const rom = open_rom(5, 1, 1);
+    REQUIRE_THROWS_AS(make_mapper(rom), std::runtime_error);
+}
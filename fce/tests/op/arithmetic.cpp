@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -10,7 +11,7 @@ TEST_CASE("ADC", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -150,7 +151,7 @@ TEST_CASE("SBC", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -290,7 +291,7 @@ TEST_CASE("CMP", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -436,7 +437,7 @@ TEST_CASE("CPX", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -503,7 +504,7 @@ TEST_CASE("CPY", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -10,12 +11,14 @@ TEST_CASE("Branch", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x06);
     memory->set(0xFFFD, 0x00);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const [offset, success, pc, cycles] = GENERATE(table<u8, bool, u16, u16>({
         { 0x50, false, 0x0008, 2 },
         { 0x50, true,  0x0058, 3 },
-        { 0xF8, true,  0x0100, 4 },
+        { 0x7F, true,  0x0087, 3 },
+        { 0xFE, true,  0x0006, 3 },  // to itself
+        { 0xF0, true,  0xFFF8, 4 },
     }));
 
     memory->set(0x0007, offset);
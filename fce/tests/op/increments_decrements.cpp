@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -10,7 +11,7 @@ TEST_CASE("INC", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -95,7 +96,7 @@ TEST_CASE("INX", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -133,7 +134,7 @@ TEST_CASE("INY", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -171,7 +172,7 @@ TEST_CASE("DEC", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -256,7 +257,7 @@ TEST_CASE("DEX", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -294,7 +295,7 @@ TEST_CASE("DEY", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -9,7 +10,7 @@ TEST_CASE("LDA", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -139,7 +140,7 @@ TEST_CASE("LDX", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -222,7 +223,7 @@ TEST_CASE("LDY", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -305,7 +306,7 @@ TEST_CASE("STA", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -436,7 +437,7 @@ TEST_CASE("STX", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -497,7 +498,7 @@ TEST_CASE("STY", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -10,7 +11,7 @@ TEST_CASE("AND", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -143,7 +144,7 @@ TEST_CASE("EOR", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -276,7 +277,7 @@ TEST_CASE("ORA", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -409,7 +410,7 @@ TEST_CASE("BIT", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -9,7 +10,7 @@ TEST_CASE("TAX", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -45,7 +46,7 @@ TEST_CASE("TAY", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -81,7 +82,7 @@ TEST_CASE("TXA", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -117,7 +118,7 @@ TEST_CASE("TYA", "[cpu][instruction]") {
     auto memory = std::make_shared<Memory>();
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
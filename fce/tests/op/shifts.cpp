@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -10,7 +11,7 @@ TEST_CASE("ASL", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -108,7 +109,7 @@ TEST_CASE("LSR", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -208,7 +209,7 @@ TEST_CASE("ROL", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -306,7 +307,7 @@ TEST_CASE("ROR", "[cpu][instruction]") {
     memory->set(0xFFFC, 0x00);
     memory->set(0xFFFD, 0x80);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -12,7 +13,7 @@ TEST_CASE("PHA/PLA", "[cpu][instruction]") {
     memory->set(0x8000, 0x48);  // PHA
     memory->set(0x8001, 0x68);  // PLA
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -53,7 +54,7 @@ TEST_CASE("PHP/PLP", "[cpu][instruction]") {
     memory->set(0x8000, 0x08);  // PHP
     memory->set(0x8001, 0x28);  // PLP
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
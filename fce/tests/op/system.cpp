@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 #include <fce/cpu.hpp>
 #include <fce/memory.hpp>
+#include "test_cpu.hpp"
 
 using namespace fce;
 
@@ -11,7 +12,7 @@ TEST_CASE("NOP", "[cpu][instruction]") {
     memory->set(0xFFFD, 0x80);
     memory->set(0x8000, 0xEA);
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = cpu.p();
@@ -32,7 +33,7 @@ TEST_CASE("BRK/RTI", "[cpu][instruction]") {
     memory->set(0xFFFF, 0xAB);
     memory->set(0xABCD, 0x40);  // RTI
 
-    auto cpu = CPU{memory};
+    auto cpu = TestCPU{memory};
 
     auto const old_cycles = cpu.cycles();
     u8 const old_p = 0x36;
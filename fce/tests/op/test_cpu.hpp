@@ -0,0 +1,110 @@
+#ifndef FCE_TESTS_OP_TEST_CPU_HPP_
+#define FCE_TESTS_OP_TEST_CPU_HPP_
+
+#include <memory>
+#include <fce/cpu.hpp>
+#include <fce/memory.hpp>
+
+#if defined(FCE_TEST_LOCKSTEP)
+
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/lockstep.hpp>
+
+// The part of the CPU interface the instruction tests use, stepping every
+// lane of a Lockstep. Even lanes run the test, and must agree; odd lanes
+// sit at another PC further ahead, and must be left alone.
+class LockstepCPU
+{
+public:
+    explicit LockstepCPU(std::shared_ptr<fce::Memory> memory)
+        : memory_{std::move(memory)}, lockstep_{std::make_unique<fce::Lockstep<8>>()}, state_{}
+    {
+        // as CPU::reset()
+        state_.s = 0xFA;
+        state_.pc = fce::u16(memory_->get(0xFFFD) << 8 | memory_->get(0xFFFC));
+        state_.cycles = 2;
+    }
+
+    auto step() -> void
+    {
+        auto idle = state_;
+        idle.pc ^= 0x4000;
+        idle.cycles += 1000;
+        idle.a = fce::u8(~idle.a);
+
+        for (std::size_t lane = 0; lane < lockstep_->lanes(); lane++) {
+            lockstep_->load(lane, memory_->data());
+            lockstep_->state(lane, lane % 2 ? idle : state_);
+        }
+
+        REQUIRE(lockstep_->step() == 0x55);
+
+        auto const state = lockstep_->state(0);
+        std::vector<fce::u8> ram(0x10000);
+        std::vector<fce::u8> lane_ram(0x10000);
+        lockstep_->save(0, ram.data());
+        for (std::size_t lane = 0; lane < lockstep_->lanes(); lane++) {
+            auto const expected = lane % 2 ? idle : state;
+            auto const actual = lockstep_->state(lane);
+            REQUIRE(actual.cycles == expected.cycles);
+            REQUIRE(actual.pc == expected.pc);
+            REQUIRE(actual.a == expected.a);
+            REQUIRE(actual.x == expected.x);
+            REQUIRE(actual.y == expected.y);
+            REQUIRE(actual.s == expected.s);
+            REQUIRE(actual.p == expected.p);
+
+            lockstep_->save(lane, lane_ram.data());
+            REQUIRE(std::memcmp(lane_ram.data(), lane % 2 ? memory_->data() : ram.data(), 0x10000) == 0);
+        }
+
+        state_ = state;
+        std::memcpy(memory_->data(), ram.data(), 0x10000);
+    }
+
+    auto cycles() const noexcept -> fce::u64 { return state_.cycles; }
+
+#define MAKE_REGISTER(type, name)                               \
+    auto name() const noexcept -> type { return state_.name; }  \
+    auto name(type v) noexcept -> void { state_.name = v; }
+
+    MAKE_REGISTER(fce::u8, a)
+    MAKE_REGISTER(fce::u8, x)
+    MAKE_REGISTER(fce::u8, y)
+    MAKE_REGISTER(fce::u8, s)
+    MAKE_REGISTER(fce::u8, p)
+    MAKE_REGISTER(fce::u16, pc)
+
+#undef MAKE_REGISTER
+
+#define MAKE_FLAG(n, name)                                                                    \
+    auto name() const noexcept -> bool { return state_.p & (1u << n); }                       \
+    auto name(bool v) noexcept -> void { state_.p = fce::u8((state_.p & ~(1u << n)) | (unsigned(v) << n)); }
+
+    MAKE_FLAG(0, c)
+    MAKE_FLAG(1, z)
+    MAKE_FLAG(2, i)
+    MAKE_FLAG(3, d)
+    MAKE_FLAG(4, b)
+    MAKE_FLAG(6, v)
+    MAKE_FLAG(7, n)
+
+#undef MAKE_FLAG
+
+private:
+    std::shared_ptr<fce::Memory> memory_;
+    std::unique_ptr<fce::Lockstep<8>> lockstep_;
+    fce::CpuState state_;
+};
+
+using TestCPU = LockstepCPU;
+
+#else
+
+using TestCPU = fce::CPU<fce::Bus>;
+
+#endif
+
+#endif  // FCE_TESTS_OP_TEST_CPU_HPP_
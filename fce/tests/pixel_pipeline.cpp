@@ -0,0 +1,99 @@
+#include <array>
+#include <random>
+#include <catch2/catch.hpp>
+#include <fce/pixel_pipeline.hpp>
+
+using namespace fce;
+
+namespace {
+
+constexpr auto width = PixelPipeline::width;
+
+struct Line
+{
+    std::array<u8, width> background{};
+    std::array<u8, width> sprite{};
+    std::array<u8, width> behind{};
+    std::array<u8, width> zero{};
+
+    auto pixels() const noexcept -> PixelLine
+    {
+        return {background.data(), sprite.data(), behind.data(), zero.data()};
+    }
+};
+
+}  // namespace
+
+TEST_CASE("Pixel Pipeline", "[pixel_pipeline]") {
+    auto const simd = GENERATE(Simd::none, Simd::sse41, Simd::avx2);
+    if (simd > detect_simd()) {
+        return;
+    }
+    PixelPipeline const pipeline{simd};
+    PixelPipeline const scalar{Simd::none};
+
+    std::array<u8, 32> palette{};
+    for (std::size_t i = 0; i < palette.size(); i++) {
+        palette[i] = u8(i * 2 + 1);
+    }
+
+    SECTION("Matches Scalar") {
+        std::mt19937 random{42};
+        Line line;
+        for (int round = 0; round < 16; round++) {
+            for (std::size_t x = 0; x < width; x++) {
+                // backgrounds are palettes 0-3, sprites 4-7, either maybe clear
+                auto const bits = random();
+                line.background[x] = bits & 1 ? u8(bits >> 1 & 0x0F) : u8(0);
+                line.sprite[x] = bits & 0x20 ? u8(0x10 | (bits >> 6 & 0x0F)) : u8(0);
+                line.behind[x] = bits & 0x400 ? 0x20 : 0;
+                line.zero[x] = (bits >> 11 & 0x3F) == 0;
+            }
+            auto const grey = u8(round & 1 ? 0x30 : 0x3F);
+
+            std::array<u8, width> expected{};
+            std::array<u8, width> actual{};
+            auto const hit = scalar.compose(line.pixels(), palette.data(), grey, expected.data());
+            REQUIRE(pipeline.compose(line.pixels(), palette.data(), grey, actual.data()) == hit);
+            REQUIRE(actual == expected);
+
+            std::array<u32, width> rgba{};
+            pipeline.lookup(actual.data(), nes_colours.data(), rgba.data());
+            for (std::size_t x = 0; x < width; x++) {
+                REQUIRE(rgba[x] == nes_colours[actual[x]]);
+            }
+        }
+    }
+    SECTION("Priorities") {
+        Line line;
+        line.background[1] = 1;
+        line.sprite[1] = 0x11;
+        line.background[2] = 2;
+        line.sprite[2] = 0x12;
+        line.behind[2] = 0x20;
+        line.sprite[3] = 0x13;
+        line.behind[3] = 0x20;
+
+        std::array<u8, width> out{};
+        REQUIRE_FALSE(pipeline.compose(line.pixels(), palette.data(), 0x3F, out.data()));
+        REQUIRE(out[0] == palette[0]);
+        REQUIRE(out[1] == palette[0x11]);
+        REQUIRE(out[2] == palette[2]);
+        REQUIRE(out[3] == palette[0x13]);  // behind nothing
+    }
+    SECTION("Sprite 0 Hit") {
+        Line line;
+        std::array<u8, width> out{};
+        auto const x = GENERATE(std::size_t{0}, std::size_t{17}, std::size_t{254}, std::size_t{255});
+        line.background[x] = 3;
+        line.sprite[x] = 0x13;
+        line.behind[x] = 0x20;
+        line.zero[x] = 1;
+
+        // not at the last column
+        REQUIRE(pipeline.compose(line.pixels(), palette.data(), 0x3F, out.data()) == (x != width - 1));
+
+        line.background[x] = 0;
+        REQUIRE_FALSE(pipeline.compose(line.pixels(), palette.data(), 0x3F, out.data()));
+    }
+}
@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/mapper.hpp>
+#include <fce/ppu.hpp>
+#include <fce/rom.hpp>
+#include <fce/scheduler.hpp>
+
+using namespace fce;
+
+namespace {
+
+constexpr char const *path = "fce-tests-ppu.nes";
+
+// NROM with 8 KiB of CHR RAM
+auto open_rom() -> Rom
+{
+    std::ofstream file{path, std::ios::binary};
+    std::vector<u8> header = {'N', 'E', 'S', 0x1A, 1, 0, 0x00, 0x00};
+    header.resize(Rom::header_size + 0x4000);
+    file.write(reinterpret_cast<char const *>(header.data()), std::streamsize(header.size()));
+    file.close();
+
+    Rom rom{path};
+    std::remove(path);
+    return rom;
+}
+
+auto write_vram(Ppu& ppu, u16 addr, std::initializer_list<u8> bytes) -> void
+{
+    ppu.set(0x2006, u8(addr >> 8));
+    ppu.set(0x2006, u8(addr));
+    for (auto b : bytes) {
+        ppu.set(0x2007, b);
+    }
+}
+
+// The first CPU cycle of `line` in frame `frame`.
+auto cycle_of(u64 frame, unsigned line) -> u64
+{
+    return (frame * Ppu::dots_per_frame + line * Mapper::dots_per_line) / 3 + 1;
+}
+
+}  // namespace
+
+TEST_CASE("PPU", "[ppu]") {
+    auto const rom = open_rom();
+    auto const mapper = make_mapper(rom);
+    Ppu ppu{mapper};
+
+    Scheduler scheduler;
+    u64 now = 0;
+    int nmis = 0;
+    ppu.attach(scheduler, [&] { return now; }, [&] { nmis++; });
+    auto const run_to = [&](u64 cycle) {
+        now = cycle;
+        scheduler.dispatch(now);
+        ppu.catch_up(now);
+    };
+
+    // tile 1 is colour 1 all over, tile 2 colour 3 in its left half
+    write_vram(ppu, 0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    write_vram(ppu, 0x0020, {0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
+                             0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0});
+    write_vram(ppu, 0x3F00, {0x0F, 0x16, 0x27, 0x30});
+    write_vram(ppu, 0x3F11, {0x2A});
+    write_vram(ppu, 0x2000, {1, 0, 2});
+    ppu.set(0x2000, 0x80);  // NMI on
+    ppu.set(0x2005, 0);
+    ppu.set(0x2005, 0);
+    ppu.set(0x2001, 0x1E);  // everything shown
+
+    // the first frame is drawn from wherever the writes left the address
+    SECTION("Background") {
+        run_to(cycle_of(1, 241));
+        auto const pixels = ppu.pixels();
+
+        REQUIRE(ppu.frames() == 2);
+        REQUIRE(nmis == 2);
+        REQUIRE(pixels[0] == 0x16);
+        REQUIRE(pixels[7 * Ppu::width + 7] == 0x16);
+        REQUIRE(pixels[8 * Ppu::width] == 0x0F);  // the row below
+        REQUIRE(pixels[8] == 0x0F);
+        REQUIRE(pixels[16] == 0x30);
+        REQUIRE(pixels[20] == 0x0F);
+    }
+    SECTION("Scroll") {
+        ppu.set(0x2005, 16);
+        ppu.set(0x2005, 0);
+        run_to(cycle_of(1, 241));
+
+        REQUIRE(ppu.pixels()[0] == 0x30);
+        REQUIRE(ppu.pixels()[4] == 0x0F);
+    }
+    SECTION("Tiles Decoded Once") {
+        run_to(cycle_of(3, 241));
+        auto const decoded = ppu.tiles().decoded();
+        REQUIRE(decoded <= 3);
+
+        // CHR RAM writes make the tile stale
+        run_to(cycle_of(3, 250));
+        write_vram(ppu, 0x0010, {0x00});
+        ppu.set(0x2005, 0);
+        ppu.set(0x2005, 0);
+        run_to(cycle_of(4, 241));
+        REQUIRE(ppu.tiles().decoded() == decoded + 1);
+        REQUIRE(ppu.pixels()[0] == 0x0F);
+        REQUIRE(ppu.pixels()[Ppu::width] == 0x16);
+    }
+    SECTION("Sprites And VBlank") {
+        u8 page[256] = {};
+        for (unsigned i = 4; i < 256; i++) {
+            page[i] = 0xFF;  // off the bottom of the screen
+        }
+        page[0] = 0;   // on line 1
+        page[1] = 1;
+        page[2] = 0x00;
+        page[3] = 2;
+        ppu.set(0x2003, 0);
+        ppu.oam_dma(page);
+
+        run_to(cycle_of(1, 10));
+        REQUIRE(ppu.pixels()[Ppu::width + 2] == 0x2A);
+        REQUIRE(ppu.pixels()[Ppu::width + 1] == 0x16);
+        REQUIRE(ppu.pixels()[2] == 0x16);
+        REQUIRE((ppu.get(0x2002) & 0xC0) == 0x40);  // sprite 0 hit
+
+        run_to(cycle_of(1, 242));
+        REQUIRE((ppu.get(0x2002) & 0xC0) == 0xC0);
+        REQUIRE((ppu.get(0x3FFA) & 0x80) == 0x00);  // cleared by reading
+
+        run_to(cycle_of(2, 0));
+        REQUIRE((ppu.get(0x2002) & 0x40) == 0x00);
+    }
+    SECTION("Rendering Off") {
+        ppu.set(0x2001, 0x00);
+        run_to(cycle_of(1, 241));
+        REQUIRE(ppu.pixels()[0] == 0x0F);
+        REQUIRE(ppu.tiles().decoded() == 0);
+    }
+}
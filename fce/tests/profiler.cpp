@@ -0,0 +1,91 @@
+#include <sstream>
+#include <string>
+#include <catch2/catch.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/profiler.hpp>
+#include <fce/variant.hpp>
+
+using namespace fce;
+
+TEST_CASE("Profiler", "[profiler]") {
+    FlatRamBus bus;
+    u16 addr = 0x8000;
+    for (auto e : {
+        0xE8,               // 8000  INX
+        0x20, 0x10, 0x80,   // 8001  JSR $8010
+        0x4C, 0x00, 0x80,   // 8004  JMP $8000
+    })
+    {
+        bus.set(addr++, u8(e));
+    }
+    addr = 0x8010;
+    for (auto e : {
+        0x8D, 0x00, 0x03,   // 8010  STA $0300
+        0x60,               // 8013  RTS
+    })
+    {
+        bus.set(addr++, u8(e));
+    }
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x80);
+
+    // 2 + 6 + 3 + 4 + 6 cycles a round
+    CPU<FlatRamBus, Profiler> cpu{bus};
+    cpu.s(0xFD);
+    cpu.engine(GENERATE(Engine::interpreter, Engine::block_cache));
+    auto& profiler = cpu.tracer();
+    profiler.clear();
+    cpu.run(21 * 100);
+    cpu.run(1);  // charges the last instruction
+
+    SECTION("Instructions And Cycles") {
+        REQUIRE(profiler.instructions(0x8000) == 101);
+        REQUIRE(profiler.instructions(0x8010) == 100);
+        REQUIRE(profiler.cycles(0x8001) == 6 * 100);
+        REQUIRE(profiler.cycles(0x8013) == 6 * 100);
+        REQUIRE(profiler.opcode_instructions(0x8D) == 100);
+        REQUIRE(profiler.opcode_cycles(0x8D) == 4 * 100);
+    }
+    SECTION("Pages") {
+        REQUIRE(profiler.writes(0x03) == 100);
+        REQUIRE(profiler.reads(0x03) == 0);
+        REQUIRE(profiler.writes(0x01) == 200);
+        REQUIRE(profiler.reads(0x01) == 200);
+        REQUIRE(profiler.reads(0x80) == 100 * (1 + 3 + 3 + 3 + 1) + 1);
+    }
+    SECTION("Report") {
+        std::ostringstream report;
+        profiler.report(report, 3);
+        auto const text = report.str();
+
+        REQUIRE(text.find("501 instructions") != std::string::npos);
+        REQUIRE(text.find("8001  JSR") != std::string::npos);
+        REQUIRE(text.find("8000  INX") == std::string::npos);
+    }
+    SECTION("Collapsed Stacks") {
+        std::ostringstream stacks;
+        profiler.collapsed(stacks);
+
+        REQUIRE(stacks.str() == "root 1100\nroot;8010 1000\n");
+    }
+}
+
+TEST_CASE("Profiler 65C02", "[profiler][variant]") {
+    FlatRamBus bus;
+    bus.set(0x8000, 0x64);  // STZ $10
+    bus.set(0x8001, 0x10);
+    bus.set(0x8002, 0x80);  // BRA $8000
+    bus.set(0x8003, 0xFC);
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x80);
+
+    CPU<FlatRamBus, Profiler, Wdc65C02> cpu{bus};
+    cpu.run(60);
+    std::ostringstream report;
+    cpu.tracer().report(report, 2);
+    auto const text = report.str();
+
+    REQUIRE(text.find("8000  STZ") != std::string::npos);
+    REQUIRE(text.find("80 BRA") != std::string::npos);
+}
@@ -0,0 +1,115 @@
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/cpu.hpp>
+#include <fce/memory.hpp>
+#include <fce/rewind.hpp>
+#include <fce/savestate.hpp>
+
+using namespace fce;
+
+TEST_CASE("Rewind", "[rewind]") {
+    auto memory = std::make_shared<Memory>();
+    // noise, so that keyframes are about as large as they get
+    for (int i = 0; i < 0x10000; i++) {
+        memory->set(u16(i), u8(i * 131 + (i >> 8) + 1));
+    }
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x02);
+    memory->set(0x0200, 0xE8);  // INX
+    memory->set(0x0201, 0xE6);  // INC $10
+    memory->set(0x0202, 0x10);
+    memory->set(0x0203, 0x96);  // STX $20,Y
+    memory->set(0x0204, 0x20);
+    memory->set(0x0205, 0xC8);  // INY
+    memory->set(0x0206, 0x4C);  // JMP $0200
+    memory->set(0x0207, 0x00);
+    memory->set(0x0208, 0x02);
+
+    CPU cpu{memory};
+    cpu.x(0x00);
+    cpu.y(0x00);
+
+    // frames pushed so far, for reference
+    std::vector<std::unique_ptr<Savestate>> frames;
+    auto const run = [&](Rewind& rewind, int count) {
+        for (int i = 0; i < count; i++) {
+            cpu.run(200);
+            rewind.push(cpu, *memory);
+            frames.push_back(std::make_unique<Savestate>());
+            capture(cpu, *memory, *frames.back());
+        }
+    };
+    auto const matches = [](Savestate const& a, Savestate const& b) {
+        return a.cpu.cycles == b.cpu.cycles && a.cpu.pc == b.cpu.pc && a.cpu.x == b.cpu.x && a.memory == b.memory;
+    };
+
+    auto const state = std::make_unique<Savestate>();
+
+    SECTION("Peek") {
+        Rewind rewind{std::size_t{1} << 20, 8};
+        run(rewind, 30);
+        REQUIRE(rewind.size() == 30);
+
+        for (std::size_t back = 0; back < 30; back++) {
+            REQUIRE(rewind.peek(back, *state));
+            REQUIRE(matches(*state, *frames[29 - back]));
+        }
+        REQUIRE_FALSE(rewind.peek(30, *state));
+    }
+    SECTION("Rewind And Continue") {
+        Rewind rewind{std::size_t{1} << 20, 8};
+        run(rewind, 30);
+
+        REQUIRE(rewind.rewind(12, *state));
+        REQUIRE(rewind.size() == 18);
+        REQUIRE(matches(*state, *frames[17]));
+
+        restore(cpu, *memory, *state);
+        frames.resize(18);
+        run(rewind, 20);
+        REQUIRE(rewind.size() == 38);
+
+        for (std::size_t back = 0; back < 38; back++) {
+            REQUIRE(rewind.peek(back, *state));
+            REQUIRE(matches(*state, *frames[37 - back]));
+        }
+    }
+    SECTION("Too Far") {
+        Rewind rewind{std::size_t{1} << 20, 8};
+        run(rewind, 5);
+
+        REQUIRE_FALSE(rewind.rewind(5, *state));
+        REQUIRE(rewind.size() == 5);
+        REQUIRE(rewind.rewind(4, *state));
+        REQUIRE(matches(*state, *frames[0]));
+    }
+    SECTION("Oldest Frames Dropped") {
+        Rewind rewind{0, 4};
+        run(rewind, 500);
+
+        REQUIRE(rewind.size() > 4);
+        REQUIRE(rewind.size() < 500);
+        REQUIRE(rewind.memory_usage() <= rewind.capacity());
+        for (std::size_t back = 0; back < rewind.size(); back++) {
+            REQUIRE(rewind.peek(back, *state));
+            REQUIRE(matches(*state, *frames[499 - back]));
+        }
+    }
+    SECTION("Frames Are Small") {
+        Rewind rewind{std::size_t{1} << 20, 60};
+        run(rewind, 120);
+
+        REQUIRE(rewind.size() == 120);
+        REQUIRE(rewind.memory_usage() < 120 * sizeof(Savestate) / 20);
+    }
+    SECTION("Clear") {
+        Rewind rewind;
+        run(rewind, 3);
+        rewind.clear();
+
+        REQUIRE(rewind.size() == 0);
+        REQUIRE(rewind.memory_usage() == 0);
+        REQUIRE_FALSE(rewind.peek(0, *state));
+    }
+}
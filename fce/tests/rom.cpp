@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/memory.hpp>
+#include <fce/rom.hpp>
+
+using namespace fce;
+
+namespace {
+
+constexpr char const *path = "fce-tests-rom.nes";
+
+// A ROM whose PRG byte i is i / 0x400, and CHR byte i is 0x80 | i / 0x400.
+auto write_rom(std::vector<u8> header, std::size_t prg, std::size_t chr) -> void
+{
+    header.resize(Rom::header_size);
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<char const *>(header.data()), std::streamsize(header.size()));
+    if (header[6] & 0x04) {
+        file.write(std::string(Rom::trainer_size, 'T').data(), Rom::trainer_size);
+    }
+    for (std::size_t i = 0; i < prg; i++) {
+        file.put(char(i / 0x400));
+    }
+    for (std::size_t i = 0; i < chr; i++) {
+        file.put(char(0x80 | i / 0x400));
+    }
+}
+
+}  // namespace
+
+TEST_CASE("iNES", "[rom]") {
+    write_rom({'N', 'E', 'S', 0x1A, 2, 1, 0x13, 0x40}, 2 * 0x4000, 0x2000);
+    Rom rom{path};
+
+    REQUIRE(rom.format() == RomFormat::ines);
+    REQUIRE(rom.mapper() == 0x41);
+    REQUIRE(rom.mirroring() == Mirroring::vertical);
+    REQUIRE(rom.battery());
+    REQUIRE(rom.trainer().empty());
+    REQUIRE(rom.prg().size == 0x8000);
+    REQUIRE(rom.chr().size == 0x2000);
+    REQUIRE(rom.prg_ram_size() == 0x2000);
+    REQUIRE(rom.chr_ram_size() == 0);
+
+    SECTION("Banks") {
+        REQUIRE(rom.prg()[0x7FFF] == 0x1F);
+        REQUIRE(rom.chr()[0x0400] == 0x81);
+        REQUIRE(rom.prg_bank(1, 0x4000)[0] == 0x10);
+        REQUIRE(rom.prg_bank(3, 0x4000).data == rom.prg_bank(1, 0x4000).data);
+        REQUIRE(rom.chr_bank(7, 0x400)[0] == 0x87);
+    }
+    SECTION("Moved") {
+        auto const prg = rom.prg().data;
+        Rom moved{std::move(rom)};
+        REQUIRE(moved.prg().data == prg);
+        REQUIRE(moved.prg()[0x4000] == 0x10);
+    }
+    SECTION("Memory") {
+        Memory memory;
+        memory.set(0x8000, 0xAA);
+        memory.map(0x80, 0xFF, rom.prg().data, rom.prg().size);
+
+        REQUIRE(memory.get(0x8000) == 0x00);
+        REQUIRE(memory.get(0xC000) == 0x10);
+        REQUIRE(memory.stable(0xC000));
+        REQUIRE_FALSE(memory.stable(0x2000));
+
+        memory.unmap(0x80, 0xBF);
+        REQUIRE(memory.get(0x8000) == 0xAA);
+    }
+    std::remove(path);
+}
+
+TEST_CASE("iNES Trainer And Junk", "[rom]") {
+    write_rom({'N', 'E', 'S', 0x1A, 1, 0, 0x1C, 0x40, 0, 0, 0, 0, 'D', 'u', 'd', 'e'}, 0x4000, 0);
+    Rom const rom{path};
+
+    REQUIRE(rom.mapper() == 0x01);
+    REQUIRE(rom.mirroring() == Mirroring::four_screen);
+    REQUIRE(rom.trainer().size == Rom::trainer_size);
+    REQUIRE(rom.trainer()[0] == 'T');
+    REQUIRE(rom.prg()[0] == 0x00);
+    REQUIRE(rom.chr().empty());
+    REQUIRE(rom.chr_ram_size() == 0x2000);
+    std::remove(path);
+}
+
+TEST_CASE("NES 2.0", "[rom]") {
+    SECTION("Sizes") {
+        write_rom({'N', 'E', 'S', 0x1A, 0x02, 0x00, 0x40, 0x08, 0x31, 0x10, 0x07, 0x70}, 0x8000, 0x200000);
+        Rom const rom{path};
+
+        REQUIRE(rom.format() == RomFormat::nes2);
+        REQUIRE(rom.mapper() == 0x104);
+        REQUIRE(rom.submapper() == 3);
+        REQUIRE(rom.mirroring() == Mirroring::horizontal);
+        REQUIRE(rom.prg().size == 0x8000);
+        REQUIRE(rom.chr().size == 0x200000);
+        REQUIRE(rom.prg_ram_size() == 0x2000);
+        REQUIRE(rom.chr_ram_size() == 0x2000);
+    }
+    SECTION("Exponent") {
+        // 2^14 * 3 bytes of PRG
+        write_rom({'N', 'E', 'S', 0x1A, 14 << 2 | 1, 0x00, 0x00, 0x08, 0x00, 0x0F}, 0xC000, 0);
+        Rom const rom{path};
+
+        REQUIRE(rom.prg().size == 0xC000);
+        REQUIRE(rom.prg_bank(5, 0x4000)[0] == 0x20);
+    }
+    std::remove(path);
+}
+
+TEST_CASE("Bad ROMs", "[rom]") {
+    SECTION("Missing") {
+        REQUIRE_THROWS_AS(Rom{"fce-tests-missing.nes"}, std::runtime_error);
+    }
+    SECTION("Magic") {
+        write_rom({'N', 'E', 'S', 0x00, 1}, 0x4000, 0);
+        REQUIRE_THROWS_AS(Rom{path}, std::runtime_error);
+    }
+    SECTION("Truncated") {
+        write_rom({'N', 'E', 'S', 0x1A, 2, 1}, 0x4000, 0);
+        REQUIRE_THROWS_AS(Rom{path}, std::runtime_error);
+    }
+    SECTION("Empty") {
+        std::ofstream{path, std::ios::binary}.close();
+        REQUIRE_THROWS_AS(Rom{path}, std::runtime_error);
+    }
+    std::remove(path);
+}
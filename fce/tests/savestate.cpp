@@ -0,0 +1,201 @@
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <catch2/catch.hpp>
+#include <fce/bus.hpp>
+#include <fce/cpu.hpp>
+#include <fce/memory.hpp>
+#include <fce/savestate.hpp>
+
+using namespace fce;
+
+TEST_CASE("Savestate", "[savestate]") {
+    auto memory = std::make_shared<Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x02);
+    memory->set(0x0200, 0xE8);  // INX
+    memory->set(0x0201, 0xE6);  // INC $10
+    memory->set(0x0202, 0x10);
+    memory->set(0x0203, 0x4C);  // JMP $0200
+    memory->set(0x0204, 0x00);
+    memory->set(0x0205, 0x02);
+    memory->set(0x0010, 0x00);
+
+    CPU cpu{memory};
+    cpu.engine(GENERATE(Engine::interpreter, Engine::recompiler));
+    cpu.x(0x00);
+    cpu.run(100);
+
+    auto const state = std::make_unique<Savestate>();
+    capture(cpu, *memory, *state);
+    auto const registers = cpu.registers();
+    auto const cycles = cpu.cycles();
+    auto const counter = memory->get(0x0010);
+
+    cpu.run(100);
+    auto const later = cpu.registers();
+    auto const later_counter = memory->get(0x0010);
+    REQUIRE(later_counter != counter);
+
+    SECTION("Restore") {
+        cpu.nmi();
+        restore(cpu, *memory, *state);
+
+        REQUIRE(cpu.cycles() == cycles);
+        REQUIRE(cpu.pc() == registers.pc);
+        REQUIRE(cpu.x() == registers.x);
+        REQUIRE(memory->get(0x0010) == counter);
+
+        // no NMI was pending when the state was taken
+        auto const result = cpu.run(100);
+        REQUIRE(result.reason == StopReason::budget);
+        REQUIRE(cpu.pc() == later.pc);
+        REQUIRE(cpu.x() == later.x);
+        REQUIRE(memory->get(0x0010) == later_counter);
+    }
+    SECTION("Restore Drops Cached Code") {
+        memory->set(0x0200, 0xC8);  // INY
+        cpu.invalidate_code(0x02, 0x02);
+        cpu.run(100);
+
+        restore(cpu, *memory, *state);
+        cpu.y(0x00);
+        cpu.run(100);
+
+        REQUIRE(cpu.y() == 0x00);
+    }
+    SECTION("Reset To") {
+        restore(cpu, *memory, *state);
+        REQUIRE_FALSE(memory->dirty(0x00));
+
+        cpu.run(100);
+        REQUIRE(memory->dirty(0x00));
+        REQUIRE_FALSE(memory->dirty(0x02));
+
+        reset_to(cpu, *memory, *state);
+        REQUIRE_FALSE(memory->dirty(0x00));
+        REQUIRE(cpu.cycles() == cycles);
+        REQUIRE(cpu.pc() == registers.pc);
+        REQUIRE(memory->get(0x0010) == counter);
+
+        cpu.run(100);
+        REQUIRE(cpu.pc() == later.pc);
+        REQUIRE(cpu.x() == later.x);
+        REQUIRE(memory->get(0x0010) == later_counter);
+    }
+    SECTION("Reset To Drops Cached Code") {
+        restore(cpu, *memory, *state);
+        memory->set(0x0200, 0xC8);  // INY
+        cpu.invalidate_code(0x02, 0x02);
+        cpu.run(100);
+
+        reset_to(cpu, *memory, *state);
+        REQUIRE(memory->get(0x0200) == 0xE8);
+        cpu.y(0x00);
+        cpu.run(100);
+
+        REQUIRE(cpu.y() == 0x00);
+    }
+    SECTION("Save And Load") {
+        auto const compression = GENERATE(Compression::none, Compression::zstd);
+        std::stringstream stream;
+
+        if (!compression_available(compression)) {
+            REQUIRE_THROWS_AS(save_state(stream, *state, compression), std::runtime_error);
+            return;
+        }
+        save_state(stream, *state, compression);
+
+        auto const loaded = std::make_unique<Savestate>();
+        load_state(stream, *loaded);
+        REQUIRE(loaded->cpu.cycles == state->cpu.cycles);
+        REQUIRE(loaded->cpu.pc == state->cpu.pc);
+        REQUIRE(loaded->memory == state->memory);
+    }
+    SECTION("Little Endian") {
+        std::stringstream stream;
+        save_state(stream, *state);
+        auto const bytes = stream.str();
+
+        REQUIRE(bytes.compare(0, 8, "FCESTATE") == 0);
+        REQUIRE(u8(bytes[8]) == Savestate::version);
+        REQUIRE(u8(bytes[24]) == u8(cycles));
+        REQUIRE(u8(bytes[25]) == u8(cycles >> 8));
+        REQUIRE(u8(bytes[32]) == u8(registers.pc));
+        REQUIRE(u8(bytes[33]) == u8(registers.pc >> 8));
+    }
+    SECTION("Not A Savestate") {
+        std::stringstream stream{"FCETRAC1"};
+        REQUIRE_THROWS_AS(load_state(stream, *state), std::runtime_error);
+    }
+    SECTION("Unknown Version") {
+        std::stringstream stream;
+        save_state(stream, *state);
+        auto bytes = stream.str();
+        bytes[8] = char(Savestate::version + 1);
+
+        std::stringstream newer{bytes};
+        REQUIRE_THROWS_AS(load_state(newer, *state), std::runtime_error);
+
+        bytes[8] = 0;
+        std::stringstream none{bytes};
+        REQUIRE_THROWS_AS(load_state(none, *state), std::runtime_error);
+    }
+    SECTION("Truncated") {
+        std::stringstream stream;
+        save_state(stream, *state);
+        auto const bytes = stream.str();
+
+        std::stringstream truncated{bytes.substr(0, bytes.size() - 1)};
+        REQUIRE_THROWS_AS(load_state(truncated, *state), std::runtime_error);
+    }
+}
+
+TEST_CASE("Savestate on Mapped RAM", "[savestate]") {
+    auto memory = std::make_shared<Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x02);
+    memory->set(0x0200, 0xE8);  // INX
+    memory->set(0x0201, 0xE6);  // INC $10
+    memory->set(0x0202, 0x10);
+    memory->set(0x0203, 0x8A);  // TXA
+    memory->set(0x0204, 0x9D);  // STA $0300,X
+    memory->set(0x0205, 0x00);
+    memory->set(0x0206, 0x03);
+    memory->set(0x0207, 0x4C);  // JMP $0200
+    memory->set(0x0208, 0x00);
+    memory->set(0x0209, 0x02);
+
+    // written straight to the cells, not through Memory::set()
+    Bus bus;
+    bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+    CPU cpu{bus};
+    cpu.engine(GENERATE(Engine::interpreter, Engine::block_cache, Engine::recompiler));
+    cpu.x(0x00);
+
+    auto const state = std::make_unique<Savestate>();
+    capture(cpu, *memory, *state);
+    restore(cpu, *memory, *state);
+    REQUIRE_FALSE(cpu.bus().dirty(0x00));
+
+    cpu.run(200);
+    auto const later = cpu.registers();
+    auto const counter = memory->get(0x0010);
+    REQUIRE(counter != 0x00);
+    REQUIRE(memory->get(0x0301) == 0x01);
+    REQUIRE_FALSE(memory->dirty(0x00));
+    REQUIRE(cpu.bus().dirty(0x00));
+    REQUIRE(cpu.bus().dirty(0x03));
+    REQUIRE_FALSE(cpu.bus().dirty(0x02));
+
+    reset_to(cpu, *memory, *state);
+    REQUIRE_FALSE(cpu.bus().dirty(0x00));
+    REQUIRE(memory->get(0x0010) == 0x00);
+    REQUIRE(memory->get(0x0301) == 0x00);
+
+    cpu.run(200);
+    REQUIRE(cpu.pc() == later.pc);
+    REQUIRE(cpu.x() == later.x);
+    REQUIRE(memory->get(0x0010) == counter);
+}
@@ -0,0 +1,254 @@
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/bus.hpp>
+#include <fce/cpu.hpp>
+#include <fce/memory.hpp>
+#include <fce/scheduler.hpp>
+
+using namespace fce;
+
+namespace {
+
+// Counts the cycles it has been run for, and how often it was caught up.
+class Timer : public Component
+{
+public:
+    u64 ticks = 0;
+    int advances = 0;
+
+protected:
+    auto advance(u64 from, u64 to) -> void override {
+        ticks += to - from;
+        ++advances;
+    }
+};
+
+// Exposes the low byte of the timer at every address of its page.
+class TimerPort : public Memory
+{
+public:
+    auto get(u16) const noexcept -> u8 override {
+        timer->catch_up(cpu->cycles());
+        return u8(timer->ticks);
+    }
+
+    Timer* timer = nullptr;
+    CPU<>* cpu = nullptr;
+};
+
+}  // namespace
+
+TEST_CASE("Scheduler", "[scheduler]") {
+    Scheduler scheduler;
+    std::vector<Event> fired;
+    std::vector<u64> timestamps;
+    for (auto const event : {Event::ppu_scanline, Event::apu_frame_counter, Event::irq, Event::nmi}) {
+        scheduler.on(event, [&, event](u64 timestamp) {
+            fired.push_back(event);
+            timestamps.push_back(timestamp);
+        });
+    }
+
+    REQUIRE(scheduler.next() == Scheduler::never);
+
+    SECTION("Order") {
+        scheduler.schedule(Event::nmi, 30);
+        scheduler.schedule(Event::ppu_scanline, 10);
+        scheduler.schedule(Event::irq, 20);
+        REQUIRE(scheduler.next() == 10);
+
+        scheduler.dispatch(25);
+        REQUIRE(fired == std::vector<Event>{Event::ppu_scanline, Event::irq});
+        REQUIRE(timestamps == std::vector<u64>{10, 20});
+        REQUIRE(scheduler.next() == 30);
+        REQUIRE(scheduler.pending(Event::nmi));
+        REQUIRE_FALSE(scheduler.pending(Event::irq));
+    }
+    SECTION("Same Time") {
+        scheduler.schedule(Event::nmi, 10);
+        scheduler.schedule(Event::ppu_scanline, 10);
+        scheduler.dispatch(10);
+        REQUIRE(fired == std::vector<Event>{Event::ppu_scanline, Event::nmi});
+    }
+    SECTION("Reschedule") {
+        scheduler.schedule(Event::irq, 10);
+        scheduler.schedule(Event::irq, 40);
+        REQUIRE(scheduler.next() == 40);
+
+        scheduler.dispatch(100);
+        REQUIRE(timestamps == std::vector<u64>{40});
+    }
+    SECTION("Cancel") {
+        scheduler.schedule(Event::irq, 10);
+        scheduler.schedule(Event::nmi, 20);
+        scheduler.cancel(Event::irq);
+        REQUIRE_FALSE(scheduler.pending(Event::irq));
+        REQUIRE(scheduler.next() == 20);
+
+        scheduler.dispatch(100);
+        REQUIRE(fired == std::vector<Event>{Event::nmi});
+    }
+    SECTION("Periodic") {
+        scheduler.on(Event::ppu_scanline, [&](u64 timestamp) {
+            timestamps.push_back(timestamp);
+            scheduler.schedule(Event::ppu_scanline, timestamp + 114);
+        });
+        scheduler.schedule(Event::ppu_scanline, 0);
+
+        scheduler.dispatch(300);
+        REQUIRE(timestamps == std::vector<u64>{0, 114, 228});
+        REQUIRE(scheduler.next() == 342);
+    }
+}
+
+TEST_CASE("Scheduler Run", "[scheduler][cpu]") {
+    auto memory = std::make_shared<Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x80);
+    memory->set(0xFFFA, 0x00);
+    memory->set(0xFFFB, 0x90);
+    for (u16 addr = 0x8000; addr < 0x8100; addr++) {
+        memory->set(addr, 0xEA);  // NOP
+    }
+    memory->set(0x9000, 0xEA);  // NOP
+
+    CPU cpu{memory};
+    Scheduler scheduler;
+    std::vector<u64> fired;
+
+    SECTION("Events") {
+        scheduler.on(Event::ppu_scanline, [&](u64 timestamp) {
+            REQUIRE(cpu.cycles() >= timestamp);
+            REQUIRE(cpu.cycles() < timestamp + 2);
+            fired.push_back(timestamp);
+            scheduler.schedule(Event::ppu_scanline, timestamp + 11);
+        });
+        auto const start = cpu.cycles();
+        scheduler.schedule(Event::ppu_scanline, start + 11);
+
+        scheduler.run(cpu, start + 50);
+        REQUIRE(cpu.cycles() == start + 50);
+        REQUIRE(fired == std::vector<u64>{start + 11, start + 22, start + 33, start + 44});
+    }
+    SECTION("NMI") {
+        scheduler.on(Event::nmi, [&](u64) { cpu.nmi(); });
+        scheduler.schedule(Event::nmi, cpu.cycles() + 10);
+
+        scheduler.run(cpu, cpu.cycles() + 18);
+        REQUIRE(cpu.pc() == 0x9001);
+    }
+}
+
+TEST_CASE("Catch Up", "[scheduler][cpu]") {
+    auto memory = std::make_shared<Memory>();
+    memory->set(0xFFFC, 0x00);
+    memory->set(0xFFFD, 0x80);
+    memory->set(0x8000, 0xEA);  // NOP
+    memory->set(0x8001, 0xEA);  // NOP
+    memory->set(0x8002, 0xAD);  // LDA $4000
+    memory->set(0x8003, 0x00);
+    memory->set(0x8004, 0x40);
+
+    Timer timer;
+    auto port = std::make_shared<TimerPort>();
+
+    Bus bus;
+    bus.map_ram(0x00, 0xFF, memory->data(), 0x10000);
+    bus.map_io(0x40, 0x40, port);
+
+    CPU cpu{bus};
+    port->timer = &timer;
+    port->cpu = &cpu;
+
+    auto const start = cpu.cycles();
+    cpu.run_until(100, [](Registers const& r) { return r.pc == 0x8002; });
+    REQUIRE(timer.advances == 0);
+
+    cpu.run_until(100, [](Registers const& r) { return r.pc == 0x8005; });
+    REQUIRE(timer.advances == 1);
+    REQUIRE(timer.timestamp() == start + 8);
+    REQUIRE(cpu.a() == u8(start + 8));
+}
+
+TEST_CASE("Skip Idle", "[scheduler][cpu]") {
+    // waits for the NMI handler to set $10, then counts in X
+    auto const program = std::make_shared<Memory>();
+    for (auto [addr, v] : std::initializer_list<std::pair<u16, u8>>{
+        {0xFFFC, 0x00}, {0xFFFD, 0x80}, {0xFFFA, 0x00}, {0xFFFB, 0x90},
+        {0x8000, 0xA5}, {0x8001, 0x10},                  // LDA $10
+        {0x8002, 0xD0}, {0x8003, 0x03},                  // BNE $8007
+        {0x8004, 0x4C}, {0x8005, 0x00}, {0x8006, 0x80},  // JMP $8000
+        {0x8007, 0xE8},                                  // INX
+        {0x8008, 0x4C}, {0x8009, 0x07}, {0x800A, 0x80},  // JMP $8007
+        {0x9000, 0xC6}, {0x9001, 0x10},                  // DEC $10
+        {0x9002, 0x40},                                  // RTI
+    })
+    {
+        program->set(addr, v);
+    }
+    // or spins on a branch backwards
+    auto const branch = GENERATE(false, true);
+    if (branch) {
+        program->set(0x8002, 0x10);  // BPL $8000
+        program->set(0x8003, 0xFC);
+        program->set(0x8005, 0x07);  // JMP $8007
+    }
+
+    auto const engine = GENERATE(Engine::interpreter, Engine::block_cache, Engine::recompiler);
+    auto const make = [&](Memory& ram) {
+        ram = *program;
+        Bus bus;
+        bus.map_ram(0x00, 0xFF, ram.data(), 0x10000);
+        CPU cpu{bus};
+        cpu.engine(engine);
+        cpu.x(0x00);
+        cpu.p(0x00);
+        cpu.s(0xFD);
+        return cpu;
+    };
+    auto const run = [](CPU<>& cpu, u64 cycles) {
+        Scheduler scheduler;
+        scheduler.on(Event::nmi, [&](u64) { cpu.nmi(); });
+        scheduler.schedule(Event::nmi, cpu.cycles() + 1000);
+        scheduler.run(cpu, cpu.cycles() + cycles);
+    };
+
+    Memory reference_ram;
+    auto reference = make(reference_ram);
+    run(reference, 1100);
+
+    Memory ram;
+    auto cpu = make(ram);
+
+    SECTION("Same Results") {
+        cpu.skip_idle(true);
+        run(cpu, 1100);
+
+        REQUIRE(cpu.skipped_cycles() > 900);
+        REQUIRE(cpu.cycles() == reference.cycles());
+        REQUIRE(cpu.pc() == reference.pc());
+        REQUIRE(cpu.x() == reference.x());
+        REQUIRE(cpu.x() > 0);
+        REQUIRE(std::memcmp(ram.data(), reference_ram.data(), 0x10000) == 0);
+    }
+    SECTION("Off") {
+        run(cpu, 1100);
+
+        REQUIRE(cpu.skipped_cycles() == 0);
+        REQUIRE(cpu.x() == reference.x());
+    }
+    SECTION("Unstable Reads") {
+        Bus bus;
+        bus.map_ram(0x00, 0xFF, ram.data(), 0x10000);
+        bus.map_io(0x00, 0x00, std::make_shared<Memory>());
+        cpu.bus() = bus;
+        cpu.skip_idle(true);
+        run(cpu, 1100);
+
+        REQUIRE(cpu.skipped_cycles() == 0);
+    }
+}
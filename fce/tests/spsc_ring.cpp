@@ -0,0 +1,67 @@
+#include <numeric>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/spsc_ring.hpp>
+
+using namespace fce;
+
+TEST_CASE("SPSC Ring", "[spsc_ring]") {
+    SpscRing<u32> ring{100};
+    REQUIRE(ring.capacity() == 128);
+
+    SECTION("Wraps") {
+        std::vector<u32> in(100);
+        std::iota(in.begin(), in.end(), 0);
+        std::vector<u32> out(100);
+
+        REQUIRE(ring.push(in.data(), 100) == 100);
+        REQUIRE(ring.pop(out.data(), 70) == 70);
+        REQUIRE(out[69] == 69);
+
+        // 30 left, room for 98 more
+        REQUIRE(ring.push(in.data(), 100) == 98);
+        REQUIRE(ring.size() == 128);
+        REQUIRE(ring.push(in.data(), 1) == 0);
+
+        REQUIRE(ring.pop(out.data(), 100) == 100);
+        REQUIRE(out[29] == 99);
+        REQUIRE(out[30] == 0);
+        REQUIRE(out[99] == 69);
+        REQUIRE(ring.pop(out.data(), 100) == 28);
+        REQUIRE(out[27] == 97);
+        REQUIRE(ring.pop(out.data(), 100) == 0);
+    }
+    SECTION("Threads") {
+        constexpr u32 total = 200'000;
+        std::thread producer{[&] {
+            u32 next = 0;
+            u32 block[37];
+            while (next < total) {
+                auto const count = std::min<u32>(37, total - next);
+                std::iota(block, block + count, next);
+                auto const pushed = ring.push(block, count);
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+                next += u32(pushed);
+            }
+        }};
+
+        u32 expected = 0;
+        bool ordered = true;
+        u32 block[53];
+        while (expected < total) {
+            auto const count = ring.pop(block, 53);
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 0; i < count; i++) {
+                ordered = ordered && block[i] == expected++;
+            }
+        }
+        producer.join();
+        REQUIRE(ordered);
+        REQUIRE(ring.size() == 0);
+    }
+}
@@ -0,0 +1,26 @@
+#include <atomic>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fce/thread_pool.hpp>
+
+using namespace fce;
+
+TEST_CASE("ThreadPool", "[thread]") {
+    ThreadPool pool{GENERATE(1, 2, 4)};
+
+    SECTION("Every Index Once") {
+        std::vector<std::atomic<int>> calls(1000);
+        for (int round = 0; round < 3; round++) {
+            pool.for_each(calls.size(), [&](std::size_t i) { calls[i]++; });
+        }
+        for (auto const& count : calls) {
+            REQUIRE(count == 3);
+        }
+    }
+    SECTION("Fewer Tasks Than Threads") {
+        std::atomic<int> calls{0};
+        pool.for_each(1, [&](std::size_t) { calls++; });
+        pool.for_each(0, [&](std::size_t) { calls++; });
+        REQUIRE(calls == 1);
+    }
+}
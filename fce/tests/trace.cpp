@@ -0,0 +1,140 @@
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <catch2/catch.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/trace.hpp>
+
+using namespace fce;
+
+namespace {
+
+auto make_record(u64 cycles) -> TraceRecord {
+    TraceRecord record{};
+    record.cycles = cycles;
+    record.pc = u16(cycles);
+    return record;
+}
+
+}  // namespace
+
+TEST_CASE("Trace Buffer", "[trace]") {
+    TraceBuffer buffer{3};
+    REQUIRE(buffer.capacity() == 4);
+    REQUIRE(buffer.size() == 0);
+
+    SECTION("Partial") {
+        buffer.record(make_record(1));
+        buffer.record(make_record(2));
+        REQUIRE(buffer.size() == 2);
+        REQUIRE(buffer[0].cycles == 1);
+        REQUIRE(buffer[1].cycles == 2);
+    }
+    SECTION("Wrapped") {
+        for (u64 i = 1; i <= 6; i++) {
+            buffer.record(make_record(i));
+        }
+        REQUIRE(buffer.size() == 4);
+        REQUIRE(buffer.recorded() == 6);
+        REQUIRE(buffer[0].cycles == 3);
+        REQUIRE(buffer[3].cycles == 6);
+    }
+    SECTION("Save And Load") {
+        for (u64 i = 1; i <= 6; i++) {
+            auto record = make_record(i << 40);
+            record.cmos = i == 6;
+            buffer.record(record);
+        }
+        std::stringstream stream;
+        buffer.save(stream);
+
+        auto const records = load_trace(stream);
+        REQUIRE(records.size() == 4);
+        REQUIRE(records[0].cycles == u64{3} << 40);
+        REQUIRE(records[3].cycles == u64{6} << 40);
+        REQUIRE_FALSE(records[0].cmos);
+        REQUIRE(records[3].cmos);
+    }
+    SECTION("Not A Trace") {
+        std::stringstream stream{"nestest.log"};
+        REQUIRE_THROWS_AS(load_trace(stream), std::runtime_error);
+    }
+}
+
+TEST_CASE("Trace Format", "[trace]") {
+    TraceRecord record{};
+    record.cycles = 7;
+    record.pc = 0xC000;
+    record.opcode = 0x4C;
+    record.operand = {0xF5, 0xC5};
+    record.a = 0x00;
+    record.x = 0x00;
+    record.y = 0x00;
+    record.s = 0xFD;
+    record.p = 0x24;
+
+    SECTION("Absolute") {
+        REQUIRE(format_nestest(record) ==
+                "C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD CYC:7");
+    }
+    SECTION("Implied") {
+        record.opcode = 0xE8;
+        REQUIRE(format_nestest(record) ==
+                "C000  E8        INX                             A:00 X:00 Y:00 P:24 SP:FD CYC:7");
+    }
+    SECTION("Indirect Indexed") {
+        record.opcode = 0xB1;
+        record.operand = {0x89, 0x00};
+        REQUIRE(format_nestest(record) ==
+                "C000  B1 89     LDA ($89),Y                     A:00 X:00 Y:00 P:24 SP:FD CYC:7");
+    }
+    SECTION("65C02") {
+        record.opcode = 0xB2;
+        record.operand = {0x89, 0x00};
+        record.cmos = true;
+        REQUIRE(format_nestest(record) ==
+                "C000  B2 89     LDA ($89)                       A:00 X:00 Y:00 P:24 SP:FD CYC:7");
+        record.opcode = 0x03;
+        REQUIRE(format_nestest(record) ==
+                "C000  03        NOP                             A:00 X:00 Y:00 P:24 SP:FD CYC:7");
+    }
+}
+
+TEST_CASE("Trace CPU", "[trace][cpu]") {
+    FlatRamBus bus;
+    bus.set(0x8000, 0xA9);  // LDA #$42
+    bus.set(0x8001, 0x42);
+    bus.set(0x8002, 0x8D);  // STA $0200
+    bus.set(0x8003, 0x00);
+    bus.set(0x8004, 0x02);
+    bus.set(0x8005, 0xE8);  // INX
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x80);
+
+    CPU<FlatRamBus, TraceBuffer> cpu{bus};
+    cpu.tracer() = TraceBuffer{16};
+    cpu.x(0x00);
+    auto const start = cpu.cycles();
+
+    SECTION("Step") {
+        cpu.step();
+        cpu.step();
+    }
+    SECTION("Run") {
+        cpu.run_until(100, [](Registers const& r) { return r.pc == 0x8005; });
+    }
+
+    auto const& trace = cpu.tracer();
+    REQUIRE(trace.size() == 2);
+    REQUIRE(trace[0].pc == 0x8000);
+    REQUIRE(trace[0].opcode == 0xA9);
+    REQUIRE(trace[0].operand[0] == 0x42);
+    REQUIRE(trace[0].cycles == start);
+    REQUIRE(trace[1].pc == 0x8002);
+    REQUIRE(trace[1].operand[0] == 0x00);
+    REQUIRE(trace[1].operand[1] == 0x02);
+    REQUIRE(trace[1].a == 0x42);
+    REQUIRE(trace[1].cycles == start + 2);
+    REQUIRE(cpu.cycles() == start + 6);
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <thread>
+#include <catch2/catch.hpp>
+#include <fce/triple_buffer.hpp>
+
+using namespace fce;
+
+TEST_CASE("Triple Buffer", "[triple_buffer]") {
+    TripleBuffer buffer{256};
+
+    SECTION("Newest Frame") {
+        REQUIRE_FALSE(buffer.present());
+        REQUIRE(buffer.front()[0] == 0);
+
+        for (u32 frame = 1; frame <= 3; frame++) {
+            std::fill_n(buffer.back(), buffer.size(), frame);
+            buffer.publish();
+        }
+        REQUIRE(buffer.present());
+        REQUIRE(buffer.front()[0] == 3);
+        REQUIRE_FALSE(buffer.present());
+        REQUIRE(buffer.front()[255] == 3);
+
+        REQUIRE(buffer.published() == 3);
+        REQUIRE(buffer.dropped() == 2);
+        REQUIRE(buffer.duplicated() == 2);
+
+        // the buffer presented is not drawn into
+        REQUIRE(buffer.back() != buffer.front());
+        std::fill_n(buffer.back(), buffer.size(), 4);
+        REQUIRE(buffer.front()[0] == 3);
+        buffer.publish();
+        REQUIRE(buffer.present());
+        REQUIRE(buffer.front()[0] == 4);
+    }
+    SECTION("Threads") {
+        constexpr u32 frames = 20000;
+        std::thread producer{[&] {
+            for (u32 frame = 1; frame <= frames; frame++) {
+                std::fill_n(buffer.back(), buffer.size(), frame);
+                buffer.publish();
+            }
+        }};
+
+        u64 taken = 0;
+        u32 last = 0;
+        bool whole = true;
+        bool ordered = true;
+        while (last != frames) {
+            if (!buffer.present()) {
+                std::this_thread::yield();
+                continue;
+            }
+            auto const pixels = buffer.front();
+            whole = whole && std::all_of(pixels, pixels + buffer.size(), [&](u32 p) { return p == pixels[0]; });
+            ordered = ordered && pixels[0] > last;
+            last = pixels[0];
+            taken++;
+        }
+        producer.join();
+
+        REQUIRE(whole);
+        REQUIRE(ordered);
+        REQUIRE(buffer.published() == frames);
+        REQUIRE(buffer.dropped() + taken == frames);
+    }
+}
@@ -0,0 +1,384 @@
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <catch2/catch.hpp>
+#include <fce/bus.hpp>
+#include <fce/cpu.hpp>
+#include <fce/flat_ram_bus.hpp>
+#include <fce/memory.hpp>
+#include <fce/variant.hpp>
+
+using namespace fce;
+
+namespace {
+
+// A CPU of `Variant` at $8000 with `code` there and clear registers.
+template <typename Variant>
+auto make_cpu(std::initializer_list<u8> code) -> CPU<FlatRamBus, NoTrace, Variant>
+{
+    FlatRamBus bus;
+    bus.set(0xFFFC, 0x00);
+    bus.set(0xFFFD, 0x80);
+    u16 addr = 0x8000;
+    for (auto v : code) {
+        bus.set(addr++, v);
+    }
+
+    CPU<FlatRamBus, NoTrace, Variant> cpu{bus};
+    cpu.a(0x00);
+    cpu.x(0x00);
+    cpu.y(0x00);
+    cpu.p(0x00);
+    cpu.s(0xFD);
+    return cpu;
+}
+
+}  // namespace
+
+TEST_CASE("Decimal Mode", "[cpu][variant]") {
+    SECTION("2A03") {
+        auto cpu = make_cpu<Ricoh2A03>({0xF8, 0x69, 0x28});  // SED; ADC #$28
+        cpu.a(0x19);
+        cpu.step();
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x41);
+    }
+    SECTION("NMOS ADC") {
+        auto cpu = make_cpu<Nmos6502>({0xF8, 0x69, 0x28});
+        cpu.a(0x19);
+        cpu.step();
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x47);
+        REQUIRE(!cpu.c());
+        REQUIRE(cpu.cycles() - old_cycles == 2);
+    }
+    SECTION("NMOS ADC Carry") {
+        auto cpu = make_cpu<Nmos6502>({0xF8, 0x69, 0x58});
+        cpu.a(0x46);
+        cpu.c(true);
+        cpu.step();
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x05);
+        REQUIRE(cpu.c());
+    }
+    SECTION("NMOS SBC") {
+        auto cpu = make_cpu<Nmos6502>({0xF8, 0xE9, 0x13});  // SED; SBC #$13
+        cpu.a(0x42);
+        cpu.c(true);
+        cpu.step();
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x29);
+        REQUIRE(cpu.c());
+    }
+    SECTION("65C02 ADC") {
+        auto cpu = make_cpu<Wdc65C02>({0xF8, 0x69, 0x01});
+        cpu.a(0x99);
+        cpu.step();
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x00);
+        REQUIRE(cpu.c());
+        REQUIRE(cpu.z());
+        REQUIRE(cpu.cycles() - old_cycles == 3);
+    }
+}
+
+TEST_CASE("JMP Indirect Page Wrap", "[cpu][variant]") {
+    std::initializer_list<u8> const code = {0x6C, 0xFF, 0x10};  // JMP ($10FF)
+
+    SECTION("NMOS") {
+        auto cpu = make_cpu<Ricoh2A03>(code);
+        cpu.bus().set(0x10FF, 0x34);
+        cpu.bus().set(0x1000, 0x12);
+        cpu.bus().set(0x1100, 0x56);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0x1234);
+        REQUIRE(cpu.cycles() - old_cycles == 5);
+    }
+    SECTION("65C02") {
+        auto cpu = make_cpu<Wdc65C02>(code);
+        cpu.bus().set(0x10FF, 0x34);
+        cpu.bus().set(0x1000, 0x12);
+        cpu.bus().set(0x1100, 0x56);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0x5634);
+        REQUIRE(cpu.cycles() - old_cycles == 6);
+    }
+}
+
+TEST_CASE("Read Modify Write Indexed", "[cpu][variant]") {
+    auto const op = GENERATE(as<u8>{}, 0x1E, 0x3E, 0x5E, 0x7E, 0xDE, 0xFE);  // ASL ROL LSR ROR DEC INC $10F0,X
+    auto const shift = op < 0x80;
+    auto const x = GENERATE(as<u8>{}, 0x0F, 0x10);  // crossing a page or not
+    auto const crossed = x == 0x10;
+
+    SECTION("NMOS") {
+        auto cpu = make_cpu<Ricoh2A03>({op, 0xF0, 0x10});
+        cpu.x(x);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.cycles() - old_cycles == 7);
+    }
+    SECTION("65C02") {
+        auto cpu = make_cpu<Wdc65C02>({op, 0xF0, 0x10});
+        cpu.x(x);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.cycles() - old_cycles == (shift && !crossed ? 6 : 7));
+    }
+}
+
+TEST_CASE("65C02 Instructions", "[cpu][variant]") {
+    SECTION("STZ") {
+        auto cpu = make_cpu<Wdc65C02>({0x64, 0x10, 0x9E, 0x00, 0x02});  // STZ $10; STZ $0200,X
+        cpu.bus().set(0x0010, 0xAA);
+        cpu.bus().set(0x0203, 0xAA);
+        cpu.x(0x03);
+        cpu.step();
+        cpu.step();
+
+        REQUIRE(cpu.bus().get(0x0010) == 0x00);
+        REQUIRE(cpu.bus().get(0x0203) == 0x00);
+    }
+    SECTION("BRA") {
+        auto cpu = make_cpu<Wdc65C02>({0x80, 0x10});
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0x8012);
+        REQUIRE(cpu.cycles() - old_cycles == 3);
+    }
+    SECTION("PHX PLY") {
+        auto cpu = make_cpu<Wdc65C02>({0xDA, 0x7A});
+        cpu.x(0x80);
+        cpu.step();
+        cpu.step();
+
+        REQUIRE(cpu.y() == 0x80);
+        REQUIRE(cpu.n());
+        REQUIRE(cpu.s() == 0xFD);
+    }
+    SECTION("INC A") {
+        auto cpu = make_cpu<Wdc65C02>({0x1A});
+        cpu.a(0xFF);
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x00);
+        REQUIRE(cpu.z());
+    }
+    SECTION("Zero Page Indirect") {
+        auto cpu = make_cpu<Wdc65C02>({0xB2, 0x10});  // LDA ($10)
+        cpu.bus().set(0x0010, 0x34);
+        cpu.bus().set(0x0011, 0x12);
+        cpu.bus().set(0x1234, 0x5A);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.a() == 0x5A);
+        REQUIRE(cpu.cycles() - old_cycles == 5);
+    }
+    SECTION("TSB TRB") {
+        auto cpu = make_cpu<Wdc65C02>({0x04, 0x10, 0x14, 0x11});  // TSB $10; TRB $11
+        cpu.bus().set(0x0010, 0x0F);
+        cpu.bus().set(0x0011, 0x3C);
+        cpu.a(0x30);
+        cpu.step();
+
+        REQUIRE(cpu.bus().get(0x0010) == 0x3F);
+        REQUIRE(cpu.z());
+
+        cpu.step();
+        REQUIRE(cpu.bus().get(0x0011) == 0x0C);
+        REQUIRE(!cpu.z());
+    }
+    SECTION("Reserved NOPs") {
+        struct Nop
+        {
+            u8 opcode;
+            u16 size;
+            u64 cycles;
+        };
+        for (auto nop : std::initializer_list<Nop>{
+            {0x02, 2, 2}, {0x22, 2, 2}, {0x42, 2, 2}, {0x62, 2, 2}, {0x82, 2, 2}, {0xC2, 2, 2}, {0xE2, 2, 2},
+            {0x44, 2, 3}, {0x54, 2, 4}, {0xD4, 2, 4}, {0xF4, 2, 4},
+            {0x5C, 3, 8}, {0xDC, 3, 4}, {0xFC, 3, 4},
+            {0x03, 1, 1}, {0x0B, 1, 1}, {0xF3, 1, 1}, {0xFB, 1, 1},
+        })
+        {
+            auto cpu = make_cpu<Wdc65C02>({nop.opcode, 0x10, 0x02});
+            auto const old_cycles = cpu.cycles();
+            cpu.step();
+
+            INFO("opcode " << unsigned(nop.opcode));
+            REQUIRE(cpu.pc() == 0x8000 + nop.size);
+            REQUIRE(cpu.cycles() - old_cycles == nop.cycles);
+            REQUIRE(cpu.a() == 0x00);
+            REQUIRE(cpu.p() == 0x00);
+        }
+    }
+    SECTION("RMB SMB") {
+        auto cpu = make_cpu<Wdc65C02>({0x37, 0x10, 0x87, 0x11});  // RMB3 $10; SMB0 $11
+        cpu.bus().set(0x0010, 0xFF);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.bus().get(0x0010) == 0xF7);
+        REQUIRE(cpu.cycles() - old_cycles == 5);
+
+        cpu.step();
+        REQUIRE(cpu.bus().get(0x0011) == 0x01);
+        REQUIRE(cpu.p() == 0x00);
+    }
+    SECTION("BBR BBS") {
+        // BBS7 $10,+$10 taken
+        auto taken = make_cpu<Wdc65C02>({0xFF, 0x10, 0x10});
+        taken.bus().set(0x0010, 0x80);
+        auto old_cycles = taken.cycles();
+        taken.step();
+
+        REQUIRE(taken.pc() == 0x8013);
+        REQUIRE(taken.cycles() - old_cycles == 6);
+
+        // BBR7 $10,+$10 not taken
+        auto not_taken = make_cpu<Wdc65C02>({0x7F, 0x10, 0x10});
+        not_taken.bus().set(0x0010, 0x80);
+        old_cycles = not_taken.cycles();
+        not_taken.step();
+
+        REQUIRE(not_taken.pc() == 0x8003);
+        REQUIRE(not_taken.cycles() - old_cycles == 5);
+    }
+    SECTION("WAI") {
+        auto cpu = make_cpu<Wdc65C02>({0xCB, 0xE8});  // WAI; INX
+        cpu.bus().set(0xFFFE, 0x00);
+        cpu.bus().set(0xFFFF, 0x90);
+        auto const old_cycles = cpu.cycles();
+        cpu.step();
+
+        REQUIRE(cpu.waiting());
+        REQUIRE(cpu.cycles() - old_cycles == 3);
+
+        cpu.run(100);
+        REQUIRE(cpu.pc() == 0x8001);
+        REQUIRE(cpu.cycles() - old_cycles >= 103);
+
+        SECTION("Masked IRQ") {
+            cpu.i(true);
+            cpu.irq(true);
+            cpu.run(2);
+
+            REQUIRE_FALSE(cpu.waiting());
+            REQUIRE(cpu.x() == 0x01);
+            REQUIRE(cpu.pc() == 0x8002);
+        }
+        SECTION("IRQ") {
+            cpu.irq(true);
+            cpu.step();
+
+            REQUIRE_FALSE(cpu.waiting());
+            REQUIRE(cpu.pc() == 0x9000);
+            REQUIRE(cpu.i());
+        }
+    }
+    SECTION("STP") {
+        auto cpu = make_cpu<Wdc65C02>({0xDB, 0xE8});  // STP; INX
+        cpu.run(100);
+
+        REQUIRE(cpu.halted());
+        REQUIRE(cpu.pc() == 0x8001);
+
+        cpu.nmi();
+        cpu.irq(true);
+        cpu.run(100);
+        REQUIRE(cpu.pc() == 0x8001);
+        REQUIRE(cpu.x() == 0x00);
+
+        cpu.reset();
+        REQUIRE_FALSE(cpu.halted());
+        REQUIRE(cpu.pc() == 0x8000);
+    }
+    SECTION("NMOS NOP") {
+        auto cpu = make_cpu<Ricoh2A03>({0x64, 0x10});
+        cpu.bus().set(0x0010, 0xAA);
+        cpu.step();
+
+        REQUIRE(cpu.pc() == 0x8001);
+        REQUIRE(cpu.bus().get(0x0010) == 0xAA);
+    }
+}
+
+namespace {
+
+// RAM that counts reads, for I/O registers.
+class Counter : public Memory
+{
+public:
+    auto get(u16 addr) const noexcept -> u8 override
+    {
+        ++reads;
+        return Memory::get(addr);
+    }
+
+    mutable int reads = 0;
+};
+
+}  // namespace
+
+TEST_CASE("Accuracy", "[cpu][variant]") {
+    auto const ram = std::make_unique<Memory>();
+    for (auto [addr, v] : std::initializer_list<std::pair<u16, u8>>{
+        {0xFFFC, 0x00}, {0xFFFD, 0x80},
+        {0x8000, 0xA2}, {0x8001, 0xFF},                  // LDX #$FF
+        {0x8002, 0xBD}, {0x8003, 0x01}, {0x8004, 0x03},  // LDA $0301,X
+        {0x8005, 0x9D}, {0x8006, 0x00}, {0x8007, 0x03},  // STA $0300,X
+        {0x8008, 0xBD}, {0x8009, 0x01}, {0x800A, 0x20},  // LDA $2001,X
+        {0x800B, 0x4C}, {0x800C, 0x0B}, {0x800D, 0x80},  // JMP $800B
+        {0x0400, 0x5A},
+    })
+    {
+        ram->set(addr, v);
+    }
+
+    auto const run = [&](auto& cpu, std::shared_ptr<Counter> const& io) {
+        auto const start = cpu.cycles();
+        Bus bus;
+        bus.map_ram(0x00, 0xFF, ram->data(), 0x10000);
+        bus.map_io(0x20, 0x21, io);
+        cpu.bus() = bus;
+        cpu.run(20);
+        return cpu.cycles() - start;
+    };
+
+    auto const exact_io = std::make_shared<Counter>();
+    CPU<Bus, NoTrace, Ricoh2A03, Accuracy::exact> exact{Bus{}};
+    exact.pc(0x8000);
+    auto const exact_cycles = run(exact, exact_io);
+
+    auto const fast_io = std::make_shared<Counter>();
+    CPU<Bus, NoTrace, Ricoh2A03, Accuracy::fast> fast{Bus{}};
+    fast.engine(GENERATE(Engine::interpreter, Engine::block_cache));
+    fast.pc(0x8000);
+    auto const fast_cycles = run(fast, fast_io);
+
+    REQUIRE(fast_cycles == exact_cycles);
+    REQUIRE(fast.pc() == exact.pc());
+    REQUIRE(fast.a() == exact.a());
+    REQUIRE(fast.bus().get(0x0400) == 0x5A);
+    REQUIRE(fast.bus().get(0x03FF) == 0x5A);
+
+    // the dummy read at $2000 has side effects
+    REQUIRE(exact_io->reads == 2);
+    REQUIRE(fast_io->reads == 2);
+}
@@ -0,0 +1,35 @@
+// Renders a trace saved by fce::TraceBuffer::save() in nestest.log format.
+//
+//     fce-trace [file]
+//
+// Reads standard input when no file is given.
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <fce/trace.hpp>
+
+int main(int argc, char *argv[])
+{
+    try {
+        std::vector<fce::TraceRecord> records;
+        if (argc > 1) {
+            std::ifstream file{argv[1], std::ios::binary};
+            if (!file) {
+                std::fprintf(stderr, "fce-trace: cannot open %s\n", argv[1]);
+                return 1;
+            }
+            records = fce::load_trace(file);
+        } else {
+            records = fce::load_trace(std::cin);
+        }
+
+        for (auto const& record : records) {
+            std::cout << fce::format_nestest(record) << '\n';
+        }
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "fce-trace: %s\n", e.what());
+        return 1;
+    }
+}